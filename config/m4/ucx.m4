@@ -158,6 +158,20 @@ AS_IF([test "x$ucx_happy" = "xno"], [
                 ],
                 [AC_MSG_NOTICE([UCX: ucp_worker_flush_nbx NOT found])
                 ])
+            AC_COMPILE_IFELSE(
+                [AC_LANG_PROGRAM([[#include <ucp/api/ucp.h>]], [ucp_am_send_nbx])],
+                [AC_MSG_NOTICE([UCX: ucp_am_send_nbx found])
+               AC_DEFINE([HAVE_UCP_AM_SEND_NBX], [1], [UCX has extended active messages])
+                ],
+                [AC_MSG_NOTICE([UCX: ucp_am_send_nbx NOT found])
+                ])
+            AC_COMPILE_IFELSE(
+                [AC_LANG_PROGRAM([[#include <ucp/api/ucp.h>]], [ucp_atomic_op_nbx])],
+                [AC_MSG_NOTICE([UCX: ucp_atomic_op_nbx found])
+               AC_DEFINE([HAVE_UCP_ATOMIC_OP_NBX], [1], [UCX has extended atomics])
+                ],
+                [AC_MSG_NOTICE([UCX: ucp_atomic_op_nbx NOT found])
+                ])
             AC_LANG_POP([C])
             AC_SUBST([UCX_LIBS])
 
@@ -0,0 +1,60 @@
+/* For license: see LICENSE file at top-level */
+
+/*
+ * Cohort lock check: every PE takes the lock over and over, and while
+ * holding it notes on PE 0 that it's inside.  Anyone finding someone
+ * else already inside means two PEs held the lock at once.  Run
+ * across (at least) two nodes with SHMEM_COHORT_PASSES > 0, so the
+ * lock is handed around on each node and between them.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <shmem.h>
+#include <shmemx.h>
+
+static shmemx_cohort_lock_t lk;
+static long inside = 0;
+static long bumps = 0;
+static long clashes = 0;
+
+int
+main(int argc, char *argv[])
+{
+    const long iters = (argc > 1) ? atol(argv[1]) : 10000;
+    long i;
+    int me, npes;
+
+    shmem_init();
+
+    me = shmem_my_pe();
+    npes = shmem_n_pes();
+
+    shmem_barrier_all();
+    for (i = 0; i < iters; ++i) {
+        shmemx_cohort_set_lock(&lk);
+
+        if (shmem_long_atomic_fetch_inc(&inside, 0) != 0) {
+            shmem_long_atomic_inc(&clashes, 0);
+        }
+        shmem_long_p(&bumps, shmem_long_g(&bumps, 0) + 1, 0);
+        shmem_long_atomic_add(&inside, -1, 0);
+
+        shmemx_cohort_clear_lock(&lk);
+    }
+    shmem_barrier_all();
+
+    if (me == 0) {
+        if ((clashes != 0) || (bumps != iters * npes)) {
+            printf("FAIL: %ld clashes, counter %ld, expected %ld\n",
+                   clashes, bumps, iters * npes);
+        } else {
+            printf("OK: %d PEs x %ld\n", npes, iters);
+        }
+    }
+
+    shmem_finalize();
+
+    return ((clashes != 0) || (bumps != iters * npes)) ? 1 : 0;
+}
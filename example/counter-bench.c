@@ -0,0 +1,86 @@
+/* For license: see LICENSE file at top-level */
+
+/*
+ * Shared-counter throughput: every PE takes tickets from one counter
+ * on PE 0, first with plain shmem_uint64_atomic_fetch_inc(), then with
+ * a combining counter.  Prints the aggregate rate for each, and
+ * checks the combining counter handed out every ticket exactly once.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+#include <shmem.h>
+#include <shmemx.h>
+
+static uint64_t plain = 0;
+static long seen = 0;
+
+int
+main(int argc, char *argv[])
+{
+    const long iters = (argc > 1) ? atol(argv[1]) : 100000;
+    shmemx_combining_counter_t comb;
+    double t0, t1;
+    long i;
+    int me, npes;
+
+    shmem_init();
+
+    me = shmem_my_pe();
+    npes = shmem_n_pes();
+
+    if (shmemx_combining_counter_create(0, 0, &comb) != 0) {
+        fprintf(stderr, "PE %d: can't create combining counter\n", me);
+        shmem_global_exit(1);
+    }
+
+    if (me == 0) {
+        printf("%12s %16s\n", "counter", "tickets/s");
+    }
+
+    shmem_barrier_all();
+    t0 = shmemx_wtime();
+    for (i = 0; i < iters; ++i) {
+        (void) shmem_uint64_atomic_fetch_inc(&plain, 0);
+    }
+    shmem_barrier_all();
+    t1 = shmemx_wtime();
+
+    if (me == 0) {
+        printf("%12s %16.0f\n", "plain", (double) iters * npes / (t1 - t0));
+    }
+
+    shmem_barrier_all();
+    t0 = shmemx_wtime();
+    for (i = 0; i < iters; ++i) {
+        const uint64_t t = shmemx_combining_counter_fetch_inc(comb);
+
+        /* each ticket number should turn up once, anywhere */
+        shmem_long_atomic_inc(&seen, (int) (t % (uint64_t) npes));
+    }
+    shmem_barrier_all();
+    t1 = shmemx_wtime();
+
+    if (me == 0) {
+        printf("%12s %16.0f\n", "combining",
+               (double) iters * npes / (t1 - t0));
+    }
+
+    if (shmemx_combining_counter_read(comb) != (uint64_t) iters * npes) {
+        fprintf(stderr, "PE %d: counter is %lu, expected %lu\n", me,
+                (unsigned long) shmemx_combining_counter_read(comb),
+                (unsigned long) iters * npes);
+    }
+    if (seen != iters) {
+        fprintf(stderr, "PE %d: got %ld tickets, expected %ld\n", me,
+                seen, iters);
+    }
+
+    shmemx_combining_counter_destroy(comb);
+
+    shmem_finalize();
+
+    return 0;
+}
@@ -0,0 +1,180 @@
+/* For license: see LICENSE file at top-level */
+
+/*
+ * Many independent locks: every PE goes round an array of locks,
+ * setting and clearing each in turn, with no two PEs on the same lock
+ * at once.  Done for an array of global locks and one allocated on
+ * the symmetric heap.  The owners of both should be spread over the
+ * PEs, so neither should pile up on one PE.
+ *
+ * Then everyone fights over one lock, bumping a counter on PE 0 with
+ * plain get/put while holding it, to check nobody gets in at the same
+ * time.  Worth running with as many PEs as you have: lock words hold
+ * full int PE numbers.
+ *
+ * Last, the same one-lock fight with a reader-writer lock where 1 in
+ * RW_WRITES goes is a write.  Readers shouldn't queue behind each other.
+ *
+ * And once more with a cohort lock, which should beat the plain lock
+ * across several nodes by handing off on a node where it can.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <shmem.h>
+#include <shmemx.h>
+
+#define NLOCKS 4096
+#define RW_WRITES 100
+
+static long glocks[NLOCKS];
+
+static long one_lock = 0;
+static long bumps = 0;
+
+static shmemx_rwlock_t rw;
+static long rw_bumps = 0;
+
+static shmemx_cohort_lock_t cohort;
+static long cohort_bumps = 0;
+
+static double
+run(long *locks, long iters, int me, int npes)
+{
+    double t0, t1;
+    long i;
+
+    shmem_barrier_all();
+    t0 = shmemx_wtime();
+    for (i = 0; i < iters; ++i) {
+        /* PEs on different locks at every step */
+        long *lp = &locks[(i * npes + me) % NLOCKS];
+
+        shmem_set_lock(lp);
+        shmem_clear_lock(lp);
+    }
+    shmem_barrier_all();
+    t1 = shmemx_wtime();
+
+    return (double) iters * npes / (t1 - t0);
+}
+
+static double
+contend(long iters, int npes)
+{
+    double t0, t1;
+    long i;
+
+    shmem_barrier_all();
+    t0 = shmemx_wtime();
+    for (i = 0; i < iters; ++i) {
+        shmem_set_lock(&one_lock);
+        shmem_long_p(&bumps, shmem_long_g(&bumps, 0) + 1, 0);
+        shmem_clear_lock(&one_lock);
+    }
+    shmem_barrier_all();
+    t1 = shmemx_wtime();
+
+    return (double) iters * npes / (t1 - t0);
+}
+
+static double
+contend_rw(long iters, int npes)
+{
+    double t0, t1;
+    long i;
+
+    shmem_barrier_all();
+    t0 = shmemx_wtime();
+    for (i = 0; i < iters; ++i) {
+        if (i % RW_WRITES == 0) {
+            shmemx_rwlock_write_lock(&rw);
+            shmem_long_p(&rw_bumps, shmem_long_g(&rw_bumps, 0) + 1, 0);
+            shmemx_rwlock_write_unlock(&rw);
+        } else {
+            shmemx_rwlock_read_lock(&rw);
+            (void) shmem_long_g(&rw_bumps, 0);
+            shmemx_rwlock_read_unlock(&rw);
+        }
+    }
+    shmem_barrier_all();
+    t1 = shmemx_wtime();
+
+    return (double) iters * npes / (t1 - t0);
+}
+
+static double
+contend_cohort(long iters, int npes)
+{
+    double t0, t1;
+    long i;
+
+    shmem_barrier_all();
+    t0 = shmemx_wtime();
+    for (i = 0; i < iters; ++i) {
+        shmemx_cohort_set_lock(&cohort);
+        shmem_long_p(&cohort_bumps, shmem_long_g(&cohort_bumps, 0) + 1, 0);
+        shmemx_cohort_clear_lock(&cohort);
+    }
+    shmem_barrier_all();
+    t1 = shmemx_wtime();
+
+    return (double) iters * npes / (t1 - t0);
+}
+
+int
+main(int argc, char *argv[])
+{
+    const long iters = (argc > 1) ? atol(argv[1]) : 10000;
+    long *hlocks;
+    const long citers = (iters / 10 > 0) ? iters / 10 : 1;
+    const long writes = (citers + RW_WRITES - 1) / RW_WRITES;
+    double g, h, c, r, k;
+    int me, npes;
+
+    shmem_init();
+
+    me = shmem_my_pe();
+    npes = shmem_n_pes();
+
+    hlocks = (long *) shmem_calloc(NLOCKS, sizeof(*hlocks));
+    if (hlocks == NULL) {
+        fprintf(stderr, "PE %d: can't allocate locks\n", me);
+        shmem_global_exit(1);
+    }
+
+    g = run(glocks, iters, me, npes);
+    h = run(hlocks, iters, me, npes);
+    c = contend(citers, npes);
+    r = contend_rw(citers, npes);
+    k = contend_cohort(citers, npes);
+
+    if (me == 0) {
+        printf("%8s %16s\n", "locks", "set+clear/s");
+        printf("%8s %16.0f\n", "global", g);
+        printf("%8s %16.0f\n", "heap", h);
+        printf("%8s %16.0f\n", "one", c);
+        printf("%8s %16.0f\n", "one rw", r);
+        printf("%8s %16.0f\n", "cohort", k);
+
+        if (bumps != citers * npes) {
+            fprintf(stderr, "counter is %ld, expected %ld\n", bumps,
+                    citers * npes);
+        }
+        if (rw_bumps != writes * npes) {
+            fprintf(stderr, "rw counter is %ld, expected %ld\n", rw_bumps,
+                    writes * npes);
+        }
+        if (cohort_bumps != citers * npes) {
+            fprintf(stderr, "cohort counter is %ld, expected %ld\n",
+                    cohort_bumps, citers * npes);
+        }
+    }
+
+    shmem_free(hlocks);
+
+    shmem_finalize();
+
+    return 0;
+}
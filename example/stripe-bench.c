@@ -0,0 +1,94 @@
+/* For license: see LICENSE file at top-level */
+
+/*
+ * Large-put bandwidth, to compare single-lane and striped transfers.
+ *
+ * PE 0 puts to PE 1 with shmem_putmem(), doubling the size each time
+ * up to the maximum (argument 1, MiB), then quiets.  Striping is
+ * chosen at launch, so run it once as-is and once with e.g.
+ *
+ *   SHMEM_STRIPE_LANES=4
+ *
+ * and compare the columns.  On one node also set SHMEM_MAPPED_RMA=n,
+ * or puts are plain memcpy()s and never reach UCX.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <shmem.h>
+#include <shmemx.h>
+
+#define MIB (1024UL * 1024UL)
+
+#define WARMUP 2
+#define ITERS 10
+
+int
+main(int argc, char *argv[])
+{
+    const size_t maxmb = (argc > 1) ? (size_t) atol(argv[1]) : 256;
+    const size_t maxsize = maxmb * MIB;
+    char *dest;
+    char *src;
+    size_t size;
+    int me, npes;
+
+    shmem_init();
+
+    me = shmem_my_pe();
+    npes = shmem_n_pes();
+
+    if (npes < 2) {
+        if (me == 0) {
+            fprintf(stderr, "needs at least 2 PEs\n");
+        }
+        shmem_finalize();
+        return 1;
+    }
+
+    dest = (char *) shmem_malloc(maxsize);
+    src = (char *) malloc(maxsize);
+    if ((dest == NULL) || (src == NULL)) {
+        fprintf(stderr, "PE %d: can't allocate %lu MiB\n", me,
+                (unsigned long) maxmb);
+        shmem_global_exit(1);
+    }
+    memset(src, me, maxsize);
+
+    if (me == 0) {
+        printf("%12s %12s\n", "bytes", "MB/s");
+    }
+
+    for (size = MIB; size <= maxsize; size *= 2) {
+        double t0 = 0.0, t1;
+        int i;
+
+        shmem_barrier_all();
+
+        if (me == 0) {
+            for (i = 0; i < WARMUP + ITERS; ++i) {
+                if (i == WARMUP) {
+                    shmem_quiet();
+                    t0 = shmemx_wtime();
+                }
+                shmem_putmem(dest, src, size, 1);
+            }
+            shmem_quiet();
+            t1 = shmemx_wtime();
+
+            printf("%12lu %12.1f\n", (unsigned long) size,
+                   (double) size * ITERS / (t1 - t0) / 1.0e6);
+        }
+    }
+
+    shmem_barrier_all();
+
+    free(src);
+    shmem_free(dest);
+
+    shmem_finalize();
+
+    return 0;
+}
@@ -0,0 +1,107 @@
+/* For license: see LICENSE file at top-level */
+
+/*
+ * Per-operation cost of symmetric address translation.
+ *
+ * Every put/get/AMO translates the local symmetric address into the
+ * target's address + rkey.  shmemx_lookup_remote_addr() runs exactly
+ * that translation without any communication, so we can time it
+ * directly:
+ *
+ *   - "hot":       same region every time (per-context cache hit)
+ *   - "alternate": bounce between globals and the heap (cache miss,
+ *                  table search every time)
+ *
+ * then, for scale, a small put to the neighbouring PE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <shmem.h>
+#include <shmemx.h>
+
+#define NADDRS 1024
+
+static long globals[NADDRS];
+
+static double
+per_op_ns(double t0, double t1, long n)
+{
+    return (t1 - t0) * 1.0e9 / (double) n;
+}
+
+int
+main(int argc, char *argv[])
+{
+    const long iters = (argc > 1) ? atol(argv[1]) : 10000000L;
+    long *heap;
+    void *addrs[NADDRS];
+    volatile void *sink = NULL;
+    double t0, t1;
+    long i;
+    int me, npes, other;
+
+    shmem_init();
+
+    me = shmem_my_pe();
+    npes = shmem_n_pes();
+    other = (me + 1) % npes;
+
+    heap = (long *) shmem_malloc(NADDRS * sizeof(*heap));
+
+    /* hot: all in the heap */
+    for (i = 0; i < NADDRS; ++i) {
+        addrs[i] = &heap[i];
+    }
+
+    t0 = shmemx_wtime();
+    for (i = 0; i < iters; ++i) {
+        sink = shmemx_lookup_remote_addr(addrs[i % NADDRS], other);
+    }
+    t1 = shmemx_wtime();
+
+    if (me == 0) {
+        printf("%-12s %10.2f ns/op\n", "hot", per_op_ns(t0, t1, iters));
+    }
+
+    /* alternate: globals, heap, globals, ... */
+    for (i = 0; i < NADDRS; ++i) {
+        addrs[i] = (i % 2) ? (void *) &heap[i] : (void *) &globals[i];
+    }
+
+    t0 = shmemx_wtime();
+    for (i = 0; i < iters; ++i) {
+        sink = shmemx_lookup_remote_addr(addrs[i % NADDRS], other);
+    }
+    t1 = shmemx_wtime();
+
+    if (me == 0) {
+        printf("%-12s %10.2f ns/op\n", "alternate", per_op_ns(t0, t1, iters));
+    }
+
+    /* end-to-end small put, same region */
+    shmem_barrier_all();
+
+    t0 = shmemx_wtime();
+    for (i = 0; i < iters / 100; ++i) {
+        shmem_long_p(&heap[i % NADDRS], i, other);
+    }
+    shmem_quiet();
+    t1 = shmemx_wtime();
+
+    if (me == 0) {
+        printf("%-12s %10.2f ns/op\n", "long_p",
+               per_op_ns(t0, t1, iters / 100));
+    }
+
+    (void) sink;
+
+    shmem_barrier_all();
+
+    shmem_free(heap);
+
+    shmem_finalize();
+
+    return 0;
+}
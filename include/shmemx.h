@@ -65,6 +65,11 @@ void *shmemx_lookup_remote_addr(void *addr, int pe);
 /**
  * @defgroup shmemx_fence_quiet Non-blocking Fence/Quiet Functions
  * @brief Functions for testing fence and quiet completion
+ *
+ * The first test call starts the fence/quiet and later calls only
+ * check on it, so call repeatedly until it returns non-zero, e.g.
+ * while (!shmemx_quiet_test()) { do_work(); }.  Operations issued
+ * after the first call are not covered.
  * @{
  */
 
@@ -102,6 +107,696 @@ int shmemx_fence_test(void);
  */
 int shmemx_quiet_test(void);
 
+/**
+ * @brief Order puts/AMOs issued on a context to a single PE, without
+ * waiting for traffic to any other PE
+ *
+ * @param ctx Context on which to fence
+ * @param pe Target PE
+ * @return Non-zero once the fence is satisfied (always, currently)
+ */
+int shmemx_pe_fence(shmem_ctx_t ctx, int pe);
+
+/**
+ * @brief Complete puts/AMOs issued on a context to a single PE,
+ * without waiting for traffic to any other PE
+ *
+ * @param ctx Context on which to quiet
+ * @param pe Target PE
+ */
+void shmemx_pe_quiet(shmem_ctx_t ctx, int pe);
+
+/**
+ * @brief As shmemx_pe_quiet(), for a list of PEs.  The PEs are flushed
+ * concurrently.
+ *
+ * @param ctx Context on which to quiet
+ * @param pes Array of target PEs
+ * @param npes Number of entries in "pes"
+ */
+void shmemx_pe_quiet_multi(shmem_ctx_t ctx, const int *pes, size_t npes);
+
+/** @} */
+
+/**
+ * @defgroup shmemx_strided_nbi Non-blocking Strided Put/Get
+ * @brief Strided transfers that complete at the next quiet
+ * @{
+ */
+
+/**
+ * @brief Declares non-blocking strided put/get operations for typed data
+ *
+ * shmemx_[ctx_]TYPENAME_iput_nbi() and shmemx_[ctx_]TYPENAME_iget_nbi()
+ * take the same arguments as their blocking shmem_ counterparts.
+ * Return does not imply the source may be reused (put) or that the
+ * target holds the data (get): call shmem_[ctx_]quiet() for that.
+ */
+#define API_DECL_SHMEMX_IPUTGET_NBI(_opname, _typename, _type)                 \
+  void shmemx_ctx_##_typename##_i##_opname##_nbi(                              \
+      shmem_ctx_t ctx, _type *dest, const _type *src, ptrdiff_t tst,           \
+      ptrdiff_t sst, size_t nelems, int pe);                                   \
+  void shmemx_##_typename##_i##_opname##_nbi(_type *dest, const _type *src,    \
+                                             ptrdiff_t tst, ptrdiff_t sst,     \
+                                             size_t nelems, int pe);
+
+#define DECL_SHMEMX_IPUT_NBI(_type, _typename)                                 \
+  API_DECL_SHMEMX_IPUTGET_NBI(put, _typename, _type)
+SHMEM_STANDARD_RMA_TYPE_TABLE(DECL_SHMEMX_IPUT_NBI)
+#undef DECL_SHMEMX_IPUT_NBI
+
+#define DECL_SHMEMX_IGET_NBI(_type, _typename)                                 \
+  API_DECL_SHMEMX_IPUTGET_NBI(get, _typename, _type)
+SHMEM_STANDARD_RMA_TYPE_TABLE(DECL_SHMEMX_IGET_NBI)
+#undef DECL_SHMEMX_IGET_NBI
+
+#undef API_DECL_SHMEMX_IPUTGET_NBI
+
+/**
+ * @brief Declares non-blocking strided put/get operations for sized data
+ *
+ * shmemx_[ctx_]iputSIZE_nbi() and shmemx_[ctx_]igetSIZE_nbi() for
+ * SIZE in 8, 16, 32, 64, 128 bits.
+ */
+#define API_DECL_SHMEMX_IPUTGET_SIZE_NBI(_opname, _size)                       \
+  void shmemx_ctx_i##_opname##_size##_nbi(shmem_ctx_t ctx, void *dest,         \
+                                          const void *src, ptrdiff_t tst,      \
+                                          ptrdiff_t sst, size_t nelems,        \
+                                          int pe);                             \
+  void shmemx_i##_opname##_size##_nbi(void *dest, const void *src,             \
+                                      ptrdiff_t tst, ptrdiff_t sst,            \
+                                      size_t nelems, int pe);
+
+API_DECL_SHMEMX_IPUTGET_SIZE_NBI(put, 8)
+API_DECL_SHMEMX_IPUTGET_SIZE_NBI(put, 16)
+API_DECL_SHMEMX_IPUTGET_SIZE_NBI(put, 32)
+API_DECL_SHMEMX_IPUTGET_SIZE_NBI(put, 64)
+API_DECL_SHMEMX_IPUTGET_SIZE_NBI(put, 128)
+
+API_DECL_SHMEMX_IPUTGET_SIZE_NBI(get, 8)
+API_DECL_SHMEMX_IPUTGET_SIZE_NBI(get, 16)
+API_DECL_SHMEMX_IPUTGET_SIZE_NBI(get, 32)
+API_DECL_SHMEMX_IPUTGET_SIZE_NBI(get, 64)
+API_DECL_SHMEMX_IPUTGET_SIZE_NBI(get, 128)
+
+#undef API_DECL_SHMEMX_IPUTGET_SIZE_NBI
+
+/** @} */
+
+/**
+ * @defgroup shmemx_nbx Handle-based Put/Get
+ * @brief Non-blocking transfers that each complete independently
+ * @{
+ */
+
+/**
+ * @brief Handle for an outstanding put/get.  NULL means complete.
+ */
+typedef struct shmemx_handle *shmemx_handle_t;
+
+/**
+ * @brief Declares handle-based put/get operations for typed data
+ *
+ * shmemx_[ctx_]TYPENAME_put_nbx() and shmemx_[ctx_]TYPENAME_get_nbx()
+ * take the same arguments as shmem_[ctx_]TYPENAME_put_nbi() etc. and
+ * return a handle for just that operation.  A put completes when the
+ * source can be reused (remote visibility still needs a quiet), a get
+ * when the data has arrived.
+ */
+#define API_DECL_SHMEMX_PUTGET_NBX(_opname, _typename, _type)                  \
+  shmemx_handle_t shmemx_ctx_##_typename##_##_opname##_nbx(                    \
+      shmem_ctx_t ctx, _type *dest, const _type *src, size_t nelems, int pe);  \
+  shmemx_handle_t shmemx_##_typename##_##_opname##_nbx(                        \
+      _type *dest, const _type *src, size_t nelems, int pe);
+
+#define DECL_SHMEMX_PUT_NBX(_type, _typename)                                  \
+  API_DECL_SHMEMX_PUTGET_NBX(put, _typename, _type)
+SHMEM_STANDARD_RMA_TYPE_TABLE(DECL_SHMEMX_PUT_NBX)
+#undef DECL_SHMEMX_PUT_NBX
+
+#define DECL_SHMEMX_GET_NBX(_type, _typename)                                  \
+  API_DECL_SHMEMX_PUTGET_NBX(get, _typename, _type)
+SHMEM_STANDARD_RMA_TYPE_TABLE(DECL_SHMEMX_GET_NBX)
+#undef DECL_SHMEMX_GET_NBX
+
+#undef API_DECL_SHMEMX_PUTGET_NBX
+
+/**
+ * @brief Handle-based put/get of "nbytes" bytes
+ */
+shmemx_handle_t shmemx_ctx_putmem_nbx(shmem_ctx_t ctx, void *dest,
+                                      const void *src, size_t nbytes, int pe);
+shmemx_handle_t shmemx_putmem_nbx(void *dest, const void *src, size_t nbytes,
+                                  int pe);
+shmemx_handle_t shmemx_ctx_getmem_nbx(shmem_ctx_t ctx, void *dest,
+                                      const void *src, size_t nbytes, int pe);
+shmemx_handle_t shmemx_getmem_nbx(void *dest, const void *src, size_t nbytes,
+                                  int pe);
+
+/**
+ * @brief Check whether an operation has completed, without blocking
+ *
+ * @param hp Pointer to handle; set to NULL on completion
+ * @return Non-zero if complete, 0 otherwise
+ */
+int shmemx_test(shmemx_handle_t *hp);
+
+/**
+ * @brief Wait for an operation to complete
+ *
+ * @param hp Pointer to handle; set to NULL on return
+ */
+void shmemx_wait(shmemx_handle_t *hp);
+
+/**
+ * @brief Wait for all of an array of operations to complete
+ *
+ * @param hs Array of handles; all set to NULL on return
+ * @param n Number of handles
+ */
+void shmemx_waitall(shmemx_handle_t *hs, size_t n);
+
+/**
+ * @brief Check whether any outstanding operation in an array has
+ * completed, without blocking
+ *
+ * @param hs Array of handles; NULL entries are skipped
+ * @param n Number of handles
+ * @param idx Set to the index of a completed handle, which is then
+ *            set to NULL
+ * @return Non-zero if one completed, 0 if none did
+ */
+int shmemx_testany(shmemx_handle_t *hs, size_t n, size_t *idx);
+
+/** @} */
+
+/**
+ * @defgroup shmemx_vectored Vectored Put/Get
+ * @brief Many contiguous transfers, to any PEs, in one call
+ * @{
+ */
+
+/**
+ * @brief One transfer.  For puts "dest" is the symmetric address on
+ * "pe", for gets "src" is.
+ */
+typedef struct shmemx_xfer {
+  void *dest;      /**< where the data goes */
+  const void *src; /**< where the data comes from */
+  size_t nbytes;   /**< how much (bytes) */
+  int pe;          /**< remote PE */
+} shmemx_xfer_t;
+
+/**
+ * @brief Put/get every transfer in an array
+ *
+ * Transfers are grouped by PE internally and issued back-to-back;
+ * their relative order is unspecified.  The blocking versions return
+ * when all transfers have completed as for shmem_putmem() and
+ * shmem_getmem(), the _nbi versions complete at the next quiet.
+ *
+ * @param ctx Context for the transfers
+ * @param xs Array of transfers
+ * @param n Number of transfers
+ */
+void shmemx_ctx_putv(shmem_ctx_t ctx, const shmemx_xfer_t *xs, size_t n);
+void shmemx_putv(const shmemx_xfer_t *xs, size_t n);
+void shmemx_ctx_getv(shmem_ctx_t ctx, const shmemx_xfer_t *xs, size_t n);
+void shmemx_getv(const shmemx_xfer_t *xs, size_t n);
+void shmemx_ctx_putv_nbi(shmem_ctx_t ctx, const shmemx_xfer_t *xs, size_t n);
+void shmemx_putv_nbi(const shmemx_xfer_t *xs, size_t n);
+void shmemx_ctx_getv_nbi(shmem_ctx_t ctx, const shmemx_xfer_t *xs, size_t n);
+void shmemx_getv_nbi(const shmemx_xfer_t *xs, size_t n);
+
+/** @} */
+
+/**
+ * @defgroup shmemx_counters Completion Counters
+ * @brief Count completions of tagged non-blocking operations
+ * @{
+ */
+
+/**
+ * @brief Completion counter, tied to the context it was created on
+ */
+typedef struct shmemx_ctx_counter *shmemx_ctx_counter_t;
+
+/**
+ * @brief Create a counter, starting at 0, for operations on a context
+ *
+ * @param ctx Context the counted operations will use
+ * @param counter Set to the new counter
+ * @return 0 on success, non-zero otherwise
+ */
+int shmemx_ctx_counter_create(shmem_ctx_t ctx, shmemx_ctx_counter_t *counter);
+
+/**
+ * @brief Destroy a counter.  Quiets its context first.
+ *
+ * @param counter Counter to destroy
+ */
+void shmemx_ctx_counter_destroy(shmemx_ctx_counter_t counter);
+
+/**
+ * @brief Current value of a counter
+ *
+ * @param counter Counter to read
+ * @return Number of counted operations completed so far
+ */
+uint64_t shmemx_ctx_counter_read(shmemx_ctx_counter_t counter);
+
+/**
+ * @brief Wait until a counter reaches at least "n"
+ *
+ * @param counter Counter to wait on
+ * @param n Value to wait for
+ */
+void shmemx_counter_wait(shmemx_ctx_counter_t counter, uint64_t n);
+
+/**
+ * @brief Check whether a counter has reached at least "n", without
+ * blocking
+ *
+ * @param counter Counter to test
+ * @param n Value to test for
+ * @return Non-zero if reached, 0 otherwise
+ */
+int shmemx_counter_test(shmemx_ctx_counter_t counter, uint64_t n);
+
+/**
+ * @brief Declares counted non-blocking put/get operations
+ *
+ * shmemx_TYPENAME_put_nbi_ct() and shmemx_TYPENAME_get_nbi_ct() are
+ * shmem_ctx_TYPENAME_put_nbi() etc. on the counter's context, taking
+ * the counter in place of the context.  The counter goes up by 1 when
+ * a put is complete at the target PE, or when a get's data has
+ * arrived.  A quiet on the context completes them as usual.
+ */
+#define API_DECL_SHMEMX_PUTGET_NBI_CT(_opname, _typename, _type)               \
+  void shmemx_##_typename##_##_opname##_nbi_ct(shmemx_ctx_counter_t counter,   \
+                                               _type *dest, const _type *src,  \
+                                               size_t nelems, int pe);
+
+#define DECL_SHMEMX_PUT_NBI_CT(_type, _typename)                               \
+  API_DECL_SHMEMX_PUTGET_NBI_CT(put, _typename, _type)
+SHMEM_STANDARD_RMA_TYPE_TABLE(DECL_SHMEMX_PUT_NBI_CT)
+#undef DECL_SHMEMX_PUT_NBI_CT
+
+#define DECL_SHMEMX_GET_NBI_CT(_type, _typename)                               \
+  API_DECL_SHMEMX_PUTGET_NBI_CT(get, _typename, _type)
+SHMEM_STANDARD_RMA_TYPE_TABLE(DECL_SHMEMX_GET_NBI_CT)
+#undef DECL_SHMEMX_GET_NBI_CT
+
+#undef API_DECL_SHMEMX_PUTGET_NBI_CT
+
+/**
+ * @brief Counted non-blocking put/get of "nbytes" bytes
+ */
+void shmemx_putmem_nbi_ct(shmemx_ctx_counter_t counter, void *dest,
+                          const void *src, size_t nbytes, int pe);
+void shmemx_getmem_nbi_ct(shmemx_ctx_counter_t counter, void *dest,
+                          const void *src, size_t nbytes, int pe);
+
+/**
+ * @brief Declares counted atomic add operations
+ *
+ * shmemx_TYPENAME_atomic_add_ct() counts once the add has been done
+ * at the target PE, shmemx_TYPENAME_atomic_fetch_add_nbi_ct() once
+ * the old value is in "fetch".
+ */
+#define API_DECL_SHMEMX_ADD_CT(_type, _typename)                               \
+  void shmemx_##_typename##_atomic_add_ct(shmemx_ctx_counter_t counter,        \
+                                          _type *dest, _type value, int pe);   \
+  void shmemx_##_typename##_atomic_fetch_add_nbi_ct(                           \
+      shmemx_ctx_counter_t counter, _type *fetch, _type *dest, _type value,    \
+      int pe);
+
+SHMEM_STANDARD_AMO_TYPE_TABLE(API_DECL_SHMEMX_ADD_CT)
+
+#undef API_DECL_SHMEMX_ADD_CT
+
+/** @} */
+
+/**
+ * @defgroup shmemx_amo_ext Extended Atomics
+ * @brief Atomics beyond the standard set
+ *
+ * UCX can't do these natively.  Where it supports active messages,
+ * the operation is sent to the target PE and applied there in one
+ * round trip, so the target has to make progress (e.g. a progress
+ * thread, or calling into the library).  Otherwise min/max and
+ * floating-point add are emulated with compare-and-swap.
+ *
+ * They are atomic with respect to each other.  They are atomic with
+ * respect to the standard atomics on the same location only if UCX
+ * also uses the CPU for those (see SHMEM_AM_AMO).
+ * @{
+ */
+
+/**
+ * @brief Declares atomic fetch-min/max
+ *
+ * shmemx_TYPENAME_atomic_fetch_min() sets "dest" on "pe" to the
+ * smaller of its value and "value", and returns the old value.
+ * fetch_max likewise with the larger.
+ */
+#define API_DECL_SHMEMX_FETCH_MINMAX(_type, _typename)                         \
+  _type shmemx_ctx_##_typename##_atomic_fetch_min(                             \
+      shmem_ctx_t ctx, _type *dest, _type value, int pe);                      \
+  _type shmemx_##_typename##_atomic_fetch_min(_type *dest, _type value,        \
+                                              int pe);                         \
+  _type shmemx_ctx_##_typename##_atomic_fetch_max(                             \
+      shmem_ctx_t ctx, _type *dest, _type value, int pe);                      \
+  _type shmemx_##_typename##_atomic_fetch_max(_type *dest, _type value,        \
+                                              int pe);
+
+SHMEM_STANDARD_AMO_TYPE_TABLE(API_DECL_SHMEMX_FETCH_MINMAX)
+
+#undef API_DECL_SHMEMX_FETCH_MINMAX
+
+/**
+ * @brief Declares floating-point atomic add and fetch-add
+ *
+ * The non-fetching add returns without waiting, a quiet completes it.
+ */
+#define API_DECL_SHMEMX_FLOAT_ADD(_type, _typename)                            \
+  _type shmemx_ctx_##_typename##_atomic_fetch_add(                             \
+      shmem_ctx_t ctx, _type *dest, _type value, int pe);                      \
+  _type shmemx_##_typename##_atomic_fetch_add(_type *dest, _type value,        \
+                                              int pe);                         \
+  void shmemx_ctx_##_typename##_atomic_add(shmem_ctx_t ctx, _type *dest,       \
+                                           _type value, int pe);               \
+  void shmemx_##_typename##_atomic_add(_type *dest, _type value, int pe);
+
+API_DECL_SHMEMX_FLOAT_ADD(float, float)
+API_DECL_SHMEMX_FLOAT_ADD(double, double)
+
+#undef API_DECL_SHMEMX_FLOAT_ADD
+
+/**
+ * @brief 128-bit unsigned integer, as two 64-bit halves
+ */
+typedef struct shmemx_uint128 {
+  uint64_t lo; /**< least significant half */
+  uint64_t hi; /**< most significant half */
+} shmemx_uint128_t;
+
+/**
+ * @brief 128-bit atomic compare-and-swap
+ *
+ * If "dest" on "pe" equals "cond", replace it with "value".  Always
+ * returns the old value.  "dest" must be 16-byte aligned.  Needs UCX
+ * active messages, unless "pe" is the calling PE.
+ *
+ * @param ctx Context to use
+ * @param dest Symmetric address of the target
+ * @param cond Value to compare with
+ * @param value Value to swap in
+ * @param pe Target PE
+ * @return Old value of "dest"
+ */
+shmemx_uint128_t shmemx_ctx_uint128_atomic_compare_swap(shmem_ctx_t ctx,
+                                                        shmemx_uint128_t *dest,
+                                                        shmemx_uint128_t cond,
+                                                        shmemx_uint128_t value,
+                                                        int pe);
+shmemx_uint128_t shmemx_uint128_atomic_compare_swap(shmemx_uint128_t *dest,
+                                                    shmemx_uint128_t cond,
+                                                    shmemx_uint128_t value,
+                                                    int pe);
+
+/** @} */
+
+/**
+ * @defgroup shmemx_amo_batched Batched Atomics
+ * @brief Atomic adds to many PEs in one call
+ * @{
+ */
+
+/**
+ * @brief Declares batched atomic add and fetch-add
+ *
+ * Element i adds "value[i]" to "dest[i]" (symmetric) on "pe[i]".  All
+ * the adds are issued before waiting for any.
+ * shmemx_TYPENAME_atomic_fetch_add_v() returns once every old value
+ * is in "fetch[i]"; shmemx_TYPENAME_atomic_add_v() returns at once,
+ * and the adds complete at the next quiet.
+ *
+ * Each add is atomic; the order they happen in is unspecified.
+ */
+#define API_DECL_SHMEMX_ADD_V(_type, _typename)                                \
+  void shmemx_ctx_##_typename##_atomic_fetch_add_v(                            \
+      shmem_ctx_t ctx, _type *fetch, _type *const *dest, const _type *value,   \
+      const int *pe, size_t n);                                                \
+  void shmemx_##_typename##_atomic_fetch_add_v(                                \
+      _type *fetch, _type *const *dest, const _type *value, const int *pe,     \
+      size_t n);                                                               \
+  void shmemx_ctx_##_typename##_atomic_add_v(                                  \
+      shmem_ctx_t ctx, _type *const *dest, const _type *value, const int *pe,  \
+      size_t n);                                                               \
+  void shmemx_##_typename##_atomic_add_v(_type *const *dest,                   \
+                                         const _type *value, const int *pe,    \
+                                         size_t n);
+
+SHMEM_STANDARD_AMO_TYPE_TABLE(API_DECL_SHMEMX_ADD_V)
+
+#undef API_DECL_SHMEMX_ADD_V
+
+/** @} */
+
+/**
+ * @defgroup shmemx_combining Combining Counters
+ * @brief Shared counters that don't serialize on their owner
+ *
+ * Fetch-adds are combined within each node, then up a tree of nodes,
+ * so only one combined add per batch reaches the owning PE; the range
+ * it gets back is split up again on the way down.  Every caller still
+ * gets distinct values, as from shmem_atomic_fetch_add() on a single
+ * location, but the owner sees far fewer requests.
+ *
+ * The counter value is only changed through these calls.
+ * @{
+ */
+
+/**
+ * @brief Combining counter
+ */
+typedef struct shmemx_combining_counter *shmemx_combining_counter_t;
+
+/**
+ * @brief Create a counter.  Collective over all PEs.
+ *
+ * @param owner PE holding the value
+ * @param value Starting value
+ * @param counter Set to the new counter
+ * @return 0 on success, non-zero otherwise
+ */
+int shmemx_combining_counter_create(int owner, uint64_t value,
+                                    shmemx_combining_counter_t *counter);
+
+/**
+ * @brief Destroy a counter.  Collective over all PEs.
+ *
+ * @param counter Counter to destroy
+ */
+void shmemx_combining_counter_destroy(shmemx_combining_counter_t counter);
+
+/**
+ * @brief Add to a counter, returning the value before the add
+ *
+ * Adds of 2^16 or more are not combined.
+ *
+ * @param counter Counter to add to
+ * @param value Amount to add
+ * @return Old value
+ */
+uint64_t shmemx_combining_counter_fetch_add(shmemx_combining_counter_t counter,
+                                            uint64_t value);
+
+/**
+ * @brief Add 1 to a counter, returning the value before the add
+ *
+ * @param counter Counter to increment
+ * @return Old value
+ */
+uint64_t shmemx_combining_counter_fetch_inc(shmemx_combining_counter_t counter);
+
+/**
+ * @brief Current value of a counter at its owner
+ *
+ * @param counter Counter to read
+ * @return Value (adds still being combined aren't in it yet)
+ */
+uint64_t shmemx_combining_counter_read(shmemx_combining_counter_t counter);
+
+/** @} */
+
+/**
+ * @defgroup shmemx_ctx_aggregate Small-message Aggregation
+ * @brief Extra context option to batch small puts and AMOs
+ * @{
+ */
+
+/**
+ * @brief Context option, OR into shmem_ctx_create()'s options
+ *
+ * Small blocking/non-blocking puts and non-fetching AMOs on the
+ * context are copied into a buffer per destination PE and sent as
+ * one message when the buffer fills, after SHMEM_AGGREGATE_TIMEOUT,
+ * or at the next fence, quiet or barrier.  Operations complete
+ * locally at once, remotely only after a quiet.
+ */
+enum shmemx_ctx_options {
+  SHMEMX_CTX_AGGREGATE = SHMEM_BIT_SET(16) /**< aggregate small ops */
+};
+
+/** @} */
+
+/**
+ * @defgroup shmemx_rwlock Reader-Writer Locks
+ * @brief Distributed locks that let readers in together
+ *
+ * Readers get in with a single atomic on the lock's owner PE unless a
+ * writer holds or is waiting for the lock; only then do they queue.
+ * Writers queue as for shmem_set_lock() and have the lock to
+ * themselves.
+ * @{
+ */
+
+/**
+ * @brief Reader-writer lock.  Must be symmetric and start zeroed.
+ */
+typedef struct shmemx_rwlock {
+  long wlock;          /**< queues writers */
+  unsigned long state; /**< readers in, writer flag */
+} shmemx_rwlock_t;
+
+/**
+ * @brief Take a lock for reading
+ *
+ * @param rw Lock to take
+ */
+void shmemx_rwlock_read_lock(shmemx_rwlock_t *rw);
+
+/**
+ * @brief Release a lock taken for reading
+ *
+ * @param rw Lock to release
+ */
+void shmemx_rwlock_read_unlock(shmemx_rwlock_t *rw);
+
+/**
+ * @brief Take a lock for writing
+ *
+ * @param rw Lock to take
+ */
+void shmemx_rwlock_write_lock(shmemx_rwlock_t *rw);
+
+/**
+ * @brief Release a lock taken for writing
+ *
+ * @param rw Lock to release
+ */
+void shmemx_rwlock_write_unlock(shmemx_rwlock_t *rw);
+
+/** @} */
+
+/**
+ * @defgroup shmemx_cohort Cohort Locks
+ * @brief Distributed locks that stay on a node while they can
+ *
+ * A cohort lock is handed straight to another PE on the same node
+ * when one is waiting, up to SHMEM_COHORT_PASSES times in a row,
+ * before PEs on other nodes get a turn.  Under contention, most
+ * hand-offs then stay on the node.
+ * @{
+ */
+
+/**
+ * @brief Cohort lock.  Must be symmetric and start zeroed.
+ */
+typedef struct shmemx_cohort_lock {
+  long local;            /**< queue of PEs on this node */
+  unsigned long ticket;  /**< next ticket for the global lock */
+  unsigned long serving; /**< ticket holding the global lock */
+  unsigned long passes;  /**< node holds the global lock, hand-offs */
+} shmemx_cohort_lock_t;
+
+/**
+ * @brief Take a cohort lock
+ *
+ * @param lk Lock to take
+ */
+void shmemx_cohort_set_lock(shmemx_cohort_lock_t *lk);
+
+/**
+ * @brief Release a cohort lock
+ *
+ * @param lk Lock to release
+ */
+void shmemx_cohort_clear_lock(shmemx_cohort_lock_t *lk);
+
+/** @} */
+
+/**
+ * @defgroup shmemx_wait_policy Wait Policies
+ * @brief What point-to-point waits do after spinning, per context
+ *
+ * Waits spin for SHMEM_WAIT_SPIN nanoseconds, then follow a policy
+ * until the condition holds.  SHMEM_WAIT_POLICY sets it for
+ * everyone; a context can choose its own.
+ * @{
+ */
+
+/**
+ * @brief Wait policies
+ */
+enum shmemx_wait_policy {
+  SHMEMX_WAIT_DEFAULT = 0, /**< whatever SHMEM_WAIT_POLICY says */
+  SHMEMX_WAIT_SPIN,        /**< keep spinning with a CPU pause */
+  SHMEMX_WAIT_YIELD,       /**< yield the CPU between checks (default) */
+  SHMEMX_WAIT_BACKOFF,     /**< sleep between checks, doubling up to 1ms */
+  SHMEMX_WAIT_EVENT        /**< sleep on the network wakeup event
+                              (yield unless SHMEM_WAIT_POLICY or
+                              SHMEM_PROGRESS_MODE is "event") */
+};
+
+/**
+ * @brief What a context's waits have done
+ */
+typedef struct shmemx_wait_stats {
+  uint64_t waits;   /**< waits that didn't succeed at once */
+  uint64_t spins;   /**< checks in the spin phase */
+  uint64_t yields;  /**< CPU yields */
+  uint64_t naps;    /**< backoff sleeps */
+  uint64_t sleeps;  /**< sleeps on the wakeup event */
+  uint64_t wakeups; /**< ...cut short by an event */
+} shmemx_wait_stats_t;
+
+/**
+ * @brief Set a context's wait policy
+ *
+ * @param ctx Context whose waits to change
+ * @param policy One of enum shmemx_wait_policy
+ * @return 0 on success, non-zero if policy isn't one
+ */
+int shmemx_ctx_set_wait_policy(shmem_ctx_t ctx, int policy);
+
+/**
+ * @brief Read a context's wait counters
+ *
+ * @param ctx Context to look at
+ * @param stats Filled in with the counters
+ */
+void shmemx_ctx_get_wait_stats(shmem_ctx_t ctx, shmemx_wait_stats_t *stats);
+
+/**
+ * @brief Zero a context's wait counters
+ *
+ * @param ctx Context to reset
+ */
+void shmemx_ctx_reset_wait_stats(shmem_ctx_t ctx);
+
 /** @} */
 
 /**
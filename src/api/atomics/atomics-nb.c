@@ -460,7 +460,7 @@ SHMEM_STANDARD_AMO_TYPE_TABLE(API_DEF_AMO2_NBI_AND_HELPER)
 #define SHMEM_CTX_TYPE_FETCH_BITWISE_NBI(_opname, _name, _type)                \
   void shmem_ctx_##_name##_atomic_fetch_##_opname##_nbi(                       \
       shmem_ctx_t ctx, _type *fetch, _type *target, _type value, int pe) {     \
-    SHMEMT_MUTEX_NOPROTECT(shmemc_ctx_fetch_##_opname(                         \
+    SHMEMT_MUTEX_NOPROTECT(shmemc_ctx_fetch_##_opname##_nbi(                   \
         ctx, target, &value, sizeof(value), pe, fetch));                       \
   }
 
@@ -14,6 +14,7 @@
 
 #include "thispe.h"
 #include "shmemu.h"
+#include "shmemc.h"
 #include "collectives/table.h"
 #include "shmem/teams.h"
 
@@ -1396,6 +1397,9 @@ extern long *shmemc_sync_all_psync;
 void shmem_barrier_all(void) {
   logger(LOG_COLLECTIVES, "%s()", __func__);
 
+  /* get aggregated ops moving before we block */
+  shmemc_aggr_flush_all();
+
   colls.barrier_all.f(shmemc_barrier_all_psync);
 }
 
@@ -1463,6 +1467,8 @@ void shmem_barrier(int PE_start, int logPE_stride, int PE_size, long *pSync) {
   logger(LOG_COLLECTIVES, "%s(%d, %d, %zu, %p)", __func__, PE_start,
          logPE_stride, PE_size, pSync);
 
+  shmemc_aggr_flush_all();
+
   colls.barrier.f(PE_start, logPE_stride, PE_size, pSync);
 }
 
@@ -0,0 +1,505 @@
+/* For license: see LICENSE file at top-level */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif /* HAVE_CONFIG_H */
+
+#include "shmemu.h"
+#include "shmemc.h"
+#include "shmem_mutex.h"
+#include "shmemx.h"
+
+#include <shmem/api_types.h>
+
+/*
+ * Atomics UCX doesn't have: done at the target by active message
+ * where possible (see shmemc_ctx_amo_ext()).  And batched adds to
+ * many PEs.
+ */
+
+/*
+ * -- fetch-min/max --
+ */
+
+/*
+ * the standard AMO types, with how the target compares them
+ */
+#define SHMEMX_MINMAX_TYPE_TABLE(X)                                            \
+  X(int, int, INT)                                                             \
+  X(long, long, INT)                                                           \
+  X(long long, longlong, INT)                                                  \
+  X(unsigned int, uint, UINT)                                                  \
+  X(unsigned long, ulong, UINT)                                                \
+  X(unsigned long long, ulonglong, UINT)                                       \
+  X(int32_t, int32, INT)                                                       \
+  X(int64_t, int64, INT)                                                       \
+  X(uint32_t, uint32, UINT)                                                    \
+  X(uint64_t, uint64, UINT)                                                    \
+  X(size_t, size, UINT)                                                        \
+  X(ptrdiff_t, ptrdiff, INT)
+
+#define SHMEMX_CTX_TYPED_FETCH_MINMAX(_opname, _OP, _name, _type, _ext)        \
+  _type shmemx_ctx_##_name##_atomic_fetch_##_opname(                           \
+      shmem_ctx_t ctx, _type *dest, _type value, int pe) {                     \
+    _type v;                                                                   \
+                                                                               \
+    SHMEMU_CHECK_INIT();                                                       \
+    SHMEMU_CHECK_PE_ARG_RANGE(pe, 4);                                          \
+    SHMEMU_CHECK_SYMMETRIC(dest, 2);                                           \
+                                                                               \
+    logger(LOG_ATOMICS, "%s(ctx=%lu, dest=%p, pe=%d)", __func__,               \
+           shmemc_context_id(ctx), dest, pe);                                  \
+                                                                               \
+    SHMEMT_MUTEX_NOPROTECT(shmemc_ctx_amo_ext(                                 \
+        ctx, SHMEMC_AMO_EXT_##_OP, SHMEMC_AMO_EXT_##_ext, dest, &value, NULL,  \
+        sizeof(value), pe, &v));                                               \
+                                                                               \
+    return v;                                                                  \
+  }                                                                            \
+                                                                               \
+  _type shmemx_##_name##_atomic_fetch_##_opname(_type *dest, _type value,      \
+                                                int pe) {                      \
+    return shmemx_ctx_##_name##_atomic_fetch_##_opname(SHMEM_CTX_DEFAULT,      \
+                                                       dest, value, pe);       \
+  }
+
+#ifdef ENABLE_PSHMEM
+#pragma weak shmemx_ctx_int_atomic_fetch_min = pshmemx_ctx_int_atomic_fetch_min
+#define shmemx_ctx_int_atomic_fetch_min pshmemx_ctx_int_atomic_fetch_min
+#pragma weak shmemx_int_atomic_fetch_min = pshmemx_int_atomic_fetch_min
+#define shmemx_int_atomic_fetch_min pshmemx_int_atomic_fetch_min
+#pragma weak shmemx_ctx_long_atomic_fetch_min =                                \
+    pshmemx_ctx_long_atomic_fetch_min
+#define shmemx_ctx_long_atomic_fetch_min pshmemx_ctx_long_atomic_fetch_min
+#pragma weak shmemx_long_atomic_fetch_min = pshmemx_long_atomic_fetch_min
+#define shmemx_long_atomic_fetch_min pshmemx_long_atomic_fetch_min
+#pragma weak shmemx_ctx_longlong_atomic_fetch_min =                            \
+    pshmemx_ctx_longlong_atomic_fetch_min
+#define shmemx_ctx_longlong_atomic_fetch_min                                   \
+    pshmemx_ctx_longlong_atomic_fetch_min
+#pragma weak shmemx_longlong_atomic_fetch_min =                                \
+    pshmemx_longlong_atomic_fetch_min
+#define shmemx_longlong_atomic_fetch_min pshmemx_longlong_atomic_fetch_min
+#pragma weak shmemx_ctx_uint_atomic_fetch_min =                                \
+    pshmemx_ctx_uint_atomic_fetch_min
+#define shmemx_ctx_uint_atomic_fetch_min pshmemx_ctx_uint_atomic_fetch_min
+#pragma weak shmemx_uint_atomic_fetch_min = pshmemx_uint_atomic_fetch_min
+#define shmemx_uint_atomic_fetch_min pshmemx_uint_atomic_fetch_min
+#pragma weak shmemx_ctx_ulong_atomic_fetch_min =                               \
+    pshmemx_ctx_ulong_atomic_fetch_min
+#define shmemx_ctx_ulong_atomic_fetch_min pshmemx_ctx_ulong_atomic_fetch_min
+#pragma weak shmemx_ulong_atomic_fetch_min = pshmemx_ulong_atomic_fetch_min
+#define shmemx_ulong_atomic_fetch_min pshmemx_ulong_atomic_fetch_min
+#pragma weak shmemx_ctx_ulonglong_atomic_fetch_min =                           \
+    pshmemx_ctx_ulonglong_atomic_fetch_min
+#define shmemx_ctx_ulonglong_atomic_fetch_min                                  \
+    pshmemx_ctx_ulonglong_atomic_fetch_min
+#pragma weak shmemx_ulonglong_atomic_fetch_min =                               \
+    pshmemx_ulonglong_atomic_fetch_min
+#define shmemx_ulonglong_atomic_fetch_min pshmemx_ulonglong_atomic_fetch_min
+#pragma weak shmemx_ctx_int32_atomic_fetch_min =                               \
+    pshmemx_ctx_int32_atomic_fetch_min
+#define shmemx_ctx_int32_atomic_fetch_min pshmemx_ctx_int32_atomic_fetch_min
+#pragma weak shmemx_int32_atomic_fetch_min = pshmemx_int32_atomic_fetch_min
+#define shmemx_int32_atomic_fetch_min pshmemx_int32_atomic_fetch_min
+#pragma weak shmemx_ctx_int64_atomic_fetch_min =                               \
+    pshmemx_ctx_int64_atomic_fetch_min
+#define shmemx_ctx_int64_atomic_fetch_min pshmemx_ctx_int64_atomic_fetch_min
+#pragma weak shmemx_int64_atomic_fetch_min = pshmemx_int64_atomic_fetch_min
+#define shmemx_int64_atomic_fetch_min pshmemx_int64_atomic_fetch_min
+#pragma weak shmemx_ctx_uint32_atomic_fetch_min =                              \
+    pshmemx_ctx_uint32_atomic_fetch_min
+#define shmemx_ctx_uint32_atomic_fetch_min pshmemx_ctx_uint32_atomic_fetch_min
+#pragma weak shmemx_uint32_atomic_fetch_min = pshmemx_uint32_atomic_fetch_min
+#define shmemx_uint32_atomic_fetch_min pshmemx_uint32_atomic_fetch_min
+#pragma weak shmemx_ctx_uint64_atomic_fetch_min =                              \
+    pshmemx_ctx_uint64_atomic_fetch_min
+#define shmemx_ctx_uint64_atomic_fetch_min pshmemx_ctx_uint64_atomic_fetch_min
+#pragma weak shmemx_uint64_atomic_fetch_min = pshmemx_uint64_atomic_fetch_min
+#define shmemx_uint64_atomic_fetch_min pshmemx_uint64_atomic_fetch_min
+#pragma weak shmemx_ctx_size_atomic_fetch_min =                                \
+    pshmemx_ctx_size_atomic_fetch_min
+#define shmemx_ctx_size_atomic_fetch_min pshmemx_ctx_size_atomic_fetch_min
+#pragma weak shmemx_size_atomic_fetch_min = pshmemx_size_atomic_fetch_min
+#define shmemx_size_atomic_fetch_min pshmemx_size_atomic_fetch_min
+#pragma weak shmemx_ctx_ptrdiff_atomic_fetch_min =                             \
+    pshmemx_ctx_ptrdiff_atomic_fetch_min
+#define shmemx_ctx_ptrdiff_atomic_fetch_min pshmemx_ctx_ptrdiff_atomic_fetch_min
+#pragma weak shmemx_ptrdiff_atomic_fetch_min = pshmemx_ptrdiff_atomic_fetch_min
+#define shmemx_ptrdiff_atomic_fetch_min pshmemx_ptrdiff_atomic_fetch_min
+#pragma weak shmemx_ctx_int_atomic_fetch_max = pshmemx_ctx_int_atomic_fetch_max
+#define shmemx_ctx_int_atomic_fetch_max pshmemx_ctx_int_atomic_fetch_max
+#pragma weak shmemx_int_atomic_fetch_max = pshmemx_int_atomic_fetch_max
+#define shmemx_int_atomic_fetch_max pshmemx_int_atomic_fetch_max
+#pragma weak shmemx_ctx_long_atomic_fetch_max =                                \
+    pshmemx_ctx_long_atomic_fetch_max
+#define shmemx_ctx_long_atomic_fetch_max pshmemx_ctx_long_atomic_fetch_max
+#pragma weak shmemx_long_atomic_fetch_max = pshmemx_long_atomic_fetch_max
+#define shmemx_long_atomic_fetch_max pshmemx_long_atomic_fetch_max
+#pragma weak shmemx_ctx_longlong_atomic_fetch_max =                            \
+    pshmemx_ctx_longlong_atomic_fetch_max
+#define shmemx_ctx_longlong_atomic_fetch_max                                   \
+    pshmemx_ctx_longlong_atomic_fetch_max
+#pragma weak shmemx_longlong_atomic_fetch_max =                                \
+    pshmemx_longlong_atomic_fetch_max
+#define shmemx_longlong_atomic_fetch_max pshmemx_longlong_atomic_fetch_max
+#pragma weak shmemx_ctx_uint_atomic_fetch_max =                                \
+    pshmemx_ctx_uint_atomic_fetch_max
+#define shmemx_ctx_uint_atomic_fetch_max pshmemx_ctx_uint_atomic_fetch_max
+#pragma weak shmemx_uint_atomic_fetch_max = pshmemx_uint_atomic_fetch_max
+#define shmemx_uint_atomic_fetch_max pshmemx_uint_atomic_fetch_max
+#pragma weak shmemx_ctx_ulong_atomic_fetch_max =                               \
+    pshmemx_ctx_ulong_atomic_fetch_max
+#define shmemx_ctx_ulong_atomic_fetch_max pshmemx_ctx_ulong_atomic_fetch_max
+#pragma weak shmemx_ulong_atomic_fetch_max = pshmemx_ulong_atomic_fetch_max
+#define shmemx_ulong_atomic_fetch_max pshmemx_ulong_atomic_fetch_max
+#pragma weak shmemx_ctx_ulonglong_atomic_fetch_max =                           \
+    pshmemx_ctx_ulonglong_atomic_fetch_max
+#define shmemx_ctx_ulonglong_atomic_fetch_max                                  \
+    pshmemx_ctx_ulonglong_atomic_fetch_max
+#pragma weak shmemx_ulonglong_atomic_fetch_max =                               \
+    pshmemx_ulonglong_atomic_fetch_max
+#define shmemx_ulonglong_atomic_fetch_max pshmemx_ulonglong_atomic_fetch_max
+#pragma weak shmemx_ctx_int32_atomic_fetch_max =                               \
+    pshmemx_ctx_int32_atomic_fetch_max
+#define shmemx_ctx_int32_atomic_fetch_max pshmemx_ctx_int32_atomic_fetch_max
+#pragma weak shmemx_int32_atomic_fetch_max = pshmemx_int32_atomic_fetch_max
+#define shmemx_int32_atomic_fetch_max pshmemx_int32_atomic_fetch_max
+#pragma weak shmemx_ctx_int64_atomic_fetch_max =                               \
+    pshmemx_ctx_int64_atomic_fetch_max
+#define shmemx_ctx_int64_atomic_fetch_max pshmemx_ctx_int64_atomic_fetch_max
+#pragma weak shmemx_int64_atomic_fetch_max = pshmemx_int64_atomic_fetch_max
+#define shmemx_int64_atomic_fetch_max pshmemx_int64_atomic_fetch_max
+#pragma weak shmemx_ctx_uint32_atomic_fetch_max =                              \
+    pshmemx_ctx_uint32_atomic_fetch_max
+#define shmemx_ctx_uint32_atomic_fetch_max pshmemx_ctx_uint32_atomic_fetch_max
+#pragma weak shmemx_uint32_atomic_fetch_max = pshmemx_uint32_atomic_fetch_max
+#define shmemx_uint32_atomic_fetch_max pshmemx_uint32_atomic_fetch_max
+#pragma weak shmemx_ctx_uint64_atomic_fetch_max =                              \
+    pshmemx_ctx_uint64_atomic_fetch_max
+#define shmemx_ctx_uint64_atomic_fetch_max pshmemx_ctx_uint64_atomic_fetch_max
+#pragma weak shmemx_uint64_atomic_fetch_max = pshmemx_uint64_atomic_fetch_max
+#define shmemx_uint64_atomic_fetch_max pshmemx_uint64_atomic_fetch_max
+#pragma weak shmemx_ctx_size_atomic_fetch_max =                                \
+    pshmemx_ctx_size_atomic_fetch_max
+#define shmemx_ctx_size_atomic_fetch_max pshmemx_ctx_size_atomic_fetch_max
+#pragma weak shmemx_size_atomic_fetch_max = pshmemx_size_atomic_fetch_max
+#define shmemx_size_atomic_fetch_max pshmemx_size_atomic_fetch_max
+#pragma weak shmemx_ctx_ptrdiff_atomic_fetch_max =                             \
+    pshmemx_ctx_ptrdiff_atomic_fetch_max
+#define shmemx_ctx_ptrdiff_atomic_fetch_max pshmemx_ctx_ptrdiff_atomic_fetch_max
+#pragma weak shmemx_ptrdiff_atomic_fetch_max = pshmemx_ptrdiff_atomic_fetch_max
+#define shmemx_ptrdiff_atomic_fetch_max pshmemx_ptrdiff_atomic_fetch_max
+#endif /* ENABLE_PSHMEM */
+
+#define SHMEMX_CTX_FETCH_MIN_HELPER(_type, _typename, _ext)                    \
+  SHMEMX_CTX_TYPED_FETCH_MINMAX(min, MIN, _typename, _type, _ext)
+SHMEMX_MINMAX_TYPE_TABLE(SHMEMX_CTX_FETCH_MIN_HELPER)
+#undef SHMEMX_CTX_FETCH_MIN_HELPER
+
+#define SHMEMX_CTX_FETCH_MAX_HELPER(_type, _typename, _ext)                    \
+  SHMEMX_CTX_TYPED_FETCH_MINMAX(max, MAX, _typename, _type, _ext)
+SHMEMX_MINMAX_TYPE_TABLE(SHMEMX_CTX_FETCH_MAX_HELPER)
+#undef SHMEMX_CTX_FETCH_MAX_HELPER
+
+#undef SHMEMX_CTX_TYPED_FETCH_MINMAX
+#undef SHMEMX_MINMAX_TYPE_TABLE
+
+/*
+ * -- floating-point add --
+ */
+
+#define SHMEMX_CTX_FLOAT_ADD(_name, _type)                                     \
+  _type shmemx_ctx_##_name##_atomic_fetch_add(shmem_ctx_t ctx, _type *dest,    \
+                                              _type value, int pe) {           \
+    _type v;                                                                   \
+                                                                               \
+    SHMEMU_CHECK_INIT();                                                       \
+    SHMEMU_CHECK_PE_ARG_RANGE(pe, 4);                                          \
+    SHMEMU_CHECK_SYMMETRIC(dest, 2);                                           \
+                                                                               \
+    logger(LOG_ATOMICS, "%s(ctx=%lu, dest=%p, pe=%d)", __func__,               \
+           shmemc_context_id(ctx), dest, pe);                                  \
+                                                                               \
+    SHMEMT_MUTEX_NOPROTECT(shmemc_ctx_amo_ext(                                 \
+        ctx, SHMEMC_AMO_EXT_ADD, SHMEMC_AMO_EXT_FLOAT, dest, &value, NULL,     \
+        sizeof(value), pe, &v));                                               \
+                                                                               \
+    return v;                                                                  \
+  }                                                                            \
+                                                                               \
+  _type shmemx_##_name##_atomic_fetch_add(_type *dest, _type value, int pe) {  \
+    return shmemx_ctx_##_name##_atomic_fetch_add(SHMEM_CTX_DEFAULT, dest,      \
+                                                 value, pe);                   \
+  }                                                                            \
+                                                                               \
+  void shmemx_ctx_##_name##_atomic_add(shmem_ctx_t ctx, _type *dest,           \
+                                       _type value, int pe) {                  \
+    SHMEMU_CHECK_INIT();                                                       \
+    SHMEMU_CHECK_PE_ARG_RANGE(pe, 4);                                          \
+    SHMEMU_CHECK_SYMMETRIC(dest, 2);                                           \
+                                                                               \
+    logger(LOG_ATOMICS, "%s(ctx=%lu, dest=%p, pe=%d)", __func__,               \
+           shmemc_context_id(ctx), dest, pe);                                  \
+                                                                               \
+    SHMEMT_MUTEX_NOPROTECT(shmemc_ctx_amo_ext(                                 \
+        ctx, SHMEMC_AMO_EXT_ADD, SHMEMC_AMO_EXT_FLOAT, dest, &value, NULL,     \
+        sizeof(value), pe, NULL));                                             \
+  }                                                                            \
+                                                                               \
+  void shmemx_##_name##_atomic_add(_type *dest, _type value, int pe) {         \
+    shmemx_ctx_##_name##_atomic_add(SHMEM_CTX_DEFAULT, dest, value, pe);       \
+  }
+
+#ifdef ENABLE_PSHMEM
+#pragma weak shmemx_ctx_float_atomic_fetch_add =                               \
+    pshmemx_ctx_float_atomic_fetch_add
+#define shmemx_ctx_float_atomic_fetch_add pshmemx_ctx_float_atomic_fetch_add
+#pragma weak shmemx_float_atomic_fetch_add = pshmemx_float_atomic_fetch_add
+#define shmemx_float_atomic_fetch_add pshmemx_float_atomic_fetch_add
+#pragma weak shmemx_ctx_float_atomic_add = pshmemx_ctx_float_atomic_add
+#define shmemx_ctx_float_atomic_add pshmemx_ctx_float_atomic_add
+#pragma weak shmemx_float_atomic_add = pshmemx_float_atomic_add
+#define shmemx_float_atomic_add pshmemx_float_atomic_add
+#pragma weak shmemx_ctx_double_atomic_fetch_add =                              \
+    pshmemx_ctx_double_atomic_fetch_add
+#define shmemx_ctx_double_atomic_fetch_add pshmemx_ctx_double_atomic_fetch_add
+#pragma weak shmemx_double_atomic_fetch_add = pshmemx_double_atomic_fetch_add
+#define shmemx_double_atomic_fetch_add pshmemx_double_atomic_fetch_add
+#pragma weak shmemx_ctx_double_atomic_add = pshmemx_ctx_double_atomic_add
+#define shmemx_ctx_double_atomic_add pshmemx_ctx_double_atomic_add
+#pragma weak shmemx_double_atomic_add = pshmemx_double_atomic_add
+#define shmemx_double_atomic_add pshmemx_double_atomic_add
+#endif /* ENABLE_PSHMEM */
+
+SHMEMX_CTX_FLOAT_ADD(float, float)
+SHMEMX_CTX_FLOAT_ADD(double, double)
+
+#undef SHMEMX_CTX_FLOAT_ADD
+
+/*
+ * -- 128-bit compare-and-swap --
+ */
+
+#ifdef ENABLE_PSHMEM
+#pragma weak shmemx_ctx_uint128_atomic_compare_swap =                          \
+    pshmemx_ctx_uint128_atomic_compare_swap
+#define shmemx_ctx_uint128_atomic_compare_swap                                 \
+    pshmemx_ctx_uint128_atomic_compare_swap
+#pragma weak shmemx_uint128_atomic_compare_swap =                              \
+    pshmemx_uint128_atomic_compare_swap
+#define shmemx_uint128_atomic_compare_swap pshmemx_uint128_atomic_compare_swap
+#endif /* ENABLE_PSHMEM */
+
+shmemx_uint128_t shmemx_ctx_uint128_atomic_compare_swap(shmem_ctx_t ctx,
+                                                        shmemx_uint128_t *dest,
+                                                        shmemx_uint128_t cond,
+                                                        shmemx_uint128_t value,
+                                                        int pe) {
+  shmemx_uint128_t v;
+
+  SHMEMU_CHECK_INIT();
+  SHMEMU_CHECK_PE_ARG_RANGE(pe, 5);
+  SHMEMU_CHECK_SYMMETRIC(dest, 2);
+
+  shmemu_assert(((uintptr_t)dest & 0xf) == 0,
+                "%s: target %p is not 16-byte aligned", __func__, dest);
+
+  logger(LOG_ATOMICS, "%s(ctx=%lu, dest=%p, pe=%d)", __func__,
+         shmemc_context_id(ctx), dest, pe);
+
+  SHMEMT_MUTEX_NOPROTECT(shmemc_ctx_amo_ext(ctx, SHMEMC_AMO_EXT_CSWAP,
+                                            SHMEMC_AMO_EXT_UINT, dest, &value,
+                                            &cond, sizeof(value), pe, &v));
+
+  return v;
+}
+
+shmemx_uint128_t shmemx_uint128_atomic_compare_swap(shmemx_uint128_t *dest,
+                                                    shmemx_uint128_t cond,
+                                                    shmemx_uint128_t value,
+                                                    int pe) {
+  return shmemx_ctx_uint128_atomic_compare_swap(SHMEM_CTX_DEFAULT, dest, cond,
+                                                value, pe);
+}
+
+/*
+ * -- batched adds --
+ */
+
+#define SHMEMX_CTX_TYPED_ADD_V(_name, _type)                                   \
+  void shmemx_ctx_##_name##_atomic_fetch_add_v(                                \
+      shmem_ctx_t ctx, _type *fetch, _type *const *dest, const _type *value,   \
+      const int *pe, size_t n) {                                               \
+    SHMEMU_CHECK_INIT();                                                       \
+    SHMEMU_CHECK_NOT_NULL(fetch, 2);                                           \
+    SHMEMU_CHECK_NOT_NULL(dest, 3);                                            \
+    SHMEMU_CHECK_NOT_NULL(value, 4);                                           \
+    SHMEMU_CHECK_NOT_NULL(pe, 5);                                              \
+                                                                               \
+    logger(LOG_ATOMICS, "%s(ctx=%lu, fetch=%p, dest=%p, value=%p, pe=%p, "     \
+                        "n=%lu)",                                              \
+           __func__, shmemc_context_id(ctx), fetch, dest, value, pe,           \
+           (unsigned long)n);                                                  \
+                                                                               \
+    SHMEMT_MUTEX_NOPROTECT(shmemc_ctx_fadd_v(ctx, (void *const *)dest, value,  \
+                                             sizeof(_type), pe, n, fetch));    \
+  }                                                                            \
+                                                                               \
+  void shmemx_##_name##_atomic_fetch_add_v(_type *fetch, _type *const *dest,   \
+                                           const _type *value, const int *pe,  \
+                                           size_t n) {                         \
+    shmemx_ctx_##_name##_atomic_fetch_add_v(SHMEM_CTX_DEFAULT, fetch, dest,    \
+                                            value, pe, n);                     \
+  }                                                                            \
+                                                                               \
+  void shmemx_ctx_##_name##_atomic_add_v(shmem_ctx_t ctx, _type *const *dest,  \
+                                         const _type *value, const int *pe,    \
+                                         size_t n) {                           \
+    SHMEMU_CHECK_INIT();                                                       \
+    SHMEMU_CHECK_NOT_NULL(dest, 2);                                            \
+    SHMEMU_CHECK_NOT_NULL(value, 3);                                           \
+    SHMEMU_CHECK_NOT_NULL(pe, 4);                                              \
+                                                                               \
+    logger(LOG_ATOMICS, "%s(ctx=%lu, dest=%p, value=%p, pe=%p, n=%lu)",        \
+           __func__, shmemc_context_id(ctx), dest, value, pe,                  \
+           (unsigned long)n);                                                  \
+                                                                               \
+    SHMEMT_MUTEX_NOPROTECT(shmemc_ctx_add_v(ctx, (void *const *)dest, value,   \
+                                            sizeof(_type), pe, n));            \
+  }                                                                            \
+                                                                               \
+  void shmemx_##_name##_atomic_add_v(_type *const *dest, const _type *value,   \
+                                     const int *pe, size_t n) {                \
+    shmemx_ctx_##_name##_atomic_add_v(SHMEM_CTX_DEFAULT, dest, value, pe, n);  \
+  }
+
+#ifdef ENABLE_PSHMEM
+#pragma weak shmemx_ctx_int_atomic_fetch_add_v =                               \
+    pshmemx_ctx_int_atomic_fetch_add_v
+#define shmemx_ctx_int_atomic_fetch_add_v pshmemx_ctx_int_atomic_fetch_add_v
+#pragma weak shmemx_int_atomic_fetch_add_v = pshmemx_int_atomic_fetch_add_v
+#define shmemx_int_atomic_fetch_add_v pshmemx_int_atomic_fetch_add_v
+#pragma weak shmemx_ctx_int_atomic_add_v = pshmemx_ctx_int_atomic_add_v
+#define shmemx_ctx_int_atomic_add_v pshmemx_ctx_int_atomic_add_v
+#pragma weak shmemx_int_atomic_add_v = pshmemx_int_atomic_add_v
+#define shmemx_int_atomic_add_v pshmemx_int_atomic_add_v
+#pragma weak shmemx_ctx_long_atomic_fetch_add_v =                              \
+    pshmemx_ctx_long_atomic_fetch_add_v
+#define shmemx_ctx_long_atomic_fetch_add_v pshmemx_ctx_long_atomic_fetch_add_v
+#pragma weak shmemx_long_atomic_fetch_add_v = pshmemx_long_atomic_fetch_add_v
+#define shmemx_long_atomic_fetch_add_v pshmemx_long_atomic_fetch_add_v
+#pragma weak shmemx_ctx_long_atomic_add_v = pshmemx_ctx_long_atomic_add_v
+#define shmemx_ctx_long_atomic_add_v pshmemx_ctx_long_atomic_add_v
+#pragma weak shmemx_long_atomic_add_v = pshmemx_long_atomic_add_v
+#define shmemx_long_atomic_add_v pshmemx_long_atomic_add_v
+#pragma weak shmemx_ctx_longlong_atomic_fetch_add_v =                          \
+    pshmemx_ctx_longlong_atomic_fetch_add_v
+#define shmemx_ctx_longlong_atomic_fetch_add_v                                 \
+    pshmemx_ctx_longlong_atomic_fetch_add_v
+#pragma weak shmemx_longlong_atomic_fetch_add_v =                              \
+    pshmemx_longlong_atomic_fetch_add_v
+#define shmemx_longlong_atomic_fetch_add_v pshmemx_longlong_atomic_fetch_add_v
+#pragma weak shmemx_ctx_longlong_atomic_add_v =                                \
+    pshmemx_ctx_longlong_atomic_add_v
+#define shmemx_ctx_longlong_atomic_add_v pshmemx_ctx_longlong_atomic_add_v
+#pragma weak shmemx_longlong_atomic_add_v = pshmemx_longlong_atomic_add_v
+#define shmemx_longlong_atomic_add_v pshmemx_longlong_atomic_add_v
+#pragma weak shmemx_ctx_uint_atomic_fetch_add_v =                              \
+    pshmemx_ctx_uint_atomic_fetch_add_v
+#define shmemx_ctx_uint_atomic_fetch_add_v pshmemx_ctx_uint_atomic_fetch_add_v
+#pragma weak shmemx_uint_atomic_fetch_add_v = pshmemx_uint_atomic_fetch_add_v
+#define shmemx_uint_atomic_fetch_add_v pshmemx_uint_atomic_fetch_add_v
+#pragma weak shmemx_ctx_uint_atomic_add_v = pshmemx_ctx_uint_atomic_add_v
+#define shmemx_ctx_uint_atomic_add_v pshmemx_ctx_uint_atomic_add_v
+#pragma weak shmemx_uint_atomic_add_v = pshmemx_uint_atomic_add_v
+#define shmemx_uint_atomic_add_v pshmemx_uint_atomic_add_v
+#pragma weak shmemx_ctx_ulong_atomic_fetch_add_v =                             \
+    pshmemx_ctx_ulong_atomic_fetch_add_v
+#define shmemx_ctx_ulong_atomic_fetch_add_v pshmemx_ctx_ulong_atomic_fetch_add_v
+#pragma weak shmemx_ulong_atomic_fetch_add_v = pshmemx_ulong_atomic_fetch_add_v
+#define shmemx_ulong_atomic_fetch_add_v pshmemx_ulong_atomic_fetch_add_v
+#pragma weak shmemx_ctx_ulong_atomic_add_v = pshmemx_ctx_ulong_atomic_add_v
+#define shmemx_ctx_ulong_atomic_add_v pshmemx_ctx_ulong_atomic_add_v
+#pragma weak shmemx_ulong_atomic_add_v = pshmemx_ulong_atomic_add_v
+#define shmemx_ulong_atomic_add_v pshmemx_ulong_atomic_add_v
+#pragma weak shmemx_ctx_ulonglong_atomic_fetch_add_v =                         \
+    pshmemx_ctx_ulonglong_atomic_fetch_add_v
+#define shmemx_ctx_ulonglong_atomic_fetch_add_v                                \
+    pshmemx_ctx_ulonglong_atomic_fetch_add_v
+#pragma weak shmemx_ulonglong_atomic_fetch_add_v =                             \
+    pshmemx_ulonglong_atomic_fetch_add_v
+#define shmemx_ulonglong_atomic_fetch_add_v pshmemx_ulonglong_atomic_fetch_add_v
+#pragma weak shmemx_ctx_ulonglong_atomic_add_v =                               \
+    pshmemx_ctx_ulonglong_atomic_add_v
+#define shmemx_ctx_ulonglong_atomic_add_v pshmemx_ctx_ulonglong_atomic_add_v
+#pragma weak shmemx_ulonglong_atomic_add_v = pshmemx_ulonglong_atomic_add_v
+#define shmemx_ulonglong_atomic_add_v pshmemx_ulonglong_atomic_add_v
+#pragma weak shmemx_ctx_int32_atomic_fetch_add_v =                             \
+    pshmemx_ctx_int32_atomic_fetch_add_v
+#define shmemx_ctx_int32_atomic_fetch_add_v pshmemx_ctx_int32_atomic_fetch_add_v
+#pragma weak shmemx_int32_atomic_fetch_add_v = pshmemx_int32_atomic_fetch_add_v
+#define shmemx_int32_atomic_fetch_add_v pshmemx_int32_atomic_fetch_add_v
+#pragma weak shmemx_ctx_int32_atomic_add_v = pshmemx_ctx_int32_atomic_add_v
+#define shmemx_ctx_int32_atomic_add_v pshmemx_ctx_int32_atomic_add_v
+#pragma weak shmemx_int32_atomic_add_v = pshmemx_int32_atomic_add_v
+#define shmemx_int32_atomic_add_v pshmemx_int32_atomic_add_v
+#pragma weak shmemx_ctx_int64_atomic_fetch_add_v =                             \
+    pshmemx_ctx_int64_atomic_fetch_add_v
+#define shmemx_ctx_int64_atomic_fetch_add_v pshmemx_ctx_int64_atomic_fetch_add_v
+#pragma weak shmemx_int64_atomic_fetch_add_v = pshmemx_int64_atomic_fetch_add_v
+#define shmemx_int64_atomic_fetch_add_v pshmemx_int64_atomic_fetch_add_v
+#pragma weak shmemx_ctx_int64_atomic_add_v = pshmemx_ctx_int64_atomic_add_v
+#define shmemx_ctx_int64_atomic_add_v pshmemx_ctx_int64_atomic_add_v
+#pragma weak shmemx_int64_atomic_add_v = pshmemx_int64_atomic_add_v
+#define shmemx_int64_atomic_add_v pshmemx_int64_atomic_add_v
+#pragma weak shmemx_ctx_uint32_atomic_fetch_add_v =                            \
+    pshmemx_ctx_uint32_atomic_fetch_add_v
+#define shmemx_ctx_uint32_atomic_fetch_add_v                                   \
+    pshmemx_ctx_uint32_atomic_fetch_add_v
+#pragma weak shmemx_uint32_atomic_fetch_add_v =                                \
+    pshmemx_uint32_atomic_fetch_add_v
+#define shmemx_uint32_atomic_fetch_add_v pshmemx_uint32_atomic_fetch_add_v
+#pragma weak shmemx_ctx_uint32_atomic_add_v = pshmemx_ctx_uint32_atomic_add_v
+#define shmemx_ctx_uint32_atomic_add_v pshmemx_ctx_uint32_atomic_add_v
+#pragma weak shmemx_uint32_atomic_add_v = pshmemx_uint32_atomic_add_v
+#define shmemx_uint32_atomic_add_v pshmemx_uint32_atomic_add_v
+#pragma weak shmemx_ctx_uint64_atomic_fetch_add_v =                            \
+    pshmemx_ctx_uint64_atomic_fetch_add_v
+#define shmemx_ctx_uint64_atomic_fetch_add_v                                   \
+    pshmemx_ctx_uint64_atomic_fetch_add_v
+#pragma weak shmemx_uint64_atomic_fetch_add_v =                                \
+    pshmemx_uint64_atomic_fetch_add_v
+#define shmemx_uint64_atomic_fetch_add_v pshmemx_uint64_atomic_fetch_add_v
+#pragma weak shmemx_ctx_uint64_atomic_add_v = pshmemx_ctx_uint64_atomic_add_v
+#define shmemx_ctx_uint64_atomic_add_v pshmemx_ctx_uint64_atomic_add_v
+#pragma weak shmemx_uint64_atomic_add_v = pshmemx_uint64_atomic_add_v
+#define shmemx_uint64_atomic_add_v pshmemx_uint64_atomic_add_v
+#pragma weak shmemx_ctx_size_atomic_fetch_add_v =                              \
+    pshmemx_ctx_size_atomic_fetch_add_v
+#define shmemx_ctx_size_atomic_fetch_add_v pshmemx_ctx_size_atomic_fetch_add_v
+#pragma weak shmemx_size_atomic_fetch_add_v = pshmemx_size_atomic_fetch_add_v
+#define shmemx_size_atomic_fetch_add_v pshmemx_size_atomic_fetch_add_v
+#pragma weak shmemx_ctx_size_atomic_add_v = pshmemx_ctx_size_atomic_add_v
+#define shmemx_ctx_size_atomic_add_v pshmemx_ctx_size_atomic_add_v
+#pragma weak shmemx_size_atomic_add_v = pshmemx_size_atomic_add_v
+#define shmemx_size_atomic_add_v pshmemx_size_atomic_add_v
+#pragma weak shmemx_ctx_ptrdiff_atomic_fetch_add_v =                           \
+    pshmemx_ctx_ptrdiff_atomic_fetch_add_v
+#define shmemx_ctx_ptrdiff_atomic_fetch_add_v                                  \
+    pshmemx_ctx_ptrdiff_atomic_fetch_add_v
+#pragma weak shmemx_ptrdiff_atomic_fetch_add_v =                               \
+    pshmemx_ptrdiff_atomic_fetch_add_v
+#define shmemx_ptrdiff_atomic_fetch_add_v pshmemx_ptrdiff_atomic_fetch_add_v
+#pragma weak shmemx_ctx_ptrdiff_atomic_add_v = pshmemx_ctx_ptrdiff_atomic_add_v
+#define shmemx_ctx_ptrdiff_atomic_add_v pshmemx_ctx_ptrdiff_atomic_add_v
+#pragma weak shmemx_ptrdiff_atomic_add_v = pshmemx_ptrdiff_atomic_add_v
+#define shmemx_ptrdiff_atomic_add_v pshmemx_ptrdiff_atomic_add_v
+#endif /* ENABLE_PSHMEM */
+
+#define SHMEMX_CTX_ADD_V_HELPER(_type, _typename)                              \
+  SHMEMX_CTX_TYPED_ADD_V(_typename, _type)
+SHMEM_STANDARD_AMO_TYPE_TABLE(SHMEMX_CTX_ADD_V_HELPER)
+#undef SHMEMX_CTX_ADD_V_HELPER
+
+#undef SHMEMX_CTX_TYPED_ADD_V
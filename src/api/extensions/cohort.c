@@ -0,0 +1,119 @@
+/* For license: see LICENSE file at top-level */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif /* HAVE_CONFIG_H */
+
+#include "shmemu.h"
+#include "shmemc.h"
+#include "shmem.h"
+#include "shmemx.h"
+#include "shmem_mutex.h"
+#include "lock.h"
+
+/*
+ * Cohort locks.
+ *
+ * Two levels: a per-node MCS lock ("local", tail on the node's first
+ * PE) and a global ticket lock ("ticket"/"serving", on the lock's
+ * owner PE).  A PE takes its node's lock first.  If the PE before it
+ * on the node left the global lock held for it, it's done; otherwise
+ * it takes a ticket.
+ *
+ * On release, if another PE on the node is queued, the global lock is
+ * passed on with the local one, up to SHMEM_COHORT_PASSES times in a
+ * row; then it goes back to the other nodes.  A ticket lock can be
+ * released by any PE, which is what lets a node share it around.
+ *
+ * "passes" (on the node's first PE) says whether the node holds the
+ * global lock, and how many times it's been passed on.
+ */
+
+#define COHORT_HELD (1UL << 63)
+
+static int node_head = -1;
+
+inline static int cohort_node_head(void) {
+  if (shmemu_unlikely(node_head < 0)) {
+    node_head =
+        shmem_team_translate_pe(SHMEM_TEAM_SHARED, 0, SHMEM_TEAM_WORLD);
+  }
+
+  return node_head;
+}
+
+static void cohort_lock(shmemx_cohort_lock_t *lk, int me) {
+  unsigned long *local = (unsigned long *)&lk->local;
+  const int head = cohort_node_head();
+  const int owner = lock_owner(lk);
+  unsigned long t;
+
+  lock_mcs_set(local, head, me);
+
+  if ((shmem_ulong_atomic_fetch(&lk->passes, head) & COHORT_HELD) != 0) {
+    return; /* handed over on the node */
+    /* NOT REACHED */
+  }
+
+  t = shmem_ulong_atomic_fetch_inc(&lk->ticket, owner);
+  while (shmem_ulong_atomic_fetch(&lk->serving, owner) != t) {
+    shmemc_progress();
+  }
+
+  shmem_ulong_atomic_set(&lk->passes, COHORT_HELD, head);
+}
+
+static void cohort_unlock(shmemx_cohort_lock_t *lk, int me) {
+  unsigned long *local = (unsigned long *)&lk->local;
+  const int head = cohort_node_head();
+  unsigned long passes;
+
+  /* required to flush comms before clearing lock */
+  shmemc_quiet();
+
+  passes = shmem_ulong_atomic_fetch(&lk->passes, head) & ~COHORT_HELD;
+
+  if ((passes < proc.env.cohort_passes) &&
+      lock_mcs_waiters(local, head, me)) {
+    /* keep the global lock on the node */
+    shmem_ulong_atomic_set(&lk->passes, COHORT_HELD | (passes + 1), head);
+  } else {
+    shmem_ulong_atomic_set(&lk->passes, 0, head);
+    shmem_ulong_atomic_inc(&lk->serving, lock_owner(lk));
+  }
+
+  /*
+   * those are posted: the next PE on the node mustn't see the old
+   * "passes", nor another node get in, before they've landed
+   */
+  shmemc_quiet();
+
+  lock_mcs_clear(local, head, me);
+}
+
+#ifdef ENABLE_PSHMEM
+#pragma weak shmemx_cohort_set_lock = pshmemx_cohort_set_lock
+#define shmemx_cohort_set_lock pshmemx_cohort_set_lock
+#pragma weak shmemx_cohort_clear_lock = pshmemx_cohort_clear_lock
+#define shmemx_cohort_clear_lock pshmemx_cohort_clear_lock
+#endif /* ENABLE_PSHMEM */
+
+void shmemx_cohort_set_lock(shmemx_cohort_lock_t *lk) {
+  SHMEMU_CHECK_INIT();
+  SHMEMU_CHECK_NOT_NULL(lk, 1);
+  SHMEMU_CHECK_SYMMETRIC(lk, 1);
+
+  logger(LOG_LOCKS, "%s(lock=%p)", __func__, lk);
+
+  SHMEMT_MUTEX_NOPROTECT(cohort_lock(lk, shmemc_my_pe()));
+}
+
+void shmemx_cohort_clear_lock(shmemx_cohort_lock_t *lk) {
+  SHMEMU_CHECK_INIT();
+  SHMEMU_CHECK_NOT_NULL(lk, 1);
+  SHMEMU_CHECK_SYMMETRIC(lk, 1);
+
+  logger(LOG_LOCKS, "%s(lock=%p)", __func__, lk);
+
+  SHMEMT_MUTEX_NOPROTECT(cohort_unlock(lk, shmemc_my_pe()));
+}
@@ -0,0 +1,308 @@
+/* For license: see LICENSE file at top-level */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif /* HAVE_CONFIG_H */
+
+#include "shmemu.h"
+#include "shmemc.h"
+#include "shmem.h"
+#include "shmemx.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+
+/*
+ * Combining counters.
+ *
+ * Everyone hitting one counter with fetch-inc serializes on the
+ * owner.  Instead, increments are combined at each level of a tree:
+ * first among the PEs on a node (shared team), then among nodes in
+ * groups of COMB_RADIX, and so on.  Only one combined add per batch
+ * reaches the owner; the range it gets back is handed down again, so
+ * each PE still gets its own values.
+ *
+ * A level lives on one host PE:
+ *
+ *   req   open batch: epoch in the top bits, sum of amounts asked
+ *         for in the rest
+ *   slot  ring of results for closed batches
+ *
+ * Joining a batch is one fetch-add on "req": the old sum is our
+ * offset in the batch.  Whoever sees offset 0 is the combiner: it
+ * claims the batch's result slot, closes the batch by swapping in the
+ * next epoch (getting the total), asks the next level up for that
+ * much, and publishes the base it got back.  The others wait for the
+ * base, add their offset, and hand back their share of the slot so
+ * it can be reused.
+ *
+ * All built on the standard AMOs, so it works across nodes and
+ * within them alike.
+ */
+
+#define COMB_RADIX 8      /* nodes per group at each tree level */
+#define COMB_MAX_LEVELS 8 /* node level + up to 8^7 nodes */
+#define COMB_RING 16      /* results for closed batches */
+
+#define COMB_SUM_BITS 40
+#define COMB_SUM_MASK ((UINT64_C(1) << COMB_SUM_BITS) - 1)
+#define COMB_EPOCH_MASK ((UINT64_C(1) << (64 - COMB_SUM_BITS)) - 1)
+
+/*
+ * larger adds go straight to the owner, so a batch's sum can't
+ * overflow into the epoch (fine for up to 2^24 PEs)
+ */
+#define COMB_MAX_ADD (UINT64_C(1) << 16)
+
+#define COMB_SLOT_BUSY UINT64_MAX /* claimed, result not out yet */
+
+typedef struct comb_slot {
+  uint64_t tag;     /* epoch + 1 of the result in here */
+  uint64_t base;    /* first value of that batch's range */
+  uint64_t pending; /* amounts yet to collect it, or BUSY */
+} comb_slot_t;
+
+typedef struct comb_level {
+  uint64_t req;
+  comb_slot_t slot[COMB_RING];
+} comb_level_t;
+
+/*
+ * symmetric: every PE has one, hosts use their levels, the owner its
+ * value
+ */
+typedef struct comb_sym {
+  uint64_t value;
+  comb_level_t level[COMB_MAX_LEVELS];
+} comb_sym_t;
+
+struct shmemx_combining_counter {
+  comb_sym_t *sym;
+  int owner;
+  int nlevels;                /* levels on our path */
+  int index[COMB_MAX_LEVELS]; /* which level... */
+  int host[COMB_MAX_LEVELS];  /* ...and where it lives */
+};
+
+/*
+ * lay out the tree, see which levels we go through on the way up
+ */
+static void comb_path(shmemx_combining_counter_t c, const int *leaders,
+                      int npes) {
+  const int me = shmem_my_pe();
+  int *nodes;
+  int nnodes = 0;
+  int mynode = -1;
+  int span;
+  int lvl;
+  int i;
+
+  nodes = (int *)malloc(npes * sizeof(*nodes));
+  shmemu_assert(nodes != NULL, "can't allocate combining tree for %d PEs",
+                npes);
+
+  /* nodes in PE order of their leaders */
+  for (i = 0; i < npes; ++i) {
+    if (leaders[i] == i) {
+      if (i == leaders[me]) {
+        mynode = nnodes;
+      }
+      nodes[nnodes++] = i;
+    }
+  }
+
+  c->nlevels = 0;
+
+  /* node level, if there's anyone to combine with */
+  if (shmem_team_n_pes(SHMEM_TEAM_SHARED) > 1) {
+    c->index[c->nlevels] = 0;
+    c->host[c->nlevels] = leaders[me];
+    ++c->nlevels;
+  }
+
+  /* then groups of nodes, groups of groups... */
+  for (span = 1, lvl = 1; span < nnodes; span *= COMB_RADIX, ++lvl) {
+    const int first = (mynode / (span * COMB_RADIX)) * (span * COMB_RADIX);
+    const int left = nnodes - first;
+    const int width = (left < span * COMB_RADIX) ? left : span * COMB_RADIX;
+    const int members = (width + span - 1) / span;
+
+    shmemu_assert(lvl < COMB_MAX_LEVELS,
+                  "combining tree too deep for %d nodes", nnodes);
+
+    if (members > 1) {
+      c->index[c->nlevels] = lvl;
+      c->host[c->nlevels] = nodes[first];
+      ++c->nlevels;
+    }
+  }
+
+  free(nodes);
+}
+
+/*
+ * the owner's value is the level above the top one
+ */
+static uint64_t comb_fetch_add(shmemx_combining_counter_t c, int i,
+                               uint64_t amount) {
+  comb_level_t *lp;
+  comb_slot_t *sp;
+  uint64_t old, epoch, offset, base;
+  int h;
+
+  if (i == c->nlevels) {
+    return shmem_uint64_atomic_fetch_add(&c->sym->value, amount, c->owner);
+    /* NOT REACHED */
+  }
+
+  h = c->host[i];
+  lp = &c->sym->level[c->index[i]];
+
+  old = shmem_uint64_atomic_fetch_add(&lp->req, amount, h);
+  epoch = old >> COMB_SUM_BITS;
+  offset = old & COMB_SUM_MASK;
+  sp = &lp->slot[epoch % COMB_RING];
+
+  if (offset == 0) {
+    uint64_t total;
+
+    /* last users of this slot have to be done with it */
+    while (shmem_uint64_atomic_compare_swap(&sp->pending, 0, COMB_SLOT_BUSY,
+                                            h) != 0) {
+      shmemc_progress();
+    }
+
+    old = shmem_uint64_atomic_swap(
+        &lp->req, ((epoch + 1) & COMB_EPOCH_MASK) << COMB_SUM_BITS, h);
+    total = old & COMB_SUM_MASK;
+
+    base = comb_fetch_add(c, i + 1, total);
+
+    if (total == amount) {
+      /* on our own */
+      shmem_uint64_atomic_set(&sp->pending, 0, h);
+    } else {
+      /*
+       * sets can be puts or stores (SHMEM_AMO_RMA): base and pending
+       * have to land before the tag releases the waiters
+       */
+      shmem_uint64_atomic_set(&sp->base, base, h);
+      shmem_uint64_atomic_set(&sp->pending, total - amount, h);
+      shmem_fence();
+      if (shmem_ptr(&sp->tag, h) != NULL) {
+        shmem_quiet();
+      }
+      shmem_uint64_atomic_set(&sp->tag, epoch + 1, h);
+    }
+
+    return base;
+    /* NOT REACHED */
+  }
+
+  while (shmem_uint64_atomic_fetch(&sp->tag, h) != (epoch + 1)) {
+    shmemc_progress();
+  }
+  base = shmem_uint64_atomic_fetch(&sp->base, h);
+
+  /* give back our share of the slot */
+  shmem_uint64_atomic_add(&sp->pending, -amount, h);
+
+  return base + offset;
+}
+
+#ifdef ENABLE_PSHMEM
+#pragma weak shmemx_combining_counter_create =                                 \
+    pshmemx_combining_counter_create
+#define shmemx_combining_counter_create pshmemx_combining_counter_create
+#pragma weak shmemx_combining_counter_destroy =                                \
+    pshmemx_combining_counter_destroy
+#define shmemx_combining_counter_destroy pshmemx_combining_counter_destroy
+#pragma weak shmemx_combining_counter_fetch_add =                              \
+    pshmemx_combining_counter_fetch_add
+#define shmemx_combining_counter_fetch_add pshmemx_combining_counter_fetch_add
+#pragma weak shmemx_combining_counter_fetch_inc =                              \
+    pshmemx_combining_counter_fetch_inc
+#define shmemx_combining_counter_fetch_inc pshmemx_combining_counter_fetch_inc
+#pragma weak shmemx_combining_counter_read = pshmemx_combining_counter_read
+#define shmemx_combining_counter_read pshmemx_combining_counter_read
+#endif /* ENABLE_PSHMEM */
+
+int shmemx_combining_counter_create(int owner, uint64_t value,
+                                    shmemx_combining_counter_t *counter) {
+  const int npes = shmem_n_pes();
+  shmemx_combining_counter_t c;
+  int *leaders;
+  int *leader;
+
+  SHMEMU_CHECK_INIT();
+  SHMEMU_CHECK_PE_ARG_RANGE(owner, 1);
+  SHMEMU_CHECK_NOT_NULL(counter, 3);
+
+  /* bailing out here would leave the others stuck in the collectives */
+  c = (shmemx_combining_counter_t)malloc(sizeof(*c));
+  shmemu_assert(c != NULL, "%s: can't allocate counter", __func__);
+
+  c->owner = owner;
+  c->sym = (comb_sym_t *)shmem_calloc(1, sizeof(*c->sym));
+  leaders = (int *)shmem_malloc(npes * sizeof(*leaders));
+  leader = (int *)shmem_malloc(sizeof(*leader));
+
+  shmemu_assert((c->sym != NULL) && (leaders != NULL) && (leader != NULL),
+                "%s: can't allocate symmetric state", __func__);
+
+  /* who's in charge of each PE's node */
+  *leader = shmem_team_translate_pe(SHMEM_TEAM_SHARED, 0, SHMEM_TEAM_WORLD);
+  shmem_int_fcollect(SHMEM_TEAM_WORLD, leaders, leader, 1);
+
+  comb_path(c, leaders, npes);
+
+  if (shmem_my_pe() == owner) {
+    c->sym->value = value;
+  }
+
+  shmem_free(leader);
+  shmem_free(leaders); /* barriers, so value is set for everyone */
+
+  *counter = c;
+
+  logger(LOG_ATOMICS, "%s(owner=%d, value=%lu, counter->%p) levels=%d",
+         __func__, owner, (unsigned long)value, *counter, c->nlevels);
+
+  return 0;
+}
+
+void shmemx_combining_counter_destroy(shmemx_combining_counter_t counter) {
+  SHMEMU_CHECK_INIT();
+  SHMEMU_CHECK_NOT_NULL(counter, 1);
+
+  shmem_free(counter->sym);
+  free(counter);
+
+  logger(LOG_ATOMICS, "%s(counter=%p)", __func__, counter);
+}
+
+uint64_t shmemx_combining_counter_fetch_add(shmemx_combining_counter_t counter,
+                                            uint64_t value) {
+  SHMEMU_CHECK_INIT();
+  SHMEMU_CHECK_NOT_NULL(counter, 1);
+
+  if ((value == 0) || (value >= COMB_MAX_ADD)) {
+    return shmem_uint64_atomic_fetch_add(&counter->sym->value, value,
+                                         counter->owner);
+    /* NOT REACHED */
+  }
+
+  return comb_fetch_add(counter, 0, value);
+}
+
+uint64_t
+shmemx_combining_counter_fetch_inc(shmemx_combining_counter_t counter) {
+  return shmemx_combining_counter_fetch_add(counter, 1);
+}
+
+uint64_t shmemx_combining_counter_read(shmemx_combining_counter_t counter) {
+  SHMEMU_CHECK_INIT();
+  SHMEMU_CHECK_NOT_NULL(counter, 1);
+
+  return shmem_uint64_atomic_fetch(&counter->sym->value, counter->owner);
+}
@@ -0,0 +1,363 @@
+/* For license: see LICENSE file at top-level */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif /* HAVE_CONFIG_H */
+
+#include "shmemu.h"
+#include "shmemc.h"
+#include "shmem_mutex.h"
+#include "shmemx.h"
+
+#include <shmem/api_types.h>
+
+/*
+ * Completion counters: non-blocking puts, gets and AMOs tagged with a
+ * counter add 1 to it when they complete, so a caller can wait for
+ * "n of mine are done" without a quiet on the whole context.
+ */
+
+/*
+ * -- counters --
+ */
+
+#ifdef ENABLE_PSHMEM
+#pragma weak shmemx_ctx_counter_create = pshmemx_ctx_counter_create
+#define shmemx_ctx_counter_create pshmemx_ctx_counter_create
+#pragma weak shmemx_ctx_counter_destroy = pshmemx_ctx_counter_destroy
+#define shmemx_ctx_counter_destroy pshmemx_ctx_counter_destroy
+#pragma weak shmemx_ctx_counter_read = pshmemx_ctx_counter_read
+#define shmemx_ctx_counter_read pshmemx_ctx_counter_read
+#pragma weak shmemx_counter_test = pshmemx_counter_test
+#define shmemx_counter_test pshmemx_counter_test
+#pragma weak shmemx_counter_wait = pshmemx_counter_wait
+#define shmemx_counter_wait pshmemx_counter_wait
+#endif /* ENABLE_PSHMEM */
+
+int shmemx_ctx_counter_create(shmem_ctx_t ctx, shmemx_ctx_counter_t *counter) {
+  shmemc_counter_h c;
+
+  SHMEMU_CHECK_INIT();
+  SHMEMU_CHECK_NOT_NULL(counter, 2);
+
+  SHMEMT_MUTEX_NOPROTECT(c = shmemc_ctx_counter_create(ctx));
+
+  *counter = (shmemx_ctx_counter_t)c;
+
+  logger(LOG_CONTEXTS, "%s(ctx=%lu, counter->%p)", __func__,
+         shmemc_context_id(ctx), *counter);
+
+  return (c != NULL) ? 0 : 1;
+}
+
+void shmemx_ctx_counter_destroy(shmemx_ctx_counter_t counter) {
+  SHMEMU_CHECK_INIT();
+  SHMEMU_CHECK_NOT_NULL(counter, 1);
+
+  SHMEMT_MUTEX_NOPROTECT(shmemc_counter_destroy((shmemc_counter_h)counter));
+
+  logger(LOG_CONTEXTS, "%s(counter=%p)", __func__, counter);
+}
+
+uint64_t shmemx_ctx_counter_read(shmemx_ctx_counter_t counter) {
+  SHMEMU_CHECK_NOT_NULL(counter, 1);
+
+  return shmemc_counter_read((shmemc_counter_h)counter);
+}
+
+int shmemx_counter_test(shmemx_ctx_counter_t counter, uint64_t n) {
+  int s;
+
+  SHMEMU_CHECK_NOT_NULL(counter, 1);
+
+  SHMEMT_MUTEX_NOPROTECT(s = shmemc_counter_test((shmemc_counter_h)counter, n));
+
+  return s;
+}
+
+void shmemx_counter_wait(shmemx_ctx_counter_t counter, uint64_t n) {
+  SHMEMU_CHECK_NOT_NULL(counter, 1);
+
+  SHMEMT_MUTEX_NOPROTECT(shmemc_counter_wait((shmemc_counter_h)counter, n));
+
+  logger(LOG_QUIET, "%s(counter=%p, n=%lu)", __func__, counter,
+         (unsigned long)n);
+}
+
+/*
+ * -- puts & gets --
+ */
+
+#define SHMEMX_TYPED_PUTGET_NBI_CT(_op, _name, _type, _symarg, _argno)         \
+  void shmemx_##_name##_##_op##_nbi_ct(shmemx_ctx_counter_t counter,           \
+                                       _type *dest, const _type *src,          \
+                                       size_t nelems, int pe) {                \
+    SHMEMU_CHECK_INIT();                                                       \
+    SHMEMU_CHECK_NOT_NULL(counter, 1);                                         \
+    SHMEMU_CHECK_PE_ARG_RANGE(pe, 5);                                          \
+    SHMEMU_CHECK_SYMMETRIC(_symarg, _argno);                                   \
+                                                                               \
+    logger(LOG_RMA, "%s(counter=%p, dest=%p, src=%p, nelems=%lu, pe=%d)",      \
+           __func__, counter, dest, src, nelems, pe);                          \
+                                                                               \
+    SHMEMT_MUTEX_NOPROTECT(shmemc_counter_##_op##_nbi(                         \
+        (shmemc_counter_h)counter, dest, src, sizeof(_type) * nelems, pe));    \
+  }
+
+#ifdef ENABLE_PSHMEM
+#pragma weak shmemx_float_put_nbi_ct = pshmemx_float_put_nbi_ct
+#define shmemx_float_put_nbi_ct pshmemx_float_put_nbi_ct
+#pragma weak shmemx_double_put_nbi_ct = pshmemx_double_put_nbi_ct
+#define shmemx_double_put_nbi_ct pshmemx_double_put_nbi_ct
+#pragma weak shmemx_longdouble_put_nbi_ct = pshmemx_longdouble_put_nbi_ct
+#define shmemx_longdouble_put_nbi_ct pshmemx_longdouble_put_nbi_ct
+#pragma weak shmemx_char_put_nbi_ct = pshmemx_char_put_nbi_ct
+#define shmemx_char_put_nbi_ct pshmemx_char_put_nbi_ct
+#pragma weak shmemx_schar_put_nbi_ct = pshmemx_schar_put_nbi_ct
+#define shmemx_schar_put_nbi_ct pshmemx_schar_put_nbi_ct
+#pragma weak shmemx_short_put_nbi_ct = pshmemx_short_put_nbi_ct
+#define shmemx_short_put_nbi_ct pshmemx_short_put_nbi_ct
+#pragma weak shmemx_int_put_nbi_ct = pshmemx_int_put_nbi_ct
+#define shmemx_int_put_nbi_ct pshmemx_int_put_nbi_ct
+#pragma weak shmemx_long_put_nbi_ct = pshmemx_long_put_nbi_ct
+#define shmemx_long_put_nbi_ct pshmemx_long_put_nbi_ct
+#pragma weak shmemx_longlong_put_nbi_ct = pshmemx_longlong_put_nbi_ct
+#define shmemx_longlong_put_nbi_ct pshmemx_longlong_put_nbi_ct
+#pragma weak shmemx_uchar_put_nbi_ct = pshmemx_uchar_put_nbi_ct
+#define shmemx_uchar_put_nbi_ct pshmemx_uchar_put_nbi_ct
+#pragma weak shmemx_ushort_put_nbi_ct = pshmemx_ushort_put_nbi_ct
+#define shmemx_ushort_put_nbi_ct pshmemx_ushort_put_nbi_ct
+#pragma weak shmemx_uint_put_nbi_ct = pshmemx_uint_put_nbi_ct
+#define shmemx_uint_put_nbi_ct pshmemx_uint_put_nbi_ct
+#pragma weak shmemx_ulong_put_nbi_ct = pshmemx_ulong_put_nbi_ct
+#define shmemx_ulong_put_nbi_ct pshmemx_ulong_put_nbi_ct
+#pragma weak shmemx_ulonglong_put_nbi_ct = pshmemx_ulonglong_put_nbi_ct
+#define shmemx_ulonglong_put_nbi_ct pshmemx_ulonglong_put_nbi_ct
+#pragma weak shmemx_int8_put_nbi_ct = pshmemx_int8_put_nbi_ct
+#define shmemx_int8_put_nbi_ct pshmemx_int8_put_nbi_ct
+#pragma weak shmemx_int16_put_nbi_ct = pshmemx_int16_put_nbi_ct
+#define shmemx_int16_put_nbi_ct pshmemx_int16_put_nbi_ct
+#pragma weak shmemx_int32_put_nbi_ct = pshmemx_int32_put_nbi_ct
+#define shmemx_int32_put_nbi_ct pshmemx_int32_put_nbi_ct
+#pragma weak shmemx_int64_put_nbi_ct = pshmemx_int64_put_nbi_ct
+#define shmemx_int64_put_nbi_ct pshmemx_int64_put_nbi_ct
+#pragma weak shmemx_uint8_put_nbi_ct = pshmemx_uint8_put_nbi_ct
+#define shmemx_uint8_put_nbi_ct pshmemx_uint8_put_nbi_ct
+#pragma weak shmemx_uint16_put_nbi_ct = pshmemx_uint16_put_nbi_ct
+#define shmemx_uint16_put_nbi_ct pshmemx_uint16_put_nbi_ct
+#pragma weak shmemx_uint32_put_nbi_ct = pshmemx_uint32_put_nbi_ct
+#define shmemx_uint32_put_nbi_ct pshmemx_uint32_put_nbi_ct
+#pragma weak shmemx_uint64_put_nbi_ct = pshmemx_uint64_put_nbi_ct
+#define shmemx_uint64_put_nbi_ct pshmemx_uint64_put_nbi_ct
+#pragma weak shmemx_size_put_nbi_ct = pshmemx_size_put_nbi_ct
+#define shmemx_size_put_nbi_ct pshmemx_size_put_nbi_ct
+#pragma weak shmemx_ptrdiff_put_nbi_ct = pshmemx_ptrdiff_put_nbi_ct
+#define shmemx_ptrdiff_put_nbi_ct pshmemx_ptrdiff_put_nbi_ct
+#pragma weak shmemx_float_get_nbi_ct = pshmemx_float_get_nbi_ct
+#define shmemx_float_get_nbi_ct pshmemx_float_get_nbi_ct
+#pragma weak shmemx_double_get_nbi_ct = pshmemx_double_get_nbi_ct
+#define shmemx_double_get_nbi_ct pshmemx_double_get_nbi_ct
+#pragma weak shmemx_longdouble_get_nbi_ct = pshmemx_longdouble_get_nbi_ct
+#define shmemx_longdouble_get_nbi_ct pshmemx_longdouble_get_nbi_ct
+#pragma weak shmemx_char_get_nbi_ct = pshmemx_char_get_nbi_ct
+#define shmemx_char_get_nbi_ct pshmemx_char_get_nbi_ct
+#pragma weak shmemx_schar_get_nbi_ct = pshmemx_schar_get_nbi_ct
+#define shmemx_schar_get_nbi_ct pshmemx_schar_get_nbi_ct
+#pragma weak shmemx_short_get_nbi_ct = pshmemx_short_get_nbi_ct
+#define shmemx_short_get_nbi_ct pshmemx_short_get_nbi_ct
+#pragma weak shmemx_int_get_nbi_ct = pshmemx_int_get_nbi_ct
+#define shmemx_int_get_nbi_ct pshmemx_int_get_nbi_ct
+#pragma weak shmemx_long_get_nbi_ct = pshmemx_long_get_nbi_ct
+#define shmemx_long_get_nbi_ct pshmemx_long_get_nbi_ct
+#pragma weak shmemx_longlong_get_nbi_ct = pshmemx_longlong_get_nbi_ct
+#define shmemx_longlong_get_nbi_ct pshmemx_longlong_get_nbi_ct
+#pragma weak shmemx_uchar_get_nbi_ct = pshmemx_uchar_get_nbi_ct
+#define shmemx_uchar_get_nbi_ct pshmemx_uchar_get_nbi_ct
+#pragma weak shmemx_ushort_get_nbi_ct = pshmemx_ushort_get_nbi_ct
+#define shmemx_ushort_get_nbi_ct pshmemx_ushort_get_nbi_ct
+#pragma weak shmemx_uint_get_nbi_ct = pshmemx_uint_get_nbi_ct
+#define shmemx_uint_get_nbi_ct pshmemx_uint_get_nbi_ct
+#pragma weak shmemx_ulong_get_nbi_ct = pshmemx_ulong_get_nbi_ct
+#define shmemx_ulong_get_nbi_ct pshmemx_ulong_get_nbi_ct
+#pragma weak shmemx_ulonglong_get_nbi_ct = pshmemx_ulonglong_get_nbi_ct
+#define shmemx_ulonglong_get_nbi_ct pshmemx_ulonglong_get_nbi_ct
+#pragma weak shmemx_int8_get_nbi_ct = pshmemx_int8_get_nbi_ct
+#define shmemx_int8_get_nbi_ct pshmemx_int8_get_nbi_ct
+#pragma weak shmemx_int16_get_nbi_ct = pshmemx_int16_get_nbi_ct
+#define shmemx_int16_get_nbi_ct pshmemx_int16_get_nbi_ct
+#pragma weak shmemx_int32_get_nbi_ct = pshmemx_int32_get_nbi_ct
+#define shmemx_int32_get_nbi_ct pshmemx_int32_get_nbi_ct
+#pragma weak shmemx_int64_get_nbi_ct = pshmemx_int64_get_nbi_ct
+#define shmemx_int64_get_nbi_ct pshmemx_int64_get_nbi_ct
+#pragma weak shmemx_uint8_get_nbi_ct = pshmemx_uint8_get_nbi_ct
+#define shmemx_uint8_get_nbi_ct pshmemx_uint8_get_nbi_ct
+#pragma weak shmemx_uint16_get_nbi_ct = pshmemx_uint16_get_nbi_ct
+#define shmemx_uint16_get_nbi_ct pshmemx_uint16_get_nbi_ct
+#pragma weak shmemx_uint32_get_nbi_ct = pshmemx_uint32_get_nbi_ct
+#define shmemx_uint32_get_nbi_ct pshmemx_uint32_get_nbi_ct
+#pragma weak shmemx_uint64_get_nbi_ct = pshmemx_uint64_get_nbi_ct
+#define shmemx_uint64_get_nbi_ct pshmemx_uint64_get_nbi_ct
+#pragma weak shmemx_size_get_nbi_ct = pshmemx_size_get_nbi_ct
+#define shmemx_size_get_nbi_ct pshmemx_size_get_nbi_ct
+#pragma weak shmemx_ptrdiff_get_nbi_ct = pshmemx_ptrdiff_get_nbi_ct
+#define shmemx_ptrdiff_get_nbi_ct pshmemx_ptrdiff_get_nbi_ct
+#pragma weak shmemx_putmem_nbi_ct = pshmemx_putmem_nbi_ct
+#define shmemx_putmem_nbi_ct pshmemx_putmem_nbi_ct
+#pragma weak shmemx_getmem_nbi_ct = pshmemx_getmem_nbi_ct
+#define shmemx_getmem_nbi_ct pshmemx_getmem_nbi_ct
+#endif /* ENABLE_PSHMEM */
+
+#define PUT_NBI_CT_TYPE_HELPER(_type, _typename)                               \
+  SHMEMX_TYPED_PUTGET_NBI_CT(put, _typename, _type, dest, 2)
+SHMEM_STANDARD_RMA_TYPE_TABLE(PUT_NBI_CT_TYPE_HELPER)
+#undef PUT_NBI_CT_TYPE_HELPER
+
+#define GET_NBI_CT_TYPE_HELPER(_type, _typename)                               \
+  SHMEMX_TYPED_PUTGET_NBI_CT(get, _typename, _type, src, 3)
+SHMEM_STANDARD_RMA_TYPE_TABLE(GET_NBI_CT_TYPE_HELPER)
+#undef GET_NBI_CT_TYPE_HELPER
+
+void shmemx_putmem_nbi_ct(shmemx_ctx_counter_t counter, void *dest,
+                          const void *src, size_t nbytes, int pe) {
+  SHMEMU_CHECK_INIT();
+  SHMEMU_CHECK_NOT_NULL(counter, 1);
+  SHMEMU_CHECK_PE_ARG_RANGE(pe, 5);
+  SHMEMU_CHECK_SYMMETRIC(dest, 2);
+
+  logger(LOG_RMA, "%s(counter=%p, dest=%p, src=%p, nbytes=%lu, pe=%d)",
+         __func__, counter, dest, src, nbytes, pe);
+
+  SHMEMT_MUTEX_NOPROTECT(
+      shmemc_counter_put_nbi((shmemc_counter_h)counter, dest, src, nbytes, pe));
+}
+
+void shmemx_getmem_nbi_ct(shmemx_ctx_counter_t counter, void *dest,
+                          const void *src, size_t nbytes, int pe) {
+  SHMEMU_CHECK_INIT();
+  SHMEMU_CHECK_NOT_NULL(counter, 1);
+  SHMEMU_CHECK_PE_ARG_RANGE(pe, 5);
+  SHMEMU_CHECK_SYMMETRIC(src, 3);
+
+  logger(LOG_RMA, "%s(counter=%p, dest=%p, src=%p, nbytes=%lu, pe=%d)",
+         __func__, counter, dest, src, nbytes, pe);
+
+  SHMEMT_MUTEX_NOPROTECT(
+      shmemc_counter_get_nbi((shmemc_counter_h)counter, dest, src, nbytes, pe));
+}
+
+/*
+ * -- AMOs --
+ */
+
+#define SHMEMX_TYPED_ADD_CT(_name, _type)                                      \
+  void shmemx_##_name##_atomic_add_ct(shmemx_ctx_counter_t counter,            \
+                                      _type *dest, _type value, int pe) {      \
+    SHMEMU_CHECK_INIT();                                                       \
+    SHMEMU_CHECK_NOT_NULL(counter, 1);                                         \
+    SHMEMU_CHECK_PE_ARG_RANGE(pe, 4);                                          \
+    SHMEMU_CHECK_SYMMETRIC(dest, 2);                                           \
+                                                                               \
+    logger(LOG_ATOMICS, "%s(counter=%p, dest=%p, pe=%d)", __func__, counter,   \
+           dest, pe);                                                          \
+                                                                               \
+    SHMEMT_MUTEX_NOPROTECT(shmemc_counter_add(                                 \
+        (shmemc_counter_h)counter, dest, &value, sizeof(value), pe));          \
+  }
+
+#define SHMEMX_TYPED_FETCH_ADD_NBI_CT(_name, _type)                            \
+  void shmemx_##_name##_atomic_fetch_add_nbi_ct(shmemx_ctx_counter_t counter,  \
+                                                _type *fetch, _type *dest,     \
+                                                _type value, int pe) {         \
+    SHMEMU_CHECK_INIT();                                                       \
+    SHMEMU_CHECK_NOT_NULL(counter, 1);                                         \
+    SHMEMU_CHECK_NOT_NULL(fetch, 2);                                           \
+    SHMEMU_CHECK_PE_ARG_RANGE(pe, 5);                                          \
+    SHMEMU_CHECK_SYMMETRIC(dest, 3);                                           \
+                                                                               \
+    logger(LOG_ATOMICS, "%s(counter=%p, fetch=%p, dest=%p, pe=%d)", __func__,  \
+           counter, fetch, dest, pe);                                          \
+                                                                               \
+    SHMEMT_MUTEX_NOPROTECT(shmemc_counter_fadd_nbi(                            \
+        (shmemc_counter_h)counter, dest, &value, sizeof(value), pe, fetch));   \
+  }
+
+#ifdef ENABLE_PSHMEM
+#pragma weak shmemx_int_atomic_add_ct = pshmemx_int_atomic_add_ct
+#define shmemx_int_atomic_add_ct pshmemx_int_atomic_add_ct
+#pragma weak shmemx_long_atomic_add_ct = pshmemx_long_atomic_add_ct
+#define shmemx_long_atomic_add_ct pshmemx_long_atomic_add_ct
+#pragma weak shmemx_longlong_atomic_add_ct = pshmemx_longlong_atomic_add_ct
+#define shmemx_longlong_atomic_add_ct pshmemx_longlong_atomic_add_ct
+#pragma weak shmemx_uint_atomic_add_ct = pshmemx_uint_atomic_add_ct
+#define shmemx_uint_atomic_add_ct pshmemx_uint_atomic_add_ct
+#pragma weak shmemx_ulong_atomic_add_ct = pshmemx_ulong_atomic_add_ct
+#define shmemx_ulong_atomic_add_ct pshmemx_ulong_atomic_add_ct
+#pragma weak shmemx_ulonglong_atomic_add_ct = pshmemx_ulonglong_atomic_add_ct
+#define shmemx_ulonglong_atomic_add_ct pshmemx_ulonglong_atomic_add_ct
+#pragma weak shmemx_int32_atomic_add_ct = pshmemx_int32_atomic_add_ct
+#define shmemx_int32_atomic_add_ct pshmemx_int32_atomic_add_ct
+#pragma weak shmemx_int64_atomic_add_ct = pshmemx_int64_atomic_add_ct
+#define shmemx_int64_atomic_add_ct pshmemx_int64_atomic_add_ct
+#pragma weak shmemx_uint32_atomic_add_ct = pshmemx_uint32_atomic_add_ct
+#define shmemx_uint32_atomic_add_ct pshmemx_uint32_atomic_add_ct
+#pragma weak shmemx_uint64_atomic_add_ct = pshmemx_uint64_atomic_add_ct
+#define shmemx_uint64_atomic_add_ct pshmemx_uint64_atomic_add_ct
+#pragma weak shmemx_size_atomic_add_ct = pshmemx_size_atomic_add_ct
+#define shmemx_size_atomic_add_ct pshmemx_size_atomic_add_ct
+#pragma weak shmemx_ptrdiff_atomic_add_ct = pshmemx_ptrdiff_atomic_add_ct
+#define shmemx_ptrdiff_atomic_add_ct pshmemx_ptrdiff_atomic_add_ct
+#pragma weak shmemx_int_atomic_fetch_add_nbi_ct =                              \
+    pshmemx_int_atomic_fetch_add_nbi_ct
+#define shmemx_int_atomic_fetch_add_nbi_ct pshmemx_int_atomic_fetch_add_nbi_ct
+#pragma weak shmemx_long_atomic_fetch_add_nbi_ct =                             \
+    pshmemx_long_atomic_fetch_add_nbi_ct
+#define shmemx_long_atomic_fetch_add_nbi_ct pshmemx_long_atomic_fetch_add_nbi_ct
+#pragma weak shmemx_longlong_atomic_fetch_add_nbi_ct =                         \
+    pshmemx_longlong_atomic_fetch_add_nbi_ct
+#define shmemx_longlong_atomic_fetch_add_nbi_ct                                \
+    pshmemx_longlong_atomic_fetch_add_nbi_ct
+#pragma weak shmemx_uint_atomic_fetch_add_nbi_ct =                             \
+    pshmemx_uint_atomic_fetch_add_nbi_ct
+#define shmemx_uint_atomic_fetch_add_nbi_ct pshmemx_uint_atomic_fetch_add_nbi_ct
+#pragma weak shmemx_ulong_atomic_fetch_add_nbi_ct =                            \
+    pshmemx_ulong_atomic_fetch_add_nbi_ct
+#define shmemx_ulong_atomic_fetch_add_nbi_ct                                   \
+    pshmemx_ulong_atomic_fetch_add_nbi_ct
+#pragma weak shmemx_ulonglong_atomic_fetch_add_nbi_ct =                        \
+    pshmemx_ulonglong_atomic_fetch_add_nbi_ct
+#define shmemx_ulonglong_atomic_fetch_add_nbi_ct                               \
+    pshmemx_ulonglong_atomic_fetch_add_nbi_ct
+#pragma weak shmemx_int32_atomic_fetch_add_nbi_ct =                            \
+    pshmemx_int32_atomic_fetch_add_nbi_ct
+#define shmemx_int32_atomic_fetch_add_nbi_ct                                   \
+    pshmemx_int32_atomic_fetch_add_nbi_ct
+#pragma weak shmemx_int64_atomic_fetch_add_nbi_ct =                            \
+    pshmemx_int64_atomic_fetch_add_nbi_ct
+#define shmemx_int64_atomic_fetch_add_nbi_ct                                   \
+    pshmemx_int64_atomic_fetch_add_nbi_ct
+#pragma weak shmemx_uint32_atomic_fetch_add_nbi_ct =                           \
+    pshmemx_uint32_atomic_fetch_add_nbi_ct
+#define shmemx_uint32_atomic_fetch_add_nbi_ct                                  \
+    pshmemx_uint32_atomic_fetch_add_nbi_ct
+#pragma weak shmemx_uint64_atomic_fetch_add_nbi_ct =                           \
+    pshmemx_uint64_atomic_fetch_add_nbi_ct
+#define shmemx_uint64_atomic_fetch_add_nbi_ct                                  \
+    pshmemx_uint64_atomic_fetch_add_nbi_ct
+#pragma weak shmemx_size_atomic_fetch_add_nbi_ct =                             \
+    pshmemx_size_atomic_fetch_add_nbi_ct
+#define shmemx_size_atomic_fetch_add_nbi_ct pshmemx_size_atomic_fetch_add_nbi_ct
+#pragma weak shmemx_ptrdiff_atomic_fetch_add_nbi_ct =                          \
+    pshmemx_ptrdiff_atomic_fetch_add_nbi_ct
+#define shmemx_ptrdiff_atomic_fetch_add_nbi_ct                                 \
+    pshmemx_ptrdiff_atomic_fetch_add_nbi_ct
+#endif /* ENABLE_PSHMEM */
+
+#define ADD_CT_TYPE_HELPER(_type, _typename)                                   \
+  SHMEMX_TYPED_ADD_CT(_typename, _type)
+SHMEM_STANDARD_AMO_TYPE_TABLE(ADD_CT_TYPE_HELPER)
+#undef ADD_CT_TYPE_HELPER
+
+#define FETCH_ADD_NBI_CT_TYPE_HELPER(_type, _typename)                         \
+  SHMEMX_TYPED_FETCH_ADD_NBI_CT(_typename, _type)
+SHMEM_STANDARD_AMO_TYPE_TABLE(FETCH_ADD_NBI_CT_TYPE_HELPER)
+#undef FETCH_ADD_NBI_CT_TYPE_HELPER
@@ -38,13 +38,13 @@ int shmemx_fence_test(void) {
 #endif /* ENABLE_PSHMEM */
 
 int shmemx_pe_fence(shmem_ctx_t ctx, int pe) {
-  int s;
+  SHMEMU_CHECK_INIT();
+  SHMEMU_CHECK_PE_ARG_RANGE(pe, 2);
 
-  NO_WARN_UNUSED(pe);
+  SHMEMT_MUTEX_NOPROTECT(shmemc_ctx_pe_fence(ctx, pe));
 
-  SHMEMT_MUTEX_NOPROTECT(s = shmemc_ctx_fence_test(ctx));
+  logger(LOG_FENCE, "%s(ctx=%lu, pe=%d)", __func__, shmemc_context_id(ctx),
+         pe);
 
-  logger(LOG_FENCE, "%s(ctx=%lu) -> %d", __func__, shmemc_context_id(ctx), s);
-
-  return s;
+  return 1;
 }
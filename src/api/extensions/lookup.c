@@ -0,0 +1,27 @@
+/* For license: see LICENSE file at top-level */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif /* HAVE_CONFIG_H */
+
+#include "shmemu.h"
+#include "shmemc.h"
+#include "shmemx.h"
+
+#ifdef ENABLE_PSHMEM
+#pragma weak shmemx_lookup_remote_addr = pshmemx_lookup_remote_addr
+#define shmemx_lookup_remote_addr pshmemx_lookup_remote_addr
+#endif /* ENABLE_PSHMEM */
+
+void *shmemx_lookup_remote_addr(void *addr, int pe) {
+  void *ra;
+
+  SHMEMU_CHECK_INIT();
+  SHMEMU_CHECK_PE_ARG_RANGE(pe, 2);
+
+  ra = shmemc_ctx_lookup_remote_addr(SHMEM_CTX_DEFAULT, addr, pe);
+
+  logger(LOG_MEMORY, "%s(addr=%p, pe=%d) -> %p", __func__, addr, pe, ra);
+
+  return ra;
+}
@@ -0,0 +1,423 @@
+/* For license: see LICENSE file at top-level */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif /* HAVE_CONFIG_H */
+
+#include "shmemu.h"
+#include "shmemc.h"
+#include "shmem_mutex.h"
+#include "shmemx.h"
+
+#include <shmem/api_types.h>
+
+/*
+ * Handle-based puts and gets: each returns a handle that completes on
+ * its own, independently of any other outstanding operation.  A NULL
+ * handle means the operation has already completed.
+ */
+
+/*
+ * -- puts --
+ */
+
+#define SHMEMX_CTX_TYPED_PUT_NBX(_name, _type)                                 \
+  shmemx_handle_t shmemx_ctx_##_name##_put_nbx(                                \
+      shmem_ctx_t ctx, _type *dest, const _type *src, size_t nelems, int pe) { \
+    shmemx_handle_t h;                                                         \
+                                                                               \
+    SHMEMU_CHECK_INIT();                                                       \
+    SHMEMU_CHECK_PE_ARG_RANGE(pe, 5);                                          \
+    SHMEMU_CHECK_SYMMETRIC(dest, 2);                                           \
+                                                                               \
+    SHMEMT_MUTEX_NOPROTECT(h = (shmemx_handle_t)shmemc_ctx_put_nbx(            \
+                               ctx, dest, src, sizeof(_type) * nelems, pe));   \
+                                                                               \
+    logger(LOG_RMA, "%s(ctx=%lu, dest=%p, src=%p, nelems=%lu, pe=%d) -> %p",   \
+           __func__, shmemc_context_id(ctx), dest, src, nelems, pe, h);        \
+                                                                               \
+    return h;                                                                  \
+  }                                                                            \
+  shmemx_handle_t shmemx_##_name##_put_nbx(_type *dest, const _type *src,      \
+                                          size_t nelems, int pe) {             \
+    return shmemx_ctx_##_name##_put_nbx(SHMEM_CTX_DEFAULT, dest, src, nelems,  \
+                                       pe);                                    \
+  }
+
+#ifdef ENABLE_PSHMEM
+#pragma weak shmemx_ctx_float_put_nbx = pshmemx_ctx_float_put_nbx
+#define shmemx_ctx_float_put_nbx pshmemx_ctx_float_put_nbx
+#pragma weak shmemx_float_put_nbx = pshmemx_float_put_nbx
+#define shmemx_float_put_nbx pshmemx_float_put_nbx
+#pragma weak shmemx_ctx_double_put_nbx = pshmemx_ctx_double_put_nbx
+#define shmemx_ctx_double_put_nbx pshmemx_ctx_double_put_nbx
+#pragma weak shmemx_double_put_nbx = pshmemx_double_put_nbx
+#define shmemx_double_put_nbx pshmemx_double_put_nbx
+#pragma weak shmemx_ctx_longdouble_put_nbx = pshmemx_ctx_longdouble_put_nbx
+#define shmemx_ctx_longdouble_put_nbx pshmemx_ctx_longdouble_put_nbx
+#pragma weak shmemx_longdouble_put_nbx = pshmemx_longdouble_put_nbx
+#define shmemx_longdouble_put_nbx pshmemx_longdouble_put_nbx
+#pragma weak shmemx_ctx_char_put_nbx = pshmemx_ctx_char_put_nbx
+#define shmemx_ctx_char_put_nbx pshmemx_ctx_char_put_nbx
+#pragma weak shmemx_char_put_nbx = pshmemx_char_put_nbx
+#define shmemx_char_put_nbx pshmemx_char_put_nbx
+#pragma weak shmemx_ctx_schar_put_nbx = pshmemx_ctx_schar_put_nbx
+#define shmemx_ctx_schar_put_nbx pshmemx_ctx_schar_put_nbx
+#pragma weak shmemx_schar_put_nbx = pshmemx_schar_put_nbx
+#define shmemx_schar_put_nbx pshmemx_schar_put_nbx
+#pragma weak shmemx_ctx_short_put_nbx = pshmemx_ctx_short_put_nbx
+#define shmemx_ctx_short_put_nbx pshmemx_ctx_short_put_nbx
+#pragma weak shmemx_short_put_nbx = pshmemx_short_put_nbx
+#define shmemx_short_put_nbx pshmemx_short_put_nbx
+#pragma weak shmemx_ctx_int_put_nbx = pshmemx_ctx_int_put_nbx
+#define shmemx_ctx_int_put_nbx pshmemx_ctx_int_put_nbx
+#pragma weak shmemx_int_put_nbx = pshmemx_int_put_nbx
+#define shmemx_int_put_nbx pshmemx_int_put_nbx
+#pragma weak shmemx_ctx_long_put_nbx = pshmemx_ctx_long_put_nbx
+#define shmemx_ctx_long_put_nbx pshmemx_ctx_long_put_nbx
+#pragma weak shmemx_long_put_nbx = pshmemx_long_put_nbx
+#define shmemx_long_put_nbx pshmemx_long_put_nbx
+#pragma weak shmemx_ctx_longlong_put_nbx = pshmemx_ctx_longlong_put_nbx
+#define shmemx_ctx_longlong_put_nbx pshmemx_ctx_longlong_put_nbx
+#pragma weak shmemx_longlong_put_nbx = pshmemx_longlong_put_nbx
+#define shmemx_longlong_put_nbx pshmemx_longlong_put_nbx
+#pragma weak shmemx_ctx_uchar_put_nbx = pshmemx_ctx_uchar_put_nbx
+#define shmemx_ctx_uchar_put_nbx pshmemx_ctx_uchar_put_nbx
+#pragma weak shmemx_uchar_put_nbx = pshmemx_uchar_put_nbx
+#define shmemx_uchar_put_nbx pshmemx_uchar_put_nbx
+#pragma weak shmemx_ctx_ushort_put_nbx = pshmemx_ctx_ushort_put_nbx
+#define shmemx_ctx_ushort_put_nbx pshmemx_ctx_ushort_put_nbx
+#pragma weak shmemx_ushort_put_nbx = pshmemx_ushort_put_nbx
+#define shmemx_ushort_put_nbx pshmemx_ushort_put_nbx
+#pragma weak shmemx_ctx_uint_put_nbx = pshmemx_ctx_uint_put_nbx
+#define shmemx_ctx_uint_put_nbx pshmemx_ctx_uint_put_nbx
+#pragma weak shmemx_uint_put_nbx = pshmemx_uint_put_nbx
+#define shmemx_uint_put_nbx pshmemx_uint_put_nbx
+#pragma weak shmemx_ctx_ulong_put_nbx = pshmemx_ctx_ulong_put_nbx
+#define shmemx_ctx_ulong_put_nbx pshmemx_ctx_ulong_put_nbx
+#pragma weak shmemx_ulong_put_nbx = pshmemx_ulong_put_nbx
+#define shmemx_ulong_put_nbx pshmemx_ulong_put_nbx
+#pragma weak shmemx_ctx_ulonglong_put_nbx = pshmemx_ctx_ulonglong_put_nbx
+#define shmemx_ctx_ulonglong_put_nbx pshmemx_ctx_ulonglong_put_nbx
+#pragma weak shmemx_ulonglong_put_nbx = pshmemx_ulonglong_put_nbx
+#define shmemx_ulonglong_put_nbx pshmemx_ulonglong_put_nbx
+#pragma weak shmemx_ctx_int8_put_nbx = pshmemx_ctx_int8_put_nbx
+#define shmemx_ctx_int8_put_nbx pshmemx_ctx_int8_put_nbx
+#pragma weak shmemx_int8_put_nbx = pshmemx_int8_put_nbx
+#define shmemx_int8_put_nbx pshmemx_int8_put_nbx
+#pragma weak shmemx_ctx_int16_put_nbx = pshmemx_ctx_int16_put_nbx
+#define shmemx_ctx_int16_put_nbx pshmemx_ctx_int16_put_nbx
+#pragma weak shmemx_int16_put_nbx = pshmemx_int16_put_nbx
+#define shmemx_int16_put_nbx pshmemx_int16_put_nbx
+#pragma weak shmemx_ctx_int32_put_nbx = pshmemx_ctx_int32_put_nbx
+#define shmemx_ctx_int32_put_nbx pshmemx_ctx_int32_put_nbx
+#pragma weak shmemx_int32_put_nbx = pshmemx_int32_put_nbx
+#define shmemx_int32_put_nbx pshmemx_int32_put_nbx
+#pragma weak shmemx_ctx_int64_put_nbx = pshmemx_ctx_int64_put_nbx
+#define shmemx_ctx_int64_put_nbx pshmemx_ctx_int64_put_nbx
+#pragma weak shmemx_int64_put_nbx = pshmemx_int64_put_nbx
+#define shmemx_int64_put_nbx pshmemx_int64_put_nbx
+#pragma weak shmemx_ctx_uint8_put_nbx = pshmemx_ctx_uint8_put_nbx
+#define shmemx_ctx_uint8_put_nbx pshmemx_ctx_uint8_put_nbx
+#pragma weak shmemx_uint8_put_nbx = pshmemx_uint8_put_nbx
+#define shmemx_uint8_put_nbx pshmemx_uint8_put_nbx
+#pragma weak shmemx_ctx_uint16_put_nbx = pshmemx_ctx_uint16_put_nbx
+#define shmemx_ctx_uint16_put_nbx pshmemx_ctx_uint16_put_nbx
+#pragma weak shmemx_uint16_put_nbx = pshmemx_uint16_put_nbx
+#define shmemx_uint16_put_nbx pshmemx_uint16_put_nbx
+#pragma weak shmemx_ctx_uint32_put_nbx = pshmemx_ctx_uint32_put_nbx
+#define shmemx_ctx_uint32_put_nbx pshmemx_ctx_uint32_put_nbx
+#pragma weak shmemx_uint32_put_nbx = pshmemx_uint32_put_nbx
+#define shmemx_uint32_put_nbx pshmemx_uint32_put_nbx
+#pragma weak shmemx_ctx_uint64_put_nbx = pshmemx_ctx_uint64_put_nbx
+#define shmemx_ctx_uint64_put_nbx pshmemx_ctx_uint64_put_nbx
+#pragma weak shmemx_uint64_put_nbx = pshmemx_uint64_put_nbx
+#define shmemx_uint64_put_nbx pshmemx_uint64_put_nbx
+#pragma weak shmemx_ctx_size_put_nbx = pshmemx_ctx_size_put_nbx
+#define shmemx_ctx_size_put_nbx pshmemx_ctx_size_put_nbx
+#pragma weak shmemx_size_put_nbx = pshmemx_size_put_nbx
+#define shmemx_size_put_nbx pshmemx_size_put_nbx
+#pragma weak shmemx_ctx_ptrdiff_put_nbx = pshmemx_ctx_ptrdiff_put_nbx
+#define shmemx_ctx_ptrdiff_put_nbx pshmemx_ctx_ptrdiff_put_nbx
+#pragma weak shmemx_ptrdiff_put_nbx = pshmemx_ptrdiff_put_nbx
+#define shmemx_ptrdiff_put_nbx pshmemx_ptrdiff_put_nbx
+#endif /* ENABLE_PSHMEM */
+
+#define PUT_NBX_TYPE_HELPER(_type, _typename)                                  \
+  SHMEMX_CTX_TYPED_PUT_NBX(_typename, _type)
+SHMEM_STANDARD_RMA_TYPE_TABLE(PUT_NBX_TYPE_HELPER)
+#undef PUT_NBX_TYPE_HELPER
+
+#ifdef ENABLE_PSHMEM
+#pragma weak shmemx_ctx_putmem_nbx = pshmemx_ctx_putmem_nbx
+#define shmemx_ctx_putmem_nbx pshmemx_ctx_putmem_nbx
+#pragma weak shmemx_putmem_nbx = pshmemx_putmem_nbx
+#define shmemx_putmem_nbx pshmemx_putmem_nbx
+#endif /* ENABLE_PSHMEM */
+
+shmemx_handle_t shmemx_ctx_putmem_nbx(shmem_ctx_t ctx, void *dest,
+                                     const void *src, size_t nbytes, int pe) {
+  shmemx_handle_t h;
+
+  SHMEMU_CHECK_INIT();
+  SHMEMU_CHECK_PE_ARG_RANGE(pe, 5);
+  SHMEMU_CHECK_SYMMETRIC(dest, 2);
+
+  SHMEMT_MUTEX_NOPROTECT(
+      h = (shmemx_handle_t)shmemc_ctx_put_nbx(ctx, dest, src, nbytes, pe));
+
+  logger(LOG_RMA, "%s(ctx=%lu, dest=%p, src=%p, nbytes=%lu, pe=%d) -> %p",
+         __func__, shmemc_context_id(ctx), dest, src, nbytes, pe, h);
+
+  return h;
+}
+
+shmemx_handle_t shmemx_putmem_nbx(void *dest, const void *src, size_t nbytes,
+                                 int pe) {
+  return shmemx_ctx_putmem_nbx(SHMEM_CTX_DEFAULT, dest, src, nbytes, pe);
+}
+
+/*
+ * -- gets --
+ */
+
+#define SHMEMX_CTX_TYPED_GET_NBX(_name, _type)                                 \
+  shmemx_handle_t shmemx_ctx_##_name##_get_nbx(                                \
+      shmem_ctx_t ctx, _type *dest, const _type *src, size_t nelems, int pe) { \
+    shmemx_handle_t h;                                                         \
+                                                                               \
+    SHMEMU_CHECK_INIT();                                                       \
+    SHMEMU_CHECK_PE_ARG_RANGE(pe, 5);                                          \
+    SHMEMU_CHECK_SYMMETRIC(src, 3);                                            \
+                                                                               \
+    SHMEMT_MUTEX_NOPROTECT(h = (shmemx_handle_t)shmemc_ctx_get_nbx(            \
+                               ctx, dest, src, sizeof(_type) * nelems, pe));   \
+                                                                               \
+    logger(LOG_RMA, "%s(ctx=%lu, dest=%p, src=%p, nelems=%lu, pe=%d) -> %p",   \
+           __func__, shmemc_context_id(ctx), dest, src, nelems, pe, h);        \
+                                                                               \
+    return h;                                                                  \
+  }                                                                            \
+  shmemx_handle_t shmemx_##_name##_get_nbx(_type *dest, const _type *src,      \
+                                          size_t nelems, int pe) {             \
+    return shmemx_ctx_##_name##_get_nbx(SHMEM_CTX_DEFAULT, dest, src, nelems,  \
+                                       pe);                                    \
+  }
+
+#ifdef ENABLE_PSHMEM
+#pragma weak shmemx_ctx_float_get_nbx = pshmemx_ctx_float_get_nbx
+#define shmemx_ctx_float_get_nbx pshmemx_ctx_float_get_nbx
+#pragma weak shmemx_float_get_nbx = pshmemx_float_get_nbx
+#define shmemx_float_get_nbx pshmemx_float_get_nbx
+#pragma weak shmemx_ctx_double_get_nbx = pshmemx_ctx_double_get_nbx
+#define shmemx_ctx_double_get_nbx pshmemx_ctx_double_get_nbx
+#pragma weak shmemx_double_get_nbx = pshmemx_double_get_nbx
+#define shmemx_double_get_nbx pshmemx_double_get_nbx
+#pragma weak shmemx_ctx_longdouble_get_nbx = pshmemx_ctx_longdouble_get_nbx
+#define shmemx_ctx_longdouble_get_nbx pshmemx_ctx_longdouble_get_nbx
+#pragma weak shmemx_longdouble_get_nbx = pshmemx_longdouble_get_nbx
+#define shmemx_longdouble_get_nbx pshmemx_longdouble_get_nbx
+#pragma weak shmemx_ctx_char_get_nbx = pshmemx_ctx_char_get_nbx
+#define shmemx_ctx_char_get_nbx pshmemx_ctx_char_get_nbx
+#pragma weak shmemx_char_get_nbx = pshmemx_char_get_nbx
+#define shmemx_char_get_nbx pshmemx_char_get_nbx
+#pragma weak shmemx_ctx_schar_get_nbx = pshmemx_ctx_schar_get_nbx
+#define shmemx_ctx_schar_get_nbx pshmemx_ctx_schar_get_nbx
+#pragma weak shmemx_schar_get_nbx = pshmemx_schar_get_nbx
+#define shmemx_schar_get_nbx pshmemx_schar_get_nbx
+#pragma weak shmemx_ctx_short_get_nbx = pshmemx_ctx_short_get_nbx
+#define shmemx_ctx_short_get_nbx pshmemx_ctx_short_get_nbx
+#pragma weak shmemx_short_get_nbx = pshmemx_short_get_nbx
+#define shmemx_short_get_nbx pshmemx_short_get_nbx
+#pragma weak shmemx_ctx_int_get_nbx = pshmemx_ctx_int_get_nbx
+#define shmemx_ctx_int_get_nbx pshmemx_ctx_int_get_nbx
+#pragma weak shmemx_int_get_nbx = pshmemx_int_get_nbx
+#define shmemx_int_get_nbx pshmemx_int_get_nbx
+#pragma weak shmemx_ctx_long_get_nbx = pshmemx_ctx_long_get_nbx
+#define shmemx_ctx_long_get_nbx pshmemx_ctx_long_get_nbx
+#pragma weak shmemx_long_get_nbx = pshmemx_long_get_nbx
+#define shmemx_long_get_nbx pshmemx_long_get_nbx
+#pragma weak shmemx_ctx_longlong_get_nbx = pshmemx_ctx_longlong_get_nbx
+#define shmemx_ctx_longlong_get_nbx pshmemx_ctx_longlong_get_nbx
+#pragma weak shmemx_longlong_get_nbx = pshmemx_longlong_get_nbx
+#define shmemx_longlong_get_nbx pshmemx_longlong_get_nbx
+#pragma weak shmemx_ctx_uchar_get_nbx = pshmemx_ctx_uchar_get_nbx
+#define shmemx_ctx_uchar_get_nbx pshmemx_ctx_uchar_get_nbx
+#pragma weak shmemx_uchar_get_nbx = pshmemx_uchar_get_nbx
+#define shmemx_uchar_get_nbx pshmemx_uchar_get_nbx
+#pragma weak shmemx_ctx_ushort_get_nbx = pshmemx_ctx_ushort_get_nbx
+#define shmemx_ctx_ushort_get_nbx pshmemx_ctx_ushort_get_nbx
+#pragma weak shmemx_ushort_get_nbx = pshmemx_ushort_get_nbx
+#define shmemx_ushort_get_nbx pshmemx_ushort_get_nbx
+#pragma weak shmemx_ctx_uint_get_nbx = pshmemx_ctx_uint_get_nbx
+#define shmemx_ctx_uint_get_nbx pshmemx_ctx_uint_get_nbx
+#pragma weak shmemx_uint_get_nbx = pshmemx_uint_get_nbx
+#define shmemx_uint_get_nbx pshmemx_uint_get_nbx
+#pragma weak shmemx_ctx_ulong_get_nbx = pshmemx_ctx_ulong_get_nbx
+#define shmemx_ctx_ulong_get_nbx pshmemx_ctx_ulong_get_nbx
+#pragma weak shmemx_ulong_get_nbx = pshmemx_ulong_get_nbx
+#define shmemx_ulong_get_nbx pshmemx_ulong_get_nbx
+#pragma weak shmemx_ctx_ulonglong_get_nbx = pshmemx_ctx_ulonglong_get_nbx
+#define shmemx_ctx_ulonglong_get_nbx pshmemx_ctx_ulonglong_get_nbx
+#pragma weak shmemx_ulonglong_get_nbx = pshmemx_ulonglong_get_nbx
+#define shmemx_ulonglong_get_nbx pshmemx_ulonglong_get_nbx
+#pragma weak shmemx_ctx_int8_get_nbx = pshmemx_ctx_int8_get_nbx
+#define shmemx_ctx_int8_get_nbx pshmemx_ctx_int8_get_nbx
+#pragma weak shmemx_int8_get_nbx = pshmemx_int8_get_nbx
+#define shmemx_int8_get_nbx pshmemx_int8_get_nbx
+#pragma weak shmemx_ctx_int16_get_nbx = pshmemx_ctx_int16_get_nbx
+#define shmemx_ctx_int16_get_nbx pshmemx_ctx_int16_get_nbx
+#pragma weak shmemx_int16_get_nbx = pshmemx_int16_get_nbx
+#define shmemx_int16_get_nbx pshmemx_int16_get_nbx
+#pragma weak shmemx_ctx_int32_get_nbx = pshmemx_ctx_int32_get_nbx
+#define shmemx_ctx_int32_get_nbx pshmemx_ctx_int32_get_nbx
+#pragma weak shmemx_int32_get_nbx = pshmemx_int32_get_nbx
+#define shmemx_int32_get_nbx pshmemx_int32_get_nbx
+#pragma weak shmemx_ctx_int64_get_nbx = pshmemx_ctx_int64_get_nbx
+#define shmemx_ctx_int64_get_nbx pshmemx_ctx_int64_get_nbx
+#pragma weak shmemx_int64_get_nbx = pshmemx_int64_get_nbx
+#define shmemx_int64_get_nbx pshmemx_int64_get_nbx
+#pragma weak shmemx_ctx_uint8_get_nbx = pshmemx_ctx_uint8_get_nbx
+#define shmemx_ctx_uint8_get_nbx pshmemx_ctx_uint8_get_nbx
+#pragma weak shmemx_uint8_get_nbx = pshmemx_uint8_get_nbx
+#define shmemx_uint8_get_nbx pshmemx_uint8_get_nbx
+#pragma weak shmemx_ctx_uint16_get_nbx = pshmemx_ctx_uint16_get_nbx
+#define shmemx_ctx_uint16_get_nbx pshmemx_ctx_uint16_get_nbx
+#pragma weak shmemx_uint16_get_nbx = pshmemx_uint16_get_nbx
+#define shmemx_uint16_get_nbx pshmemx_uint16_get_nbx
+#pragma weak shmemx_ctx_uint32_get_nbx = pshmemx_ctx_uint32_get_nbx
+#define shmemx_ctx_uint32_get_nbx pshmemx_ctx_uint32_get_nbx
+#pragma weak shmemx_uint32_get_nbx = pshmemx_uint32_get_nbx
+#define shmemx_uint32_get_nbx pshmemx_uint32_get_nbx
+#pragma weak shmemx_ctx_uint64_get_nbx = pshmemx_ctx_uint64_get_nbx
+#define shmemx_ctx_uint64_get_nbx pshmemx_ctx_uint64_get_nbx
+#pragma weak shmemx_uint64_get_nbx = pshmemx_uint64_get_nbx
+#define shmemx_uint64_get_nbx pshmemx_uint64_get_nbx
+#pragma weak shmemx_ctx_size_get_nbx = pshmemx_ctx_size_get_nbx
+#define shmemx_ctx_size_get_nbx pshmemx_ctx_size_get_nbx
+#pragma weak shmemx_size_get_nbx = pshmemx_size_get_nbx
+#define shmemx_size_get_nbx pshmemx_size_get_nbx
+#pragma weak shmemx_ctx_ptrdiff_get_nbx = pshmemx_ctx_ptrdiff_get_nbx
+#define shmemx_ctx_ptrdiff_get_nbx pshmemx_ctx_ptrdiff_get_nbx
+#pragma weak shmemx_ptrdiff_get_nbx = pshmemx_ptrdiff_get_nbx
+#define shmemx_ptrdiff_get_nbx pshmemx_ptrdiff_get_nbx
+#endif /* ENABLE_PSHMEM */
+
+#define GET_NBX_TYPE_HELPER(_type, _typename)                                  \
+  SHMEMX_CTX_TYPED_GET_NBX(_typename, _type)
+SHMEM_STANDARD_RMA_TYPE_TABLE(GET_NBX_TYPE_HELPER)
+#undef GET_NBX_TYPE_HELPER
+
+#ifdef ENABLE_PSHMEM
+#pragma weak shmemx_ctx_getmem_nbx = pshmemx_ctx_getmem_nbx
+#define shmemx_ctx_getmem_nbx pshmemx_ctx_getmem_nbx
+#pragma weak shmemx_getmem_nbx = pshmemx_getmem_nbx
+#define shmemx_getmem_nbx pshmemx_getmem_nbx
+#endif /* ENABLE_PSHMEM */
+
+shmemx_handle_t shmemx_ctx_getmem_nbx(shmem_ctx_t ctx, void *dest,
+                                     const void *src, size_t nbytes, int pe) {
+  shmemx_handle_t h;
+
+  SHMEMU_CHECK_INIT();
+  SHMEMU_CHECK_PE_ARG_RANGE(pe, 5);
+  SHMEMU_CHECK_SYMMETRIC(src, 3);
+
+  SHMEMT_MUTEX_NOPROTECT(
+      h = (shmemx_handle_t)shmemc_ctx_get_nbx(ctx, dest, src, nbytes, pe));
+
+  logger(LOG_RMA, "%s(ctx=%lu, dest=%p, src=%p, nbytes=%lu, pe=%d) -> %p",
+         __func__, shmemc_context_id(ctx), dest, src, nbytes, pe, h);
+
+  return h;
+}
+
+shmemx_handle_t shmemx_getmem_nbx(void *dest, const void *src, size_t nbytes,
+                                 int pe) {
+  return shmemx_ctx_getmem_nbx(SHMEM_CTX_DEFAULT, dest, src, nbytes, pe);
+}
+
+/*
+ * -- completion --
+ *
+ * Handles are reset to NULL once complete, so they can't be waited on
+ * twice.
+ */
+
+#ifdef ENABLE_PSHMEM
+#pragma weak shmemx_test = pshmemx_test
+#define shmemx_test pshmemx_test
+#endif /* ENABLE_PSHMEM */
+
+int shmemx_test(shmemx_handle_t *hp) {
+  int s;
+
+  SHMEMU_CHECK_NOT_NULL(hp, 1);
+
+  SHMEMT_MUTEX_NOPROTECT(s = shmemc_request_test(*hp));
+  if (s) {
+    *hp = NULL;
+  }
+
+  return s;
+}
+
+#ifdef ENABLE_PSHMEM
+#pragma weak shmemx_wait = pshmemx_wait
+#define shmemx_wait pshmemx_wait
+#endif /* ENABLE_PSHMEM */
+
+void shmemx_wait(shmemx_handle_t *hp) {
+  SHMEMU_CHECK_NOT_NULL(hp, 1);
+
+  SHMEMT_MUTEX_NOPROTECT(shmemc_request_wait(*hp));
+  *hp = NULL;
+}
+
+#ifdef ENABLE_PSHMEM
+#pragma weak shmemx_waitall = pshmemx_waitall
+#define shmemx_waitall pshmemx_waitall
+#endif /* ENABLE_PSHMEM */
+
+void shmemx_waitall(shmemx_handle_t *hs, size_t n) {
+  size_t i;
+
+  if (n > 0) {
+    SHMEMU_CHECK_NOT_NULL(hs, 1);
+  }
+
+  for (i = 0; i < n; ++i) {
+    SHMEMT_MUTEX_NOPROTECT(shmemc_request_wait(hs[i]));
+    hs[i] = NULL;
+  }
+}
+
+#ifdef ENABLE_PSHMEM
+#pragma weak shmemx_testany = pshmemx_testany
+#define shmemx_testany pshmemx_testany
+#endif /* ENABLE_PSHMEM */
+
+int shmemx_testany(shmemx_handle_t *hs, size_t n, size_t *idx) {
+  size_t i;
+
+  if (n > 0) {
+    SHMEMU_CHECK_NOT_NULL(hs, 1);
+  }
+  SHMEMU_CHECK_NOT_NULL(idx, 3);
+
+  for (i = 0; i < n; ++i) {
+    if (hs[i] != NULL) {
+      int s;
+
+      SHMEMT_MUTEX_NOPROTECT(s = shmemc_request_test(hs[i]));
+      if (s) {
+        hs[i] = NULL;
+        *idx = i;
+        return 1;
+        /* NOT REACHED */
+      }
+    }
+  }
+
+  return 0;
+}
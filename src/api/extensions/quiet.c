@@ -38,9 +38,33 @@ int shmemx_quiet_test(void) {
 #endif /* ENABLE_PSHMEM */
 
 void shmemx_pe_quiet(shmem_ctx_t ctx, int pe) {
-  NO_WARN_UNUSED(pe);
+  SHMEMU_CHECK_INIT();
+  SHMEMU_CHECK_PE_ARG_RANGE(pe, 2);
 
-  SHMEMT_MUTEX_NOPROTECT(shmemc_ctx_quiet(ctx));
+  SHMEMT_MUTEX_NOPROTECT(shmemc_ctx_pe_quiet(ctx, pe));
 
-  logger(LOG_QUIET, "%s(ctx=%lu)", __func__, shmemc_context_id(ctx));
+  logger(LOG_QUIET, "%s(ctx=%lu, pe=%d)", __func__, shmemc_context_id(ctx),
+         pe);
+}
+
+#ifdef ENABLE_PSHMEM
+#pragma weak shmemx_pe_quiet_multi = pshmemx_pe_quiet_multi
+#define shmemx_pe_quiet_multi pshmemx_pe_quiet_multi
+#endif /* ENABLE_PSHMEM */
+
+void shmemx_pe_quiet_multi(shmem_ctx_t ctx, const int *pes, size_t npes) {
+  SHMEMU_CHECK_INIT();
+  if (npes > 0) {
+    size_t i;
+
+    SHMEMU_CHECK_NOT_NULL(pes, 2);
+    for (i = 0; i < npes; ++i) {
+      SHMEMU_CHECK_PE_ARG_RANGE(pes[i], 2);
+    }
+  }
+
+  SHMEMT_MUTEX_NOPROTECT(shmemc_ctx_pe_quiet_multi(ctx, pes, npes));
+
+  logger(LOG_QUIET, "%s(ctx=%lu, pes=%p, npes=%lu)", __func__,
+         shmemc_context_id(ctx), pes, (unsigned long)npes);
 }
@@ -0,0 +1,132 @@
+/* For license: see LICENSE file at top-level */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif /* HAVE_CONFIG_H */
+
+#include "shmemu.h"
+#include "shmemc.h"
+#include "shmem.h"
+#include "shmemx.h"
+#include "shmem_mutex.h"
+#include "lock.h"
+
+/*
+ * Reader-writer locks.
+ *
+ * "state" on the owner PE counts readers in its low bits, plus
+ * RW_WRITER while a writer is in or waiting.  "wlock" is a standard
+ * lock that queues writers, and readers that ran into one.
+ *
+ * A reader takes the lock with one fetch-add on the owner.  If that
+ * shows a writer, it backs out and queues on wlock: once it has
+ * that, no writer can be in, so it adds itself and lets the next one
+ * in the queue go.
+ *
+ * A writer takes wlock, sets RW_WRITER so no more readers get in, and
+ * waits for the readers already in to leave.
+ */
+
+#define RW_WRITER (1UL << 62)
+#define RW_READERS (RW_WRITER - 1)
+
+inline static int rw_owner(shmemx_rwlock_t *rw) { return lock_owner(rw); }
+
+static void rw_read_lock(shmemx_rwlock_t *rw) {
+  const int owner = rw_owner(rw);
+  unsigned long old;
+
+  old = shmem_ulong_atomic_fetch_add(&rw->state, 1, owner);
+  if ((old & RW_WRITER) == 0) {
+    return;
+    /* NOT REACHED */
+  }
+
+  shmem_ulong_atomic_add(&rw->state, -1UL, owner);
+
+  shmem_set_lock(&rw->wlock);
+  shmem_ulong_atomic_add(&rw->state, 1, owner);
+  shmem_clear_lock(&rw->wlock);
+}
+
+static void rw_read_unlock(shmemx_rwlock_t *rw) {
+  /* reads done before we go */
+  shmemc_quiet();
+
+  shmem_ulong_atomic_add(&rw->state, -1UL, rw_owner(rw));
+}
+
+static void rw_write_lock(shmemx_rwlock_t *rw) {
+  const int owner = rw_owner(rw);
+  unsigned long old;
+
+  shmem_set_lock(&rw->wlock);
+
+  old = shmem_ulong_atomic_fetch_add(&rw->state, RW_WRITER, owner);
+
+  /* wait for readers already in */
+  while ((old & RW_READERS) != 0) {
+    shmemc_progress();
+    old = shmem_ulong_atomic_fetch(&rw->state, owner);
+  }
+}
+
+static void rw_write_unlock(shmemx_rwlock_t *rw) {
+  /* writes land before anyone else gets in */
+  shmemc_quiet();
+
+  shmem_ulong_atomic_add(&rw->state, -RW_WRITER, rw_owner(rw));
+
+  shmem_clear_lock(&rw->wlock);
+}
+
+#ifdef ENABLE_PSHMEM
+#pragma weak shmemx_rwlock_read_lock = pshmemx_rwlock_read_lock
+#define shmemx_rwlock_read_lock pshmemx_rwlock_read_lock
+#pragma weak shmemx_rwlock_read_unlock = pshmemx_rwlock_read_unlock
+#define shmemx_rwlock_read_unlock pshmemx_rwlock_read_unlock
+#pragma weak shmemx_rwlock_write_lock = pshmemx_rwlock_write_lock
+#define shmemx_rwlock_write_lock pshmemx_rwlock_write_lock
+#pragma weak shmemx_rwlock_write_unlock = pshmemx_rwlock_write_unlock
+#define shmemx_rwlock_write_unlock pshmemx_rwlock_write_unlock
+#endif /* ENABLE_PSHMEM */
+
+void shmemx_rwlock_read_lock(shmemx_rwlock_t *rw) {
+  SHMEMU_CHECK_INIT();
+  SHMEMU_CHECK_NOT_NULL(rw, 1);
+  SHMEMU_CHECK_SYMMETRIC(rw, 1);
+
+  logger(LOG_LOCKS, "%s(rwlock=%p)", __func__, rw);
+
+  SHMEMT_MUTEX_NOPROTECT(rw_read_lock(rw));
+}
+
+void shmemx_rwlock_read_unlock(shmemx_rwlock_t *rw) {
+  SHMEMU_CHECK_INIT();
+  SHMEMU_CHECK_NOT_NULL(rw, 1);
+  SHMEMU_CHECK_SYMMETRIC(rw, 1);
+
+  logger(LOG_LOCKS, "%s(rwlock=%p)", __func__, rw);
+
+  SHMEMT_MUTEX_NOPROTECT(rw_read_unlock(rw));
+}
+
+void shmemx_rwlock_write_lock(shmemx_rwlock_t *rw) {
+  SHMEMU_CHECK_INIT();
+  SHMEMU_CHECK_NOT_NULL(rw, 1);
+  SHMEMU_CHECK_SYMMETRIC(rw, 1);
+
+  logger(LOG_LOCKS, "%s(rwlock=%p)", __func__, rw);
+
+  SHMEMT_MUTEX_NOPROTECT(rw_write_lock(rw));
+}
+
+void shmemx_rwlock_write_unlock(shmemx_rwlock_t *rw) {
+  SHMEMU_CHECK_INIT();
+  SHMEMU_CHECK_NOT_NULL(rw, 1);
+  SHMEMU_CHECK_SYMMETRIC(rw, 1);
+
+  logger(LOG_LOCKS, "%s(rwlock=%p)", __func__, rw);
+
+  SHMEMT_MUTEX_NOPROTECT(rw_write_unlock(rw));
+}
@@ -0,0 +1,391 @@
+/* For license: see LICENSE file at top-level */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif /* HAVE_CONFIG_H */
+
+#include "shmemu.h"
+#include "shmemc.h"
+#include "shmem_mutex.h"
+#include "shmemx.h"
+
+#include <shmem/api_types.h>
+
+/*
+ * Non-blocking strided puts and gets: same argument checking as the
+ * blocking versions, completion at the next quiet on the context.
+ */
+
+/*
+ * -- strided puts --
+ */
+
+#define SHMEMX_CTX_TYPED_IPUT_NBI(_name, _type)                                \
+  void shmemx_ctx_##_name##_iput_nbi(shmem_ctx_t ctx, _type *target,           \
+                                    const _type *source, ptrdiff_t tst,        \
+                                    ptrdiff_t sst, size_t nelems, int pe) {    \
+    SHMEMU_CHECK_INIT();                                                       \
+    SHMEMU_CHECK_PE_ARG_RANGE(pe, 7);                                          \
+    SHMEMU_CHECK_SYMMETRIC(target, 2);                                         \
+                                                                               \
+    logger(LOG_RMA,                                                            \
+           "%s(ctx=%lu, dest=%p, src=%p, "                                     \
+           "tst=%lu, sst=%lu, nelems=%lu, pe=%d)",                             \
+           __func__, shmemc_context_id(ctx), target, source, tst, sst, nelems, \
+           pe);                                                                \
+                                                                               \
+    SHMEMT_MUTEX_NOPROTECT(shmemc_ctx_iput_nbi(ctx, target, source, tst, sst,  \
+                                               sizeof(_type), nelems, pe));    \
+  }                                                                            \
+  void shmemx_##_name##_iput_nbi(_type *target, const _type *source,           \
+                                ptrdiff_t tst, ptrdiff_t sst, size_t nelems,   \
+                                int pe) {                                      \
+    shmemx_ctx_##_name##_iput_nbi(SHMEM_CTX_DEFAULT, target, source, tst, sst, \
+                                 nelems, pe);                                  \
+  }
+
+#define SHMEMX_CTX_SIZED_IPUT_NBI(_size)                                       \
+  void shmemx_ctx_iput##_size##_nbi(shmem_ctx_t ctx, void *target,             \
+                                   const void *source, ptrdiff_t tst,          \
+                                   ptrdiff_t sst, size_t nelems, int pe) {     \
+    SHMEMU_CHECK_INIT();                                                       \
+    SHMEMU_CHECK_PE_ARG_RANGE(pe, 7);                                          \
+    SHMEMU_CHECK_SYMMETRIC(target, 2);                                         \
+                                                                               \
+    logger(LOG_RMA,                                                            \
+           "%s(ctx=%lu, dest=%p, src=%p, "                                     \
+           "tst=%lu, sst=%lu, nelems=%lu, pe=%d)",                             \
+           __func__, shmemc_context_id(ctx), target, source, tst, sst, nelems, \
+           pe);                                                                \
+                                                                               \
+    SHMEMT_MUTEX_NOPROTECT(shmemc_ctx_iput_nbi(ctx, target, source, tst, sst,  \
+                                               BITS2BYTES(_size), nelems,      \
+                                               pe));                           \
+  }                                                                            \
+  void shmemx_iput##_size##_nbi(void *target, const void *source,              \
+                               ptrdiff_t tst, ptrdiff_t sst, size_t nelems,    \
+                               int pe) {                                       \
+    shmemx_ctx_iput##_size##_nbi(SHMEM_CTX_DEFAULT, target, source, tst, sst,  \
+                                nelems, pe);                                   \
+  }
+
+#ifdef ENABLE_PSHMEM
+#pragma weak shmemx_ctx_float_iput_nbi = pshmemx_ctx_float_iput_nbi
+#define shmemx_ctx_float_iput_nbi pshmemx_ctx_float_iput_nbi
+#pragma weak shmemx_float_iput_nbi = pshmemx_float_iput_nbi
+#define shmemx_float_iput_nbi pshmemx_float_iput_nbi
+#pragma weak shmemx_ctx_double_iput_nbi = pshmemx_ctx_double_iput_nbi
+#define shmemx_ctx_double_iput_nbi pshmemx_ctx_double_iput_nbi
+#pragma weak shmemx_double_iput_nbi = pshmemx_double_iput_nbi
+#define shmemx_double_iput_nbi pshmemx_double_iput_nbi
+#pragma weak shmemx_ctx_longdouble_iput_nbi = pshmemx_ctx_longdouble_iput_nbi
+#define shmemx_ctx_longdouble_iput_nbi pshmemx_ctx_longdouble_iput_nbi
+#pragma weak shmemx_longdouble_iput_nbi = pshmemx_longdouble_iput_nbi
+#define shmemx_longdouble_iput_nbi pshmemx_longdouble_iput_nbi
+#pragma weak shmemx_ctx_char_iput_nbi = pshmemx_ctx_char_iput_nbi
+#define shmemx_ctx_char_iput_nbi pshmemx_ctx_char_iput_nbi
+#pragma weak shmemx_char_iput_nbi = pshmemx_char_iput_nbi
+#define shmemx_char_iput_nbi pshmemx_char_iput_nbi
+#pragma weak shmemx_ctx_schar_iput_nbi = pshmemx_ctx_schar_iput_nbi
+#define shmemx_ctx_schar_iput_nbi pshmemx_ctx_schar_iput_nbi
+#pragma weak shmemx_schar_iput_nbi = pshmemx_schar_iput_nbi
+#define shmemx_schar_iput_nbi pshmemx_schar_iput_nbi
+#pragma weak shmemx_ctx_short_iput_nbi = pshmemx_ctx_short_iput_nbi
+#define shmemx_ctx_short_iput_nbi pshmemx_ctx_short_iput_nbi
+#pragma weak shmemx_short_iput_nbi = pshmemx_short_iput_nbi
+#define shmemx_short_iput_nbi pshmemx_short_iput_nbi
+#pragma weak shmemx_ctx_int_iput_nbi = pshmemx_ctx_int_iput_nbi
+#define shmemx_ctx_int_iput_nbi pshmemx_ctx_int_iput_nbi
+#pragma weak shmemx_int_iput_nbi = pshmemx_int_iput_nbi
+#define shmemx_int_iput_nbi pshmemx_int_iput_nbi
+#pragma weak shmemx_ctx_long_iput_nbi = pshmemx_ctx_long_iput_nbi
+#define shmemx_ctx_long_iput_nbi pshmemx_ctx_long_iput_nbi
+#pragma weak shmemx_long_iput_nbi = pshmemx_long_iput_nbi
+#define shmemx_long_iput_nbi pshmemx_long_iput_nbi
+#pragma weak shmemx_ctx_longlong_iput_nbi = pshmemx_ctx_longlong_iput_nbi
+#define shmemx_ctx_longlong_iput_nbi pshmemx_ctx_longlong_iput_nbi
+#pragma weak shmemx_longlong_iput_nbi = pshmemx_longlong_iput_nbi
+#define shmemx_longlong_iput_nbi pshmemx_longlong_iput_nbi
+#pragma weak shmemx_ctx_uchar_iput_nbi = pshmemx_ctx_uchar_iput_nbi
+#define shmemx_ctx_uchar_iput_nbi pshmemx_ctx_uchar_iput_nbi
+#pragma weak shmemx_uchar_iput_nbi = pshmemx_uchar_iput_nbi
+#define shmemx_uchar_iput_nbi pshmemx_uchar_iput_nbi
+#pragma weak shmemx_ctx_ushort_iput_nbi = pshmemx_ctx_ushort_iput_nbi
+#define shmemx_ctx_ushort_iput_nbi pshmemx_ctx_ushort_iput_nbi
+#pragma weak shmemx_ushort_iput_nbi = pshmemx_ushort_iput_nbi
+#define shmemx_ushort_iput_nbi pshmemx_ushort_iput_nbi
+#pragma weak shmemx_ctx_uint_iput_nbi = pshmemx_ctx_uint_iput_nbi
+#define shmemx_ctx_uint_iput_nbi pshmemx_ctx_uint_iput_nbi
+#pragma weak shmemx_uint_iput_nbi = pshmemx_uint_iput_nbi
+#define shmemx_uint_iput_nbi pshmemx_uint_iput_nbi
+#pragma weak shmemx_ctx_ulong_iput_nbi = pshmemx_ctx_ulong_iput_nbi
+#define shmemx_ctx_ulong_iput_nbi pshmemx_ctx_ulong_iput_nbi
+#pragma weak shmemx_ulong_iput_nbi = pshmemx_ulong_iput_nbi
+#define shmemx_ulong_iput_nbi pshmemx_ulong_iput_nbi
+#pragma weak shmemx_ctx_ulonglong_iput_nbi = pshmemx_ctx_ulonglong_iput_nbi
+#define shmemx_ctx_ulonglong_iput_nbi pshmemx_ctx_ulonglong_iput_nbi
+#pragma weak shmemx_ulonglong_iput_nbi = pshmemx_ulonglong_iput_nbi
+#define shmemx_ulonglong_iput_nbi pshmemx_ulonglong_iput_nbi
+#pragma weak shmemx_ctx_int8_iput_nbi = pshmemx_ctx_int8_iput_nbi
+#define shmemx_ctx_int8_iput_nbi pshmemx_ctx_int8_iput_nbi
+#pragma weak shmemx_int8_iput_nbi = pshmemx_int8_iput_nbi
+#define shmemx_int8_iput_nbi pshmemx_int8_iput_nbi
+#pragma weak shmemx_ctx_int16_iput_nbi = pshmemx_ctx_int16_iput_nbi
+#define shmemx_ctx_int16_iput_nbi pshmemx_ctx_int16_iput_nbi
+#pragma weak shmemx_int16_iput_nbi = pshmemx_int16_iput_nbi
+#define shmemx_int16_iput_nbi pshmemx_int16_iput_nbi
+#pragma weak shmemx_ctx_int32_iput_nbi = pshmemx_ctx_int32_iput_nbi
+#define shmemx_ctx_int32_iput_nbi pshmemx_ctx_int32_iput_nbi
+#pragma weak shmemx_int32_iput_nbi = pshmemx_int32_iput_nbi
+#define shmemx_int32_iput_nbi pshmemx_int32_iput_nbi
+#pragma weak shmemx_ctx_int64_iput_nbi = pshmemx_ctx_int64_iput_nbi
+#define shmemx_ctx_int64_iput_nbi pshmemx_ctx_int64_iput_nbi
+#pragma weak shmemx_int64_iput_nbi = pshmemx_int64_iput_nbi
+#define shmemx_int64_iput_nbi pshmemx_int64_iput_nbi
+#pragma weak shmemx_ctx_uint8_iput_nbi = pshmemx_ctx_uint8_iput_nbi
+#define shmemx_ctx_uint8_iput_nbi pshmemx_ctx_uint8_iput_nbi
+#pragma weak shmemx_uint8_iput_nbi = pshmemx_uint8_iput_nbi
+#define shmemx_uint8_iput_nbi pshmemx_uint8_iput_nbi
+#pragma weak shmemx_ctx_uint16_iput_nbi = pshmemx_ctx_uint16_iput_nbi
+#define shmemx_ctx_uint16_iput_nbi pshmemx_ctx_uint16_iput_nbi
+#pragma weak shmemx_uint16_iput_nbi = pshmemx_uint16_iput_nbi
+#define shmemx_uint16_iput_nbi pshmemx_uint16_iput_nbi
+#pragma weak shmemx_ctx_uint32_iput_nbi = pshmemx_ctx_uint32_iput_nbi
+#define shmemx_ctx_uint32_iput_nbi pshmemx_ctx_uint32_iput_nbi
+#pragma weak shmemx_uint32_iput_nbi = pshmemx_uint32_iput_nbi
+#define shmemx_uint32_iput_nbi pshmemx_uint32_iput_nbi
+#pragma weak shmemx_ctx_uint64_iput_nbi = pshmemx_ctx_uint64_iput_nbi
+#define shmemx_ctx_uint64_iput_nbi pshmemx_ctx_uint64_iput_nbi
+#pragma weak shmemx_uint64_iput_nbi = pshmemx_uint64_iput_nbi
+#define shmemx_uint64_iput_nbi pshmemx_uint64_iput_nbi
+#pragma weak shmemx_ctx_size_iput_nbi = pshmemx_ctx_size_iput_nbi
+#define shmemx_ctx_size_iput_nbi pshmemx_ctx_size_iput_nbi
+#pragma weak shmemx_size_iput_nbi = pshmemx_size_iput_nbi
+#define shmemx_size_iput_nbi pshmemx_size_iput_nbi
+#pragma weak shmemx_ctx_ptrdiff_iput_nbi = pshmemx_ctx_ptrdiff_iput_nbi
+#define shmemx_ctx_ptrdiff_iput_nbi pshmemx_ctx_ptrdiff_iput_nbi
+#pragma weak shmemx_ptrdiff_iput_nbi = pshmemx_ptrdiff_iput_nbi
+#define shmemx_ptrdiff_iput_nbi pshmemx_ptrdiff_iput_nbi
+#endif /* ENABLE_PSHMEM */
+
+#define IPUT_NBI_TYPE_HELPER(_type, _typename)                                 \
+  SHMEMX_CTX_TYPED_IPUT_NBI(_typename, _type)
+
+SHMEM_STANDARD_RMA_TYPE_TABLE(IPUT_NBI_TYPE_HELPER)
+#undef IPUT_NBI_TYPE_HELPER
+
+#ifdef ENABLE_PSHMEM
+#pragma weak shmemx_ctx_iput8_nbi = pshmemx_ctx_iput8_nbi
+#define shmemx_ctx_iput8_nbi pshmemx_ctx_iput8_nbi
+#pragma weak shmemx_iput8_nbi = pshmemx_iput8_nbi
+#define shmemx_iput8_nbi pshmemx_iput8_nbi
+#pragma weak shmemx_ctx_iput16_nbi = pshmemx_ctx_iput16_nbi
+#define shmemx_ctx_iput16_nbi pshmemx_ctx_iput16_nbi
+#pragma weak shmemx_iput16_nbi = pshmemx_iput16_nbi
+#define shmemx_iput16_nbi pshmemx_iput16_nbi
+#pragma weak shmemx_ctx_iput32_nbi = pshmemx_ctx_iput32_nbi
+#define shmemx_ctx_iput32_nbi pshmemx_ctx_iput32_nbi
+#pragma weak shmemx_iput32_nbi = pshmemx_iput32_nbi
+#define shmemx_iput32_nbi pshmemx_iput32_nbi
+#pragma weak shmemx_ctx_iput64_nbi = pshmemx_ctx_iput64_nbi
+#define shmemx_ctx_iput64_nbi pshmemx_ctx_iput64_nbi
+#pragma weak shmemx_iput64_nbi = pshmemx_iput64_nbi
+#define shmemx_iput64_nbi pshmemx_iput64_nbi
+#pragma weak shmemx_ctx_iput128_nbi = pshmemx_ctx_iput128_nbi
+#define shmemx_ctx_iput128_nbi pshmemx_ctx_iput128_nbi
+#pragma weak shmemx_iput128_nbi = pshmemx_iput128_nbi
+#define shmemx_iput128_nbi pshmemx_iput128_nbi
+#endif /* ENABLE_PSHMEM */
+
+SHMEMX_CTX_SIZED_IPUT_NBI(8)
+SHMEMX_CTX_SIZED_IPUT_NBI(16)
+SHMEMX_CTX_SIZED_IPUT_NBI(32)
+SHMEMX_CTX_SIZED_IPUT_NBI(64)
+SHMEMX_CTX_SIZED_IPUT_NBI(128)
+
+/*
+ * -- strided gets --
+ */
+
+#define SHMEMX_CTX_TYPED_IGET_NBI(_name, _type)                                \
+  void shmemx_ctx_##_name##_iget_nbi(shmem_ctx_t ctx, _type *target,           \
+                                    const _type *source, ptrdiff_t tst,        \
+                                    ptrdiff_t sst, size_t nelems, int pe) {    \
+    SHMEMU_CHECK_INIT();                                                       \
+    SHMEMU_CHECK_PE_ARG_RANGE(pe, 7);                                          \
+    SHMEMU_CHECK_SYMMETRIC(source, 3);                                         \
+                                                                               \
+    logger(LOG_RMA,                                                            \
+           "%s(ctx=%lu, dest=%p, src=%p, "                                     \
+           "tst=%lu, sst=%lu, nelems=%lu, pe=%d)",                             \
+           __func__, shmemc_context_id(ctx), target, source, tst, sst, nelems, \
+           pe);                                                                \
+                                                                               \
+    SHMEMT_MUTEX_NOPROTECT(shmemc_ctx_iget_nbi(ctx, target, source, tst, sst,  \
+                                               sizeof(_type), nelems, pe));    \
+  }                                                                            \
+  void shmemx_##_name##_iget_nbi(_type *target, const _type *source,           \
+                                ptrdiff_t tst, ptrdiff_t sst, size_t nelems,   \
+                                int pe) {                                      \
+    shmemx_ctx_##_name##_iget_nbi(SHMEM_CTX_DEFAULT, target, source, tst, sst, \
+                                 nelems, pe);                                  \
+  }
+
+#define SHMEMX_CTX_SIZED_IGET_NBI(_size)                                       \
+  void shmemx_ctx_iget##_size##_nbi(shmem_ctx_t ctx, void *target,             \
+                                   const void *source, ptrdiff_t tst,          \
+                                   ptrdiff_t sst, size_t nelems, int pe) {     \
+    SHMEMU_CHECK_INIT();                                                       \
+    SHMEMU_CHECK_PE_ARG_RANGE(pe, 7);                                          \
+    SHMEMU_CHECK_SYMMETRIC(source, 3);                                         \
+                                                                               \
+    logger(LOG_RMA,                                                            \
+           "%s(ctx=%lu, dest=%p, src=%p, "                                     \
+           "tst=%lu, sst=%lu, nelems=%lu, pe=%d)",                             \
+           __func__, shmemc_context_id(ctx), target, source, tst, sst, nelems, \
+           pe);                                                                \
+                                                                               \
+    SHMEMT_MUTEX_NOPROTECT(shmemc_ctx_iget_nbi(ctx, target, source, tst, sst,  \
+                                               BITS2BYTES(_size), nelems,      \
+                                               pe));                           \
+  }                                                                            \
+  void shmemx_iget##_size##_nbi(void *target, const void *source,              \
+                               ptrdiff_t tst, ptrdiff_t sst, size_t nelems,    \
+                               int pe) {                                       \
+    shmemx_ctx_iget##_size##_nbi(SHMEM_CTX_DEFAULT, target, source, tst, sst,  \
+                                nelems, pe);                                   \
+  }
+
+#ifdef ENABLE_PSHMEM
+#pragma weak shmemx_ctx_float_iget_nbi = pshmemx_ctx_float_iget_nbi
+#define shmemx_ctx_float_iget_nbi pshmemx_ctx_float_iget_nbi
+#pragma weak shmemx_float_iget_nbi = pshmemx_float_iget_nbi
+#define shmemx_float_iget_nbi pshmemx_float_iget_nbi
+#pragma weak shmemx_ctx_double_iget_nbi = pshmemx_ctx_double_iget_nbi
+#define shmemx_ctx_double_iget_nbi pshmemx_ctx_double_iget_nbi
+#pragma weak shmemx_double_iget_nbi = pshmemx_double_iget_nbi
+#define shmemx_double_iget_nbi pshmemx_double_iget_nbi
+#pragma weak shmemx_ctx_longdouble_iget_nbi = pshmemx_ctx_longdouble_iget_nbi
+#define shmemx_ctx_longdouble_iget_nbi pshmemx_ctx_longdouble_iget_nbi
+#pragma weak shmemx_longdouble_iget_nbi = pshmemx_longdouble_iget_nbi
+#define shmemx_longdouble_iget_nbi pshmemx_longdouble_iget_nbi
+#pragma weak shmemx_ctx_char_iget_nbi = pshmemx_ctx_char_iget_nbi
+#define shmemx_ctx_char_iget_nbi pshmemx_ctx_char_iget_nbi
+#pragma weak shmemx_char_iget_nbi = pshmemx_char_iget_nbi
+#define shmemx_char_iget_nbi pshmemx_char_iget_nbi
+#pragma weak shmemx_ctx_schar_iget_nbi = pshmemx_ctx_schar_iget_nbi
+#define shmemx_ctx_schar_iget_nbi pshmemx_ctx_schar_iget_nbi
+#pragma weak shmemx_schar_iget_nbi = pshmemx_schar_iget_nbi
+#define shmemx_schar_iget_nbi pshmemx_schar_iget_nbi
+#pragma weak shmemx_ctx_short_iget_nbi = pshmemx_ctx_short_iget_nbi
+#define shmemx_ctx_short_iget_nbi pshmemx_ctx_short_iget_nbi
+#pragma weak shmemx_short_iget_nbi = pshmemx_short_iget_nbi
+#define shmemx_short_iget_nbi pshmemx_short_iget_nbi
+#pragma weak shmemx_ctx_int_iget_nbi = pshmemx_ctx_int_iget_nbi
+#define shmemx_ctx_int_iget_nbi pshmemx_ctx_int_iget_nbi
+#pragma weak shmemx_int_iget_nbi = pshmemx_int_iget_nbi
+#define shmemx_int_iget_nbi pshmemx_int_iget_nbi
+#pragma weak shmemx_ctx_long_iget_nbi = pshmemx_ctx_long_iget_nbi
+#define shmemx_ctx_long_iget_nbi pshmemx_ctx_long_iget_nbi
+#pragma weak shmemx_long_iget_nbi = pshmemx_long_iget_nbi
+#define shmemx_long_iget_nbi pshmemx_long_iget_nbi
+#pragma weak shmemx_ctx_longlong_iget_nbi = pshmemx_ctx_longlong_iget_nbi
+#define shmemx_ctx_longlong_iget_nbi pshmemx_ctx_longlong_iget_nbi
+#pragma weak shmemx_longlong_iget_nbi = pshmemx_longlong_iget_nbi
+#define shmemx_longlong_iget_nbi pshmemx_longlong_iget_nbi
+#pragma weak shmemx_ctx_uchar_iget_nbi = pshmemx_ctx_uchar_iget_nbi
+#define shmemx_ctx_uchar_iget_nbi pshmemx_ctx_uchar_iget_nbi
+#pragma weak shmemx_uchar_iget_nbi = pshmemx_uchar_iget_nbi
+#define shmemx_uchar_iget_nbi pshmemx_uchar_iget_nbi
+#pragma weak shmemx_ctx_ushort_iget_nbi = pshmemx_ctx_ushort_iget_nbi
+#define shmemx_ctx_ushort_iget_nbi pshmemx_ctx_ushort_iget_nbi
+#pragma weak shmemx_ushort_iget_nbi = pshmemx_ushort_iget_nbi
+#define shmemx_ushort_iget_nbi pshmemx_ushort_iget_nbi
+#pragma weak shmemx_ctx_uint_iget_nbi = pshmemx_ctx_uint_iget_nbi
+#define shmemx_ctx_uint_iget_nbi pshmemx_ctx_uint_iget_nbi
+#pragma weak shmemx_uint_iget_nbi = pshmemx_uint_iget_nbi
+#define shmemx_uint_iget_nbi pshmemx_uint_iget_nbi
+#pragma weak shmemx_ctx_ulong_iget_nbi = pshmemx_ctx_ulong_iget_nbi
+#define shmemx_ctx_ulong_iget_nbi pshmemx_ctx_ulong_iget_nbi
+#pragma weak shmemx_ulong_iget_nbi = pshmemx_ulong_iget_nbi
+#define shmemx_ulong_iget_nbi pshmemx_ulong_iget_nbi
+#pragma weak shmemx_ctx_ulonglong_iget_nbi = pshmemx_ctx_ulonglong_iget_nbi
+#define shmemx_ctx_ulonglong_iget_nbi pshmemx_ctx_ulonglong_iget_nbi
+#pragma weak shmemx_ulonglong_iget_nbi = pshmemx_ulonglong_iget_nbi
+#define shmemx_ulonglong_iget_nbi pshmemx_ulonglong_iget_nbi
+#pragma weak shmemx_ctx_int8_iget_nbi = pshmemx_ctx_int8_iget_nbi
+#define shmemx_ctx_int8_iget_nbi pshmemx_ctx_int8_iget_nbi
+#pragma weak shmemx_int8_iget_nbi = pshmemx_int8_iget_nbi
+#define shmemx_int8_iget_nbi pshmemx_int8_iget_nbi
+#pragma weak shmemx_ctx_int16_iget_nbi = pshmemx_ctx_int16_iget_nbi
+#define shmemx_ctx_int16_iget_nbi pshmemx_ctx_int16_iget_nbi
+#pragma weak shmemx_int16_iget_nbi = pshmemx_int16_iget_nbi
+#define shmemx_int16_iget_nbi pshmemx_int16_iget_nbi
+#pragma weak shmemx_ctx_int32_iget_nbi = pshmemx_ctx_int32_iget_nbi
+#define shmemx_ctx_int32_iget_nbi pshmemx_ctx_int32_iget_nbi
+#pragma weak shmemx_int32_iget_nbi = pshmemx_int32_iget_nbi
+#define shmemx_int32_iget_nbi pshmemx_int32_iget_nbi
+#pragma weak shmemx_ctx_int64_iget_nbi = pshmemx_ctx_int64_iget_nbi
+#define shmemx_ctx_int64_iget_nbi pshmemx_ctx_int64_iget_nbi
+#pragma weak shmemx_int64_iget_nbi = pshmemx_int64_iget_nbi
+#define shmemx_int64_iget_nbi pshmemx_int64_iget_nbi
+#pragma weak shmemx_ctx_uint8_iget_nbi = pshmemx_ctx_uint8_iget_nbi
+#define shmemx_ctx_uint8_iget_nbi pshmemx_ctx_uint8_iget_nbi
+#pragma weak shmemx_uint8_iget_nbi = pshmemx_uint8_iget_nbi
+#define shmemx_uint8_iget_nbi pshmemx_uint8_iget_nbi
+#pragma weak shmemx_ctx_uint16_iget_nbi = pshmemx_ctx_uint16_iget_nbi
+#define shmemx_ctx_uint16_iget_nbi pshmemx_ctx_uint16_iget_nbi
+#pragma weak shmemx_uint16_iget_nbi = pshmemx_uint16_iget_nbi
+#define shmemx_uint16_iget_nbi pshmemx_uint16_iget_nbi
+#pragma weak shmemx_ctx_uint32_iget_nbi = pshmemx_ctx_uint32_iget_nbi
+#define shmemx_ctx_uint32_iget_nbi pshmemx_ctx_uint32_iget_nbi
+#pragma weak shmemx_uint32_iget_nbi = pshmemx_uint32_iget_nbi
+#define shmemx_uint32_iget_nbi pshmemx_uint32_iget_nbi
+#pragma weak shmemx_ctx_uint64_iget_nbi = pshmemx_ctx_uint64_iget_nbi
+#define shmemx_ctx_uint64_iget_nbi pshmemx_ctx_uint64_iget_nbi
+#pragma weak shmemx_uint64_iget_nbi = pshmemx_uint64_iget_nbi
+#define shmemx_uint64_iget_nbi pshmemx_uint64_iget_nbi
+#pragma weak shmemx_ctx_size_iget_nbi = pshmemx_ctx_size_iget_nbi
+#define shmemx_ctx_size_iget_nbi pshmemx_ctx_size_iget_nbi
+#pragma weak shmemx_size_iget_nbi = pshmemx_size_iget_nbi
+#define shmemx_size_iget_nbi pshmemx_size_iget_nbi
+#pragma weak shmemx_ctx_ptrdiff_iget_nbi = pshmemx_ctx_ptrdiff_iget_nbi
+#define shmemx_ctx_ptrdiff_iget_nbi pshmemx_ctx_ptrdiff_iget_nbi
+#pragma weak shmemx_ptrdiff_iget_nbi = pshmemx_ptrdiff_iget_nbi
+#define shmemx_ptrdiff_iget_nbi pshmemx_ptrdiff_iget_nbi
+#endif /* ENABLE_PSHMEM */
+
+#define IGET_NBI_TYPE_HELPER(_type, _typename)                                 \
+  SHMEMX_CTX_TYPED_IGET_NBI(_typename, _type)
+
+SHMEM_STANDARD_RMA_TYPE_TABLE(IGET_NBI_TYPE_HELPER)
+#undef IGET_NBI_TYPE_HELPER
+
+#ifdef ENABLE_PSHMEM
+#pragma weak shmemx_ctx_iget8_nbi = pshmemx_ctx_iget8_nbi
+#define shmemx_ctx_iget8_nbi pshmemx_ctx_iget8_nbi
+#pragma weak shmemx_iget8_nbi = pshmemx_iget8_nbi
+#define shmemx_iget8_nbi pshmemx_iget8_nbi
+#pragma weak shmemx_ctx_iget16_nbi = pshmemx_ctx_iget16_nbi
+#define shmemx_ctx_iget16_nbi pshmemx_ctx_iget16_nbi
+#pragma weak shmemx_iget16_nbi = pshmemx_iget16_nbi
+#define shmemx_iget16_nbi pshmemx_iget16_nbi
+#pragma weak shmemx_ctx_iget32_nbi = pshmemx_ctx_iget32_nbi
+#define shmemx_ctx_iget32_nbi pshmemx_ctx_iget32_nbi
+#pragma weak shmemx_iget32_nbi = pshmemx_iget32_nbi
+#define shmemx_iget32_nbi pshmemx_iget32_nbi
+#pragma weak shmemx_ctx_iget64_nbi = pshmemx_ctx_iget64_nbi
+#define shmemx_ctx_iget64_nbi pshmemx_ctx_iget64_nbi
+#pragma weak shmemx_iget64_nbi = pshmemx_iget64_nbi
+#define shmemx_iget64_nbi pshmemx_iget64_nbi
+#pragma weak shmemx_ctx_iget128_nbi = pshmemx_ctx_iget128_nbi
+#define shmemx_ctx_iget128_nbi pshmemx_ctx_iget128_nbi
+#pragma weak shmemx_iget128_nbi = pshmemx_iget128_nbi
+#define shmemx_iget128_nbi pshmemx_iget128_nbi
+#endif /* ENABLE_PSHMEM */
+
+SHMEMX_CTX_SIZED_IGET_NBI(8)
+SHMEMX_CTX_SIZED_IGET_NBI(16)
+SHMEMX_CTX_SIZED_IGET_NBI(32)
+SHMEMX_CTX_SIZED_IGET_NBI(64)
+SHMEMX_CTX_SIZED_IGET_NBI(128)
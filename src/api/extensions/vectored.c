@@ -0,0 +1,82 @@
+/* For license: see LICENSE file at top-level */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif /* HAVE_CONFIG_H */
+
+#include "shmemu.h"
+#include "shmemc.h"
+#include "shmem_mutex.h"
+#include "shmemx.h"
+
+#include <shmem/api_types.h>
+
+/*
+ * Vectored puts and gets: an array of (dest, src, nbytes, pe)
+ * descriptors handed over in one call.  Blocking versions return
+ * when every transfer is complete (as for putmem/getmem), _nbi ones
+ * at the next quiet on the context.
+ */
+
+/*
+ * every descriptor gets the checks the single-transfer call would
+ */
+#ifdef ENABLE_DEBUG
+
+#define SHMEMX_CHECK_XFERS(_xs, _n, _symfield)                                 \
+  do {                                                                         \
+    size_t i;                                                                  \
+                                                                               \
+    if ((_n) > 0) {                                                            \
+      SHMEMU_CHECK_NOT_NULL(_xs, 2);                                           \
+    }                                                                          \
+    for (i = 0; i < (_n); ++i) {                                               \
+      SHMEMU_CHECK_PE_ARG_RANGE((_xs)[i].pe, 2);                               \
+      SHMEMU_CHECK_SYMMETRIC((_xs)[i]._symfield, 2);                           \
+    }                                                                          \
+  } while (0)
+
+#else /* ! ENABLE_DEBUG */
+
+#define SHMEMX_CHECK_XFERS(_xs, _n, _symfield)
+
+#endif /* ENABLE_DEBUG */
+
+#define SHMEMX_CTX_VECTORED(_op, _symfield)                                    \
+  void shmemx_ctx_##_op(shmem_ctx_t ctx, const shmemx_xfer_t *xs, size_t n) {  \
+    SHMEMU_CHECK_INIT();                                                       \
+    SHMEMX_CHECK_XFERS(xs, n, _symfield);                                      \
+                                                                               \
+    logger(LOG_RMA, "%s(ctx=%lu, xs=%p, n=%lu)", __func__,                     \
+           shmemc_context_id(ctx), xs, (unsigned long)n);                      \
+                                                                               \
+    SHMEMT_MUTEX_NOPROTECT(                                                    \
+        shmemc_ctx_##_op(ctx, (const shmemc_xfer_t *)xs, n));                  \
+  }                                                                            \
+  void shmemx_##_op(const shmemx_xfer_t *xs, size_t n) {                       \
+    shmemx_ctx_##_op(SHMEM_CTX_DEFAULT, xs, n);                                \
+  }
+
+#ifdef ENABLE_PSHMEM
+#pragma weak shmemx_ctx_putv = pshmemx_ctx_putv
+#define shmemx_ctx_putv pshmemx_ctx_putv
+#pragma weak shmemx_putv = pshmemx_putv
+#define shmemx_putv pshmemx_putv
+#pragma weak shmemx_ctx_getv = pshmemx_ctx_getv
+#define shmemx_ctx_getv pshmemx_ctx_getv
+#pragma weak shmemx_getv = pshmemx_getv
+#define shmemx_getv pshmemx_getv
+#pragma weak shmemx_ctx_putv_nbi = pshmemx_ctx_putv_nbi
+#define shmemx_ctx_putv_nbi pshmemx_ctx_putv_nbi
+#pragma weak shmemx_putv_nbi = pshmemx_putv_nbi
+#define shmemx_putv_nbi pshmemx_putv_nbi
+#pragma weak shmemx_ctx_getv_nbi = pshmemx_ctx_getv_nbi
+#define shmemx_ctx_getv_nbi pshmemx_ctx_getv_nbi
+#pragma weak shmemx_getv_nbi = pshmemx_getv_nbi
+#define shmemx_getv_nbi pshmemx_getv_nbi
+#endif /* ENABLE_PSHMEM */
+
+SHMEMX_CTX_VECTORED(putv, dest)
+SHMEMX_CTX_VECTORED(getv, src)
+SHMEMX_CTX_VECTORED(putv_nbi, dest)
+SHMEMX_CTX_VECTORED(getv_nbi, src)
@@ -0,0 +1,56 @@
+/* For license: see LICENSE file at top-level */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif /* HAVE_CONFIG_H */
+
+#include "shmemu.h"
+#include "shmemc.h"
+#include "shmemx.h"
+
+#ifdef ENABLE_PSHMEM
+#pragma weak shmemx_ctx_set_wait_policy = pshmemx_ctx_set_wait_policy
+#define shmemx_ctx_set_wait_policy pshmemx_ctx_set_wait_policy
+#pragma weak shmemx_ctx_get_wait_stats = pshmemx_ctx_get_wait_stats
+#define shmemx_ctx_get_wait_stats pshmemx_ctx_get_wait_stats
+#pragma weak shmemx_ctx_reset_wait_stats = pshmemx_ctx_reset_wait_stats
+#define shmemx_ctx_reset_wait_stats pshmemx_ctx_reset_wait_stats
+#endif /* ENABLE_PSHMEM */
+
+int shmemx_ctx_set_wait_policy(shmem_ctx_t ctx, int policy) {
+  SHMEMU_CHECK_INIT();
+
+  if ((policy < SHMEMX_WAIT_DEFAULT) || (policy > SHMEMX_WAIT_EVENT)) {
+    return 1;
+    /* NOT REACHED */
+  }
+
+  shmemc_ctx_set_wait_policy(ctx, (shmemc_wait_policy_t)policy);
+
+  logger(LOG_CONTEXTS, "%s(ctx=%lu, policy=%d)", __func__,
+         shmemc_context_id(ctx), policy);
+
+  return 0;
+}
+
+void shmemx_ctx_get_wait_stats(shmem_ctx_t ctx, shmemx_wait_stats_t *stats) {
+  shmemc_wait_stats_t ws;
+
+  SHMEMU_CHECK_INIT();
+  SHMEMU_CHECK_NOT_NULL(stats, 2);
+
+  shmemc_ctx_get_wait_stats(ctx, &ws);
+
+  stats->waits = ws.waits;
+  stats->spins = ws.spins;
+  stats->yields = ws.yields;
+  stats->naps = ws.naps;
+  stats->sleeps = ws.sleeps;
+  stats->wakeups = ws.wakeups;
+}
+
+void shmemx_ctx_reset_wait_stats(shmem_ctx_t ctx) {
+  SHMEMU_CHECK_INIT();
+
+  shmemc_ctx_reset_wait_stats(ctx);
+}
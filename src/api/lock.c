@@ -24,283 +24,42 @@
 #include "shmemc.h"
 #include "shmem.h"
 #include "shmem_mutex.h"
+#include "lock.h"
 
-#include <stdint.h>
 #include <sys/types.h>
 
-/*
- * this overlays an opaque blob we can move around with AMOs, and the
- * signalling/PE parts.
- *
- * TODO "short" PE in this setup, should be "int"
- */
-
-enum {
-  SHMEM_LOCK_FREE = -1,
-  SHMEM_LOCK_RESET = 0, /* value matches lock initializer in spec */
-  SHMEM_LOCK_ACQUIRED
-};
-
-/**
- * @brief Lock data structure that combines lock state and next PE
- *
- * This union allows the lock to be manipulated both as separate fields
- * and as a single atomic value.
- */
-typedef union shmem_lock {
-  struct data_split {
-    int16_t locked; /**< Lock state */
-    int16_t next;   /**< Next PE in lock queue */
-  } d;
-  int32_t blob; /**< Combined value for atomic operations */
-} shmem_lock_t;
-
-/*
- * spread lock ownership around PEs
- */
-
-/**
- * @brief Calculate lock owner PE based on address
- *
- * @param addr Address of the lock
- * @return PE number that should own this lock
- */
-inline static int get_owner_spread(uint64_t addr) {
-  return (addr >> 3) % shmemc_n_pes();
-}
-
-/**
- * @brief Determine the owner PE for a lock
- *
- * @param addr Address of the lock
- * @return PE number that owns this lock
- */
-inline static int lock_owner(void *addr) {
-  const uint64_t la = (const uint64_t)addr;
-  int owner;
-
-  /*
-   * can only agree on distributed owners if we all agree on aligned
-   * addresses
-   */
-#ifdef ENABLE_ALIGNED_ADDRESSES
-  owner = get_owner_spread(la);
-#else
-  if (shmemc_global_address(la)) {
-    owner = get_owner_spread(la);
-  } else {
-    /* don't choose PE 0, as it is often used for work allocation */
-    owner = shmemc_n_pes() - 1;
-  }
-#endif /* ENABLE_ALIGNED_ADDRESSES */
-
-  return owner;
-}
-
-/*
- * split the lock claim into 2-phase request + execute.
- *
- * "cmp" contains the claim and connects the 2 phases
- */
-
-/**
- * @brief Common atomic lock operation
- *
- * @param lock Lock to operate on
- * @param cond Expected value for compare-swap
- * @param value New value to swap in
- * @param cmp Result of operation
- */
-inline static void try_lock_action(shmem_lock_t *lock, int cond, int value,
-                                   shmem_lock_t *cmp) {
-  cmp->blob = shmem_int_atomic_compare_swap(&(lock->blob), cond, value,
-                                            lock_owner(lock));
-}
-
-/**
- * @brief Attempt to request a lock
- *
- * @param lock Lock to request
- * @param me Current PE
- * @param cmp Operation result
- */
-inline static void try_request_lock(shmem_lock_t *lock, int me,
-                                    shmem_lock_t *cmp) {
-  const shmem_lock_t tmp = {.d.locked = SHMEM_LOCK_ACQUIRED, .d.next = me};
-
-  try_lock_action(lock, SHMEM_LOCK_RESET, tmp.blob, cmp);
-}
-
-/**
- * @brief Attempt to clear a lock
- *
- * @param lock Lock to clear
- * @param me Current PE
- * @param cmp Operation result
- */
-inline static void try_clear_lock(shmem_lock_t *lock, int me,
-                                  shmem_lock_t *cmp) {
-  const shmem_lock_t tmp = {.d.locked = SHMEM_LOCK_ACQUIRED, .d.next = me};
-
-  try_lock_action(lock, tmp.blob, SHMEM_LOCK_RESET, cmp);
-}
-
-/**
- * @brief Request phase for set_lock operation
- *
- * @param lock Lock to set
- * @param me Current PE
- * @param cmp Operation result
- */
-inline static void set_lock_request(shmem_lock_t *lock, int me,
-                                    shmem_lock_t *cmp) {
-  /* push my claim into the owner */
-  do {
-    try_request_lock(lock, me, cmp);
-  } while (cmp->blob != SHMEM_LOCK_RESET);
-}
-
-/**
- * @brief Request phase for test_lock operation
- *
- * @param lock Lock to test
- * @param me Current PE
- * @param cmp Operation result
- */
-inline static void test_lock_request(shmem_lock_t *lock, int me,
-                                     shmem_lock_t *cmp) {
-  /* if owner is unset, grab the lock */
-  try_request_lock(lock, me, cmp);
-}
-
-/**
- * @brief Request phase for clear_lock operation
- *
- * @param node Local lock data
- * @param lock Lock to clear
- * @param me Current PE
- * @param cmp Operation result
- */
-inline static void clear_lock_request(shmem_lock_t *node, shmem_lock_t *lock,
-                                      int me, shmem_lock_t *cmp) {
-  if (node->d.next == SHMEM_LOCK_FREE) {
-    try_clear_lock(lock, me, cmp);
-  }
-}
-
-/**
- * @brief Execute phase for set_lock operation
- *
- * @param node Local lock data
- * @param me Current PE
- * @param cmp Operation result
- */
-inline static void set_lock_execute(shmem_lock_t *node, int me,
-                                    shmem_lock_t *cmp) {
-  /* tail */
-  node->d.next = SHMEM_LOCK_FREE;
-
-  if (cmp->d.locked == SHMEM_LOCK_ACQUIRED) {
-    node->d.locked = SHMEM_LOCK_ACQUIRED;
-
-    /* chain me on */
-    shmem_short_p(&(node->d.next), me, cmp->d.next);
-
-    /* sit here until unlocked */
-    do {
-      shmemc_progress();
-    } while (node->d.locked == SHMEM_LOCK_ACQUIRED);
-  }
-}
-
-/**
- * @brief Execute phase for test_lock operation
- *
- * @param node Local lock data
- * @param me Current PE
- * @param cmp Operation result
- * @return 0 on success, 1 if lock not acquired
- */
-inline static int test_lock_execute(shmem_lock_t *node, int me,
-                                    shmem_lock_t *cmp) {
-  if (cmp->blob == SHMEM_LOCK_RESET) {
-    /* grabbed unset lock, now go on to set the rest of the lock */
-    set_lock_execute(node, me, cmp);
-    return 0;
-  } else {
-    /* nope, go around again */
-    return 1;
-  }
-}
-
-/**
- * @brief Execute phase for clear_lock operation
- *
- * @param node Local lock data
- * @param me Current PE
- * @param cmp Operation result
- */
-inline static void clear_lock_execute(shmem_lock_t *node, int me,
-                                      shmem_lock_t *cmp) {
-  /* any more chainers? */
-  if (cmp->d.next == me) {
-    return;
-    /* NOT REACHED */
-  }
-
-  /* wait for a chainer PE to appear */
-  do {
-    shmemc_progress();
-  } while (node->d.next == SHMEM_LOCK_FREE);
-
-  /* tell next pe about release */
-  shmem_short_p(&(node->d.locked), SHMEM_LOCK_RESET, node->d.next);
-}
-
 /**
  * @brief Internal blocking set_lock implementation
  *
- * @param node Local lock data
  * @param lock Lock to set
  * @param me Current PE
  */
-inline static void set_lock(shmem_lock_t *node, shmem_lock_t *lock, int me) {
-  shmem_lock_t t;
-
-  set_lock_request(lock, me, &t);
-  set_lock_execute(node, me, &t);
+inline static void set_lock(unsigned long *lock, int me) {
+  lock_mcs_set(lock, lock_owner(lock), me);
 }
 
 /**
  * @brief Internal blocking clear_lock implementation
  *
- * @param node Local lock data
  * @param lock Lock to clear
  * @param me Current PE
  */
-inline static void clear_lock(shmem_lock_t *node, shmem_lock_t *lock, int me) {
-  shmem_lock_t t;
-
+inline static void clear_lock(unsigned long *lock, int me) {
   /* required to flush comms before clearing lock */
   shmemc_quiet();
 
-  clear_lock_request(node, lock, me, &t);
-  clear_lock_execute(node, me, &t);
+  lock_mcs_clear(lock, lock_owner(lock), me);
 }
 
 /**
- * @brief Internal blocking test_lock implementation
+ * @brief Internal test_lock implementation
  *
- * @param node Local lock data
  * @param lock Lock to test
  * @param me Current PE
  * @return 0 on success, non-zero if lock not acquired
  */
-inline static int test_lock(shmem_lock_t *node, shmem_lock_t *lock, int me) {
-  shmem_lock_t t;
-
-  test_lock_request(lock, me, &t);
-  return test_lock_execute(node, me, &t);
+inline static int test_lock(unsigned long *lock, int me) {
+  return lock_mcs_test(lock, lock_owner(lock), me);
 }
 
 /**
@@ -317,14 +76,10 @@ inline static int test_lock(shmem_lock_t *node, shmem_lock_t *lock, int me) {
 #endif /* ENABLE_PSHMEM */
 
 /*
- * split the "big" user-visible lock into the internal management
- * types
+ * the user-visible lock is our lock word
  */
 
-#define UNPACK()                                                               \
-  shmem_lock_t *base = (shmem_lock_t *)lp;                                     \
-  shmem_lock_t *node = base + 1;                                               \
-  shmem_lock_t *lock = base + 0
+#define UNPACK() unsigned long *lock = (unsigned long *)lp
 
 /**
  * @brief Set (acquire) a distributed lock
@@ -343,7 +98,7 @@ void shmem_set_lock(long *lp) {
 
   logger(LOG_LOCKS, "%s(lock=%p)", __func__, lock);
 
-  SHMEMT_MUTEX_NOPROTECT(set_lock(node, lock, shmemc_my_pe()));
+  SHMEMT_MUTEX_NOPROTECT(set_lock(lock, shmemc_my_pe()));
 }
 
 /**
@@ -363,7 +118,7 @@ void shmem_clear_lock(long *lp) {
 
   logger(LOG_LOCKS, "%s(lock=%p)", __func__, lock);
 
-  SHMEMT_MUTEX_NOPROTECT(clear_lock(node, lock, shmemc_my_pe()));
+  SHMEMT_MUTEX_NOPROTECT(clear_lock(lock, shmemc_my_pe()));
 }
 
 /**
@@ -385,7 +140,7 @@ int shmem_test_lock(long *lp) {
 
   logger(LOG_LOCKS, "%s(lock=%p)", __func__, lock);
 
-  SHMEMT_MUTEX_NOPROTECT(ret = test_lock(node, lock, shmemc_my_pe()));
+  SHMEMT_MUTEX_NOPROTECT(ret = test_lock(lock, shmemc_my_pe()));
 
   return ret;
 }
@@ -0,0 +1,245 @@
+/* For license: see LICENSE file at top-level */
+
+/**
+ * @file lock.h
+ * @brief Distributed lock building blocks
+ *
+ * Where locks live, and the MCS queue on a lock word.  Shared by the
+ * standard locks and the lock extensions.
+ */
+
+#ifndef _SHMEM_LOCK_H
+#define _SHMEM_LOCK_H 1
+
+#include "shmemu.h"
+#include "shmemc.h"
+#include "shmem.h"
+#include "boolean.h"
+
+#include <stdint.h>
+#include <limits.h>
+
+/*
+ * spread lock ownership around PEs
+ */
+
+/**
+ * @brief Calculate lock owner PE from where the lock sits
+ *
+ * Locks are at least 8 bytes apart, but arrays of structs holding
+ * locks have larger strides, so hash rather than take the offset
+ * modulo the PE count.
+ *
+ * @param region Symmetric region of the lock
+ * @param offset Offset of the lock in the region
+ * @return PE number that should own this lock
+ */
+inline static int get_owner_spread(long region, uint64_t offset) {
+  const uint64_t key = ((uint64_t)region << 56) ^ (offset >> 3);
+  const uint64_t h = key * UINT64_C(0x9e3779b97f4a7c15); /* Fibonacci */
+
+  return (int)(((h >> 32) * (uint64_t)shmemc_n_pes()) >> 32);
+}
+
+/**
+ * @brief Determine the owner PE for a lock
+ *
+ * Addresses of symmetric heap variables can differ between PEs, but
+ * their offsets into the heap don't, so use those.
+ *
+ * @param addr Address of the lock
+ * @return PE number that owns this lock
+ */
+inline static int lock_owner(void *addr) {
+  uint64_t offset;
+  const long region = shmemc_symmetric_offset((uint64_t)addr, &offset);
+
+  if (shmemu_unlikely(region < 0)) {
+    /* don't choose PE 0, as it is often used for work allocation */
+    return shmemc_n_pes() - 1;
+    /* NOT REACHED */
+  }
+
+  return get_owner_spread(region, offset);
+}
+
+/*
+ * The user's lock is one long, used the same way on every PE:
+ *
+ *   bits  0-31  tail: last PE in the queue, + 1 (0 = free).  Only
+ *               used on the lock's owner PE.
+ *   bits 32-62  next: PE queued behind us, + 1 (0 = none).
+ *   bit  63     wait: set while we're queued behind another PE.
+ *
+ * next/wait are this PE's MCS queue node.  On the owner, the node and
+ * the tail share the word, so they're only ever changed with 64-bit
+ * AMOs that leave the other fields alone: bitwise and/or for the
+ * node, compare-and-swap for the tail.  Full int PE numbers, and 0 is
+ * the spec's lock initializer.
+ */
+
+#if ULONG_MAX < 0xffffffffffffffffUL
+#error "distributed locks need a 64-bit long"
+#endif /* ULONG_MAX */
+
+#define LOCK_TAIL_MASK 0x00000000ffffffffUL
+#define LOCK_NEXT_SHIFT 32
+#define LOCK_NEXT_MASK 0x7fffffff00000000UL
+#define LOCK_WAIT 0x8000000000000000UL
+
+#define LOCK_TAIL(_pe) ((unsigned long)(_pe) + 1)
+#define LOCK_NEXT(_pe) (LOCK_TAIL(_pe) << LOCK_NEXT_SHIFT)
+
+#define LOCK_READ(_lock) __atomic_load_n(_lock, __ATOMIC_ACQUIRE)
+
+/*
+ * Queue node updates are handed to other PEs' spin loops, so they use
+ * fetching AMOs: those complete before we go on, so they land in
+ * program order, and aggregating contexts send them at once rather
+ * than buffering them.
+ */
+#define LOCK_NODE_OR(_lock, _bits, _pe)                                        \
+  (void)shmem_ulong_atomic_fetch_or(_lock, _bits, _pe)
+#define LOCK_NODE_AND(_lock, _bits, _pe)                                       \
+  (void)shmem_ulong_atomic_fetch_and(_lock, _bits, _pe)
+
+/**
+ * @brief Swap a new tail into the lock on its owner
+ *
+ * Retries if the owner's own queue node changes under us.
+ *
+ * @param lock Lock on the owner
+ * @param owner Owner PE
+ * @param from Tail to replace, or ~0 for any
+ * @param to New tail
+ * @return Old tail, the swap only happened if it matched "from"
+ */
+inline static unsigned long lock_swap_tail(unsigned long *lock, int owner,
+                                          unsigned long from,
+                                          unsigned long to) {
+  unsigned long old = shmem_ulong_atomic_fetch(lock, owner);
+
+  for (;;) {
+    const unsigned long tail = old & LOCK_TAIL_MASK;
+    unsigned long seen;
+
+    if ((from != ~0UL) && (tail != from)) {
+      return tail;
+      /* NOT REACHED */
+    }
+
+    seen = shmem_ulong_atomic_compare_swap(
+        lock, old, (old & ~LOCK_TAIL_MASK) | to, owner);
+    if (seen == old) {
+      return tail;
+      /* NOT REACHED */
+    }
+
+    old = seen;
+  }
+}
+
+/**
+ * @brief Wait until our node says so
+ *
+ * @param lock Lock (our node)
+ * @param mask Bits to look at
+ * @param want Wait until they're non-zero (true) or zero (false)
+ * @return What we saw
+ */
+inline static unsigned long lock_wait_node(unsigned long *lock,
+                                          unsigned long mask, bool want) {
+  unsigned long v;
+
+  while (((v = LOCK_READ(lock) & mask) != 0) != want) {
+    shmemc_progress();
+  }
+
+  return v;
+}
+
+/**
+ * @brief Queue for a lock and wait to get it
+ *
+ * @param lock Lock to set
+ * @param owner PE holding the tail
+ * @param me Current PE
+ */
+inline static void lock_mcs_set(unsigned long *lock, int owner, int me) {
+  unsigned long pred;
+
+  /* our predecessor can clear this as soon as we're queued */
+  LOCK_NODE_OR(lock, LOCK_WAIT, me);
+
+  pred = lock_swap_tail(lock, owner, ~0UL, LOCK_TAIL(me));
+
+  if (pred == 0) {
+    LOCK_NODE_AND(lock, ~LOCK_WAIT, me);
+    return;
+    /* NOT REACHED */
+  }
+
+  /* chain me on and sit here until unlocked */
+  LOCK_NODE_OR(lock, LOCK_NEXT(me), (int)(pred - 1));
+
+  (void)lock_wait_node(lock, LOCK_WAIT, false);
+}
+
+/**
+ * @brief Hand a lock to the next in the queue, or free it
+ *
+ * @param lock Lock to clear
+ * @param owner PE holding the tail
+ * @param me Current PE
+ */
+inline static void lock_mcs_clear(unsigned long *lock, int owner, int me) {
+  unsigned long next = LOCK_READ(lock) & LOCK_NEXT_MASK;
+
+  if (next == 0) {
+    /* nobody behind us?  then free it */
+    if (lock_swap_tail(lock, owner, LOCK_TAIL(me), 0) == LOCK_TAIL(me)) {
+      return;
+      /* NOT REACHED */
+    }
+
+    /* wait for a chainer PE to appear */
+    next = lock_wait_node(lock, LOCK_NEXT_MASK, true);
+  }
+
+  /* reset our node, then (once that's done) tell next PE about release */
+  LOCK_NODE_AND(lock, ~LOCK_NEXT_MASK, me);
+  LOCK_NODE_AND(lock, ~LOCK_WAIT, (int)((next >> LOCK_NEXT_SHIFT) - 1));
+}
+
+/**
+ * @brief Take a lock if it's free
+ *
+ * @param lock Lock to test
+ * @param owner PE holding the tail
+ * @param me Current PE
+ * @return 0 on success, non-zero if lock not acquired
+ */
+inline static int lock_mcs_test(unsigned long *lock, int owner, int me) {
+  /* if the lock is free, grab it, nobody to wait for */
+  return lock_swap_tail(lock, owner, 0, LOCK_TAIL(me)) != 0;
+}
+
+/**
+ * @brief Is anyone queued behind us, or about to be?
+ *
+ * @param lock Lock we hold
+ * @param owner PE holding the tail
+ * @param me Current PE
+ * @return true if so
+ */
+inline static bool lock_mcs_waiters(unsigned long *lock, int owner, int me) {
+  if ((LOCK_READ(lock) & LOCK_NEXT_MASK) != 0) {
+    return true;
+    /* NOT REACHED */
+  }
+
+  return (shmem_ulong_atomic_fetch(lock, owner) & LOCK_TAIL_MASK) !=
+         LOCK_TAIL(me);
+}
+
+#endif /* ! _SHMEM_LOCK_H */
@@ -167,8 +167,7 @@ SHMEM_STANDARD_RMA_TYPE_TABLE(P_TYPE_HELPER)
 /**
  * @brief Implementation of strided put operations
  *
- * TODO: this is just layered over shmem_put/get linearly for now.
- * Looking for better iov method in UCX
+ * Handed to the comms layer as one strided transfer
  */
 
 #ifdef ENABLE_PSHMEM
@@ -131,9 +131,6 @@
   void shmem_ctx_##_name##_iput(shmem_ctx_t ctx, _type *target,                \
                                 const _type *source, ptrdiff_t tst,            \
                                 ptrdiff_t sst, size_t nelems, int pe) {        \
-    size_t ti = 0, si = 0;                                                     \
-    size_t i;                                                                  \
-                                                                               \
     SHMEMU_CHECK_INIT();                                                       \
     SHMEMU_CHECK_PE_ARG_RANGE(pe, 7);                                          \
     SHMEMU_CHECK_SYMMETRIC(target, 2);                                         \
@@ -144,11 +141,8 @@
            __func__, shmemc_context_id(ctx), target, source, tst, sst, nelems, \
            pe);                                                                \
                                                                                \
-    for (i = 0; i < nelems; ++i) {                                             \
-      shmem_ctx_##_name##_put(ctx, &(target[ti]), &(source[si]), 1, pe);       \
-      ti += tst;                                                               \
-      si += sst;                                                               \
-    }                                                                          \
+    SHMEMT_MUTEX_NOPROTECT(shmemc_ctx_iput(ctx, target, source, tst, sst,      \
+                                           sizeof(_type), nelems, pe));        \
   }
 
 /**
@@ -160,9 +154,6 @@
   void shmem_ctx_##_name##_iget(shmem_ctx_t ctx, _type *target,                \
                                 const _type *source, ptrdiff_t tst,            \
                                 ptrdiff_t sst, size_t nelems, int pe) {        \
-    size_t ti = 0, si = 0;                                                     \
-    size_t i;                                                                  \
-                                                                               \
     SHMEMU_CHECK_INIT();                                                       \
     SHMEMU_CHECK_PE_ARG_RANGE(pe, 7);                                          \
     SHMEMU_CHECK_SYMMETRIC(source, 3);                                         \
@@ -173,11 +164,8 @@
            __func__, shmemc_context_id(ctx), target, source, tst, sst, nelems, \
            pe);                                                                \
                                                                                \
-    for (i = 0; i < nelems; ++i) {                                             \
-      shmem_ctx_##_name##_get(ctx, &(target[ti]), &(source[si]), 1, pe);       \
-      ti += tst;                                                               \
-      si += sst;                                                               \
-    }                                                                          \
+    SHMEMT_MUTEX_NOPROTECT(shmemc_ctx_iget(ctx, target, source, tst, sst,      \
+                                           sizeof(_type), nelems, pe));        \
   }
 
 /**
@@ -188,11 +176,6 @@
   void shmem_ctx_iput##_size(shmem_ctx_t ctx, void *target,                    \
                              const void *source, ptrdiff_t tst, ptrdiff_t sst, \
                              size_t nelems, int pe) {                          \
-    const size_t tst_nb = BITS2BYTES(_size) * tst;                             \
-    const size_t sst_nb = BITS2BYTES(_size) * sst;                             \
-    size_t ti = 0, si = 0;                                                     \
-    size_t i;                                                                  \
-                                                                               \
     SHMEMU_CHECK_INIT();                                                       \
     SHMEMU_CHECK_PE_ARG_RANGE(pe, 7);                                          \
     SHMEMU_CHECK_SYMMETRIC(target, 2);                                         \
@@ -203,12 +186,8 @@
            __func__, shmemc_context_id(ctx), target, source, tst, sst, nelems, \
            pe);                                                                \
                                                                                \
-    for (i = 0; i < nelems; ++i) {                                             \
-      shmem_ctx_put##_size(ctx, (void *)&((char *)target)[ti],                 \
-                           (void *)&((char *)source)[si], 1, pe);              \
-      ti += tst_nb;                                                            \
-      si += sst_nb;                                                            \
-    }                                                                          \
+    SHMEMT_MUTEX_NOPROTECT(shmemc_ctx_iput(ctx, target, source, tst, sst,      \
+                                           BITS2BYTES(_size), nelems, pe));    \
   }
 
 /**
@@ -219,11 +198,6 @@
   void shmem_ctx_iget##_size(shmem_ctx_t ctx, void *target,                    \
                              const void *source, ptrdiff_t tst, ptrdiff_t sst, \
                              size_t nelems, int pe) {                          \
-    const size_t tst_nb = BITS2BYTES(_size) * tst;                             \
-    const size_t sst_nb = BITS2BYTES(_size) * sst;                             \
-    size_t ti = 0, si = 0;                                                     \
-    size_t i;                                                                  \
-                                                                               \
     SHMEMU_CHECK_INIT();                                                       \
     SHMEMU_CHECK_PE_ARG_RANGE(pe, 7);                                          \
     SHMEMU_CHECK_SYMMETRIC(source, 3);                                         \
@@ -234,12 +208,8 @@
            __func__, shmemc_context_id(ctx), target, source, tst, sst, nelems, \
            pe);                                                                \
                                                                                \
-    for (i = 0; i < nelems; ++i) {                                             \
-      shmem_ctx_get##_size(ctx, (void *)&((char *)target)[ti],                 \
-                           (void *)&((char *)source)[si], 1, pe);              \
-      ti += tst_nb;                                                            \
-      si += sst_nb;                                                            \
-    }                                                                          \
+    SHMEMT_MUTEX_NOPROTECT(shmemc_ctx_iget(ctx, target, source, tst, sst,      \
+                                           BITS2BYTES(_size), nelems, pe));    \
   }
 
 /**
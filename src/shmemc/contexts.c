@@ -20,8 +20,15 @@
 #include "shmem/defs.h"
 #include "../klib/klist.h"
 #include "ucx/api.h"
+#include "ucx/aggregate.h"
 
 #include <stdlib.h>
+#include <errno.h>
+#include <unistd.h>
+#include <time.h>
+#ifdef HAVE_SYS_EPOLL_H
+#include <sys/epoll.h>
+#endif /* HAVE_SYS_EPOLL_H */
 
 /**
  * @brief Manage free list of re-usable contexts
@@ -152,13 +159,309 @@ static size_t get_usable_context_run(shmemc_team_h th, bool *reused) {
   return idx;
 }
 
+/**
+ * @brief Contexts the progress thread can drive
+ *
+ * Only shared, unserialized contexts: the others have single-threaded
+ * workers we mustn't touch from another thread.  Workers live until
+ * finalize even when their context is destroyed.
+ */
+static shmemc_context_h *live = NULL;
+static size_t nlive = 0;
+static threadwrap_mutex_t live_lock;
+
+/**
+ * @brief Wakeup fds of the live contexts, once the progress thread
+ * wants to sleep on them
+ */
+static int live_epfd = -1;
+
+/** @brief How many wakeups to collect at a time */
+#define PROGRESS_MAX_EVENTS 16
+
+/**
+ * @brief Add a context's wakeup fd to the progress thread's set
+ *
+ * @param ch Context handle
+ * @return 0 on success, non-zero if the context can't wake us
+ */
+static int live_listen(shmemc_context_h ch) {
+#ifdef HAVE_SYS_EPOLL_H
+  struct epoll_event ev;
+  const int fd = shmemc_ucx_context_efd(ch);
+
+  if (fd < 0) {
+    return 1;
+    /* NOT REACHED */
+  }
+
+  ev.events = EPOLLIN;
+  ev.data.ptr = ch;
+
+  if ((epoll_ctl(live_epfd, EPOLL_CTL_ADD, fd, &ev) != 0) &&
+      (errno != EEXIST)) {
+    return 1;
+    /* NOT REACHED */
+  }
+#else
+  NO_WARN_UNUSED(ch);
+#endif /* HAVE_SYS_EPOLL_H */
+
+  return 0;
+}
+
+/**
+ * @brief Can another thread progress this context?
+ *
+ * @param ch Context handle
+ * @return true if so
+ */
+inline static bool context_is_shared(shmemc_context_h ch) {
+  return !(ch->attr.privat || ch->attr.serialized);
+}
+
+/**
+ * @brief Add a context to the live list
+ *
+ * @param ch Context handle
+ */
+static void live_add(shmemc_context_h ch) {
+  shmemc_context_h *chp;
+
+  threadwrap_mutex_lock(&live_lock);
+
+  chp = (shmemc_context_h *)realloc(live, (nlive + 1) * sizeof(*live));
+  shmemu_assert(chp != NULL, "can't register context #%lu", ch->id);
+  live = chp;
+  live[nlive++] = ch;
+
+  /* progress thread may be asleep without this one: wake it to re-arm */
+  if ((live_epfd >= 0) && (live_listen(ch) == 0)) {
+    shmemc_ucx_context_signal(ch);
+  }
+
+  threadwrap_mutex_unlock(&live_lock);
+}
+
+/**
+ * @brief Remove a context from the live list
+ *
+ * @param ch Context handle
+ */
+static void live_remove(shmemc_context_h ch) {
+  size_t i;
+
+  threadwrap_mutex_lock(&live_lock);
+
+  for (i = 0; i < nlive; ++i) {
+    if (live[i] == ch) {
+      live[i] = live[--nlive];
+      break;
+    }
+  }
+#ifdef HAVE_SYS_EPOLL_H
+  if ((live_epfd >= 0) && (ch->wakeup_fd >= 0)) {
+    (void)epoll_ctl(live_epfd, EPOLL_CTL_DEL, ch->wakeup_fd, NULL);
+  }
+#endif /* HAVE_SYS_EPOLL_H */
+  if (nlive == 0) {
+    free(live);
+    live = NULL;
+  }
+
+  threadwrap_mutex_unlock(&live_lock);
+}
+
+/**
+ * @brief Cap an idle period by the aggregation timeout
+ *
+ * Nothing wakes the progress thread for ops sitting in an aggregation
+ * buffer, so it can't idle past the timeout while a live context
+ * aggregates.  Caller holds live_lock.
+ *
+ * @param ns Idle period wanted (ns)
+ * @return ns, or the aggregation timeout if shorter
+ */
+static long live_idle_ns(long ns) {
+  const long aggr_ns = (long)proc.env.aggr_timeout_ns;
+  size_t i;
+
+  if (aggr_ns >= ns) {
+    return ns;
+    /* NOT REACHED */
+  }
+
+  for (i = 0; i < nlive; ++i) {
+    if (live[i]->aggr != NULL) {
+      return aggr_ns;
+      /* NOT REACHED */
+    }
+  }
+
+  return ns;
+}
+
+/**
+ * @brief How long the progress thread may idle
+ *
+ * @param ns Idle period wanted (ns)
+ * @return ns, or less if buffered ops need flushing sooner
+ */
+long shmemc_progress_idle_ns(long ns) {
+  long r;
+
+  threadwrap_mutex_lock(&live_lock);
+  r = live_idle_ns(ns);
+  threadwrap_mutex_unlock(&live_lock);
+
+  return r;
+}
+
+/**
+ * @brief Make one round of progress on every live shared context
+ *
+ * @return How many completions etc. were handled
+ */
+unsigned shmemc_progress_all(void) {
+  unsigned n = 0;
+  size_t i;
+
+  threadwrap_mutex_lock(&live_lock);
+  for (i = 0; i < nlive; ++i) {
+    n += shmemc_ctx_progress_count(live[i]);
+  }
+  threadwrap_mutex_unlock(&live_lock);
+
+  return n;
+}
+
+#ifdef HAVE_SYS_EPOLL_H
+/**
+ * @brief Wait on the live contexts' wakeup fds
+ *
+ * epoll_wait() only does whole milliseconds.  Without epoll_pwait2(),
+ * a shorter wait checks for events and then naps instead.
+ *
+ * @param timeout_ns Longest wait (ns)
+ */
+static void live_wait(long timeout_ns) {
+  struct epoll_event ev[PROGRESS_MAX_EVENTS];
+#ifdef HAVE_EPOLL_PWAIT2
+  const struct timespec ts = {.tv_sec = timeout_ns / 1000000000L,
+                              .tv_nsec = timeout_ns % 1000000000L};
+
+  (void)epoll_pwait2(live_epfd, ev, PROGRESS_MAX_EVENTS, &ts, NULL);
+#else
+  static bool warned = false;
+
+  if (timeout_ns >= 1000000L) {
+    (void)epoll_wait(live_epfd, ev, PROGRESS_MAX_EVENTS,
+                     (int)(timeout_ns / 1000000L));
+    return;
+    /* NOT REACHED */
+  }
+
+  if (!warned) {
+    shmemu_warn("can't sleep on events for less than 1ms, progress thread "
+                "will nap for %ldns while ops are aggregated",
+                timeout_ns);
+    warned = true;
+  }
+
+  if (epoll_wait(live_epfd, ev, PROGRESS_MAX_EVENTS, 0) == 0) {
+    const struct timespec ts = {.tv_sec = 0, .tv_nsec = timeout_ns};
+
+    nanosleep(&ts, NULL);
+  }
+#endif /* HAVE_EPOLL_PWAIT2 */
+}
+#endif /* HAVE_SYS_EPOLL_H */
+
+/**
+ * @brief Sleep until one of the live shared contexts has events
+ *
+ * Arms every context's worker and waits on their wakeup fds.  Returns
+ * at once if any has events already.  Sleeps no longer than the
+ * aggregation timeout while a live context aggregates.
+ *
+ * @param timeout_ms Longest sleep (ms)
+ * @return 0 on success, non-zero if we can't sleep on these contexts
+ */
+int shmemc_progress_block(int timeout_ms) {
+#ifdef HAVE_SYS_EPOLL_H
+  bool armed = true;
+  long timeout_ns;
+  size_t i;
+
+  threadwrap_mutex_lock(&live_lock);
+
+  if (live_epfd < 0) {
+    live_epfd = epoll_create1(EPOLL_CLOEXEC);
+    if (live_epfd < 0) {
+      goto fail;
+      /* NOT REACHED */
+    }
+    for (i = 0; i < nlive; ++i) {
+      if (live_listen(live[i]) != 0) {
+        goto fail;
+        /* NOT REACHED */
+      }
+    }
+  }
+
+  for (i = 0; armed && (i < nlive); ++i) {
+    if (shmemc_ucx_context_efd(live[i]) < 0) {
+      goto fail;
+      /* NOT REACHED */
+    }
+    armed = shmemc_ucx_context_arm(live[i]);
+  }
+
+  timeout_ns = live_idle_ns(timeout_ms * 1000000L);
+
+  threadwrap_mutex_unlock(&live_lock);
+
+  if (armed) {
+    live_wait(timeout_ns);
+  }
+
+  return 0;
+
+fail:
+  threadwrap_mutex_unlock(&live_lock);
+
+  return 1;
+#else
+  NO_WARN_UNUSED(timeout_ms);
+
+  return 1;
+#endif /* HAVE_SYS_EPOLL_H */
+}
+
+/**
+ * @brief Wake a thread in shmemc_progress_block()
+ */
+void shmemc_progress_unblock(void) { shmemc_ucx_context_signal(defcp); }
+
+/**
+ * @brief Release what shmemc_progress_block() set up
+ */
+void shmemc_progress_block_finalize(void) {
+  if (live_epfd >= 0) {
+    close(live_epfd);
+    live_epfd = -1;
+  }
+}
+
 /**
  * @brief Register a context in PE state
  *
  * @param ch Context handle to register
  */
 inline static void context_register(shmemc_context_h ch) {
-  NO_WARN_UNUSED(ch);
+  if (context_is_shared(ch)) {
+    live_add(ch);
+  }
 
   logger(LOG_CONTEXTS, "using context #%lu", ch->id);
 }
@@ -169,6 +472,10 @@ inline static void context_register(shmemc_context_h ch) {
  * @param ch Context handle to deregister
  */
 inline static void context_deregister(shmemc_context_h ch) {
+  if (context_is_shared(ch)) {
+    live_remove(ch);
+  }
+
   /* this one is re-usable */
   *kl_pushp(freelist, fl) = ch->id;
 
@@ -185,6 +492,7 @@ inline static void context_set_options(long options, shmemc_context_h ch) {
   ch->attr.serialized = options & SHMEM_CTX_SERIALIZED;
   ch->attr.privat = options & SHMEM_CTX_PRIVATE;
   ch->attr.nostore = options & SHMEM_CTX_NOSTORE;
+  ch->attr.aggregate = options & SHMEMC_CTX_AGGREGATE;
 }
 
 /**
@@ -248,6 +556,8 @@ int shmemc_context_create(shmemc_team_h th, long options,
   ch->id = idx;
   ch->team = th; /* connect context to its owning team */
 
+  shmemc_ucx_aggr_create(ch);
+
   context_register(ch);
 
   *ctxp = ch;
@@ -275,6 +585,10 @@ void shmemc_context_destroy(shmem_ctx_t ctx) {
     /* spec 1.4 ++ has implicit quiet for storable contexts */
     shmemc_ctx_quiet(ch);
 
+    /* nostore contexts never drain, so buffered ops go now */
+    shmemc_ucx_aggr_drain(ch);
+    shmemc_ucx_aggr_destroy(ch);
+
     context_deregister(ch);
   }
 }
@@ -306,9 +620,13 @@ shmemc_context_h defcp = &shmemc_default_context;
  * @return 0 on success, non-zero on failure
  */
 int shmemc_context_init_default(void) {
-  context_set_options(0L, defcp);
+  threadwrap_mutex_init(&live_lock);
+
+  context_set_options(proc.env.aggregate ? SHMEMC_CTX_AGGREGATE : 0L, defcp);
 
   shmemc_ucx_context_progress(defcp);
 
+  live_add(defcp);
+
   return shmemc_ucx_context_default_set_info();
 }
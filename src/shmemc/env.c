@@ -16,6 +16,7 @@
 #include "shmemc.h"
 #include "boolean.h"
 #include "collectives/defaults.h"
+#include "ucx/stripe.h"
 #include "module.h"
 
 #include <stdio.h>
@@ -60,6 +61,89 @@ static bool option_enabled_test(const char *str) {
   return false;
 }
 
+/**
+ * @brief Transports that can only do atomics with the CPU
+ */
+static const char *cpu_only_tls[] = {"self", "sm",    "shm", "posix",
+                                     "sysv", "xpmem", "cma", "knem"};
+
+/**
+ * @brief Does UCX_TLS allow nothing but shared memory and self?
+ */
+static bool cpu_only_transports(void) {
+  const int n = sizeof(cpu_only_tls) / sizeof(cpu_only_tls[0]);
+  const char *tls = getenv("UCX_TLS");
+  char *copy;
+  char *tl;
+  char *save;
+  bool ok = true;
+
+  /* unset or "all" lets in any NIC, "^..." only excludes some */
+  if ((tls == NULL) || (*tls == '\0') || (*tls == '^')) {
+    return false;
+    /* NOT REACHED */
+  }
+
+  copy = strdup(tls);
+  shmemu_assert(copy != NULL, MODULE ": can't copy UCX_TLS");
+
+  for (tl = strtok_r(copy, ",", &save); ok && (tl != NULL);
+       tl = strtok_r(NULL, ",", &save)) {
+    int i;
+
+    for (i = 0; i < n; ++i) {
+      if (strcasecmp(tl, cpu_only_tls[i]) == 0) {
+        break;
+      }
+    }
+    ok = (i < n);
+  }
+
+  free(copy);
+
+  return ok;
+}
+
+/**
+ * @brief Do CPU atomics on our memory agree with AMOs from other PEs?
+ *
+ * Only if UCX does those with the CPU as well.  Having everyone on
+ * this node doesn't tell us that: UCX's default atomic mode ("guess")
+ * picks the NIC's atomics whenever a transport in use has them, even
+ * between PEs on one node.  So only when told to, or when UCX may
+ * only use shared memory.
+ */
+static bool cpu_atomics_coherent(void) {
+  const char *am = getenv("UCX_ATOMIC_MODE");
+
+  return ((am != NULL) && (strcasecmp(am, "cpu") == 0)) ||
+         cpu_only_transports();
+}
+
+/**
+ * @brief Names for SHMEM_WAIT_POLICY, indexed by policy
+ */
+static const char *wait_policy_names[] = {"default", "spin", "yield",
+                                          "backoff", "event"};
+
+static shmemc_wait_policy_t wait_policy_from_name(const char *name) {
+  const int n = sizeof(wait_policy_names) / sizeof(wait_policy_names[0]);
+  int i;
+
+  for (i = SHMEMC_WAIT_SPIN; i < n; ++i) {
+    if (strcasecmp(name, wait_policy_names[i]) == 0) {
+      return (shmemc_wait_policy_t)i;
+      /* NOT REACHED */
+    }
+  }
+
+  shmemu_fatal(MODULE ": unknown wait policy \"%s\" "
+                      "(spin, yield, backoff or event)",
+               name);
+  /* NOT REACHED */
+  return SHMEMC_WAIT_EVENT;
+}
+
 /**
  * @brief Check for environment variable with SHMEM_ prefix
  */
@@ -329,6 +413,26 @@ void shmemc_env_init(void) {
                        "progress delay time \"%s\"",
                 e != NULL ? e : delay);
 
+  proc.env.progress_events = false;
+
+  CHECK_ENV(e, PROGRESS_MODE);
+  if (e != NULL) {
+    if (strcasecmp(e, "event") == 0) {
+      proc.env.progress_events = true;
+    } else if (strcasecmp(e, "poll") != 0) {
+      shmemu_fatal(MODULE ": unknown progress mode \"%s\" (poll or event)",
+                   e);
+      /* NOT REACHED */
+    }
+  }
+
+  proc.env.progress_cpu = NULL;
+
+  CHECK_ENV(e, PROGRESS_CPU);
+  if (e != NULL) {
+    proc.env.progress_cpu = strdup(e); /* free@end */
+  }
+
   proc.env.prealloc_contexts = 64; /* magic number */
 
   CHECK_ENV(e, PREALLOC_CTXS);
@@ -341,12 +445,164 @@ void shmemc_env_init(void) {
     proc.env.prealloc_contexts = (size_t)n;
   }
 
+  proc.env.cohort_passes = 64; /* magic number */
+
+  CHECK_ENV(e, COHORT_PASSES);
+  if (e != NULL) {
+    long n = strtol(e, NULL, 10);
+
+    if (n < 0) {
+      n = proc.env.cohort_passes;
+    }
+    proc.env.cohort_passes = (size_t)n;
+  }
+
   proc.env.memfatal = true;
 
   CHECK_ENV(e, MEMERR_FATAL);
   if (e != NULL) {
     proc.env.memfatal = option_enabled_test(e);
   }
+
+  proc.env.mapped_rma = true;
+
+  CHECK_ENV(e, MAPPED_RMA);
+  if (e != NULL) {
+    proc.env.mapped_rma = option_enabled_test(e);
+  }
+
+  {
+    const char *nt = "1M"; /* magic number: well past L2 */
+
+    CHECK_ENV(e, NT_THRESHOLD);
+
+    r = shmemu_parse_size(e != NULL ? e : nt, &proc.env.nt_threshold);
+    shmemu_assert(r == 0,
+                  MODULE ": couldn't work out requested "
+                         "non-temporal store threshold \"%s\"",
+                  e != NULL ? e : nt);
+  }
+
+  proc.env.loopback = true;
+
+  CHECK_ENV(e, LOOPBACK);
+  if (e != NULL) {
+    proc.env.loopback = option_enabled_test(e);
+  }
+
+  proc.env.loopback_amo = cpu_atomics_coherent();
+
+  CHECK_ENV(e, LOOPBACK_AMO);
+  if (e != NULL) {
+    proc.env.loopback_amo = option_enabled_test(e);
+  }
+
+  if (!proc.env.loopback) {
+    proc.env.loopback_amo = false;
+  }
+
+  /*
+   * the target applies remote-executed AMOs with CPU atomics, so same
+   * rule for those UCX could do itself
+   */
+  proc.env.amo_ext_am = cpu_atomics_coherent();
+
+  CHECK_ENV(e, AM_AMO);
+  if (e != NULL) {
+    proc.env.amo_ext_am = option_enabled_test(e);
+  }
+
+  /* aligned word puts/gets are atomic wrt CPU AMOs, not NIC ones */
+  proc.env.amo_rma = cpu_atomics_coherent();
+
+  CHECK_ENV(e, AMO_RMA);
+  if (e != NULL) {
+    proc.env.amo_rma = option_enabled_test(e);
+  }
+
+  proc.env.aggregate = false;
+
+  CHECK_ENV(e, AGGREGATE);
+  if (e != NULL) {
+    proc.env.aggregate = option_enabled_test(e);
+  }
+
+  {
+    const char *bs = "8K";     /* magic number: a few packets */
+    const char *mx = "64";     /* magic number: a cache line */
+    const char *to = "100000"; /* magic number: 100 us */
+
+    CHECK_ENV(e, AGGREGATE_BUFSIZE);
+    r = shmemu_parse_size(e != NULL ? e : bs, &proc.env.aggr_bufsize);
+    shmemu_assert(r == 0,
+                  MODULE ": couldn't work out requested "
+                         "aggregation buffer size \"%s\"",
+                  e != NULL ? e : bs);
+
+    CHECK_ENV(e, AGGREGATE_MAX);
+    r = shmemu_parse_size(e != NULL ? e : mx, &proc.env.aggr_max_msg);
+    shmemu_assert(r == 0,
+                  MODULE ": couldn't work out requested "
+                         "maximum aggregated message size \"%s\"",
+                  e != NULL ? e : mx);
+
+    CHECK_ENV(e, AGGREGATE_TIMEOUT);
+    r = shmemu_parse_size(e != NULL ? e : to, &proc.env.aggr_timeout_ns);
+    shmemu_assert(r == 0,
+                  MODULE ": couldn't work out requested "
+                         "aggregation timeout \"%s\"",
+                  e != NULL ? e : to);
+
+    /* every op (16-byte header + padded payload) fits in a buffer */
+    if (proc.env.aggr_max_msg + 16 > proc.env.aggr_bufsize) {
+      proc.env.aggr_max_msg =
+          (proc.env.aggr_bufsize > 16) ? (proc.env.aggr_bufsize - 16) & ~7UL
+                                       : 0;
+    }
+  }
+
+  proc.env.stripe_lanes = 1;
+
+  CHECK_ENV(e, STRIPE_LANES);
+  if (e != NULL) {
+    long n = strtol(e, NULL, 10);
+
+    if (n < 1) {
+      n = 1;
+    } else if (n > SHMEMC_MAX_STRIPE_LANES) {
+      n = SHMEMC_MAX_STRIPE_LANES;
+    }
+    proc.env.stripe_lanes = (size_t)n;
+  }
+
+  {
+    const char *st = "4M"; /* magic number: rendezvous territory */
+
+    CHECK_ENV(e, STRIPE_THRESHOLD);
+    r = shmemu_parse_size(e != NULL ? e : st, &proc.env.stripe_threshold);
+    shmemu_assert(r == 0,
+                  MODULE ": couldn't work out requested "
+                         "striping threshold \"%s\"",
+                  e != NULL ? e : st);
+  }
+
+  proc.env.wait_policy = SHMEMC_WAIT_YIELD;
+
+  CHECK_ENV(e, WAIT_POLICY);
+  if (e != NULL) {
+    proc.env.wait_policy = wait_policy_from_name(e);
+  }
+
+  {
+    const char *ws = "20000"; /* magic number: a few remote round trips */
+
+    CHECK_ENV(e, WAIT_SPIN);
+    r = shmemu_parse_size(e != NULL ? e : ws, &proc.env.wait_spin_ns);
+    shmemu_assert(r == 0,
+                  MODULE ": couldn't work out requested "
+                         "wait spin time \"%s\"",
+                  e != NULL ? e : ws);
+  }
 }
 
 #undef CHECK_ENV
@@ -390,6 +646,7 @@ void shmemc_env_finalize(void) {
   free(proc.env.coll.barrier);
 
   free(proc.env.progress_threads);
+  free(proc.env.progress_cpu);
 
   /* Free reduction operation fields */
   free(proc.env.coll.and_to_all);
@@ -549,7 +806,21 @@ void shmemc_print_env_vars(FILE *stream, const char *prefix) {
           "PEs that need progress threads");
   fprintf(stream, "%s%-*s %-*lu %s", prefix, var_width, "SHMEM_PROGRESS_DELAY",
           val_width, (unsigned long)proc.env.progress_delay_ns,
-          "delay between progress polls (ns)");
+          "longest delay between idle progress polls (ns)");
+  if (proc.env.progress_threads == NULL) {
+    fprintf(stream, " [not used]");
+  }
+  fprintf(stream, "\n");
+  fprintf(stream, "%s%-*s %-*s %s", prefix, var_width, "SHMEM_PROGRESS_MODE",
+          val_width, proc.env.progress_events ? "event" : "poll",
+          "how progress threads wait for work");
+  if (proc.env.progress_threads == NULL) {
+    fprintf(stream, " [not used]");
+  }
+  fprintf(stream, "\n");
+  fprintf(stream, "%s%-*s %-*s %s", prefix, var_width, "SHMEM_PROGRESS_CPU",
+          val_width, proc.env.progress_cpu ? proc.env.progress_cpu : "none",
+          "CPUs for progress threads");
   if (proc.env.progress_threads == NULL) {
     fprintf(stream, " [not used]");
   }
@@ -557,9 +828,78 @@ void shmemc_print_env_vars(FILE *stream, const char *prefix) {
   fprintf(stream, "%s%-*s %-*lu %s\n", prefix, var_width, "SHMEM_PREALLOC_CTXS",
           val_width, (unsigned long)proc.env.prealloc_contexts,
           "pre-allocate contexts at startup");
+  fprintf(stream, "%s%-*s %-*lu %s\n", prefix, var_width,
+          "SHMEM_COHORT_PASSES", val_width,
+          (unsigned long)proc.env.cohort_passes,
+          "cohort lock hand-offs on a node in a row");
   fprintf(stream, "%s%-*s %-*s %s\n", prefix, var_width, "SHMEM_MEMERR_FATAL",
           val_width, proc.env.memfatal ? "yes" : "no",
           "abort if symmetric memory corruption");
+  fprintf(stream, "%s%-*s %-*s %s\n", prefix, var_width, "SHMEM_MAPPED_RMA",
+          val_width, shmemu_human_option(proc.env.mapped_rma),
+          "load/store RMA to PEs on this node");
+  {
+    char buf[BUFSIZE];
+
+    (void)shmemu_human_number(proc.env.nt_threshold, buf, BUFSIZE);
+    fprintf(stream, "%s%-*s %-*s %s\n", prefix, var_width,
+            "SHMEM_NT_THRESHOLD", val_width, buf,
+            "non-temporal stores from this size (0 = never)");
+  }
+  fprintf(stream, "%s%-*s %-*s %s\n", prefix, var_width, "SHMEM_LOOPBACK",
+          val_width, shmemu_human_option(proc.env.loopback),
+          "local copies for RMA to self");
+  fprintf(stream, "%s%-*s %-*s %s\n", prefix, var_width,
+          "SHMEM_LOOPBACK_AMO", val_width,
+          shmemu_human_option(proc.env.loopback_amo),
+          "CPU atomics for AMOs to self");
+  fprintf(stream, "%s%-*s %-*s %s\n", prefix, var_width, "SHMEM_AM_AMO",
+          val_width, shmemu_human_option(proc.env.amo_ext_am),
+          "run emulated AMOs at the target");
+  fprintf(stream, "%s%-*s %-*s %s\n", prefix, var_width, "SHMEM_AMO_RMA",
+          val_width, shmemu_human_option(proc.env.amo_rma),
+          "atomic set/fetch as put/get");
+  fprintf(stream, "%s%-*s %-*s %s\n", prefix, var_width, "SHMEM_AGGREGATE",
+          val_width, shmemu_human_option(proc.env.aggregate),
+          "aggregate small ops on the default context");
+  {
+    char buf[BUFSIZE];
+
+    (void)shmemu_human_number(proc.env.aggr_bufsize, buf, BUFSIZE);
+    fprintf(stream, "%s%-*s %-*s %s\n", prefix, var_width,
+            "SHMEM_AGGREGATE_BUFSIZE", val_width, buf,
+            "aggregation buffer per target PE");
+    (void)shmemu_human_number(proc.env.aggr_max_msg, buf, BUFSIZE);
+    fprintf(stream, "%s%-*s %-*s %s\n", prefix, var_width,
+            "SHMEM_AGGREGATE_MAX", val_width, buf,
+            "largest op to aggregate");
+  }
+  fprintf(stream, "%s%-*s %-*lu %s\n", prefix, var_width,
+          "SHMEM_AGGREGATE_TIMEOUT", val_width,
+          (unsigned long)proc.env.aggr_timeout_ns,
+          "send aggregated ops after this long (ns)");
+  fprintf(stream, "%s%-*s %-*lu %s\n", prefix, var_width,
+          "SHMEM_STRIPE_LANES", val_width,
+          (unsigned long)proc.env.stripe_lanes,
+          "split big transfers over this many lanes");
+  {
+    char buf[BUFSIZE];
+
+    (void)shmemu_human_number(proc.env.stripe_threshold, buf, BUFSIZE);
+    fprintf(stream, "%s%-*s %-*s %s", prefix, var_width,
+            "SHMEM_STRIPE_THRESHOLD", val_width, buf,
+            "stripe transfers of at least this size");
+    if (proc.env.stripe_lanes < 2) {
+      fprintf(stream, " [not used]");
+    }
+    fprintf(stream, "\n");
+  }
+  fprintf(stream, "%s%-*s %-*s %s\n", prefix, var_width, "SHMEM_WAIT_POLICY",
+          val_width, wait_policy_names[proc.env.wait_policy],
+          "what waits do after spinning");
+  fprintf(stream, "%s%-*s %-*lu %s\n", prefix, var_width, "SHMEM_WAIT_SPIN",
+          val_width, (unsigned long)proc.env.wait_spin_ns,
+          "spin in waits this long first (ns)");
 
   /* ---------------------------------------------------------------- */
 
@@ -16,6 +16,10 @@
 #endif /* HAVE_CONFIG_H */
 
 #include "ucx/api.h"
+#include "ucx/aggregate.h"
+#include "ucx/stripe.h"
+#include "ucx/amo_ext.h"
+#include "ucx/scan.h"
 #include "boolean.h"
 #include "shmemc.h"
 #include "nodename.h"
@@ -67,6 +71,14 @@ void shmemc_init(void) {
 
   shmemc_ucx_make_eps(defcp);
 
+  /* handlers in place before anyone can send to us */
+  shmemc_ucx_aggr_register_handlers();
+  shmemc_ucx_amo_ext_register_handlers();
+  shmemc_ucx_aggr_create(defcp);
+
+  shmemc_ucx_stripe_init();
+  shmemc_ucx_scan_init();
+
   /* just sync, no collect */
   shmemc_pmi_barrier_all(false);
 }
@@ -86,6 +98,8 @@ void shmemc_init(void) {
 void shmemc_finalize(void) {
   shmemc_teams_finalize();
 
+  shmemc_ucx_stripe_finalize();
+
   shmemc_ucx_context_default_destroy();
 
   shmemc_pmi_barrier_all(false);
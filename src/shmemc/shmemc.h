@@ -51,6 +51,8 @@ void shmemc_globalexit_finalize(void);
 void shmemc_global_exit(int status);
 
 void *shmemc_ctx_ptr(shmem_ctx_t ctx, const void *target, int pe);
+void *shmemc_ctx_lookup_remote_addr(shmem_ctx_t ctx, const void *addr,
+                                    int pe);
 int shmemc_pe_accessible(int pe);
 int shmemc_addr_accessible(const void *addr, int pe);
 
@@ -62,6 +64,7 @@ void shmemc_print_env_vars(FILE *stream, const char *prefix);
 
 int shmemc_global_address(uint64_t addr);
 int shmemc_managed_address(uint64_t addr);
+long shmemc_symmetric_offset(uint64_t addr, uint64_t *offp);
 
 /*
  * -- Per-context routines ---------------------------------------------------
@@ -69,10 +72,29 @@ int shmemc_managed_address(uint64_t addr);
 
 void shmemc_ctx_progress(shmem_ctx_t ctx);
 void shmemc_progress(void);
+unsigned shmemc_ctx_progress_count(shmem_ctx_t ctx);
+unsigned shmemc_progress_all(void);
+int shmemc_progress_block(int timeout_ms);
+long shmemc_progress_idle_ns(long ns);
+void shmemc_progress_unblock(void);
+void shmemc_progress_block_finalize(void);
 
 void shmemc_ctx_fence(shmem_ctx_t ctx);
 void shmemc_ctx_quiet(shmem_ctx_t ctx);
 
+void shmemc_ctx_pe_fence(shmem_ctx_t ctx, int pe);
+void shmemc_ctx_pe_quiet(shmem_ctx_t ctx, int pe);
+void shmemc_ctx_pe_quiet_multi(shmem_ctx_t ctx, const int *pes, size_t npes);
+
+/*
+ * context option matching SHMEMX_CTX_AGGREGATE, and pushing out
+ * everything aggregating contexts have buffered (e.g. for barriers)
+ */
+
+#define SHMEMC_CTX_AGGREGATE SHMEM_BIT_SET(16)
+
+void shmemc_aggr_flush_all(void);
+
 #ifdef ENABLE_EXPERIMENTAL
 
 int shmemc_ctx_fence_test(shmem_ctx_t ctx);
@@ -90,6 +112,69 @@ void shmemc_ctx_put_nbi(shmem_ctx_t ctx, void *dest, const void *src,
 void shmemc_ctx_get_nbi(shmem_ctx_t ctx, void *dest, const void *src,
                         size_t nbytes, int pe);
 
+/*
+ * handle-based: returns request to test/wait on, or NULL if complete
+ */
+void *shmemc_ctx_put_nbx(shmem_ctx_t ctx, void *dest, const void *src,
+                         size_t nbytes, int pe);
+void *shmemc_ctx_get_nbx(shmem_ctx_t ctx, void *dest, const void *src,
+                         size_t nbytes, int pe);
+int shmemc_request_test(void *req);
+void shmemc_request_wait(void *req);
+
+void shmemc_ctx_iput(shmem_ctx_t ctx, void *dest, const void *src,
+                     ptrdiff_t tst, ptrdiff_t sst, size_t elsize,
+                     size_t nelems, int pe);
+void shmemc_ctx_iget(shmem_ctx_t ctx, void *dest, const void *src,
+                     ptrdiff_t tst, ptrdiff_t sst, size_t elsize,
+                     size_t nelems, int pe);
+
+void shmemc_ctx_iput_nbi(shmem_ctx_t ctx, void *dest, const void *src,
+                         ptrdiff_t tst, ptrdiff_t sst, size_t elsize,
+                         size_t nelems, int pe);
+void shmemc_ctx_iget_nbi(shmem_ctx_t ctx, void *dest, const void *src,
+                         ptrdiff_t tst, ptrdiff_t sst, size_t elsize,
+                         size_t nelems, int pe);
+
+/*
+ * vectored: same layout as shmemx_xfer_t
+ */
+typedef struct shmemc_xfer {
+  void *dest;
+  const void *src;
+  size_t nbytes;
+  int pe;
+} shmemc_xfer_t;
+
+void shmemc_ctx_putv(shmem_ctx_t ctx, const shmemc_xfer_t *xs, size_t n);
+void shmemc_ctx_getv(shmem_ctx_t ctx, const shmemc_xfer_t *xs, size_t n);
+void shmemc_ctx_putv_nbi(shmem_ctx_t ctx, const shmemc_xfer_t *xs, size_t n);
+void shmemc_ctx_getv_nbi(shmem_ctx_t ctx, const shmemc_xfer_t *xs, size_t n);
+
+/*
+ * completion counters: counted non-blocking ops bump "count" once
+ * complete (puts and AMOs remotely, gets and fetches locally)
+ */
+typedef struct shmemc_counter {
+  shmem_ctx_t ctx;
+  uint64_t count;
+} shmemc_counter_t, *shmemc_counter_h;
+
+shmemc_counter_h shmemc_ctx_counter_create(shmem_ctx_t ctx);
+void shmemc_counter_destroy(shmemc_counter_h c);
+uint64_t shmemc_counter_read(shmemc_counter_h c);
+int shmemc_counter_test(shmemc_counter_h c, uint64_t n);
+void shmemc_counter_wait(shmemc_counter_h c, uint64_t n);
+
+void shmemc_counter_put_nbi(shmemc_counter_h c, void *dest, const void *src,
+                            size_t nbytes, int pe);
+void shmemc_counter_get_nbi(shmemc_counter_h c, void *dest, const void *src,
+                            size_t nbytes, int pe);
+void shmemc_counter_add(shmemc_counter_h c, void *t, void *vp, size_t vs,
+                        int pe);
+void shmemc_counter_fadd_nbi(shmemc_counter_h c, void *t, void *vp, size_t vs,
+                             int pe, void *retp);
+
 void shmemc_ctx_put_signal(shmem_ctx_t ctx, void *dest, const void *src,
                            size_t nbytes, uint64_t *sig_addr, uint64_t signal,
                            int sig_op, int pe);
@@ -165,6 +250,18 @@ void shmemc_ctx_fadd(shmem_ctx_t ctx, void *target, void *value, size_t vals,
 void shmemc_ctx_fadd_nbi(shmem_ctx_t ctx, void *target, void *value,
                          size_t vals, int pe, void *retp);
 
+/*
+ * batched: element i adds values[i] to targets[i] on pes[i].  The
+ * fetching one waits for every old value (to fetches[i]), the other
+ * completes at quiet.
+ */
+void shmemc_ctx_add_v(shmem_ctx_t ctx, void *const *targets,
+                      const void *values, size_t vals, const int *pes,
+                      size_t n);
+void shmemc_ctx_fadd_v(shmem_ctx_t ctx, void *const *targets,
+                       const void *values, size_t vals, const int *pes,
+                       size_t n, void *fetches);
+
 /*
  * bitwise
  */
@@ -191,12 +288,47 @@ SHMEMC_CTX_DECL_FETCH_BITWISE(xor)
 
 #define SHMEMC_CTX_DECL_FETCH_BITWISE_NBI(_op)                                 \
   void shmemc_ctx_fetch_##_op##_nbi(shmem_ctx_t ctx, void *target,             \
-                                    void *value, size_t vals, int pe);
+                                    void *value, size_t vals, int pe,          \
+                                    void *retp);
 
 SHMEMC_CTX_DECL_FETCH_BITWISE_NBI(and)
 SHMEMC_CTX_DECL_FETCH_BITWISE_NBI(or)
 SHMEMC_CTX_DECL_FETCH_BITWISE_NBI(xor)
 
+/*
+ * AMOs the transport can't do natively: run at the target by active
+ * message, or emulated with compare-and-swap
+ */
+
+typedef enum shmemc_amo_ext_op {
+  SHMEMC_AMO_EXT_AND = 0,
+  SHMEMC_AMO_EXT_OR,
+  SHMEMC_AMO_EXT_XOR,
+  SHMEMC_AMO_EXT_MIN,
+  SHMEMC_AMO_EXT_MAX,
+  SHMEMC_AMO_EXT_ADD,
+  SHMEMC_AMO_EXT_CSWAP /* 128-bit only */
+} shmemc_amo_ext_op_t;
+
+/*
+ * how to interpret the operands
+ */
+typedef enum shmemc_amo_ext_type {
+  SHMEMC_AMO_EXT_INT = 0,
+  SHMEMC_AMO_EXT_UINT,
+  SHMEMC_AMO_EXT_FLOAT
+} shmemc_amo_ext_type_t;
+
+/*
+ * value at vp (and comparand at cp for CSWAP).  With retp, waits for
+ * the old value; without, the operation completes by the next
+ * quiet/fence.
+ */
+void shmemc_ctx_amo_ext(shmem_ctx_t ctx, shmemc_amo_ext_op_t op,
+                        shmemc_amo_ext_type_t type, void *target,
+                        const void *vp, const void *cp, size_t vals, int pe,
+                        void *retp);
+
 /*
  * set/fetch
  */
@@ -614,6 +746,13 @@ SHMEMC_CTX_WAIT_UNTIL_ANY_VECTOR(16, ge)
 SHMEMC_CTX_WAIT_UNTIL_ANY_VECTOR(32, ge)
 SHMEMC_CTX_WAIT_UNTIL_ANY_VECTOR(64, ge)
 
+/*
+ * what waits do once they've spun for a while, and what they did
+ */
+void shmemc_ctx_set_wait_policy(shmem_ctx_t ctx, shmemc_wait_policy_t policy);
+void shmemc_ctx_get_wait_stats(shmem_ctx_t ctx, shmemc_wait_stats_t *sp);
+void shmemc_ctx_reset_wait_stats(shmem_ctx_t ctx);
+
 /*
  * -- Context management -----------------------------------------------------
  *
@@ -713,6 +852,11 @@ inline static int shmemc_n_pes() { return shmemc_team_n_pes(SHMEM_TEAM_WORLD); }
 #define shmemc_put_nbi(...) shmemc_ctx_put_nbi(SHMEM_CTX_DEFAULT, __VA_ARGS__)
 #define shmemc_get_nbi(...) shmemc_ctx_get_nbi(SHMEM_CTX_DEFAULT, __VA_ARGS__)
 
+#define shmemc_iput(...) shmemc_ctx_iput(SHMEM_CTX_DEFAULT, __VA_ARGS__)
+#define shmemc_iget(...) shmemc_ctx_iget(SHMEM_CTX_DEFAULT, __VA_ARGS__)
+#define shmemc_iput_nbi(...) shmemc_ctx_iput_nbi(SHMEM_CTX_DEFAULT, __VA_ARGS__)
+#define shmemc_iget_nbi(...) shmemc_ctx_iget_nbi(SHMEM_CTX_DEFAULT, __VA_ARGS__)
+
 #define shmemc_set(...) shmemc_ctx_set(SHMEM_CTX_DEFAULT, __VA_ARGS__)
 #define shmemc_fetch(...) shmemc_ctx_fetch(SHMEM_CTX_DEFAULT, __VA_ARGS__)
 #define shmemc_fetch_nbi(...)                                                  \
@@ -115,11 +115,34 @@ typedef struct env_info {
   shmemc_coll_t coll; /**< collectives */
 
   char *progress_threads;   /**< do we need to start our own? */
-  size_t progress_delay_ns; /**< if progress needed, time (ns)
-                               between polls */
+  size_t progress_delay_ns; /**< if progress needed, longest time
+                               (ns) between idle polls */
+  char *progress_cpu;       /**< CPUs to pin progress threads to */
+  bool progress_events;     /**< progress threads sleep on events? */
 
   size_t prealloc_contexts; /**< set up this many at start */
+  size_t cohort_passes;     /**< on-node hand-offs of cohort locks */
   bool memfatal;            /**< force exit on memory usage error? */
+
+  bool mapped_rma;     /**< load/store RMA to mapped node-local PEs? */
+  size_t nt_threshold; /**< use non-temporal stores from this size
+                          (0 = never) */
+
+  bool loopback;     /**< RMA to self with local copies? */
+  bool loopback_amo; /**< AMOs to self with CPU atomics? */
+  bool amo_ext_am;   /**< emulated AMOs run at target by active message? */
+  bool amo_rma;      /**< atomic set/fetch as 32/64-bit put/get? */
+
+  bool aggregate;         /**< aggregate small ops on default context? */
+  size_t aggr_bufsize;    /**< per-PE aggregation buffer size (b) */
+  size_t aggr_max_msg;    /**< only aggregate ops up to this size (b) */
+  size_t aggr_timeout_ns; /**< send buffered ops after this long (ns) */
+
+  size_t stripe_lanes;     /**< split big transfers over this many lanes */
+  size_t stripe_threshold; /**< stripe transfers from this size (b) */
+
+  shmemc_wait_policy_t wait_policy; /**< what waits do after spinning */
+  size_t wait_spin_ns;              /**< spin this long in waits first (ns) */
 } env_info_t;
 
 /**
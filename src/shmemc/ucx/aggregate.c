@@ -0,0 +1,689 @@
+/* For license: see LICENSE file at top-level */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif /* HAVE_CONFIG_H */
+
+#include "state.h"
+#include "shmemu.h"
+#include "shmemc.h"
+#include "api.h"
+#include "aggregate.h"
+#include "threading.h"
+#include "module.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include <ucp/api/ucp.h>
+
+#ifdef SHMEMC_UCX_AGGREGATION
+
+/*
+ * Wire format: a batch is a run of records, each followed by its
+ * payload padded out to 8 bytes.  Addresses are already translated
+ * for the target.
+ */
+
+typedef enum aggr_kind { AGGR_PUT = 0, AGGR_AMO } aggr_kind_t;
+
+typedef struct aggr_rec {
+  uint64_t addr; /* target address on receiving PE */
+  uint32_t len;  /* payload size (b) */
+  uint16_t kind; /* aggr_kind_t */
+  uint16_t op;   /* ucp_atomic_post_op_t, if AMO */
+} aggr_rec_t;
+
+#define AGGR_PAD(_n) (((_n) + 7) & ~((size_t)7))
+
+/*
+ * AM header: who to acknowledge once the batch has been applied
+ */
+typedef struct aggr_hdr {
+  uint64_t token; /* sender's context, echoed back in the ack */
+  int32_t pe;     /* sender */
+  uint32_t pad;
+} aggr_hdr_t;
+
+/*
+ * header and data have to stay put until UCX has sent them
+ */
+typedef struct aggr_batch {
+  aggr_hdr_t hdr;
+  size_t used; /* bytes of data filled */
+  char data[];
+} aggr_batch_t;
+
+/*
+ * how many buffered ops between looks at the clock
+ */
+#define AGGR_TICKS 32
+
+struct shmemc_aggr {
+  aggr_batch_t **bufs; /* per destination PE, NULL until used */
+  char *isdirty;       /* per PE: in dirty list? */
+  int *dirty;          /* PEs that have had something buffered */
+  size_t ndirty;       /* how many (peeked at without the lock) */
+  double oldest;       /* when first thing buffered since last flush */
+  unsigned ticks;      /* ops since last timer check */
+
+  unsigned long sent;  /* batches sent (read without the lock) */
+  unsigned long acked; /* batches applied by their targets */
+
+  bool locked;             /* context can be used by >1 thread */
+  threadwrap_mutex_t lock; /* if so */
+};
+
+inline static void aggr_lock(struct shmemc_aggr *ap) {
+  if (ap->locked) {
+    threadwrap_mutex_lock(&ap->lock);
+  }
+}
+
+inline static void aggr_unlock(struct shmemc_aggr *ap) {
+  if (ap->locked) {
+    threadwrap_mutex_unlock(&ap->lock);
+  }
+}
+
+/*
+ * -- sending side -------------------------------------------------------
+ */
+
+static void batch_sent_callbackx(void *req, ucs_status_t status,
+                                 void *user_data) {
+  NO_WARN_UNUSED(status);
+
+  free(user_data);
+  ucp_request_free(req);
+}
+
+/*
+ * ship PE's buffer, which is then no longer ours
+ */
+static void send_batch(shmemc_context_h ch, int pe) {
+  struct shmemc_aggr *ap = ch->aggr;
+  aggr_batch_t *bp = ap->bufs[pe];
+  const ucp_request_param_t prm = {.op_attr_mask = UCP_OP_ATTR_FIELD_CALLBACK |
+                                                   UCP_OP_ATTR_FIELD_USER_DATA,
+                                   .cb.send = batch_sent_callbackx,
+                                   .user_data = bp};
+  ucs_status_ptr_t sp;
+
+  ap->bufs[pe] = NULL;
+
+  bp->hdr.token = (uint64_t)(uintptr_t)ch;
+  bp->hdr.pe = proc.li.rank;
+
+  __atomic_add_fetch(&ap->sent, 1, __ATOMIC_RELAXED);
+
+  sp = ucp_am_send_nbx(ch->eps[pe], SHMEMC_UCX_AM_AGGR_BATCH, &bp->hdr,
+                       sizeof(bp->hdr), bp->data, bp->used, &prm);
+  if (sp == NULL) {
+    free(bp);
+  } else if (UCS_PTR_IS_ERR(sp)) {
+    shmemu_fatal(MODULE ": can't send aggregated batch to PE %d (status: %s)",
+                 pe, ucs_status_string(UCS_PTR_STATUS(sp)));
+    /* NOT REACHED */
+  }
+}
+
+static void flush_locked(shmemc_context_h ch) {
+  struct shmemc_aggr *ap = ch->aggr;
+  size_t i;
+
+  for (i = 0; i < ap->ndirty; ++i) {
+    const int pe = ap->dirty[i];
+
+    if ((ap->bufs[pe] != NULL) && (ap->bufs[pe]->used > 0)) {
+      send_batch(ch, pe);
+    }
+    ap->isdirty[pe] = 0;
+  }
+  __atomic_store_n(&ap->ndirty, 0, __ATOMIC_RELAXED);
+  ap->ticks = 0;
+}
+
+inline static int timed_out(const struct shmemc_aggr *ap) {
+  const double limit = (double)proc.env.aggr_timeout_ns * 1.0e-9;
+
+  return (ap->ndirty > 0) && ((shmemu_timer() - ap->oldest) >= limit);
+}
+
+/*
+ * add a record for PE, flushing its buffer first if no room
+ */
+static void append(shmemc_context_h ch, int pe, uint64_t r_addr,
+                   aggr_kind_t kind, unsigned op, const void *p, size_t len) {
+  struct shmemc_aggr *ap = ch->aggr;
+  const size_t need = sizeof(aggr_rec_t) + AGGR_PAD(len);
+  aggr_batch_t *bp;
+  aggr_rec_t rec;
+
+  aggr_lock(ap);
+
+  bp = ap->bufs[pe];
+  if ((bp != NULL) && (bp->used + need > proc.env.aggr_bufsize)) {
+    send_batch(ch, pe);
+    bp = NULL;
+  }
+
+  if (bp == NULL) {
+    bp = (aggr_batch_t *)malloc(sizeof(*bp) + proc.env.aggr_bufsize);
+    shmemu_assert(bp != NULL,
+                  MODULE ": can't allocate aggregation buffer for PE %d", pe);
+    bp->used = 0;
+    ap->bufs[pe] = bp;
+  }
+
+  if (!ap->isdirty[pe]) {
+    if (ap->ndirty == 0) {
+      ap->oldest = shmemu_timer();
+    }
+    ap->isdirty[pe] = 1;
+    ap->dirty[ap->ndirty] = pe;
+    __atomic_store_n(&ap->ndirty, ap->ndirty + 1, __ATOMIC_RELAXED);
+  }
+
+  rec.addr = r_addr;
+  rec.len = (uint32_t)len;
+  rec.kind = (uint16_t)kind;
+  rec.op = (uint16_t)op;
+
+  memcpy(bp->data + bp->used, &rec, sizeof(rec));
+  memcpy(bp->data + bp->used + sizeof(rec), p, len);
+  bp->used += need;
+
+  if (++ap->ticks >= AGGR_TICKS) {
+    ap->ticks = 0;
+    if (timed_out(ap)) {
+      flush_locked(ch);
+    }
+  }
+
+  aggr_unlock(ap);
+}
+
+/*
+ * Only small things to other PEs
+ */
+inline static int aggregatable(size_t len, int pe) {
+  return (len <= proc.env.aggr_max_msg) && (pe != proc.li.rank);
+}
+
+int shmemc_ucx_aggr_put(shmemc_context_h ch, uint64_t r_dest, const void *src,
+                        size_t nbytes, int pe) {
+  if (!aggregatable(nbytes, pe)) {
+    return 0;
+    /* NOT REACHED */
+  }
+
+  append(ch, pe, r_dest, AGGR_PUT, 0, src, nbytes);
+
+  return 1;
+}
+
+int shmemc_ucx_aggr_amo(shmemc_context_h ch, ucp_atomic_post_op_t uapo,
+                        uint64_t r_t, uint64_t val, size_t vs, int pe) {
+  if (!aggregatable(vs, pe)) {
+    return 0;
+    /* NOT REACHED */
+  }
+
+  /* value is in the low-order bytes */
+  append(ch, pe, r_t, AGGR_AMO, (unsigned)uapo, &val, vs);
+
+  return 1;
+}
+
+void shmemc_ucx_aggr_flush(shmemc_context_h ch) {
+  struct shmemc_aggr *ap = ch->aggr;
+
+  if (ap == NULL) {
+    return;
+    /* NOT REACHED */
+  }
+
+  aggr_lock(ap);
+  flush_locked(ch);
+  aggr_unlock(ap);
+}
+
+/*
+ * Acks come back to the default worker, so progress that as well
+ */
+void shmemc_ucx_aggr_drain(shmemc_context_h ch) {
+  struct shmemc_aggr *ap = ch->aggr;
+
+  if (ap == NULL) {
+    return;
+    /* NOT REACHED */
+  }
+
+  shmemc_ucx_aggr_flush(ch);
+
+  while (__atomic_load_n(&ap->acked, __ATOMIC_ACQUIRE) !=
+         __atomic_load_n(&ap->sent, __ATOMIC_RELAXED)) {
+    (void)ucp_worker_progress(ch->w);
+    if (ch != defcp) {
+      (void)ucp_worker_progress(defcp->w);
+    }
+  }
+}
+
+int shmemc_ucx_aggr_test(shmemc_context_h ch) {
+  struct shmemc_aggr *ap = ch->aggr;
+
+  if (ap == NULL) {
+    return 1;
+    /* NOT REACHED */
+  }
+
+  shmemc_ucx_aggr_flush(ch);
+
+  if (__atomic_load_n(&ap->acked, __ATOMIC_ACQUIRE) ==
+      __atomic_load_n(&ap->sent, __ATOMIC_RELAXED)) {
+    return 1;
+    /* NOT REACHED */
+  }
+
+  (void)ucp_worker_progress(ch->w);
+  if (ch != defcp) {
+    (void)ucp_worker_progress(defcp->w);
+  }
+
+  return __atomic_load_n(&ap->acked, __ATOMIC_ACQUIRE) ==
+         __atomic_load_n(&ap->sent, __ATOMIC_RELAXED);
+}
+
+void shmemc_ucx_aggr_progress(shmemc_context_h ch) {
+  struct shmemc_aggr *ap = ch->aggr;
+
+  /* a quick look: the lock is only worth taking with something buffered */
+  if ((ap == NULL) || (__atomic_load_n(&ap->ndirty, __ATOMIC_RELAXED) == 0)) {
+    return;
+    /* NOT REACHED */
+  }
+
+  aggr_lock(ap);
+  if (timed_out(ap)) {
+    flush_locked(ch);
+  }
+  aggr_unlock(ap);
+}
+
+/*
+ * -- receiving side -----------------------------------------------------
+ */
+
+typedef struct aggr_ack {
+  uint64_t token;
+  int pe;
+} aggr_ack_t;
+
+static void ack_sent_callbackx(void *req, ucs_status_t status,
+                               void *user_data) {
+  NO_WARN_UNUSED(status);
+
+  free(user_data);
+  ucp_request_free(req);
+}
+
+static void post_ack(aggr_ack_t *kp) {
+  const ucp_request_param_t prm = {.op_attr_mask = UCP_OP_ATTR_FIELD_CALLBACK |
+                                                   UCP_OP_ATTR_FIELD_USER_DATA,
+                                   .cb.send = ack_sent_callbackx,
+                                   .user_data = kp};
+  ucs_status_ptr_t sp;
+
+  sp = ucp_am_send_nbx(defcp->eps[kp->pe], SHMEMC_UCX_AM_AGGR_ACK, NULL, 0,
+                       &kp->token, sizeof(kp->token), &prm);
+  if (sp == NULL) {
+    free(kp);
+  } else if (UCS_PTR_IS_ERR(sp)) {
+    shmemu_fatal(MODULE ": can't acknowledge aggregated batch from PE %d "
+                        "(status: %s)",
+                 kp->pe, ucs_status_string(UCS_PTR_STATUS(sp)));
+    /* NOT REACHED */
+  }
+}
+
+static void amos_done_callbackx(void *req, ucs_status_t status,
+                                void *user_data) {
+  NO_WARN_UNUSED(status);
+
+  post_ack((aggr_ack_t *)user_data);
+  ucp_request_free(req);
+}
+
+/*
+ * Puts land straight away.  AMOs go through UCX to ourselves, so they
+ * stay atomic with respect to everyone else's, and the ack has to
+ * wait for those to complete.
+ */
+static void apply_batch(const aggr_hdr_t *hp, const char *data, size_t len) {
+  const char *p = data;
+  const char *end = data + len;
+  int had_amos = 0;
+  aggr_ack_t *kp;
+
+  while (p < end) {
+    aggr_rec_t rec;
+
+    memcpy(&rec, p, sizeof(rec));
+    p += sizeof(rec);
+
+    if (rec.kind == AGGR_PUT) {
+      memcpy((void *)(uintptr_t)rec.addr, p, rec.len);
+    } else {
+      uint64_t val = 0;
+      ucs_status_t s;
+
+      memcpy(&val, p, rec.len);
+      s = shmemc_ucx_post_amo(defcp, (ucp_atomic_post_op_t)rec.op,
+                              (void *)(uintptr_t)rec.addr, val, rec.len,
+                              proc.li.rank);
+      shmemu_assert(s == UCS_OK,
+                    MODULE ": can't apply aggregated AMO (status: %s)",
+                    ucs_status_string(s));
+      had_amos = 1;
+    }
+
+    p += AGGR_PAD(rec.len);
+  }
+
+  kp = (aggr_ack_t *)malloc(sizeof(*kp));
+  shmemu_assert(kp != NULL, MODULE ": can't allocate aggregation ack");
+  kp->token = hp->token;
+  kp->pe = hp->pe;
+
+  if (had_amos) {
+    const ucp_request_param_t prm = {.op_attr_mask =
+                                         UCP_OP_ATTR_FIELD_CALLBACK |
+                                         UCP_OP_ATTR_FIELD_USER_DATA,
+                                     .cb.send = amos_done_callbackx,
+                                     .user_data = kp};
+    const ucs_status_ptr_t sp =
+        ucp_ep_flush_nbx(defcp->eps[proc.li.rank], &prm);
+
+    if (sp == NULL) {
+      post_ack(kp);
+    } else if (UCS_PTR_IS_ERR(sp)) {
+      shmemu_fatal(MODULE ": can't complete aggregated AMOs (status: %s)",
+                   ucs_status_string(UCS_PTR_STATUS(sp)));
+      /* NOT REACHED */
+    }
+  } else {
+    post_ack(kp);
+  }
+}
+
+static void batch_fetched_callback(void *req, ucs_status_t status,
+                                   size_t length, void *user_data) {
+  aggr_batch_t *bp = (aggr_batch_t *)user_data;
+
+  shmemu_assert(status == UCS_OK,
+                MODULE ": can't fetch aggregated batch (status: %s)",
+                ucs_status_string(status));
+
+  apply_batch(&bp->hdr, bp->data, length);
+  free(bp);
+  ucp_request_free(req);
+}
+
+static ucs_status_t batch_handler(void *arg, const void *header,
+                                  size_t header_length, void *data,
+                                  size_t length,
+                                  const ucp_am_recv_param_t *param) {
+  const aggr_hdr_t *hp = (const aggr_hdr_t *)header;
+
+  NO_WARN_UNUSED(arg);
+  NO_WARN_UNUSED(header_length);
+
+  /* large batch: have to go and get it first */
+  if (param->recv_attr & UCP_AM_RECV_ATTR_FLAG_RNDV) {
+    aggr_batch_t *bp = (aggr_batch_t *)malloc(sizeof(*bp) + length);
+    ucp_request_param_t prm;
+    ucs_status_ptr_t sp;
+
+    shmemu_assert(bp != NULL, MODULE ": can't allocate aggregation buffer");
+
+    bp->hdr = *hp;
+    bp->used = length;
+
+    prm.op_attr_mask = UCP_OP_ATTR_FIELD_CALLBACK | UCP_OP_ATTR_FIELD_USER_DATA;
+    prm.cb.recv_am = batch_fetched_callback;
+    prm.user_data = bp;
+
+    sp = ucp_am_recv_data_nbx(defcp->w, data, bp->data, length, &prm);
+    if (sp == NULL) {
+      apply_batch(&bp->hdr, bp->data, length);
+      free(bp);
+    } else if (UCS_PTR_IS_ERR(sp)) {
+      shmemu_fatal(MODULE ": can't fetch aggregated batch (status: %s)",
+                   ucs_status_string(UCS_PTR_STATUS(sp)));
+      /* NOT REACHED */
+    }
+
+    return UCS_OK;
+    /* NOT REACHED */
+  }
+
+  apply_batch(hp, (const char *)data, length);
+
+  return UCS_OK;
+}
+
+static ucs_status_t ack_handler(void *arg, const void *header,
+                                size_t header_length, void *data, size_t length,
+                                const ucp_am_recv_param_t *param) {
+  uint64_t token;
+  shmemc_context_h ch;
+
+  NO_WARN_UNUSED(arg);
+  NO_WARN_UNUSED(header);
+  NO_WARN_UNUSED(header_length);
+  NO_WARN_UNUSED(length);
+  NO_WARN_UNUSED(param);
+
+  memcpy(&token, data, sizeof(token));
+  ch = (shmemc_context_h)(uintptr_t)token;
+
+  __atomic_add_fetch(&ch->aggr->acked, 1, __ATOMIC_RELEASE);
+
+  return UCS_OK;
+}
+
+/*
+ * -- registry -----------------------------------------------------------
+ *
+ * Aggregating contexts, so barriers can find them
+ */
+
+static shmemc_context_h *actxts = NULL;
+static size_t nactxts = 0;
+static threadwrap_mutex_t actxts_lock;
+
+static void registry_add(shmemc_context_h ch) {
+  shmemc_context_h *chp;
+
+  threadwrap_mutex_lock(&actxts_lock);
+
+  chp = (shmemc_context_h *)realloc(actxts, (nactxts + 1) * sizeof(*actxts));
+  shmemu_assert(chp != NULL, MODULE ": can't register aggregating context");
+  actxts = chp;
+  actxts[nactxts++] = ch;
+
+  threadwrap_mutex_unlock(&actxts_lock);
+}
+
+static void registry_remove(shmemc_context_h ch) {
+  size_t i;
+
+  threadwrap_mutex_lock(&actxts_lock);
+
+  for (i = 0; i < nactxts; ++i) {
+    if (actxts[i] == ch) {
+      actxts[i] = actxts[--nactxts];
+      break;
+    }
+  }
+  if (nactxts == 0) {
+    free(actxts);
+    actxts = NULL;
+  }
+
+  threadwrap_mutex_unlock(&actxts_lock);
+}
+
+void shmemc_aggr_flush_all(void) {
+  size_t i;
+
+  /* contexts come and go on other threads, so even count under lock */
+  threadwrap_mutex_lock(&actxts_lock);
+  for (i = 0; i < nactxts; ++i) {
+    shmemc_ucx_aggr_flush(actxts[i]);
+  }
+  threadwrap_mutex_unlock(&actxts_lock);
+}
+
+/*
+ * -- setup --------------------------------------------------------------
+ */
+
+inline static void register_one(unsigned id, ucp_am_recv_callback_t cb) {
+  ucp_am_handler_param_t hp;
+  ucs_status_t s;
+
+  hp.field_mask = UCP_AM_HANDLER_PARAM_FIELD_ID |
+                  UCP_AM_HANDLER_PARAM_FIELD_CB |
+                  UCP_AM_HANDLER_PARAM_FIELD_ARG;
+  hp.id = id;
+  hp.cb = cb;
+  hp.arg = NULL;
+
+  s = ucp_worker_set_am_recv_handler(defcp->w, &hp);
+  shmemu_assert(s == UCS_OK,
+                MODULE ": can't register active message handler %u "
+                       "(status: %s)",
+                id, ucs_status_string(s));
+}
+
+void shmemc_ucx_aggr_register_handlers(void) {
+  threadwrap_mutex_init(&actxts_lock);
+
+  register_one(SHMEMC_UCX_AM_AGGR_BATCH, batch_handler);
+  register_one(SHMEMC_UCX_AM_AGGR_ACK, ack_handler);
+}
+
+void shmemc_ucx_aggr_create(shmemc_context_h ch) {
+  struct shmemc_aggr *ap;
+
+  ch->aggr = NULL;
+
+  if (!ch->attr.aggregate) {
+    return;
+    /* NOT REACHED */
+  }
+
+  ap = (struct shmemc_aggr *)calloc(1, sizeof(*ap));
+  shmemu_assert(ap != NULL, MODULE ": can't allocate aggregation state");
+
+  ap->bufs = (aggr_batch_t **)calloc(proc.li.nranks, sizeof(*(ap->bufs)));
+  ap->isdirty = (char *)calloc(proc.li.nranks, sizeof(*(ap->isdirty)));
+  ap->dirty = (int *)calloc(proc.li.nranks, sizeof(*(ap->dirty)));
+  shmemu_assert((ap->bufs != NULL) && (ap->isdirty != NULL) &&
+                    (ap->dirty != NULL),
+                MODULE ": can't allocate aggregation buffers");
+
+  /* a progress thread flushes shared contexts whatever the thread level */
+  ap->locked = ((proc.td.osh_tl == SHMEM_THREAD_MULTIPLE) ||
+                (proc.env.progress_threads != NULL)) &&
+               (!ch->attr.serialized) && (!ch->attr.privat);
+  if (ap->locked) {
+    threadwrap_mutex_init(&ap->lock);
+  }
+
+  ch->aggr = ap;
+
+  registry_add(ch);
+}
+
+void shmemc_ucx_aggr_destroy(shmemc_context_h ch) {
+  struct shmemc_aggr *ap = ch->aggr;
+  int pe;
+
+  if (ap == NULL) {
+    return;
+    /* NOT REACHED */
+  }
+
+  registry_remove(ch);
+
+  for (pe = 0; pe < proc.li.nranks; ++pe) {
+    free(ap->bufs[pe]);
+  }
+  free(ap->dirty);
+  free(ap->isdirty);
+  free(ap->bufs);
+
+  if (ap->locked) {
+    threadwrap_mutex_destroy(&ap->lock);
+  }
+
+  free(ap);
+
+  ch->aggr = NULL;
+}
+
+#else /* ! SHMEMC_UCX_AGGREGATION */
+
+/*
+ * Nothing ever gets buffered
+ */
+
+void shmemc_ucx_aggr_register_handlers(void) {}
+
+void shmemc_ucx_aggr_create(shmemc_context_h ch) { ch->aggr = NULL; }
+
+void shmemc_ucx_aggr_destroy(shmemc_context_h ch) { NO_WARN_UNUSED(ch); }
+
+int shmemc_ucx_aggr_put(shmemc_context_h ch, uint64_t r_dest, const void *src,
+                        size_t nbytes, int pe) {
+  NO_WARN_UNUSED(ch);
+  NO_WARN_UNUSED(r_dest);
+  NO_WARN_UNUSED(src);
+  NO_WARN_UNUSED(nbytes);
+  NO_WARN_UNUSED(pe);
+
+  return 0;
+}
+
+int shmemc_ucx_aggr_amo(shmemc_context_h ch, ucp_atomic_post_op_t uapo,
+                        uint64_t r_t, uint64_t val, size_t vs, int pe) {
+  NO_WARN_UNUSED(ch);
+  NO_WARN_UNUSED(uapo);
+  NO_WARN_UNUSED(r_t);
+  NO_WARN_UNUSED(val);
+  NO_WARN_UNUSED(vs);
+  NO_WARN_UNUSED(pe);
+
+  return 0;
+}
+
+void shmemc_ucx_aggr_flush(shmemc_context_h ch) { NO_WARN_UNUSED(ch); }
+
+void shmemc_ucx_aggr_drain(shmemc_context_h ch) { NO_WARN_UNUSED(ch); }
+
+int shmemc_ucx_aggr_test(shmemc_context_h ch) {
+  NO_WARN_UNUSED(ch);
+
+  return 1;
+}
+
+void shmemc_ucx_aggr_progress(shmemc_context_h ch) { NO_WARN_UNUSED(ch); }
+
+void shmemc_aggr_flush_all(void) {}
+
+#endif /* SHMEMC_UCX_AGGREGATION */
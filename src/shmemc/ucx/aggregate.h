@@ -0,0 +1,51 @@
+/* For license: see LICENSE file at top-level */
+
+#ifndef _SHMEMC_UCX_AGGREGATE_H
+#define _SHMEMC_UCX_AGGREGATE_H 1
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif /* HAVE_CONFIG_H */
+
+#include "pe.h"
+
+#include <ucp/api/ucp.h>
+
+/*
+ * Small-message aggregation: on contexts that ask for it, small puts
+ * and non-fetching AMOs are packed into a buffer per destination PE
+ * and shipped as one active message, which the target unpacks.
+ *
+ * Needs UCX active messages, otherwise contexts just don't aggregate.
+ */
+
+#if defined(HAVE_UCP_AM_SEND_NBX) && defined(HAVE_UCP_EP_FLUSH_NBX)
+#define SHMEMC_UCX_AGGREGATION 1
+#endif /* HAVE_UCP_AM_SEND_NBX && HAVE_UCP_EP_FLUSH_NBX */
+
+void shmemc_ucx_aggr_register_handlers(void);
+
+void shmemc_ucx_aggr_create(shmemc_context_h ch);
+void shmemc_ucx_aggr_destroy(shmemc_context_h ch);
+
+/*
+ * Non-zero if the operation was buffered, 0 if the caller has to do
+ * it itself
+ */
+int shmemc_ucx_aggr_put(shmemc_context_h ch, uint64_t r_dest, const void *src,
+                        size_t nbytes, int pe);
+int shmemc_ucx_aggr_amo(shmemc_context_h ch, ucp_atomic_post_op_t uapo,
+                        uint64_t r_t, uint64_t val, size_t vs, int pe);
+
+/*
+ * flush: send everything buffered
+ * drain: flush, then wait until targets have applied it all
+ * test: flush, non-zero if targets have applied it all
+ * progress: flush if anything has been buffered too long
+ */
+void shmemc_ucx_aggr_flush(shmemc_context_h ch);
+void shmemc_ucx_aggr_drain(shmemc_context_h ch);
+int shmemc_ucx_aggr_test(shmemc_context_h ch);
+void shmemc_ucx_aggr_progress(shmemc_context_h ch);
+
+#endif /* ! _SHMEMC_UCX_AGGREGATE_H */
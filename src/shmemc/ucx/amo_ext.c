@@ -0,0 +1,491 @@
+/* For license: see LICENSE file at top-level */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif /* HAVE_CONFIG_H */
+
+#include "state.h"
+#include "shmemu.h"
+#include "shmemc.h"
+#include "api.h"
+#include "amo_ext.h"
+#include "module.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include <ucp/api/ucp.h>
+
+/*
+ * -- applying operations locally ----------------------------------------
+ */
+
+#define AMO_EXT_COMBINE(_bits, _ftype)                                         \
+  inline static uint##_bits##_t combine##_bits(shmemc_amo_ext_op_t op,         \
+                                               shmemc_amo_ext_type_t type,     \
+                                               uint##_bits##_t old,            \
+                                               uint##_bits##_t v) {            \
+    switch (op) {                                                              \
+    case SHMEMC_AMO_EXT_AND:                                                   \
+      return old & v;                                                          \
+    case SHMEMC_AMO_EXT_OR:                                                    \
+      return old | v;                                                          \
+    case SHMEMC_AMO_EXT_XOR:                                                   \
+      return old ^ v;                                                          \
+    default:                                                                   \
+      break;                                                                   \
+    }                                                                          \
+                                                                               \
+    if (type == SHMEMC_AMO_EXT_FLOAT) {                                        \
+      _ftype a, b;                                                             \
+                                                                               \
+      memcpy(&a, &old, sizeof(a));                                             \
+      memcpy(&b, &v, sizeof(b));                                               \
+      if (op == SHMEMC_AMO_EXT_ADD) {                                          \
+        a += b;                                                                \
+      } else if ((op == SHMEMC_AMO_EXT_MIN) ? (b < a) : (b > a)) {             \
+        a = b;                                                                 \
+      }                                                                        \
+      memcpy(&old, &a, sizeof(a));                                             \
+      return old;                                                              \
+      /* NOT REACHED */                                                        \
+    }                                                                          \
+                                                                               \
+    if (op == SHMEMC_AMO_EXT_ADD) {                                            \
+      return old + v;                                                          \
+      /* NOT REACHED */                                                        \
+    }                                                                          \
+                                                                               \
+    if (type == SHMEMC_AMO_EXT_INT) {                                          \
+      const int##_bits##_t a = (int##_bits##_t)old;                            \
+      const int##_bits##_t b = (int##_bits##_t)v;                              \
+                                                                               \
+      return ((op == SHMEMC_AMO_EXT_MIN) ? (b < a) : (b > a)) ? v : old;       \
+      /* NOT REACHED */                                                        \
+    }                                                                          \
+                                                                               \
+    return ((op == SHMEMC_AMO_EXT_MIN) ? (v < old) : (v > old)) ? v : old;     \
+  }
+
+AMO_EXT_COMBINE(32, float)
+AMO_EXT_COMBINE(64, double)
+
+uint64_t shmemc_ucx_amo_ext_combine(shmemc_amo_ext_op_t op,
+                                    shmemc_amo_ext_type_t type, uint64_t old,
+                                    uint64_t v, size_t vs) {
+  if (vs == sizeof(uint32_t)) {
+    return combine32(op, type, (uint32_t)old, (uint32_t)v);
+    /* NOT REACHED */
+  }
+
+  return combine64(op, type, old, v);
+}
+
+/*
+ * bitwise ops have instructions of their own, the rest loop on
+ * compare-and-swap
+ */
+#define AMO_EXT_APPLY(_bits)                                                   \
+  inline static uint##_bits##_t apply##_bits(shmemc_amo_ext_op_t op,           \
+                                             shmemc_amo_ext_type_t type,       \
+                                             uint##_bits##_t *t,               \
+                                             uint##_bits##_t v) {              \
+    uint##_bits##_t old;                                                       \
+                                                                               \
+    switch (op) {                                                              \
+    case SHMEMC_AMO_EXT_AND:                                                   \
+      return __atomic_fetch_and(t, v, __ATOMIC_SEQ_CST);                       \
+    case SHMEMC_AMO_EXT_OR:                                                    \
+      return __atomic_fetch_or(t, v, __ATOMIC_SEQ_CST);                        \
+    case SHMEMC_AMO_EXT_XOR:                                                   \
+      return __atomic_fetch_xor(t, v, __ATOMIC_SEQ_CST);                       \
+    default:                                                                   \
+      break;                                                                   \
+    }                                                                          \
+                                                                               \
+    old = __atomic_load_n(t, __ATOMIC_RELAXED);                                \
+    while (!__atomic_compare_exchange_n(t, &old,                               \
+                                        combine##_bits(op, type, old, v),      \
+                                        true, __ATOMIC_SEQ_CST,                \
+                                        __ATOMIC_RELAXED)) {                   \
+      continue;                                                                \
+    }                                                                          \
+                                                                               \
+    return old;                                                                \
+  }
+
+AMO_EXT_APPLY(32)
+AMO_EXT_APPLY(64)
+
+/*
+ * 16-byte compare-and-swap: a lock-free instruction if the compiler
+ * has one, otherwise serialized on a lock.  Either way it's atomic
+ * with respect to every other 128-bit AMO on this PE.
+ */
+
+#ifdef HAVE_ATOMIC_CAS128
+
+static void cswap128(void *t, const void *cp, const void *vp, void *retp) {
+  unsigned __int128 cond, val;
+
+  memcpy(&cond, cp, sizeof(cond));
+  memcpy(&val, vp, sizeof(val));
+
+  (void)__atomic_compare_exchange_n((unsigned __int128 *)t, &cond, val, false,
+                                    __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+
+  memcpy(retp, &cond, sizeof(cond));
+}
+
+#else /* ! HAVE_ATOMIC_CAS128 */
+
+static char cas128_lock = 0;
+
+static void cswap128(void *t, const void *cp, const void *vp, void *retp) {
+  char old[16];
+
+  while (__atomic_test_and_set(&cas128_lock, __ATOMIC_ACQUIRE)) {
+    continue;
+  }
+
+  memcpy(old, t, sizeof(old));
+  if (memcmp(old, cp, sizeof(old)) == 0) {
+    memcpy(t, vp, sizeof(old));
+  }
+
+  __atomic_clear(&cas128_lock, __ATOMIC_RELEASE);
+
+  memcpy(retp, old, sizeof(old));
+}
+
+#endif /* HAVE_ATOMIC_CAS128 */
+
+void shmemc_ucx_amo_ext_apply(shmemc_amo_ext_op_t op,
+                              shmemc_amo_ext_type_t type, void *t,
+                              const void *vp, const void *cp, size_t vs,
+                              void *retp) {
+  char discard[16];
+
+  if (retp == NULL) {
+    retp = discard;
+  }
+
+  switch (vs) {
+  case 4: {
+    uint32_t v, r;
+
+    memcpy(&v, vp, sizeof(v));
+    r = apply32(op, type, (uint32_t *)t, v);
+    memcpy(retp, &r, sizeof(r));
+    break;
+  }
+  case 8: {
+    uint64_t v, r;
+
+    memcpy(&v, vp, sizeof(v));
+    r = apply64(op, type, (uint64_t *)t, v);
+    memcpy(retp, &r, sizeof(r));
+    break;
+  }
+  case 16:
+    shmemu_assert(op == SHMEMC_AMO_EXT_CSWAP,
+                  MODULE ": 16-byte AMO %d not supported", (int)op);
+    cswap128(t, cp, vp, retp);
+    break;
+  default:
+    shmemu_fatal(MODULE ": %lu-byte AMO not supported", (unsigned long)vs);
+    /* NOT REACHED */
+    break;
+  }
+}
+
+#ifdef SHMEMC_UCX_AMO_EXT_AM
+
+/*
+ * -- wire format --------------------------------------------------------
+ *
+ * Everything travels in the AM header, there's no payload.
+ */
+
+typedef struct amo_ext_hdr {
+  uint64_t token;   /* initiator's pending record, echoed in reply */
+  uint64_t addr;    /* target address on receiving PE */
+  uint64_t val[2];  /* operand */
+  uint64_t cond[2]; /* comparand (CSWAP) */
+  int32_t pe;       /* initiator */
+  uint8_t op;       /* shmemc_amo_ext_op_t */
+  uint8_t type;     /* shmemc_amo_ext_type_t */
+  uint8_t size;     /* operand size (b) */
+  uint8_t pad;
+} amo_ext_hdr_t;
+
+typedef struct amo_ext_reply {
+  uint64_t token;
+  uint64_t old[2];
+} amo_ext_reply_t;
+
+/*
+ * -- initiating side ----------------------------------------------------
+ */
+
+/*
+ * One per operation in flight.  The header has to stay put until
+ * UCX has sent it, and the reply can beat the send completion, so
+ * whichever of the two comes last frees it.
+ */
+typedef struct amo_ext_pending {
+  amo_ext_hdr_t hdr;
+  shmemc_context_h ch;
+  void *retp;      /* where the old value goes, or NULL */
+  int blocking;    /* initiator is waiting on "done" */
+  int done;        /* reply arrived */
+  unsigned refs;   /* send completion + reply */
+} amo_ext_pending_t;
+
+inline static void pending_release(amo_ext_pending_t *pp) {
+  if (__atomic_sub_fetch(&pp->refs, 1, __ATOMIC_ACQ_REL) == 0) {
+    free(pp);
+  }
+}
+
+static void request_sent_callbackx(void *req, ucs_status_t status,
+                                   void *user_data) {
+  shmemu_assert(status == UCS_OK,
+                MODULE ": can't send remote AMO (status: %s)",
+                ucs_status_string(status));
+
+  pending_release((amo_ext_pending_t *)user_data);
+  ucp_request_free(req);
+}
+
+/*
+ * Replies come back to the default worker, so progress that as well
+ */
+inline static void progress_both(shmemc_context_h ch) {
+  (void)ucp_worker_progress(ch->w);
+  if (ch != defcp) {
+    (void)ucp_worker_progress(defcp->w);
+  }
+}
+
+void shmemc_ucx_amo_ext_post(shmemc_context_h ch, shmemc_amo_ext_op_t op,
+                             shmemc_amo_ext_type_t type, uint64_t r_t,
+                             const void *vp, const void *cp, size_t vs, int pe,
+                             void *retp, int blocking) {
+  amo_ext_pending_t *pp;
+  ucs_status_ptr_t sp;
+
+  pp = (amo_ext_pending_t *)calloc(1, sizeof(*pp));
+  shmemu_assert(pp != NULL, MODULE ": can't allocate remote AMO");
+
+  pp->hdr.token = (uint64_t)(uintptr_t)pp;
+  pp->hdr.addr = r_t;
+  memcpy(pp->hdr.val, vp, vs);
+  if (cp != NULL) {
+    memcpy(pp->hdr.cond, cp, vs);
+  }
+  pp->hdr.pe = proc.li.rank;
+  pp->hdr.op = (uint8_t)op;
+  pp->hdr.type = (uint8_t)type;
+  pp->hdr.size = (uint8_t)vs;
+
+  pp->ch = ch;
+  pp->retp = retp;
+  pp->blocking = blocking;
+  pp->refs = 2;
+
+  if (!blocking) {
+    __atomic_add_fetch(&ch->amo_ext_pending, 1, __ATOMIC_RELEASE);
+  }
+
+  {
+    const ucp_request_param_t prm = {.op_attr_mask =
+                                         UCP_OP_ATTR_FIELD_CALLBACK |
+                                         UCP_OP_ATTR_FIELD_USER_DATA,
+                                     .cb.send = request_sent_callbackx,
+                                     .user_data = pp};
+
+    sp = ucp_am_send_nbx(ch->eps[pe], SHMEMC_UCX_AM_AMO_EXT, &pp->hdr,
+                         sizeof(pp->hdr), NULL, 0, &prm);
+  }
+  if (sp == NULL) {
+    pending_release(pp);
+  } else if (UCS_PTR_IS_ERR(sp)) {
+    shmemu_fatal(MODULE ": can't send remote AMO to PE %d (status: %s)", pe,
+                 ucs_status_string(UCS_PTR_STATUS(sp)));
+    /* NOT REACHED */
+  }
+
+  if (blocking) {
+    /* hold on to it, the reply handler lets go of its reference */
+    while (!__atomic_load_n(&pp->done, __ATOMIC_ACQUIRE)) {
+      progress_both(ch);
+    }
+    pending_release(pp);
+  }
+}
+
+void shmemc_ucx_amo_ext_drain(shmemc_context_h ch) {
+  while (__atomic_load_n(&ch->amo_ext_pending, __ATOMIC_ACQUIRE) > 0) {
+    progress_both(ch);
+  }
+}
+
+int shmemc_ucx_amo_ext_test(shmemc_context_h ch) {
+  if (__atomic_load_n(&ch->amo_ext_pending, __ATOMIC_ACQUIRE) == 0) {
+    return 1;
+    /* NOT REACHED */
+  }
+
+  progress_both(ch);
+
+  return __atomic_load_n(&ch->amo_ext_pending, __ATOMIC_ACQUIRE) == 0;
+}
+
+static ucs_status_t reply_handler(void *arg, const void *header,
+                                  size_t header_length, void *data,
+                                  size_t length,
+                                  const ucp_am_recv_param_t *param) {
+  const amo_ext_reply_t *rp = (const amo_ext_reply_t *)header;
+  amo_ext_pending_t *pp = (amo_ext_pending_t *)(uintptr_t)rp->token;
+
+  NO_WARN_UNUSED(arg);
+  NO_WARN_UNUSED(header_length);
+  NO_WARN_UNUSED(data);
+  NO_WARN_UNUSED(length);
+  NO_WARN_UNUSED(param);
+
+  if (pp->retp != NULL) {
+    memcpy(pp->retp, rp->old, pp->hdr.size);
+  }
+
+  if (pp->blocking) {
+    /* initiator still holds a reference, and frees it */
+    __atomic_store_n(&pp->done, 1, __ATOMIC_RELEASE);
+    return UCS_OK;
+    /* NOT REACHED */
+  }
+
+  __atomic_sub_fetch(&pp->ch->amo_ext_pending, 1, __ATOMIC_RELEASE);
+  pending_release(pp);
+
+  return UCS_OK;
+}
+
+/*
+ * -- target side --------------------------------------------------------
+ */
+
+static void reply_sent_callbackx(void *req, ucs_status_t status,
+                                 void *user_data) {
+  NO_WARN_UNUSED(status);
+
+  free(user_data);
+  ucp_request_free(req);
+}
+
+static ucs_status_t request_handler(void *arg, const void *header,
+                                    size_t header_length, void *data,
+                                    size_t length,
+                                    const ucp_am_recv_param_t *param) {
+  const amo_ext_hdr_t *hp = (const amo_ext_hdr_t *)header;
+  amo_ext_reply_t *rp;
+  ucs_status_ptr_t sp;
+
+  NO_WARN_UNUSED(arg);
+  NO_WARN_UNUSED(header_length);
+  NO_WARN_UNUSED(data);
+  NO_WARN_UNUSED(length);
+  NO_WARN_UNUSED(param);
+
+  rp = (amo_ext_reply_t *)malloc(sizeof(*rp));
+  shmemu_assert(rp != NULL, MODULE ": can't allocate remote AMO reply");
+
+  rp->token = hp->token;
+
+  shmemc_ucx_amo_ext_apply((shmemc_amo_ext_op_t)hp->op,
+                           (shmemc_amo_ext_type_t)hp->type,
+                           (void *)(uintptr_t)hp->addr, hp->val, hp->cond,
+                           hp->size, rp->old);
+
+  {
+    const ucp_request_param_t prm = {.op_attr_mask =
+                                         UCP_OP_ATTR_FIELD_CALLBACK |
+                                         UCP_OP_ATTR_FIELD_USER_DATA,
+                                     .cb.send = reply_sent_callbackx,
+                                     .user_data = rp};
+
+    sp = ucp_am_send_nbx(defcp->eps[hp->pe], SHMEMC_UCX_AM_AMO_EXT_REPLY, rp,
+                         sizeof(*rp), NULL, 0, &prm);
+  }
+  if (sp == NULL) {
+    free(rp);
+  } else if (UCS_PTR_IS_ERR(sp)) {
+    shmemu_fatal(MODULE ": can't reply to remote AMO from PE %d "
+                        "(status: %s)",
+                 hp->pe, ucs_status_string(UCS_PTR_STATUS(sp)));
+    /* NOT REACHED */
+  }
+
+  return UCS_OK;
+}
+
+/*
+ * -- setup --------------------------------------------------------------
+ */
+
+inline static void register_one(unsigned id, ucp_am_recv_callback_t cb) {
+  ucp_am_handler_param_t hp;
+  ucs_status_t s;
+
+  hp.field_mask = UCP_AM_HANDLER_PARAM_FIELD_ID |
+                  UCP_AM_HANDLER_PARAM_FIELD_CB |
+                  UCP_AM_HANDLER_PARAM_FIELD_ARG;
+  hp.id = id;
+  hp.cb = cb;
+  hp.arg = NULL;
+
+  s = ucp_worker_set_am_recv_handler(defcp->w, &hp);
+  shmemu_assert(s == UCS_OK,
+                MODULE ": can't register active message handler %u "
+                       "(status: %s)",
+                id, ucs_status_string(s));
+}
+
+void shmemc_ucx_amo_ext_register_handlers(void) {
+  register_one(SHMEMC_UCX_AM_AMO_EXT, request_handler);
+  register_one(SHMEMC_UCX_AM_AMO_EXT_REPLY, reply_handler);
+}
+
+#else /* ! SHMEMC_UCX_AMO_EXT_AM */
+
+void shmemc_ucx_amo_ext_register_handlers(void) {}
+
+void shmemc_ucx_amo_ext_post(shmemc_context_h ch, shmemc_amo_ext_op_t op,
+                             shmemc_amo_ext_type_t type, uint64_t r_t,
+                             const void *vp, const void *cp, size_t vs, int pe,
+                             void *retp, int blocking) {
+  NO_WARN_UNUSED(ch);
+  NO_WARN_UNUSED(op);
+  NO_WARN_UNUSED(type);
+  NO_WARN_UNUSED(r_t);
+  NO_WARN_UNUSED(vp);
+  NO_WARN_UNUSED(cp);
+  NO_WARN_UNUSED(vs);
+  NO_WARN_UNUSED(retp);
+  NO_WARN_UNUSED(blocking);
+
+  shmemu_fatal(MODULE ": AMO on PE %d needs UCX active messages", pe);
+  /* NOT REACHED */
+}
+
+void shmemc_ucx_amo_ext_drain(shmemc_context_h ch) { NO_WARN_UNUSED(ch); }
+
+int shmemc_ucx_amo_ext_test(shmemc_context_h ch) {
+  NO_WARN_UNUSED(ch);
+
+  return 1;
+}
+
+#endif /* SHMEMC_UCX_AMO_EXT_AM */
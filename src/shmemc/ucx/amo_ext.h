@@ -0,0 +1,65 @@
+/* For license: see LICENSE file at top-level */
+
+#ifndef _SHMEMC_UCX_AMO_EXT_H
+#define _SHMEMC_UCX_AMO_EXT_H 1
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif /* HAVE_CONFIG_H */
+
+#include "shmemc.h"
+#include "pe.h"
+
+#include <sys/types.h>
+#include <stdint.h>
+
+/*
+ * AMOs UCX can't do itself (bitwise on older UCX, min/max, floating
+ * point add, 128-bit compare-and-swap).  The initiator sends the
+ * operation as an active message, the target's handler applies it
+ * with CPU atomics and sends back the old value: one round trip, no
+ * matter how contended the location is.
+ *
+ * Needs UCX active messages.
+ */
+
+#if defined(HAVE_UCP_AM_SEND_NBX)
+#define SHMEMC_UCX_AMO_EXT_AM 1
+#endif /* HAVE_UCP_AM_SEND_NBX */
+
+void shmemc_ucx_amo_ext_register_handlers(void);
+
+/*
+ * apply operation to our own memory, old value to retp (if not NULL)
+ */
+void shmemc_ucx_amo_ext_apply(shmemc_amo_ext_op_t op,
+                              shmemc_amo_ext_type_t type, void *t,
+                              const void *vp, const void *cp, size_t vs,
+                              void *retp);
+
+/*
+ * new value from old one and operand, for compare-and-swap emulation
+ * (up to 64 bits)
+ */
+uint64_t shmemc_ucx_amo_ext_combine(shmemc_amo_ext_op_t op,
+                                    shmemc_amo_ext_type_t type, uint64_t old,
+                                    uint64_t v, size_t vs);
+
+/*
+ * Have PE apply the operation to r_t (already translated for PE).
+ * Blocking waits for the old value, otherwise it turns up in retp by
+ * the next drain.
+ */
+void shmemc_ucx_amo_ext_post(shmemc_context_h ch, shmemc_amo_ext_op_t op,
+                             shmemc_amo_ext_type_t type, uint64_t r_t,
+                             const void *vp, const void *cp, size_t vs, int pe,
+                             void *retp, int blocking);
+
+/*
+ * drain: wait until every operation posted on context has been done
+ * test: non-zero if they have
+ */
+void shmemc_ucx_amo_ext_drain(shmemc_context_h ch);
+int shmemc_ucx_amo_ext_test(shmemc_context_h ch);
+
+#endif /* ! _SHMEMC_UCX_AMO_EXT_H */
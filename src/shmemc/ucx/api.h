@@ -27,6 +27,14 @@ void shmemc_ucx_allocate_eps_table(shmemc_context_h ch);
 void shmemc_ucx_deallocate_eps_table(shmemc_context_h ch);
 
 int shmemc_ucx_context_progress(shmemc_context_h ch);
+
+/*
+ * sleeping until a context's worker has events
+ */
+
+int shmemc_ucx_context_efd(shmemc_context_h ch);
+bool shmemc_ucx_context_arm(shmemc_context_h ch);
+void shmemc_ucx_context_signal(shmemc_context_h ch);
 void shmemc_ucx_make_eps(shmemc_context_h ch);
 void shmemc_ucx_disconnect_all_eps(shmemc_context_h ch);
 
@@ -35,4 +43,22 @@ ucs_status_t shmemc_ucx_worker_wireup(shmemc_context_h ch);
 ucs_status_t shmemc_ucx_rkey_pack(ucp_mem_h mh, void **packed_rkey_p,
                                   size_t *len_p);
 
+/*
+ * active messages, all handled on the default context's worker
+ */
+
+enum shmemc_ucx_am_id {
+  SHMEMC_UCX_AM_AGGR_BATCH = 1, /* aggregated puts/AMOs */
+  SHMEMC_UCX_AM_AGGR_ACK,       /* batch has been applied */
+  SHMEMC_UCX_AM_AMO_EXT,        /* AMO to apply at target */
+  SHMEMC_UCX_AM_AMO_EXT_REPLY,  /* old value of AMO target */
+};
+
+/*
+ * non-fetching AMO straight to UCX
+ */
+
+ucs_status_t shmemc_ucx_post_amo(shmemc_context_h ch, ucp_atomic_post_op_t uapo,
+                                 void *t, uint64_t val, size_t vs, int pe);
+
 #endif /* ! _SHMEMC_UCX_H */
@@ -7,6 +7,7 @@
 #include "shmemu.h"
 #include "shmemc.h"
 #include "state.h"
+#include "module.h"
 
 #include <ucp/api/ucp.h>
 
@@ -25,6 +26,19 @@ void nb_callbackx(void *req, ucs_status_t status, void *user_data) {
   NO_WARN_UNUSED(user_data);
 }
 
+/*
+ * as above, and count the completion (see completion counters)
+ */
+
+void counter_callbackx(void *req, ucs_status_t status, void *user_data) {
+  shmemu_assert(status == UCS_OK,
+                MODULE ": counted operation failed (status: %s)",
+                ucs_status_string(status));
+
+  __atomic_add_fetch((uint64_t *)user_data, 1, __ATOMIC_RELEASE);
+  ucp_request_release(req);
+}
+
 /*
  * dummy callback
  */
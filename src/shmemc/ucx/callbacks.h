@@ -15,4 +15,9 @@ void nb_callbackx(void *request, ucs_status_t status, void *user_data);
 void noop_callback(void *request, ucs_status_t status);
 void noop_callbackx(void *request, ucs_status_t status, void *user_data);
 
+/*
+ * _nbx completion that also bumps a counter (user_data: uint64_t *)
+ */
+void counter_callbackx(void *request, ucs_status_t status, void *user_data);
+
 #endif /* ! _SHMEMC_UCX_CALLBACKS_HH */
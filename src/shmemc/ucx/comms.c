@@ -9,6 +9,9 @@
 #include "state.h"
 #include "api.h"
 #include "callbacks.h"
+#include "aggregate.h"
+#include "stripe.h"
+#include "amo_ext.h"
 #include "memfence.h"
 #include "module.h"
 
@@ -16,6 +19,12 @@
 
 #include <unistd.h>
 #include <string.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif /* __SSE2__ */
 
 #include <ucp/api/ucp.h>
 
@@ -31,46 +40,48 @@ inline static ucp_ep_h lookup_ucp_ep(shmemc_context_h ch, int pe) {
 }
 
 /*
- * find rkey for memory "region" on PE "pe"
+ * -- translation helpers ---------------------------------------------------
  */
-inline static ucp_rkey_h lookup_rkey(shmemc_context_h ch, size_t region,
-                                     int pe) {
-  return ch->racc[region].rinfo[pe].rkey;
-}
 
 /*
- * -- translation helpers ---------------------------------------------------
+ * is the given address in this interval?  Non-zero if yes, 0 if not.
  */
+inline static int in_interval(const mem_interval_t *ip, uint64_t addr) {
+  return (ip->base <= addr) && (addr < ip->end);
+}
 
 /*
- * is the given address in this memory region?  Non-zero if yes, 0 if
- * not.
+ * find the interval ADDR is in, or NULL if none.  Table is sorted by
+ * address, so binary search it.
  */
-inline static int in_region(uint64_t addr, size_t region) {
-  const mem_info_t *mip = &proc.comms.regions[region].minfo[proc.li.rank];
+inline static const mem_interval_t *lookup_interval(uint64_t addr) {
+  const mem_interval_t *tab = proc.comms.rtable;
+  size_t lo = 0;
+  size_t hi = proc.comms.nregions;
+
+  while (lo < hi) {
+    const size_t mid = lo + (hi - lo) / 2;
+
+    if (addr < tab[mid].base) {
+      hi = mid;
+    } else if (addr >= tab[mid].end) {
+      lo = mid + 1;
+    } else {
+      return &tab[mid];
+      /* NOT REACHED */
+    }
+  }
 
-  return (mip->base <= addr) && (addr < mip->end);
+  return NULL;
 }
 
 /*
  * find memory region that ADDR is in, or -1 if none
  */
 inline static long lookup_region(uint64_t addr) {
-  long r;
-
-  /*
-   * Let's search down from top heap to globals (#0) under
-   * assumption most data in heaps and newest one is most likely
-   * (may need to revisit)
-   */
-  for (r = proc.comms.nregions - 1; r >= 0; --r) {
-    if (in_region(addr, (size_t)r)) {
-      return r;
-      /* NOT REACHED */
-    }
-  }
+  const mem_interval_t *ip = lookup_interval(addr);
 
-  return -1L;
+  return (ip != NULL) ? (long)ip->region : -1L;
 }
 
 /*
@@ -79,64 +90,157 @@ inline static long lookup_region(uint64_t addr) {
  * if all addresses aligned, remote always == local
  *
  * otherwise globals are always aligned, but translate shmalloc'ed
- * variables
+ * variables (via precomputed per-PE deltas)
  */
 #ifdef ENABLE_ALIGNED_ADDRESSES
 
-#define translate_region_address(_local_addr, _region, _pe) (_local_addr)
 #define translate_address(_local_addr, _pe) (_local_addr)
 
 #else
 
-/*
- * where the heap lives on PE "pe"
- */
+inline static uint64_t translate_address(uint64_t local_addr, int pe) {
+  long r = lookup_region(local_addr);
 
-inline static size_t get_base(size_t region, int pe) {
-  return proc.comms.regions[region].minfo[pe].base;
+  if (r < 0) {
+    return 0;
+  }
+
+  return local_addr + defcp->racc[r].rinfo[pe].delta;
 }
 
-inline static uint64_t translate_region_address(uint64_t local_addr,
-                                                size_t region, int pe) {
-  if (region == 0) {
-    return local_addr;
-  } else {
-    const long my_offset = local_addr - get_base(region, proc.li.rank);
+#endif /* ENABLE_ALIGNED_ADDRESSES */
 
-    if (my_offset < 0) {
-      return 0;
-    }
+/*
+ * All ops here need to find remote keys and addresses.  Try the
+ * region this context hit last time before searching.
+ */
+inline static const mem_access_t *
+lookup_access(shmemc_context_h ch, uint64_t local_addr, int pe,
+              const mem_interval_t **ip_p) {
+  const mem_interval_t *ip = ch->hot;
+
+  if (shmemu_unlikely(!in_interval(ip, local_addr))) {
+    ip = lookup_interval(local_addr);
+
+    shmemu_assert(ip != NULL, MODULE ": can't find memory region for %p",
+                  (void *)local_addr);
 
-    return my_offset + get_base(region, pe);
+    /* racy if shared, but any entry is a valid hint */
+    ch->hot = ip;
   }
+
+  *ip_p = ip;
+
+  return &ch->racc[ip->region].rinfo[pe];
 }
 
-inline static uint64_t translate_address(uint64_t local_addr, int pe) {
-  long r = lookup_region(local_addr);
+/*
+ * A worker fence doesn't order UCX traffic against direct stores.
+ * Note which PEs we are about to send UCX traffic to that we also
+ * store to directly (maybe through another region), so a fence only
+ * has to complete that traffic when there is some.
+ */
+inline static void note_ucx_pe(shmemc_context_h ch, int pe) {
+  int cur = __atomic_load_n(&ch->ucx_pe, __ATOMIC_RELAXED);
+  size_t r;
 
-  if (r < 0) {
-    return 0;
+  if ((cur == pe) || (cur == SHMEMC_PE_MANY)) {
+    return;
+    /* NOT REACHED */
+  }
+
+  for (r = 0; r < proc.comms.nregions; ++r) {
+    if (ch->racc[r].rinfo[pe].mapped != NULL) {
+      break;
+    }
+  }
+  if (r == proc.comms.nregions) {
+    return; /* never stored to directly */
+    /* NOT REACHED */
+  }
+
+  if ((cur == SHMEMC_PE_NONE) &&
+      __atomic_compare_exchange_n(&ch->ucx_pe, &cur, pe, false,
+                                  __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    return;
+    /* NOT REACHED */
   }
 
-  return translate_region_address(local_addr, r, pe);
+  if (cur != pe) {
+    __atomic_store_n(&ch->ucx_pe, SHMEMC_PE_MANY, __ATOMIC_RELAXED);
+  }
 }
 
-#endif /* ENABLE_ALIGNED_ADDRESSES */
+/*
+ * forget what was in flight, just before a flush completes it
+ */
+inline static void clear_ucx_pe(shmemc_context_h ch) {
+  __atomic_store_n(&ch->ucx_pe, SHMEMC_PE_NONE, __ATOMIC_RELAXED);
+}
 
 /*
- * All ops here need to find remote keys and addresses
+ * does a fence have to be a quiet?
  */
+inline static bool stores_mixed(shmemc_context_h ch) {
+  return ch->mapped &&
+         (__atomic_load_n(&ch->ucx_pe, __ATOMIC_RELAXED) != SHMEMC_PE_NONE);
+}
+
 inline static void get_remote_key_and_addr(shmemc_context_h ch,
                                            uint64_t local_addr, int pe,
                                            ucp_rkey_h *rkey_p,
                                            uint64_t *raddr_p) {
-  const long r = lookup_region(local_addr);
+  const mem_interval_t *ip;
+  const mem_access_t *ap = lookup_access(ch, local_addr, pe, &ip);
+
+  if (ch->mapped) {
+    note_ucx_pe(ch, pe);
+  }
+
+  *rkey_p = ap->rkey;
+  *raddr_p = local_addr + ap->delta;
+}
+
+/*
+ * Operations on our own memory needn't go near UCX: puts and gets
+ * become memcpy()s, AMOs CPU atomics of the width UCX would use (32
+ * or 64 bits).  The latter only agree with AMOs arriving from other
+ * PEs if UCX does those with the CPU too, which env.c works out.
+ */
+inline static int loopback_rma(int pe) {
+  return proc.env.loopback && (pe == proc.li.rank);
+}
+
+inline static int loopback_amo(int pe) {
+  return proc.env.loopback_amo && (pe == proc.li.rank);
+}
+
+/*
+ * where PE's copy of LOCAL_ADDR is mapped into our address space, or
+ * NULL if it isn't.  Our own copy is just LOCAL_ADDR.
+ */
+inline static void *get_mapped_addr(shmemc_context_h ch, uint64_t local_addr,
+                                    int pe) {
+  const mem_interval_t *ip;
+  const mem_access_t *ap;
+
+  if (loopback_rma(pe)) {
+    return (void *)local_addr;
+    /* NOT REACHED */
+  }
+
+  if (!ch->mapped) {
+    return NULL;
+    /* NOT REACHED */
+  }
 
-  shmemu_assert(r >= 0, MODULE ": can't find memory region for %p",
-                (void *)local_addr);
+  ap = lookup_access(ch, local_addr, pe, &ip);
+  if (ap->mapped == NULL) {
+    return NULL;
+    /* NOT REACHED */
+  }
 
-  *rkey_p = lookup_rkey(ch, r, pe);
-  *raddr_p = translate_region_address(local_addr, r, pe);
+  return (char *)ap->mapped + (local_addr - ip->base);
 }
 
 /*
@@ -180,10 +284,40 @@ int shmemc_managed_address(uint64_t addr) { return lookup_region(addr) > 0; }
 
 int shmemc_global_address(uint64_t addr) { return lookup_region(addr) == 0; }
 
+/*
+ * which region a symmetric variable is in and how far into it, which
+ * is the same on every PE.  -1 if it isn't symmetric.
+ */
+
+long shmemc_symmetric_offset(uint64_t addr, uint64_t *offp) {
+  const mem_interval_t *ip = lookup_interval(addr);
+
+  if (ip == NULL) {
+    return -1L;
+    /* NOT REACHED */
+  }
+
+  *offp = addr - ip->base;
+
+  return (long)ip->region;
+}
+
 /*
  * -- ordering -----------------------------------------------------------
  */
 
+/*
+ * non-blocking put-with-signal posts its signal from a completion
+ * callback, so make sure every signal has actually been issued before
+ * we flush the worker
+ */
+
+inline static void drain_pending_signals(shmemc_context_h ch) {
+  while (__atomic_load_n(&ch->pending_signals, __ATOMIC_ACQUIRE) > 0) {
+    (void)ucp_worker_progress(ch->w);
+  }
+}
+
 /*
  * fence and quiet only do something on storable contexts, but
  * currently, progress is on the default context
@@ -194,7 +328,36 @@ void shmemc_ctx_fence(shmem_ctx_t ctx) {
     shmemc_context_h ch = (shmemc_context_h)ctx;
 
     if (!ch->attr.nostore) {
-      const ucs_status_t s = ucp_worker_fence(ch->w);
+      ucs_status_t s;
+
+      /* signals must be ordered before anything after the fence */
+      drain_pending_signals(ch);
+
+      /* buffered ops are applied out-of-band, wait for them */
+      shmemc_ucx_aggr_drain(ch);
+
+      /* no fence across workers, so complete striped chunks */
+      shmemc_ucx_stripe_flush(ch);
+
+      /* remote-executed AMOs are only done once they've replied */
+      shmemc_ucx_amo_ext_drain(ch);
+
+      /*
+       * a worker fence doesn't order UCX traffic against our own
+       * direct stores, so complete UCX traffic to PEs we also store
+       * to directly instead
+       */
+      if (stores_mixed(ch)) {
+        shmemc_ctx_quiet(ctx);
+        return;
+        /* NOT REACHED */
+      }
+
+      if (ch->mapped) {
+        LOAD_STORE_FENCE();
+      }
+
+      s = ucp_worker_fence(ch->w);
 
       shmemu_assert(s == UCS_OK, MODULE ": %s() failed (status: %s)", __func__,
                     ucs_status_string(s));
@@ -209,6 +372,23 @@ void shmemc_ctx_quiet(shmem_ctx_t ctx) {
     if (!ch->attr.nostore) {
       ucs_status_t s;
 
+      drain_pending_signals(ch);
+      shmemc_ucx_aggr_drain(ch);
+      shmemc_ucx_stripe_flush(ch);
+      shmemc_ucx_amo_ext_drain(ch);
+
+      /* finish off any quiet test still in flight */
+      if (ch->qtest_posted) {
+        s = check_wait_for_request(ch, ch->qtest_req);
+        shmemu_assert(s == UCS_OK, MODULE ": %s() failed (status: %s)",
+                      __func__, ucs_status_string(s));
+        ch->qtest_req = NULL;
+        ch->qtest_posted = false;
+      }
+
+      /* everything sent so far is covered by this flush */
+      clear_ucx_pe(ch);
+
 #ifdef HAVE_UCP_WORKER_FLUSH_NBX
       const ucp_request_param_t prm = {.op_attr_mask =
                                            UCP_OP_ATTR_FIELD_CALLBACK,
@@ -222,561 +402,2593 @@ void shmemc_ctx_quiet(shmem_ctx_t ctx) {
 
       shmemu_assert(s == UCS_OK, MODULE ": %s() failed (status: %s)", __func__,
                     ucs_status_string(s));
+
+      /* and make direct stores visible */
+      if (ch->mapped) {
+        LOAD_STORE_FENCE();
+      }
     }
   }
 }
 
-#ifdef ENABLE_EXPERIMENTAL
-
 /*
- * This should be correct, but not optimal.  Gets us going.
+ * per-PE quiet/fence only flush the endpoint(s) to those PEs.  UCX
+ * has no per-endpoint fence, so a fence is a flush too.
  */
 
-int shmemc_ctx_fence_test(shmem_ctx_t ctx) {
-  shmemc_ctx_fence(ctx);
-  return 1;
-}
+inline static ucs_status_ptr_t post_ep_flush(shmemc_context_h ch, int pe) {
+#ifdef HAVE_UCP_EP_FLUSH_NBX
+  const ucp_request_param_t prm = {.op_attr_mask = UCP_OP_ATTR_FIELD_CALLBACK,
+                                   .cb.send = noop_callbackx};
 
-int shmemc_ctx_quiet_test(shmem_ctx_t ctx) {
-  shmemc_ctx_quiet(ctx);
-  return 1;
+  return ucp_ep_flush_nbx(lookup_ucp_ep(ch, pe), &prm);
+#else
+  return ucp_ep_flush_nb(lookup_ucp_ep(ch, pe), 0, noop_callback);
+#endif /* HAVE_UCP_EP_FLUSH_NBX */
 }
 
-#endif /* ENABLE_EXPERIMENTAL */
+void shmemc_ctx_pe_quiet(shmem_ctx_t ctx, int pe) {
+  if (ctx != SHMEM_CTX_INVALID) {
+    shmemc_context_h ch = (shmemc_context_h)ctx;
 
-static ucs_status_t helper_posted_amo(shmemc_context_h ch,
-                                      ucp_atomic_post_op_t uapo, void *t,
-                                      void *vp, size_t vs, int pe) {
-  uint64_t r_t;
-  ucp_rkey_h r_key;
-  ucp_ep_h ep;
-  uint64_t rv = *(uint64_t *)vp;
+    if (!ch->attr.nostore) {
+      ucs_status_t s;
 
-  get_remote_key_and_addr(ch, (uint64_t)t, pe, &r_key, &r_t);
-  ep = lookup_ucp_ep(ch, pe);
+      /* signals, aggregated, striped & remote-executed ops aren't
+         tracked per PE */
+      drain_pending_signals(ch);
+      shmemc_ucx_aggr_drain(ch);
+      shmemc_ucx_stripe_flush(ch);
+      shmemc_ucx_amo_ext_drain(ch);
+
+      {
+        int cur = pe;
+
+        (void)__atomic_compare_exchange_n(&ch->ucx_pe, &cur, SHMEMC_PE_NONE,
+                                          false, __ATOMIC_RELAXED,
+                                          __ATOMIC_RELAXED);
+      }
+
+      s = check_wait_for_request(ch, post_ep_flush(ch, pe));
 
-  return ucp_atomic_post(ep, uapo, rv, vs, r_t, r_key);
+      shmemu_assert(s == UCS_OK, MODULE ": %s(pe=%d) failed (status: %s)",
+                    __func__, pe, ucs_status_string(s));
+
+      if (ch->mapped) {
+        LOAD_STORE_FENCE();
+      }
+    }
+  }
 }
 
 /*
- * fetching AMOs: target t, (optional) condition c, value v
+ * post all the flushes first so they overlap, then wait for each
  */
 
-inline static ucs_status_ptr_t
-helper_fetching_amo_internal(shmemc_context_h ch, ucp_atomic_fetch_op_t op,
-                             void *t, void *vp, size_t vs, int pe, void *retp,
-                             ucp_send_callback_t cb) {
-  ucp_rkey_h r_key;
-  uint64_t r_t;
-  ucp_ep_h ep;
-  uint64_t rv = *(uint64_t *)vp;
-  ucs_status_ptr_t sp;
+void shmemc_ctx_pe_quiet_multi(shmem_ctx_t ctx, const int *pes, size_t npes) {
+  if (ctx != SHMEM_CTX_INVALID) {
+    shmemc_context_h ch = (shmemc_context_h)ctx;
 
-  get_remote_key_and_addr(ch, (uint64_t)t, pe, &r_key, &r_t);
-  ep = lookup_ucp_ep(ch, pe);
+    if ((!ch->attr.nostore) && (npes > 0)) {
+      ucs_status_ptr_t *reqs;
+      size_t i;
 
-  sp = ucp_atomic_fetch_nb(ep, op, rv, retp, vs, r_t, r_key, cb);
+      reqs = (ucs_status_ptr_t *)malloc(npes * sizeof(*reqs));
 
-  return sp;
-}
+      shmemu_assert(reqs != NULL,
+                    MODULE ": can't allocate flush requests for %lu PEs",
+                    (unsigned long)npes);
 
-static ucs_status_t helper_fetching_amo(shmemc_context_h ch,
-                                        ucp_atomic_fetch_op_t op, void *t,
-                                        void *vp, size_t vs, int pe,
-                                        void *retp) {
-  ucs_status_ptr_t sp;
+      drain_pending_signals(ch);
+      shmemc_ucx_aggr_drain(ch);
+      shmemc_ucx_stripe_flush(ch);
+      shmemc_ucx_amo_ext_drain(ch);
 
-  sp = helper_fetching_amo_internal(ch, op, t, vp, vs, pe, retp, noop_callback);
+      for (i = 0; i < npes; ++i) {
+        reqs[i] = post_ep_flush(ch, pes[i]);
+      }
 
-  return check_wait_for_request(ch, sp);
-}
+      for (i = 0; i < npes; ++i) {
+        const ucs_status_t s = check_wait_for_request(ch, reqs[i]);
 
-static ucs_status_ptr_t helper_fetching_amo_nbi(shmemc_context_h ch,
-                                                ucp_atomic_fetch_op_t op,
-                                                void *t, void *vp, size_t vs,
-                                                int pe, void *retp) {
-  ucs_status_ptr_t sp;
+        shmemu_assert(s == UCS_OK, MODULE ": %s(pe=%d) failed (status: %s)",
+                      __func__, pes[i], ucs_status_string(s));
+      }
 
-  sp = helper_fetching_amo_internal(ch, op, t, vp, vs, pe, retp, nb_callback);
+      free(reqs);
 
-  return sp;
+      if (ch->mapped) {
+        LOAD_STORE_FENCE();
+      }
+    }
+  }
 }
 
-/**
- * API
- *
- **/
+void shmemc_ctx_pe_fence(shmem_ctx_t ctx, int pe) {
+  shmemc_ctx_pe_quiet(ctx, pe);
+}
+
+#ifdef ENABLE_EXPERIMENTAL
 
 /*
- * make progress on a context
+ * Non-blocking quiet: the first call gets everything that has to
+ * precede the flush out of the way (signals, aggregated batches,
+ * striping lanes, remote-executed AMOs), then posts a worker flush
+ * and keeps it on the context.  Later calls just progress and check
+ * it, so the caller can overlap other work.  Once it has returned
+ * non-zero, the next call starts over.
  */
 
-inline static void helper_ctx_progress(shmem_ctx_t ctx) {
+#ifdef HAVE_UCP_WORKER_FLUSH_NBX
+
+int shmemc_ctx_quiet_test(shmem_ctx_t ctx) {
   shmemc_context_h ch = (shmemc_context_h)ctx;
 
-  (void)ucp_worker_progress(ch->w);
-}
+  if ((ctx == SHMEM_CTX_INVALID) || ch->attr.nostore) {
+    return 1;
+    /* NOT REACHED */
+  }
 
-void shmemc_ctx_progress(shmem_ctx_t ctx) { helper_ctx_progress(ctx); }
+  if (!ch->qtest_posted) {
+    const ucp_request_param_t prm = {.op_attr_mask =
+                                         UCP_OP_ATTR_FIELD_CALLBACK,
+                                     .cb.send = noop_callbackx};
+    ucs_status_ptr_t sp;
 
-void shmemc_progress(void) { helper_ctx_progress(SHMEM_CTX_DEFAULT); }
+    if (__atomic_load_n(&ch->pending_signals, __ATOMIC_ACQUIRE) > 0) {
+      (void)ucp_worker_progress(ch->w);
+      return 0;
+      /* NOT REACHED */
+    }
+    if (!shmemc_ucx_aggr_test(ch) || !shmemc_ucx_stripe_test(ch) ||
+        !shmemc_ucx_amo_ext_test(ch)) {
+      return 0;
+      /* NOT REACHED */
+    }
 
-/*
- * -- accessible memory pointers -----------------------------------------
- */
+    clear_ucx_pe(ch);
 
-/*
- * See if addr is reachable using given context.  Return usable
- * address if so, otherwise NULL.
- */
+    sp = ucp_worker_flush_nbx(ch->w, &prm);
+    shmemu_assert(!UCS_PTR_IS_ERR(sp), MODULE ": %s() failed (status: %s)",
+                  __func__, ucs_status_string(UCS_PTR_STATUS(sp)));
 
-inline static void *ctx_ptr_self_check(const void *addr) {
-  /* is it remotely accessible? */
-  if (lookup_region((uint64_t)addr) >= 0) {
-    return (void *)addr;
-  } else {
-    return NULL;
+    ch->qtest_req = sp;
+    ch->qtest_posted = true;
   }
-}
 
-inline static void *ctx_ptr_remote_check(shmem_ctx_t ctx, const void *addr,
-                                         int pe) {
-  shmemc_context_h ch = (shmemc_context_h)ctx;
-  uint64_t r_addr;  /* address on other PE */
-  ucp_rkey_h r_key; /* rkey for remote address */
-  void *usable_addr = NULL;
-  ucs_status_t s;
+  if (ch->qtest_req != NULL) {
+    ucs_status_t s;
 
-  get_remote_key_and_addr(ch, (uint64_t)addr, pe, &r_key, &r_addr);
+    (void)ucp_worker_progress(ch->w);
 
-  s = ucp_rkey_ptr(r_key, r_addr, &usable_addr);
-  if (s == UCS_OK) {
-    return usable_addr;
-  } else {
-    return NULL;
+    s = UCX_REQUEST_CHECK(ch->qtest_req);
+    if (s == UCS_INPROGRESS) {
+      return 0;
+      /* NOT REACHED */
+    }
+
+    ucp_request_free(ch->qtest_req);
+    ch->qtest_req = NULL;
+
+    shmemu_assert(s == UCS_OK, MODULE ": %s() failed (status: %s)", __func__,
+                  ucs_status_string(s));
   }
-}
 
-void *shmemc_ctx_ptr(shmem_ctx_t ctx, const void *addr, int pe) {
-  /* self short-circuit */
-  if (shmemu_unlikely(pe == proc.li.rank)) {
-    return ctx_ptr_self_check(addr);
-    /* NOT REACHED */
+  ch->qtest_posted = false;
+
+  if (ch->mapped) {
+    LOAD_STORE_FENCE();
   }
 
-  /* if UCX has check routine, do a full test, otherwise give up */
-#ifdef HAVE_UCP_RKEY_PTR
-  return ctx_ptr_remote_check(ctx, addr, pe);
-#else
-  return NULL;
-#endif /* HAVE_UCP_RKEY_PTR */
+  return 1;
 }
 
+#else /* ! HAVE_UCP_WORKER_FLUSH_NBX */
+
 /*
- * Return non-zero if adddress is remotely accessible, 0 otherwise.
- *
+ * nothing to keep hold of, so just complete
  */
-int shmemc_addr_accessible(const void *addr, int pe) {
-  uint64_t uaddr = (uint64_t)addr;
 
-  NO_WARN_UNUSED(pe); /* if aligned addresses */
-
-  return translate_address(uaddr, pe) > 0;
+int shmemc_ctx_quiet_test(shmem_ctx_t ctx) {
+  shmemc_ctx_quiet(ctx);
+  return 1;
 }
 
-/*
- * Return non-zero if a valid PE #, 0 otherwise.
- *
- * N.B. this function was originally meant to test which ranks were
- * SHMEM in mixed SHMEM/MPI programs.  Here we just check the rank
- * number is valid and assume reachability, although might want to
- * revisit for FT/resilience purposes.
- */
-int shmemc_pe_accessible(int pe) { return shmemu_valid_pe_number(pe); }
+#endif /* HAVE_UCP_WORKER_FLUSH_NBX */
 
 /*
- * -- atomics ------------------------------------------------------------
+ * A plain fence never blocks once the signals are out.  Where fence
+ * has to be a quiet (direct stores mixed with UCX traffic,
+ * aggregation, striping, remote-executed AMOs), test the quiet
+ * instead.
  */
 
-/**
- * AMO API
- **/
+int shmemc_ctx_fence_test(shmem_ctx_t ctx) {
+  shmemc_context_h ch = (shmemc_context_h)ctx;
+  ucs_status_t s;
 
-/*
- * add
- */
+  if ((ctx == SHMEM_CTX_INVALID) || ch->attr.nostore) {
+    return 1;
+    /* NOT REACHED */
+  }
 
-void shmemc_ctx_add(shmem_ctx_t ctx, void *t, void *vp, size_t vs, int pe) {
-  shmemc_context_h ch = (shmemc_context_h)ctx;
+  if (stores_mixed(ch) || (ch->aggr != NULL) || ch->striped ||
+      (ch->lane_flushes > 0) || ch->qtest_posted ||
+      (ch->amo_ext_pending > 0)) {
+    return shmemc_ctx_quiet_test(ctx);
+    /* NOT REACHED */
+  }
 
-  helper_posted_amo(ch, UCP_ATOMIC_POST_OP_ADD, t, vp, vs, pe);
+  if (__atomic_load_n(&ch->pending_signals, __ATOMIC_ACQUIRE) > 0) {
+    (void)ucp_worker_progress(ch->w);
+    return 0;
+    /* NOT REACHED */
+  }
+
+  if (ch->mapped) {
+    LOAD_STORE_FENCE();
+  }
+
+  s = ucp_worker_fence(ch->w);
+  shmemu_assert(s == UCS_OK, MODULE ": %s() failed (status: %s)", __func__,
+                ucs_status_string(s));
+
+  return 1;
 }
 
+#endif /* ENABLE_EXPERIMENTAL */
+
 /*
- * inc = add 1
+ * -- loopback AMOs --
  */
 
+#ifdef HAVE_UCP_BITWISE_ATOMICS
+#define LOOPBACK_BITWISE_CASES(_t, _v)                                         \
+  case UCP_ATOMIC_FETCH_OP_FAND:                                               \
+    return __atomic_fetch_and(_t, _v, __ATOMIC_SEQ_CST);                       \
+  case UCP_ATOMIC_FETCH_OP_FOR:                                                \
+    return __atomic_fetch_or(_t, _v, __ATOMIC_SEQ_CST);                        \
+  case UCP_ATOMIC_FETCH_OP_FXOR:                                               \
+    return __atomic_fetch_xor(_t, _v, __ATOMIC_SEQ_CST);
+#else
+#define LOOPBACK_BITWISE_CASES(_t, _v)
+#endif /* HAVE_UCP_BITWISE_ATOMICS */
+
 /*
- * fetch-and-add
+ * same meaning as ucp_atomic_fetch_nb(): for CSWAP "v" is the
+ * comparand and "swap" the new value
  */
+#define LOOPBACK_FETCH_OP(_bits)                                               \
+  inline static uint##_bits##_t loopback_fetch_op##_bits(                      \
+      ucp_atomic_fetch_op_t op, uint##_bits##_t *t, uint##_bits##_t v,         \
+      uint##_bits##_t swap) {                                                  \
+    switch (op) {                                                              \
+    case UCP_ATOMIC_FETCH_OP_FADD:                                             \
+      return __atomic_fetch_add(t, v, __ATOMIC_SEQ_CST);                       \
+    case UCP_ATOMIC_FETCH_OP_SWAP:                                             \
+      return __atomic_exchange_n(t, v, __ATOMIC_SEQ_CST);                      \
+    case UCP_ATOMIC_FETCH_OP_CSWAP:                                            \
+      (void)__atomic_compare_exchange_n(t, &v, swap, false, __ATOMIC_SEQ_CST,  \
+                                        __ATOMIC_SEQ_CST);                     \
+      return v;                                                                \
+      LOOPBACK_BITWISE_CASES(t, v)                                             \
+    default:                                                                   \
+      shmemu_fatal(MODULE ": unknown loopback AMO %d", (int)op);               \
+      /* NOT REACHED */                                                        \
+      return 0;                                                                \
+    }                                                                          \
+  }
 
-void shmemc_ctx_fadd(shmem_ctx_t ctx, void *t, void *vp, size_t vs, int pe,
-                     void *retp) {
-  shmemc_context_h ch = (shmemc_context_h)ctx;
+LOOPBACK_FETCH_OP(32)
+LOOPBACK_FETCH_OP(64)
 
-  helper_fetching_amo(ch, UCP_ATOMIC_FETCH_OP_FADD, t, vp, vs, pe, retp);
+#define LOOPBACK_FETCHING_AMO(_bits, _op, _tp, _vp, _vs, _retp)                \
+  do {                                                                         \
+    uint##_bits##_t v, swap = 0, r;                                            \
+                                                                               \
+    memcpy(&v, _vp, _vs);                                                      \
+    if ((_op) == UCP_ATOMIC_FETCH_OP_CSWAP) {                                  \
+      memcpy(&swap, _retp, _vs); /* primed by caller */                        \
+    }                                                                          \
+    r = loopback_fetch_op##_bits(_op, (uint##_bits##_t *)(_tp), v, swap);      \
+    memcpy(_retp, &r, _vs);                                                    \
+  } while (0)
+
+static void loopback_fetching_amo(ucp_atomic_fetch_op_t op, void *t,
+                                  const void *vp, size_t vs, void *retp) {
+  if (vs == sizeof(uint32_t)) {
+    LOOPBACK_FETCHING_AMO(32, op, t, vp, vs, retp);
+  } else {
+    LOOPBACK_FETCHING_AMO(64, op, t, vp, vs, retp);
+  }
 }
 
-void shmemc_ctx_fadd_nbi(shmem_ctx_t ctx, void *t, void *vp, size_t vs, int pe,
-                         void *retp) {
-  helper_fetching_amo_nbi(ctx, UCP_ATOMIC_FETCH_OP_FADD, t, vp, vs, pe, retp);
+static void loopback_posted_amo(ucp_atomic_post_op_t uapo, void *t,
+                                const void *vp, size_t vs) {
+  ucp_atomic_fetch_op_t op;
+  uint64_t discard;
+
+  switch (uapo) {
+  case UCP_ATOMIC_POST_OP_ADD:
+    op = UCP_ATOMIC_FETCH_OP_FADD;
+    break;
+#ifdef HAVE_UCP_BITWISE_ATOMICS
+  case UCP_ATOMIC_POST_OP_AND:
+    op = UCP_ATOMIC_FETCH_OP_FAND;
+    break;
+  case UCP_ATOMIC_POST_OP_OR:
+    op = UCP_ATOMIC_FETCH_OP_FOR;
+    break;
+  case UCP_ATOMIC_POST_OP_XOR:
+    op = UCP_ATOMIC_FETCH_OP_FXOR;
+    break;
+#endif /* HAVE_UCP_BITWISE_ATOMICS */
+  default:
+    shmemu_fatal(MODULE ": unknown loopback AMO %d", (int)uapo);
+    /* NOT REACHED */
+    return;
+  }
+
+  loopback_fetching_amo(op, t, vp, vs, &discard);
 }
 
 /*
- * fetch-and-inc: finc = fadd 1
+ * An AMO to ourself that did go through UCX has to land before any
+ * later direct store to our memory can.
  */
+inline static void loopback_order(shmemc_context_h ch, int pe) {
+  if (loopback_rma(pe)) {
+    const ucs_status_t s = check_wait_for_request(ch, post_ep_flush(ch, pe));
+
+    shmemu_assert(s == UCS_OK, MODULE ": can't complete AMO to self "
+                               "(status: %s)",
+                  ucs_status_string(s));
+  }
+}
 
 /*
- * swaps
+ * UCX AMOs
+ *
+ * With ucp_atomic_op_nbx() non-fetching AMOs don't need a request:
+ * any we get back is handed straight back to UCX, and completion is
+ * left to the next flush, as ucp_atomic_post() did.  Fetching AMOs
+ * return the old value into the reply buffer (primed with the new
+ * value for CSWAP, the operand being the comparand).
  */
 
-void shmemc_ctx_swap(shmem_ctx_t ctx, void *t, void *vp, size_t vs, int pe,
-                     void *retp) {
-  shmemc_context_h ch = (shmemc_context_h)ctx;
-  ucs_status_t s;
+#ifdef HAVE_UCP_ATOMIC_OP_NBX
 
-  s = helper_fetching_amo(ch, UCP_ATOMIC_FETCH_OP_SWAP, t, vp, vs, pe, retp);
+typedef ucp_send_nbx_callback_t amo_callback_t;
+#define AMO_NOOP_CALLBACK noop_callbackx
+#define AMO_NB_CALLBACK nb_callbackx
 
-  shmemu_assert(s == UCS_OK, MODULE ": AMO swap failed (status: %s)",
-                ucs_status_string(s));
+inline static ucp_atomic_op_t amo_post_op(ucp_atomic_post_op_t uapo) {
+  switch (uapo) {
+  case UCP_ATOMIC_POST_OP_ADD:
+    return UCP_ATOMIC_OP_ADD;
+#ifdef HAVE_UCP_BITWISE_ATOMICS
+  case UCP_ATOMIC_POST_OP_AND:
+    return UCP_ATOMIC_OP_AND;
+  case UCP_ATOMIC_POST_OP_OR:
+    return UCP_ATOMIC_OP_OR;
+  case UCP_ATOMIC_POST_OP_XOR:
+    return UCP_ATOMIC_OP_XOR;
+#endif /* HAVE_UCP_BITWISE_ATOMICS */
+  default:
+    shmemu_fatal(MODULE ": unknown AMO post op %d", (int)uapo);
+    /* NOT REACHED */
+    return UCP_ATOMIC_OP_LAST;
+  }
 }
 
-void shmemc_ctx_cswap(shmem_ctx_t ctx, void *t, void *c, void *vp, size_t vs,
-                      int pe, void *retp) {
-  shmemc_context_h ch = (shmemc_context_h)ctx;
+inline static ucp_atomic_op_t amo_fetch_op(ucp_atomic_fetch_op_t op) {
+  switch (op) {
+  case UCP_ATOMIC_FETCH_OP_FADD:
+    return UCP_ATOMIC_OP_ADD;
+  case UCP_ATOMIC_FETCH_OP_SWAP:
+    return UCP_ATOMIC_OP_SWAP;
+  case UCP_ATOMIC_FETCH_OP_CSWAP:
+    return UCP_ATOMIC_OP_CSWAP;
+#ifdef HAVE_UCP_BITWISE_ATOMICS
+  case UCP_ATOMIC_FETCH_OP_FAND:
+    return UCP_ATOMIC_OP_AND;
+  case UCP_ATOMIC_FETCH_OP_FOR:
+    return UCP_ATOMIC_OP_OR;
+  case UCP_ATOMIC_FETCH_OP_FXOR:
+    return UCP_ATOMIC_OP_XOR;
+#endif /* HAVE_UCP_BITWISE_ATOMICS */
+  default:
+    shmemu_fatal(MODULE ": unknown AMO fetch op %d", (int)op);
+    /* NOT REACHED */
+    return UCP_ATOMIC_OP_LAST;
+  }
+}
+
+static ucs_status_t ucx_post_amo(ucp_ep_h ep, ucp_atomic_post_op_t uapo,
+                                 uint64_t val, size_t vs, uint64_t r_t,
+                                 ucp_rkey_h r_key) {
+  const ucp_request_param_t prm = {.op_attr_mask =
+                                       UCP_OP_ATTR_FIELD_DATATYPE,
+                                   .datatype = ucp_dt_make_contig(vs)};
+  ucs_status_ptr_t sp;
+
+  /* low-order bytes, and the operand is copied before we return */
+  sp = ucp_atomic_op_nbx(ep, amo_post_op(uapo), &val, 1, r_t, r_key, &prm);
+  if (UCS_PTR_IS_ERR(sp)) {
+    return UCS_PTR_STATUS(sp);
+    /* NOT REACHED */
+  }
+  if (sp != NULL) {
+    ucp_request_free(sp);
+  }
+
+  return UCS_OK;
+}
+
+inline static ucs_status_ptr_t ucx_fetch_amo(ucp_ep_h ep,
+                                             ucp_atomic_fetch_op_t op,
+                                             const void *vp, size_t vs,
+                                             uint64_t r_t, ucp_rkey_h r_key,
+                                             void *retp, amo_callback_t cb) {
+  const ucp_request_param_t prm = {
+      .op_attr_mask = UCP_OP_ATTR_FIELD_CALLBACK | UCP_OP_ATTR_FIELD_DATATYPE |
+                      UCP_OP_ATTR_FIELD_REPLY_BUFFER,
+      .cb.send = cb,
+      .datatype = ucp_dt_make_contig(vs),
+      .reply_buffer = retp};
+
+  return ucp_atomic_op_nbx(ep, amo_fetch_op(op), vp, 1, r_t, r_key, &prm);
+}
+
+#else /* ! HAVE_UCP_ATOMIC_OP_NBX */
+
+typedef ucp_send_callback_t amo_callback_t;
+#define AMO_NOOP_CALLBACK noop_callback
+#define AMO_NB_CALLBACK nb_callback
+
+inline static ucs_status_t ucx_post_amo(ucp_ep_h ep,
+                                        ucp_atomic_post_op_t uapo,
+                                        uint64_t val, size_t vs, uint64_t r_t,
+                                        ucp_rkey_h r_key) {
+  return ucp_atomic_post(ep, uapo, val, vs, r_t, r_key);
+}
+
+inline static ucs_status_ptr_t ucx_fetch_amo(ucp_ep_h ep,
+                                             ucp_atomic_fetch_op_t op,
+                                             const void *vp, size_t vs,
+                                             uint64_t r_t, ucp_rkey_h r_key,
+                                             void *retp, amo_callback_t cb) {
+  uint64_t rv = 0;
+
+  memcpy(&rv, vp, vs);
+
+  return ucp_atomic_fetch_nb(ep, op, rv, retp, vs, r_t, r_key, cb);
+}
+
+#endif /* HAVE_UCP_ATOMIC_OP_NBX */
+
+/*
+ * also used to apply aggregated AMOs that arrive here
+ */
+
+ucs_status_t shmemc_ucx_post_amo(shmemc_context_h ch, ucp_atomic_post_op_t uapo,
+                                 void *t, uint64_t val, size_t vs, int pe) {
+  uint64_t r_t;
+  ucp_rkey_h r_key;
+
+  get_remote_key_and_addr(ch, (uint64_t)t, pe, &r_key, &r_t);
+
+  return ucx_post_amo(lookup_ucp_ep(ch, pe), uapo, val, vs, r_t, r_key);
+}
+
+static ucs_status_t helper_posted_amo(shmemc_context_h ch,
+                                      ucp_atomic_post_op_t uapo, void *t,
+                                      void *vp, size_t vs, int pe) {
+  uint64_t rv = *(uint64_t *)vp;
   ucs_status_t s;
 
-  memcpy(retp, vp, vs); /* prime the value */
+  if (loopback_amo(pe)) {
+    loopback_posted_amo(uapo, t, vp, vs);
+    return UCS_OK;
+    /* NOT REACHED */
+  }
 
-  s = helper_fetching_amo(ch, UCP_ATOMIC_FETCH_OP_CSWAP, t, c, vs, pe, retp);
+  if (ch->aggr != NULL) {
+    uint64_t r_t;
+    ucp_rkey_h r_key;
 
-  shmemu_assert(s == UCS_OK,
-                MODULE ": AMO conditional swap failed (status: %s)",
-                ucs_status_string(s));
+    get_remote_key_and_addr(ch, (uint64_t)t, pe, &r_key, &r_t);
+
+    if (shmemc_ucx_aggr_amo(ch, uapo, r_t, rv, vs, pe)) {
+      return UCS_OK;
+      /* NOT REACHED */
+    }
+  }
+
+  s = shmemc_ucx_post_amo(ch, uapo, t, rv, vs, pe);
+  loopback_order(ch, pe);
+
+  return s;
 }
 
-void shmemc_ctx_swap_nbi(shmem_ctx_t ctx, void *t, void *vp, size_t vs, int pe,
-                         void *retp) {
-  shmemc_context_h ch = (shmemc_context_h)ctx;
+/*
+ * fetching AMOs: target t, (optional) condition c, value v
+ */
+
+inline static ucs_status_ptr_t
+helper_fetching_amo_internal(shmemc_context_h ch, ucp_atomic_fetch_op_t op,
+                             void *t, void *vp, size_t vs, int pe, void *retp,
+                             amo_callback_t cb) {
+  ucp_rkey_h r_key;
+  uint64_t r_t;
+
+  if (loopback_amo(pe)) {
+    loopback_fetching_amo(op, t, vp, vs, retp);
+    return NULL;
+    /* NOT REACHED */
+  }
+
+  get_remote_key_and_addr(ch, (uint64_t)t, pe, &r_key, &r_t);
+
+  return ucx_fetch_amo(lookup_ucp_ep(ch, pe), op, vp, vs, r_t, r_key, retp,
+                       cb);
+}
+
+static ucs_status_t helper_fetching_amo(shmemc_context_h ch,
+                                        ucp_atomic_fetch_op_t op, void *t,
+                                        void *vp, size_t vs, int pe,
+                                        void *retp) {
   ucs_status_ptr_t sp;
 
-  sp = helper_fetching_amo_nbi(ch, UCP_ATOMIC_FETCH_OP_SWAP, t, vp, vs, pe,
-                               retp);
+  sp = helper_fetching_amo_internal(ch, op, t, vp, vs, pe, retp,
+                                    AMO_NOOP_CALLBACK);
 
-  shmemu_assert(!UCS_PTR_IS_ERR(sp), MODULE ": AMO nbi swap failed");
+  return check_wait_for_request(ch, sp);
 }
 
-void shmemc_ctx_cswap_nbi(shmem_ctx_t ctx, void *t, void *c, void *vp,
-                          size_t vs, int pe, void *retp) {
-  shmemc_context_h ch = (shmemc_context_h)ctx;
+static ucs_status_ptr_t helper_fetching_amo_nbi(shmemc_context_h ch,
+                                                ucp_atomic_fetch_op_t op,
+                                                void *t, void *vp, size_t vs,
+                                                int pe, void *retp) {
   ucs_status_ptr_t sp;
 
-  memcpy(retp, vp, vs); /* prime the value */
+  sp = helper_fetching_amo_internal(ch, op, t, vp, vs, pe, retp,
+                                    AMO_NB_CALLBACK);
+  if (sp != NULL) {
+    loopback_order(ch, pe);
+  }
 
-  sp = helper_fetching_amo_nbi(ch, UCP_ATOMIC_FETCH_OP_CSWAP, t, c, vs, pe,
-                               retp);
+  return sp;
+}
 
-  shmemu_assert(!UCS_PTR_IS_ERR(sp),
-                MODULE ": AMO nbi conditional swap failed");
+/**
+ * API
+ *
+ **/
+
+/*
+ * make progress on a context
+ */
+
+inline static unsigned helper_ctx_progress(shmem_ctx_t ctx) {
+  shmemc_context_h ch = (shmemc_context_h)ctx;
+  unsigned n;
+
+  shmemc_ucx_aggr_progress(ch);
+
+  n = ucp_worker_progress(ch->w);
+
+  if (ch->striped || (ch->lane_flushes > 0)) {
+    shmemc_ucx_stripe_progress();
+  }
+
+  return n;
+}
+
+void shmemc_ctx_progress(shmem_ctx_t ctx) { (void)helper_ctx_progress(ctx); }
+
+unsigned shmemc_ctx_progress_count(shmem_ctx_t ctx) {
+  return helper_ctx_progress(ctx);
+}
+
+void shmemc_progress(void) {
+  (void)helper_ctx_progress(SHMEM_CTX_DEFAULT);
 }
 
 /*
- * fetch handled via typed-0-swap
+ * -- accessible memory pointers -----------------------------------------
  */
 
 /*
- * bitwise helpers
- *
- * Newer versions of UCX now have native support for bitwise atomics:
- * we detect this during configure.
- *
+ * See if addr is reachable using given context.  Return usable
+ * address if so, otherwise NULL.
  */
 
-#ifdef HAVE_UCP_BITWISE_ATOMICS
+inline static void *ctx_ptr_self_check(const void *addr) {
+  /* is it remotely accessible? */
+  if (lookup_region((uint64_t)addr) >= 0) {
+    return (void *)addr;
+  } else {
+    return NULL;
+  }
+}
 
-#define MAKE_UCP_FETCH_OP(_op) UCP_ATOMIC_FETCH_OP_F##_op
-#define MAKE_UCP_POST_OP(_op) UCP_ATOMIC_POST_OP_##_op
+inline static void *ctx_ptr_remote_check(shmem_ctx_t ctx, const void *addr,
+                                         int pe) {
+  shmemc_context_h ch = (shmemc_context_h)ctx;
+  uint64_t r_addr;  /* address on other PE */
+  ucp_rkey_h r_key; /* rkey for remote address */
+  void *usable_addr = get_mapped_addr(ch, (uint64_t)addr, pe);
+  ucs_status_t s;
 
-#define HELPER_BITWISE_FETCH_ATOMIC(_ucp_op, _opname)                          \
-  inline static void helper_atomic_fetch_##_opname(                            \
-      shmemc_context_h ch, void *t, void *vp, size_t vs, int pe, void *retp) { \
-    const ucs_status_t s = helper_fetching_amo(ch, MAKE_UCP_FETCH_OP(_ucp_op), \
-                                               t, vp, vs, pe, retp);           \
-                                                                               \
-    /* value came back? */                                                     \
-    shmemu_assert(s == UCS_OK,                                                 \
-                  MODULE ": AMO fetch op \"%s\" failed (status: %s)",          \
-                  #_opname, ucs_status_string(s));                             \
+  if (usable_addr != NULL) {
+    return usable_addr;
+    /* NOT REACHED */
   }
 
-HELPER_BITWISE_FETCH_ATOMIC(AND, and)
-HELPER_BITWISE_FETCH_ATOMIC(OR, or)
-HELPER_BITWISE_FETCH_ATOMIC(XOR, xor)
+  get_remote_key_and_addr(ch, (uint64_t)addr, pe, &r_key, &r_addr);
+
+  s = ucp_rkey_ptr(r_key, r_addr, &usable_addr);
+  if (s == UCS_OK) {
+    return usable_addr;
+  } else {
+    return NULL;
+  }
+}
+
+void *shmemc_ctx_ptr(shmem_ctx_t ctx, const void *addr, int pe) {
+  /* self short-circuit */
+  if (shmemu_unlikely(pe == proc.li.rank)) {
+    return ctx_ptr_self_check(addr);
+    /* NOT REACHED */
+  }
+
+  /* if UCX has check routine, do a full test, otherwise give up */
+#ifdef HAVE_UCP_RKEY_PTR
+  return ctx_ptr_remote_check(ctx, addr, pe);
+#else
+  return NULL;
+#endif /* HAVE_UCP_RKEY_PTR */
+}
+
+/*
+ * Symmetric address on PE "pe" corresponding to local "addr", or NULL
+ * if "addr" isn't symmetric.
+ */
+void *shmemc_ctx_lookup_remote_addr(shmem_ctx_t ctx, const void *addr,
+                                    int pe) {
+  shmemc_context_h ch = (shmemc_context_h)ctx;
+  const uint64_t uaddr = (uint64_t)addr;
+  const mem_interval_t *ip = ch->hot;
+
+  if (shmemu_unlikely(!in_interval(ip, uaddr))) {
+    ip = lookup_interval(uaddr);
+    if (ip == NULL) {
+      return NULL;
+      /* NOT REACHED */
+    }
+    ch->hot = ip;
+  }
+
+  return (void *)(uaddr + ch->racc[ip->region].rinfo[pe].delta);
+}
+
+/*
+ * Return non-zero if adddress is remotely accessible, 0 otherwise.
+ *
+ */
+int shmemc_addr_accessible(const void *addr, int pe) {
+  uint64_t uaddr = (uint64_t)addr;
+
+  NO_WARN_UNUSED(pe); /* if aligned addresses */
+
+  return translate_address(uaddr, pe) > 0;
+}
+
+/*
+ * Return non-zero if a valid PE #, 0 otherwise.
+ *
+ * N.B. this function was originally meant to test which ranks were
+ * SHMEM in mixed SHMEM/MPI programs.  Here we just check the rank
+ * number is valid and assume reachability, although might want to
+ * revisit for FT/resilience purposes.
+ */
+int shmemc_pe_accessible(int pe) { return shmemu_valid_pe_number(pe); }
+
+/*
+ * -- atomics ------------------------------------------------------------
+ */
+
+/**
+ * AMO API
+ **/
+
+/*
+ * add
+ */
+
+void shmemc_ctx_add(shmem_ctx_t ctx, void *t, void *vp, size_t vs, int pe) {
+  shmemc_context_h ch = (shmemc_context_h)ctx;
+
+  helper_posted_amo(ch, UCP_ATOMIC_POST_OP_ADD, t, vp, vs, pe);
+}
+
+/*
+ * inc = add 1
+ */
+
+/*
+ * fetch-and-add
+ */
+
+void shmemc_ctx_fadd(shmem_ctx_t ctx, void *t, void *vp, size_t vs, int pe,
+                     void *retp) {
+  shmemc_context_h ch = (shmemc_context_h)ctx;
+
+  helper_fetching_amo(ch, UCP_ATOMIC_FETCH_OP_FADD, t, vp, vs, pe, retp);
+}
+
+void shmemc_ctx_fadd_nbi(shmem_ctx_t ctx, void *t, void *vp, size_t vs, int pe,
+                         void *retp) {
+  helper_fetching_amo_nbi(ctx, UCP_ATOMIC_FETCH_OP_FADD, t, vp, vs, pe, retp);
+}
+
+/*
+ * fetch-and-inc: finc = fadd 1
+ */
+
+/*
+ * swaps
+ */
+
+void shmemc_ctx_swap(shmem_ctx_t ctx, void *t, void *vp, size_t vs, int pe,
+                     void *retp) {
+  shmemc_context_h ch = (shmemc_context_h)ctx;
+  ucs_status_t s;
+
+  s = helper_fetching_amo(ch, UCP_ATOMIC_FETCH_OP_SWAP, t, vp, vs, pe, retp);
+
+  shmemu_assert(s == UCS_OK, MODULE ": AMO swap failed (status: %s)",
+                ucs_status_string(s));
+}
+
+void shmemc_ctx_cswap(shmem_ctx_t ctx, void *t, void *c, void *vp, size_t vs,
+                      int pe, void *retp) {
+  shmemc_context_h ch = (shmemc_context_h)ctx;
+  ucs_status_t s;
+
+  memcpy(retp, vp, vs); /* prime the value */
+
+  s = helper_fetching_amo(ch, UCP_ATOMIC_FETCH_OP_CSWAP, t, c, vs, pe, retp);
+
+  shmemu_assert(s == UCS_OK,
+                MODULE ": AMO conditional swap failed (status: %s)",
+                ucs_status_string(s));
+}
+
+void shmemc_ctx_swap_nbi(shmem_ctx_t ctx, void *t, void *vp, size_t vs, int pe,
+                         void *retp) {
+  shmemc_context_h ch = (shmemc_context_h)ctx;
+  ucs_status_ptr_t sp;
+
+  sp = helper_fetching_amo_nbi(ch, UCP_ATOMIC_FETCH_OP_SWAP, t, vp, vs, pe,
+                               retp);
+
+  shmemu_assert(!UCS_PTR_IS_ERR(sp), MODULE ": AMO nbi swap failed");
+}
+
+void shmemc_ctx_cswap_nbi(shmem_ctx_t ctx, void *t, void *c, void *vp,
+                          size_t vs, int pe, void *retp) {
+  shmemc_context_h ch = (shmemc_context_h)ctx;
+  ucs_status_ptr_t sp;
+
+  memcpy(retp, vp, vs); /* prime the value */
+
+  sp = helper_fetching_amo_nbi(ch, UCP_ATOMIC_FETCH_OP_CSWAP, t, c, vs, pe,
+                               retp);
+
+  shmemu_assert(!UCS_PTR_IS_ERR(sp),
+                MODULE ": AMO nbi conditional swap failed");
+}
+
+/*
+ * batched adds: post them all, then wait once
+ */
+
+#ifdef HAVE_UCP_ATOMIC_OP_NBX
+
+static void helper_add_v(shmemc_context_h ch, void *const *ts,
+                         const void *vals, size_t vs, const int *pes, size_t n,
+                         void *fetches) {
+  ucp_request_param_t prm = {.op_attr_mask = UCP_OP_ATTR_FIELD_CALLBACK |
+                                             UCP_OP_ATTR_FIELD_DATATYPE,
+                             .datatype = ucp_dt_make_contig(vs)};
+  uint64_t done = 0; /* fetches that came back */
+  uint64_t posted = 0;
+  int self = 0;
+  size_t i;
+
+  if (fetches != NULL) {
+    prm.op_attr_mask |= UCP_OP_ATTR_FIELD_USER_DATA |
+                        UCP_OP_ATTR_FIELD_REPLY_BUFFER;
+    prm.cb.send = counter_callbackx;
+    prm.user_data = &done;
+  } else {
+    prm.cb.send = nb_callbackx;
+  }
+
+  for (i = 0; i < n; ++i) {
+    const int pe = pes[i];
+    const char *vp = (const char *)vals + (i * vs);
+    char *retp = (fetches != NULL) ? (char *)fetches + (i * vs) : NULL;
+    uint64_t r_t;
+    ucp_rkey_h r_key;
+    ucs_status_ptr_t sp;
+
+    if (loopback_amo(pe)) {
+      uint64_t discard;
+
+      loopback_fetching_amo(UCP_ATOMIC_FETCH_OP_FADD, ts[i], vp, vs,
+                            (retp != NULL) ? (void *)retp : &discard);
+      continue;
+    }
+
+    get_remote_key_and_addr(ch, (uint64_t)ts[i], pe, &r_key, &r_t);
+
+    if (retp == NULL) {
+      uint64_t rv = 0;
+
+      memcpy(&rv, vp, vs);
+      if ((ch->aggr != NULL) &&
+          shmemc_ucx_aggr_amo(ch, UCP_ATOMIC_POST_OP_ADD, r_t, rv, vs, pe)) {
+        continue;
+      }
+    } else {
+      prm.reply_buffer = retp;
+    }
+
+    sp = ucp_atomic_op_nbx(lookup_ucp_ep(ch, pe), UCP_ATOMIC_OP_ADD, vp, 1,
+                           r_t, r_key, &prm);
+    shmemu_assert(!UCS_PTR_IS_ERR(sp),
+                  MODULE ": batched AMO to PE %d failed (status: %s)", pe,
+                  ucs_status_string(UCS_PTR_STATUS(sp)));
+
+    if ((sp != NULL) && (retp != NULL)) {
+      ++posted;
+    }
+    if (pe == proc.li.rank) {
+      self = 1;
+    }
+  }
+
+  while (__atomic_load_n(&done, __ATOMIC_ACQUIRE) < posted) {
+    (void)ucp_worker_progress(ch->w);
+  }
+
+  if (self) {
+    loopback_order(ch, proc.li.rank);
+  }
+}
+
+#else /* ! HAVE_UCP_ATOMIC_OP_NBX */
+
+static void helper_add_v(shmemc_context_h ch, void *const *ts,
+                         const void *vals, size_t vs, const int *pes, size_t n,
+                         void *fetches) {
+  ucs_status_ptr_t *reqs;
+  size_t i;
+
+  if (fetches == NULL) {
+    for (i = 0; i < n; ++i) {
+      uint64_t v = 0;
+
+      memcpy(&v, (const char *)vals + (i * vs), vs);
+      helper_posted_amo(ch, UCP_ATOMIC_POST_OP_ADD, ts[i], &v, vs, pes[i]);
+    }
+    return;
+    /* NOT REACHED */
+  }
+
+  reqs = (ucs_status_ptr_t *)malloc(n * sizeof(*reqs));
+  shmemu_assert(reqs != NULL,
+                MODULE ": can't allocate requests for %lu batched AMOs",
+                (unsigned long)n);
+
+  for (i = 0; i < n; ++i) {
+    uint64_t v = 0; /* read as 64 bits */
+
+    memcpy(&v, (const char *)vals + (i * vs), vs);
+    reqs[i] = helper_fetching_amo_internal(ch, UCP_ATOMIC_FETCH_OP_FADD, ts[i],
+                                           &v, vs, pes[i],
+                                           (char *)fetches + (i * vs),
+                                           AMO_NOOP_CALLBACK);
+  }
+
+  for (i = 0; i < n; ++i) {
+    const ucs_status_t s = check_wait_for_request(ch, reqs[i]);
+
+    shmemu_assert(s == UCS_OK,
+                  MODULE ": batched AMO to PE %d failed (status: %s)", pes[i],
+                  ucs_status_string(s));
+  }
+
+  free(reqs);
+}
+
+#endif /* HAVE_UCP_ATOMIC_OP_NBX */
+
+void shmemc_ctx_add_v(shmem_ctx_t ctx, void *const *ts, const void *vals,
+                      size_t vs, const int *pes, size_t n) {
+  helper_add_v((shmemc_context_h)ctx, ts, vals, vs, pes, n, NULL);
+}
+
+void shmemc_ctx_fadd_v(shmem_ctx_t ctx, void *const *ts, const void *vals,
+                       size_t vs, const int *pes, size_t n, void *fetches) {
+  helper_add_v((shmemc_context_h)ctx, ts, vals, vs, pes, n, fetches);
+}
+
+/*
+ * fetch handled via typed-0-swap
+ */
+
+/*
+ * extended AMOs
+ *
+ * Anything UCX can't do itself.  With active messages, the target
+ * applies the operation and replies with the old value, one round
+ * trip however contended the location.  Otherwise, emulate with a
+ * compare-and-swap loop through UCX (not possible for 128 bits).
+ */
+
+inline static int ext_amo_via_am(size_t vs) {
+#ifdef SHMEMC_UCX_AMO_EXT_AM
+  return (vs > sizeof(uint64_t)) || proc.env.amo_ext_am;
+#else
+  NO_WARN_UNUSED(vs);
+
+  return 0;
+#endif /* SHMEMC_UCX_AMO_EXT_AM */
+}
+
+static void ext_amo_cas_loop(shmemc_context_h ch, shmemc_amo_ext_op_t op,
+                             shmemc_amo_ext_type_t type, void *t,
+                             const void *vp, size_t vs, int pe, void *retp) {
+  const uint64_t mask =
+      (vs == sizeof(uint64_t)) ? ~(uint64_t)0 : (((uint64_t)1 << (vs * 8)) - 1);
+  uint64_t v = 0, old = 0, seen, zero = 0;
+  ucs_status_t s;
+
+  memcpy(&v, vp, vs);
+
+  s = helper_fetching_amo(ch, UCP_ATOMIC_FETCH_OP_FADD, t, &zero, vs, pe,
+                          &old);
+  shmemu_assert(s == UCS_OK, MODULE ": AMO fetch failed in CAS (status: %s)",
+                ucs_status_string(s));
+
+  for (;;) {
+    /* prime with the new value */
+    seen = shmemc_ucx_amo_ext_combine(op, type, old, v, vs);
+
+    s = helper_fetching_amo(ch, UCP_ATOMIC_FETCH_OP_CSWAP, t, &old, vs, pe,
+                            &seen);
+    shmemu_assert(s == UCS_OK, MODULE ": AMO CAS failed (status: %s)",
+                  ucs_status_string(s));
+
+    if ((seen & mask) == old) {
+      break;
+      /* NOT REACHED */
+    }
+    old = seen & mask;
+  }
+
+  if (retp != NULL) {
+    memcpy(retp, &old, vs);
+  }
+}
+
+static void helper_ext_amo(shmemc_context_h ch, shmemc_amo_ext_op_t op,
+                           shmemc_amo_ext_type_t type, void *t, const void *vp,
+                           const void *cp, size_t vs, int pe, void *retp) {
+  const int via_am = ext_amo_via_am(vs);
+
+  /* the target would only do it with CPU atomics anyway */
+  if ((pe == proc.li.rank) &&
+      (via_am || loopback_amo(pe) || (vs > sizeof(uint64_t)))) {
+    shmemc_ucx_amo_ext_apply(op, type, t, vp, cp, vs, retp);
+    return;
+    /* NOT REACHED */
+  }
+
+  if (via_am) {
+    uint64_t r_t;
+    ucp_rkey_h r_key;
+
+    get_remote_key_and_addr(ch, (uint64_t)t, pe, &r_key, &r_t);
+
+    shmemc_ucx_amo_ext_post(ch, op, type, r_t, vp, cp, vs, pe, retp,
+                            retp != NULL);
+    return;
+    /* NOT REACHED */
+  }
+
+  if (vs > sizeof(uint64_t)) {
+    shmemu_fatal(MODULE ": %lu-byte AMO on PE %d needs UCX active messages",
+                 (unsigned long)vs, pe);
+    /* NOT REACHED */
+  }
+
+  ext_amo_cas_loop(ch, op, type, t, vp, vs, pe, retp);
+}
+
+void shmemc_ctx_amo_ext(shmem_ctx_t ctx, shmemc_amo_ext_op_t op,
+                        shmemc_amo_ext_type_t type, void *t, const void *vp,
+                        const void *cp, size_t vs, int pe, void *retp) {
+  shmemc_context_h ch = (shmemc_context_h)ctx;
+
+  helper_ext_amo(ch, op, type, t, vp, cp, vs, pe, retp);
+}
+
+/*
+ * bitwise helpers
+ *
+ * Newer versions of UCX now have native support for bitwise atomics:
+ * we detect this during configure.
+ *
+ */
+
+#ifdef HAVE_UCP_BITWISE_ATOMICS
+
+#define MAKE_UCP_FETCH_OP(_op) UCP_ATOMIC_FETCH_OP_F##_op
+#define MAKE_UCP_POST_OP(_op) UCP_ATOMIC_POST_OP_##_op
+
+#define HELPER_BITWISE_FETCH_ATOMIC(_ucp_op, _opname)                          \
+  inline static void helper_atomic_fetch_##_opname(                            \
+      shmemc_context_h ch, void *t, void *vp, size_t vs, int pe, void *retp) { \
+    const ucs_status_t s = helper_fetching_amo(ch, MAKE_UCP_FETCH_OP(_ucp_op), \
+                                               t, vp, vs, pe, retp);           \
+                                                                               \
+    /* value came back? */                                                     \
+    shmemu_assert(s == UCS_OK,                                                 \
+                  MODULE ": AMO fetch op \"%s\" failed (status: %s)",          \
+                  #_opname, ucs_status_string(s));                             \
+  }
+
+HELPER_BITWISE_FETCH_ATOMIC(AND, and)
+HELPER_BITWISE_FETCH_ATOMIC(OR, or)
+HELPER_BITWISE_FETCH_ATOMIC(XOR, xor)
+
+#define HELPER_BITWISE_FETCH_ATOMIC_NBI(_ucp_op, _opname)                      \
+  inline static void helper_atomic_fetch_##_opname##_nbi(                      \
+      shmemc_context_h ch, void *t, void *vp, size_t vs, int pe, void *retp) { \
+    const ucs_status_ptr_t sp = helper_fetching_amo_nbi(                       \
+        ch, MAKE_UCP_FETCH_OP(_ucp_op), t, vp, vs, pe, retp);                  \
+                                                                               \
+    shmemu_assert(!UCS_PTR_IS_ERR(sp),                                         \
+                  MODULE ": AMO fetch nbi op \"%s\" failed", #_opname);        \
+  }
+
+HELPER_BITWISE_FETCH_ATOMIC_NBI(AND, and)
+HELPER_BITWISE_FETCH_ATOMIC_NBI(OR, or)
+HELPER_BITWISE_FETCH_ATOMIC_NBI(XOR, xor)
+
+#define HELPER_BITWISE_ATOMIC(_ucp_op, _opname)                                \
+  inline static void helper_atomic_##_opname(shmemc_context_h ch, void *t,     \
+                                             void *vp, size_t vs, int pe) {    \
+    const ucs_status_t s =                                                     \
+        helper_posted_amo(ch, MAKE_UCP_POST_OP(_ucp_op), t, vp, vs, pe);       \
+                                                                               \
+    shmemu_assert(s == UCS_OK,                                                 \
+                  MODULE ": AMO post op \"%s\" failed (status: %s)", #_opname, \
+                  ucs_status_string(s));                                       \
+  }
+
+HELPER_BITWISE_ATOMIC(AND, and)
+HELPER_BITWISE_ATOMIC(OR, or)
+HELPER_BITWISE_ATOMIC(XOR, xor)
+
+#else /* ! HAVE_UCP_BITWISE_ATOMICS */
+
+/*
+ * no native support, so have the target do them
+ */
+
+#define HELPER_BITWISE_FETCH_ATOMIC(_ext_op, _opname)                          \
+  inline static void helper_atomic_fetch_##_opname(                            \
+      shmemc_context_h ch, void *t, void *vp, size_t vs, int pe, void *retp) { \
+    helper_ext_amo(ch, SHMEMC_AMO_EXT_##_ext_op, SHMEMC_AMO_EXT_UINT, t, vp,   \
+                   NULL, vs, pe, retp);                                        \
+  }
+
+HELPER_BITWISE_FETCH_ATOMIC(AND, and)
+HELPER_BITWISE_FETCH_ATOMIC(OR, or)
+HELPER_BITWISE_FETCH_ATOMIC(XOR, xor)
+
+/*
+ * value only has to be there by the next quiet
+ */
+
+#define HELPER_BITWISE_FETCH_ATOMIC_NBI(_ext_op, _opname)                      \
+  inline static void helper_atomic_fetch_##_opname##_nbi(                      \
+      shmemc_context_h ch, void *t, void *vp, size_t vs, int pe, void *retp) { \
+    if (ext_amo_via_am(vs) && (pe != proc.li.rank)) {                          \
+      uint64_t r_t;                                                            \
+      ucp_rkey_h r_key;                                                        \
+                                                                               \
+      get_remote_key_and_addr(ch, (uint64_t)t, pe, &r_key, &r_t);              \
+      shmemc_ucx_amo_ext_post(ch, SHMEMC_AMO_EXT_##_ext_op,                    \
+                              SHMEMC_AMO_EXT_UINT, r_t, vp, NULL, vs, pe,      \
+                              retp, 0);                                        \
+    } else {                                                                   \
+      helper_atomic_fetch_##_opname(ch, t, vp, vs, pe, retp);                  \
+    }                                                                          \
+  }
+
+HELPER_BITWISE_FETCH_ATOMIC_NBI(AND, and)
+HELPER_BITWISE_FETCH_ATOMIC_NBI(OR, or)
+HELPER_BITWISE_FETCH_ATOMIC_NBI(XOR, xor)
+
+#define HELPER_BITWISE_ATOMIC(_ext_op, _opname)                                \
+  inline static void helper_atomic_##_opname(shmemc_context_h ch, void *t,     \
+                                             void *vp, size_t vs, int pe) {    \
+    helper_ext_amo(ch, SHMEMC_AMO_EXT_##_ext_op, SHMEMC_AMO_EXT_UINT, t, vp,   \
+                   NULL, vs, pe, NULL);                                        \
+  }
+
+HELPER_BITWISE_ATOMIC(AND, and)
+HELPER_BITWISE_ATOMIC(OR, or)
+HELPER_BITWISE_ATOMIC(XOR, xor)
+
+#endif /* HAVE_UCP_BITWISE_ATOMICS */
+
+/*
+ * fetched-bitwise
+ */
+
+#define SHMEMC_CTX_FETCH_BITWISE(_op)                                          \
+  void shmemc_ctx_fetch_##_op(shmem_ctx_t ctx, void *t, void *vp, size_t vs,   \
+                              int pe, void *retp) {                            \
+    shmemc_context_h ch = (shmemc_context_h)ctx;                               \
+                                                                               \
+    helper_atomic_fetch_##_op(ch, t, vp, vs, pe, retp);                        \
+  }
+
+SHMEMC_CTX_FETCH_BITWISE(and)
+SHMEMC_CTX_FETCH_BITWISE(or)
+SHMEMC_CTX_FETCH_BITWISE(xor)
+
+#define SHMEMC_CTX_FETCH_BITWISE_NBI(_op)                                      \
+  void shmemc_ctx_fetch_##_op##_nbi(shmem_ctx_t ctx, void *t, void *vp,        \
+                                    size_t vs, int pe, void *retp) {           \
+    shmemc_context_h ch = (shmemc_context_h)ctx;                               \
+                                                                               \
+    helper_atomic_fetch_##_op##_nbi(ch, t, vp, vs, pe, retp);                  \
+  }
+
+SHMEMC_CTX_FETCH_BITWISE_NBI(and)
+SHMEMC_CTX_FETCH_BITWISE_NBI(or)
+SHMEMC_CTX_FETCH_BITWISE_NBI(xor)
+
+/*
+ * bitwise
+ */
+
+#define SHMEMC_CTX_BITWISE(_op)                                                \
+  void shmemc_ctx_##_op(shmem_ctx_t ctx, void *t, void *vp, size_t vs,         \
+                        int pe) {                                              \
+    shmemc_context_h ch = (shmemc_context_h)ctx;                               \
+                                                                               \
+    helper_atomic_##_op(ch, t, vp, vs, pe);                                    \
+  }
+
+SHMEMC_CTX_BITWISE(and)
+SHMEMC_CTX_BITWISE(or)
+SHMEMC_CTX_BITWISE(xor)
+
+/*
+ * set/fetch
+ *
+ * With AMOs done by the CPU, an aligned 32/64-bit put or get is just
+ * as atomic: set doesn't wait for a reply, fetch doesn't go near the
+ * atomic unit.  Otherwise set is a swap and fetch a fetch-add of 0.
+ * UCX has no posted swap, so the swap still waits for its reply: that
+ * keeps it ordered with the caller's following AMOs, as before.
+ */
+
+inline static int amo_as_rma(const void *tp, size_t ts) {
+  return proc.env.amo_rma &&
+         ((ts == sizeof(uint32_t)) || (ts == sizeof(uint64_t))) &&
+         (((uintptr_t)tp & (ts - 1)) == 0);
+}
+
+/*
+ * a set's put goes out as one word, straight away: never into an
+ * aggregation buffer (applied later with memcpy()) or across lanes
+ */
+static void word_put(shmemc_context_h ch, void *tp, const void *vp, size_t ts,
+                     int pe) {
+  uint64_t r_t;
+  ucp_rkey_h r_key;
+  ucp_ep_h ep;
+#if defined(HAVE_UCP_PUT_NBX) || defined(HAVE_UCP_PUT_NB)
+  ucs_status_ptr_t sp;
+#endif /* HAVE_UCP_PUT_NBX || HAVE_UCP_PUT_NB */
+  ucs_status_t s;
+
+  get_remote_key_and_addr(ch, (uint64_t)tp, pe, &r_key, &r_t);
+  ep = lookup_ucp_ep(ch, pe);
+
+#ifdef HAVE_UCP_PUT_NBX
+  const ucp_request_param_t prm = {.op_attr_mask = UCP_OP_ATTR_FIELD_CALLBACK,
+                                   .cb.send = noop_callbackx};
+
+  sp = ucp_put_nbx(ep, vp, ts, r_t, r_key, &prm);
+  s = check_wait_for_request(ch, sp);
+#elif defined(HAVE_UCP_PUT_NB)
+  sp = ucp_put_nb(ep, vp, ts, r_t, r_key, noop_callback);
+  s = check_wait_for_request(ch, sp);
+#else  /* ! HAVE_UCP_PUT_NB */
+  s = ucp_put(ep, vp, ts, r_t, r_key);
+#endif /* HAVE_UCP_PUT_NBX */
+
+  shmemu_assert(s == UCS_OK, MODULE ": AMO set failed (status: %s)",
+                ucs_status_string(s));
+}
+
+void shmemc_ctx_set(shmem_ctx_t ctx, void *tp, size_t ts, void *vp, size_t vs,
+                    int pe) {
+  shmemc_context_h ch = (shmemc_context_h)ctx;
+  uint64_t old; /* each set gets its own reply buffer */
+  ucs_status_t s;
+
+  if (amo_as_rma(tp, ts)) {
+    void *mp = get_mapped_addr(ch, (uint64_t)tp, pe);
+
+    if (mp == NULL) {
+      word_put(ch, tp, vp, ts, pe);
+    } else if (ts == sizeof(uint64_t)) {
+      __atomic_store_n((uint64_t *)mp, *(uint64_t *)vp, __ATOMIC_RELEASE);
+    } else {
+      __atomic_store_n((uint32_t *)mp, *(uint32_t *)vp, __ATOMIC_RELEASE);
+    }
+    return;
+    /* NOT REACHED */
+  }
+
+  s = helper_fetching_amo(ch, UCP_ATOMIC_FETCH_OP_SWAP, tp, vp, vs, pe, &old);
+
+  shmemu_assert(s == UCS_OK, MODULE ": AMO set failed (status: %s)",
+                ucs_status_string(s));
+}
+
+void shmemc_ctx_fetch(shmem_ctx_t ctx, void *tp, size_t ts, int pe,
+                      void *valp) {
+  uint64_t zero = 0;
+
+  if (amo_as_rma(tp, ts)) {
+    void *mp = get_mapped_addr((shmemc_context_h)ctx, (uint64_t)tp, pe);
+
+    if (mp == NULL) {
+      shmemc_ctx_get(ctx, valp, tp, ts, pe);
+    } else if (ts == sizeof(uint64_t)) {
+      *(uint64_t *)valp = __atomic_load_n((uint64_t *)mp, __ATOMIC_ACQUIRE);
+    } else {
+      *(uint32_t *)valp = __atomic_load_n((uint32_t *)mp, __ATOMIC_ACQUIRE);
+    }
+    return;
+    /* NOT REACHED */
+  }
+
+  shmemc_ctx_fadd(ctx, tp, &zero, ts, pe, valp);
+}
+
+void shmemc_ctx_fetch_nbi(shmem_ctx_t ctx, void *tp, size_t ts, int pe,
+                          void *valp) {
+  uint64_t zero = 0;
+
+  if (amo_as_rma(tp, ts)) {
+    shmemc_ctx_get_nbi(ctx, valp, tp, ts, pe);
+    return;
+    /* NOT REACHED */
+  }
+
+  shmemc_ctx_fadd_nbi(ctx, tp, &zero, ts, pe, valp);
+}
+
+/*
+ * -- direct load/store --------------------------------------------------
+ */
+
+/*
+ * Large direct puts stream past the cache: the target PE is going to
+ * read the data, not us.  Ends with a store fence so the caller sees
+ * the same ordering as from memcpy().
+ */
+
+#ifdef __SSE2__
+
+static void nt_copy(void *dst, const void *src, size_t n) {
+  char *d = (char *)dst;
+  const char *s = (const char *)src;
+  size_t head = (16 - ((uintptr_t)d & 15)) & 15;
+
+  if (head > n) {
+    head = n;
+  }
+
+  /* bring destination up to alignment for the streaming stores */
+  memcpy(d, s, head);
+  d += head;
+  s += head;
+  n -= head;
+
+  while (n >= 64) {
+    const __m128i a = _mm_loadu_si128((const __m128i *)(s + 0));
+    const __m128i b = _mm_loadu_si128((const __m128i *)(s + 16));
+    const __m128i c = _mm_loadu_si128((const __m128i *)(s + 32));
+    const __m128i e = _mm_loadu_si128((const __m128i *)(s + 48));
+
+    _mm_stream_si128((__m128i *)(d + 0), a);
+    _mm_stream_si128((__m128i *)(d + 16), b);
+    _mm_stream_si128((__m128i *)(d + 32), c);
+    _mm_stream_si128((__m128i *)(d + 48), e);
+
+    d += 64;
+    s += 64;
+    n -= 64;
+  }
+
+  _mm_sfence();
+
+  memcpy(d, s, n);
+}
+
+#endif /* __SSE2__ */
+
+inline static void mapped_put(void *dst, const void *src, size_t n) {
+#ifdef __SSE2__
+  if ((proc.env.nt_threshold > 0) && (n >= proc.env.nt_threshold)) {
+    nt_copy(dst, src, n);
+    return;
+    /* NOT REACHED */
+  }
+#endif /* __SSE2__ */
+
+  memcpy(dst, src, n);
+}
+
+/*
+ * -- striping -----------------------------------------------------------
+ */
+
+/*
+ * Big transfers are cut into one cache-line-multiple chunk per lane,
+ * lane 0 being the caller's context, and all chunks are posted before
+ * anyone waits.  Chunks on the internal lanes aren't seen by the
+ * context's worker, so the context is marked and quiet/fence flush
+ * the lanes as well.
+ */
+
+#ifdef SHMEMC_UCX_STRIPING
+
+inline static int stripe_wanted(size_t nbytes) {
+  return (shmemc_ucx_stripe_nlanes() > 0) &&
+         (nbytes >= proc.env.stripe_threshold);
+}
+
+static void helper_striped(shmemc_context_h ch, int is_put, void *dest,
+                           const void *src, size_t nbytes, int pe,
+                           int blocking) {
+  const size_t nl = shmemc_ucx_stripe_nlanes() + 1;
+  const size_t cl = SHMEMC_CACHELINE_SIZE;
+  const size_t chunk = (((nbytes + nl - 1) / nl) + cl - 1) & ~(cl - 1);
+  const ucp_request_param_t prm = {.op_attr_mask = UCP_OP_ATTR_FIELD_CALLBACK,
+                                   .cb.send = blocking ? noop_callbackx
+                                                       : nb_callbackx};
+  ucs_status_ptr_t reqs[SHMEMC_MAX_STRIPE_LANES];
+  size_t nreqs = 0;
+  size_t off = 0;
+  size_t i;
+
+  for (i = 0; (i < nl) && (off < nbytes); ++i) {
+    const shmemc_context_h lp = (i == 0) ? ch : shmemc_ucx_stripe_lane(i - 1);
+    const size_t len = (nbytes - off < chunk) ? (nbytes - off) : chunk;
+    const ucp_ep_h ep = lookup_ucp_ep(lp, pe);
+    uint64_t r_addr;
+    ucp_rkey_h r_key;
+    ucs_status_ptr_t sp;
+
+    if (is_put) {
+      get_remote_key_and_addr(lp, (uint64_t)dest + off, pe, &r_key, &r_addr);
+      sp = ucp_put_nbx(ep, (const char *)src + off, len, r_addr, r_key, &prm);
+    } else {
+      get_remote_key_and_addr(lp, (uint64_t)src + off, pe, &r_key, &r_addr);
+      sp = ucp_get_nbx(ep, (char *)dest + off, len, r_addr, r_key, &prm);
+    }
+    shmemu_assert(!UCS_PTR_IS_ERR(sp),
+                  MODULE ": striped %s on lane %lu failed (status: %s)",
+                  is_put ? "put" : "get", (unsigned long)i,
+                  ucs_status_string(UCS_PTR_STATUS(sp)));
+
+    if (blocking && (sp != NULL)) {
+      reqs[nreqs++] = sp;
+    }
+
+    off += len;
+  }
+
+  /* blocking puts are only locally complete */
+  if (is_put || !blocking) {
+    __atomic_store_n(&ch->striped, true, __ATOMIC_RELEASE);
+  }
+
+  for (i = 0; i < nreqs; ++i) {
+    ucs_status_t s;
+
+    do {
+      (void)ucp_worker_progress(ch->w);
+      shmemc_ucx_stripe_progress();
+      s = UCX_REQUEST_CHECK(reqs[i]);
+    } while (s == UCS_INPROGRESS);
+
+    ucp_request_free(reqs[i]);
+
+    shmemu_assert(s == UCS_OK, MODULE ": striped %s failed (status: %s)",
+                  is_put ? "put" : "get", ucs_status_string(s));
+  }
+}
+
+#else /* ! SHMEMC_UCX_STRIPING */
+
+#define stripe_wanted(_nbytes) 0
+
+#define helper_striped(_ch, _is_put, _dest, _src, _nbytes, _pe, _blocking)
+
+#endif /* SHMEMC_UCX_STRIPING */
+
+/*
+ * -- puts & gets --------------------------------------------------------
+ */
+
+/*
+ * Node-local PEs whose memory is mapped here are done directly, and
+ * so complete immediately.  Everything else goes through UCX.
+ */
+
+void shmemc_ctx_put(shmem_ctx_t ctx, void *dest, const void *src, size_t nbytes,
+                    int pe) {
+  shmemc_context_h ch = (shmemc_context_h)ctx;
+  uint64_t r_dest;  /* address on other PE */
+  ucp_rkey_h r_key; /* rkey for remote address */
+  ucp_ep_h ep;
+#if defined(HAVE_UCP_PUT_NBX) || defined(HAVE_UCP_PUT_NB)
+  ucs_status_ptr_t sp;
+#endif /* HAVE_UCP_PUT_NBX || HAVE_UCP_PUT_NB */
+  ucs_status_t s;
+  void *mp = get_mapped_addr(ch, (uint64_t)dest, pe);
+
+  if (mp != NULL) {
+    mapped_put(mp, src, nbytes);
+    return;
+    /* NOT REACHED */
+  }
+
+  if (stripe_wanted(nbytes)) {
+    helper_striped(ch, 1, dest, src, nbytes, pe, 1);
+    return;
+    /* NOT REACHED */
+  }
+
+  get_remote_key_and_addr(ch, (uint64_t)dest, pe, &r_key, &r_dest);
+
+  /* buffered, so locally complete */
+  if ((ch->aggr != NULL) &&
+      shmemc_ucx_aggr_put(ch, r_dest, src, nbytes, pe)) {
+    return;
+    /* NOT REACHED */
+  }
+
+  ep = lookup_ucp_ep(ch, pe);
+
+#ifdef HAVE_UCP_PUT_NBX
+  const ucp_request_param_t prm = {.op_attr_mask = UCP_OP_ATTR_FIELD_CALLBACK,
+                                   .cb.send = noop_callbackx};
+
+  sp = ucp_put_nbx(ep, src, nbytes, r_dest, r_key, &prm);
+  s = check_wait_for_request(ch, sp);
+#elif defined(HAVE_UCP_PUT_NB)
+  sp = ucp_put_nb(ep, src, nbytes, r_dest, r_key, noop_callback);
+  s = check_wait_for_request(ch, sp);
+#else  /* ! HAVE_UCP_PUT_NB */
+  s = ucp_put(ep, src, nbytes, r_dest, r_key);
+#endif /* HAVE_UCP_PUT_NBX */
+
+  shmemu_assert(s == UCS_OK, MODULE ": put failed (status: %s)",
+                ucs_status_string(s));
+}
+
+void shmemc_ctx_get(shmem_ctx_t ctx, void *dest, const void *src, size_t nbytes,
+                    int pe) {
+  shmemc_context_h ch = (shmemc_context_h)ctx;
+  uint64_t r_src;
+  ucp_rkey_h r_key;
+  ucp_ep_h ep;
+#if defined(HAVE_UCP_GET_NBX) || defined(HAVE_UCP_GET_NB)
+  ucs_status_ptr_t sp;
+#endif /* HAVE_UCP_GET_NBX || HAVE_UCP_GET_NB */
+  ucs_status_t s;
+  void *mp = get_mapped_addr(ch, (uint64_t)src, pe);
+
+  if (mp != NULL) {
+    memcpy(dest, mp, nbytes);
+    return;
+    /* NOT REACHED */
+  }
+
+  if (stripe_wanted(nbytes)) {
+    helper_striped(ch, 0, dest, src, nbytes, pe, 1);
+    return;
+    /* NOT REACHED */
+  }
+
+  get_remote_key_and_addr(ch, (uint64_t)src, pe, &r_key, &r_src);
+  ep = lookup_ucp_ep(ch, pe);
+
+#ifdef HAVE_UCP_GET_NBX
+  const ucp_request_param_t prm = {.op_attr_mask = UCP_OP_ATTR_FIELD_CALLBACK,
+                                   .cb.send = noop_callbackx};
+
+  sp = ucp_get_nbx(ep, dest, nbytes, r_src, r_key, &prm);
+  s = check_wait_for_request(ch, sp);
+#elif defined(HAVE_UCP_GET_NB)
+  sp = ucp_get_nb(ep, dest, nbytes, r_src, r_key, noop_callback);
+  s = check_wait_for_request(ch, sp);
+#else  /* ! HAVE_UCP_GET_NB */
+  s = ucp_get(ep, dest, nbytes, r_src, r_key);
+#endif /* HAVE_UCP_GET_NB */
+
+  shmemu_assert(s == UCS_OK, MODULE ": get failed (status: %s)",
+                ucs_status_string(s));
+}
+
+
+/**
+ * Return status from UCP nbi routines probably needs more handling
+ *
+ */
+
+void shmemc_ctx_put_nbi(shmem_ctx_t ctx, void *dest, const void *src,
+                        size_t nbytes, int pe) {
+  shmemc_context_h ch = (shmemc_context_h)ctx;
+  uint64_t r_dest;
+  ucp_rkey_h r_key;
+  ucp_ep_h ep;
+  ucs_status_t s;
+  void *mp = get_mapped_addr(ch, (uint64_t)dest, pe);
+
+  if (mp != NULL) {
+    mapped_put(mp, src, nbytes);
+    return;
+    /* NOT REACHED */
+  }
+
+  if (stripe_wanted(nbytes)) {
+    helper_striped(ch, 1, dest, src, nbytes, pe, 0);
+    return;
+    /* NOT REACHED */
+  }
+
+  get_remote_key_and_addr(ch, (uint64_t)dest, pe, &r_key, &r_dest);
+
+  if ((ch->aggr != NULL) &&
+      shmemc_ucx_aggr_put(ch, r_dest, src, nbytes, pe)) {
+    return;
+    /* NOT REACHED */
+  }
+
+  ep = lookup_ucp_ep(ch, pe);
+
+  s = ucp_put_nbi(ep, src, nbytes, r_dest, r_key);
+  shmemu_assert(s == UCS_OK || s == UCS_INPROGRESS,
+                MODULE ": non-blocking put failed");
+}
+
+void shmemc_ctx_get_nbi(shmem_ctx_t ctx, void *dest, const void *src,
+                        size_t nbytes, int pe) {
+  shmemc_context_h ch = (shmemc_context_h)ctx;
+  uint64_t r_src;
+  ucp_rkey_h r_key;
+  ucp_ep_h ep;
+  ucs_status_t s;
+  void *mp = get_mapped_addr(ch, (uint64_t)src, pe);
+
+  if (mp != NULL) {
+    memcpy(dest, mp, nbytes);
+    return;
+    /* NOT REACHED */
+  }
+
+  if (stripe_wanted(nbytes)) {
+    helper_striped(ch, 0, dest, src, nbytes, pe, 0);
+    return;
+    /* NOT REACHED */
+  }
+
+  get_remote_key_and_addr(ch, (uint64_t)src, pe, &r_key, &r_src);
+  ep = lookup_ucp_ep(ch, pe);
+
+  s = ucp_get_nbi(ep, dest, nbytes, r_src, r_key);
+  shmemu_assert(s == UCS_OK || s == UCS_INPROGRESS,
+                MODULE ": non-blocking get failed");
+}
+
+/*
+ * -- handle-based puts & gets -------------------------------------------
+ */
+
+/*
+ * The handle is the UCX request itself, or NULL if the operation has
+ * already completed.  The request carries its context so we know
+ * which worker to progress.
+ *
+ * A put is complete once the source can be reused, a get once the
+ * data has arrived.
+ */
+
+#if defined(HAVE_UCP_PUT_NBX) && defined(HAVE_UCP_GET_NBX)
+
+inline static void *tag_request(shmemc_context_h ch, ucs_status_ptr_t sp,
+                                const char *op) {
+  if (sp == NULL) {
+    return NULL;
+    /* NOT REACHED */
+  }
+
+  if (shmemu_unlikely(UCS_PTR_IS_ERR(sp))) {
+    shmemu_fatal(MODULE ": non-blocking %s failed (status: %s)", op,
+                 ucs_status_string(UCS_PTR_STATUS(sp)));
+    /* NOT REACHED */
+  }
+
+  ((shmemc_ucx_request_t *)sp)->ch = ch;
+
+  return sp;
+}
+
+void *shmemc_ctx_put_nbx(shmem_ctx_t ctx, void *dest, const void *src,
+                         size_t nbytes, int pe) {
+  shmemc_context_h ch = (shmemc_context_h)ctx;
+  uint64_t r_dest;
+  ucp_rkey_h r_key;
+  void *mp = get_mapped_addr(ch, (uint64_t)dest, pe);
+  const ucp_request_param_t prm = {.op_attr_mask = UCP_OP_ATTR_FIELD_CALLBACK,
+                                   .cb.send = noop_callbackx};
+
+  if (mp != NULL) {
+    mapped_put(mp, src, nbytes);
+    return NULL;
+    /* NOT REACHED */
+  }
+
+  get_remote_key_and_addr(ch, (uint64_t)dest, pe, &r_key, &r_dest);
+
+  return tag_request(ch,
+                     ucp_put_nbx(lookup_ucp_ep(ch, pe), src, nbytes, r_dest,
+                                 r_key, &prm),
+                     "put");
+}
+
+void *shmemc_ctx_get_nbx(shmem_ctx_t ctx, void *dest, const void *src,
+                         size_t nbytes, int pe) {
+  shmemc_context_h ch = (shmemc_context_h)ctx;
+  uint64_t r_src;
+  ucp_rkey_h r_key;
+  void *mp = get_mapped_addr(ch, (uint64_t)src, pe);
+  const ucp_request_param_t prm = {.op_attr_mask = UCP_OP_ATTR_FIELD_CALLBACK,
+                                   .cb.send = noop_callbackx};
+
+  if (mp != NULL) {
+    memcpy(dest, mp, nbytes);
+    return NULL;
+    /* NOT REACHED */
+  }
+
+  get_remote_key_and_addr(ch, (uint64_t)src, pe, &r_key, &r_src);
+
+  return tag_request(ch,
+                     ucp_get_nbx(lookup_ucp_ep(ch, pe), dest, nbytes, r_src,
+                                 r_key, &prm),
+                     "get");
+}
+
+/*
+ * Non-zero if complete, in which case the request has been released
+ */
+
+int shmemc_request_test(void *req) {
+  ucs_status_t s;
+
+  if (req == NULL) {
+    return 1;
+    /* NOT REACHED */
+  }
+
+  s = UCX_REQUEST_CHECK(req);
+  if (s == UCS_INPROGRESS) {
+    (void)ucp_worker_progress(((shmemc_ucx_request_t *)req)->ch->w);
+
+    s = UCX_REQUEST_CHECK(req);
+    if (s == UCS_INPROGRESS) {
+      return 0;
+      /* NOT REACHED */
+    }
+  }
+
+  shmemu_assert(s == UCS_OK,
+                MODULE ": non-blocking request failed (status: %s)",
+                ucs_status_string(s));
+
+  ucp_request_free(req);
+
+  return 1;
+}
+
+#else /* ! (HAVE_UCP_PUT_NBX && HAVE_UCP_GET_NBX) */
+
+/*
+ * no requests to hand out, so just complete before return
+ */
+
+void *shmemc_ctx_put_nbx(shmem_ctx_t ctx, void *dest, const void *src,
+                         size_t nbytes, int pe) {
+  shmemc_ctx_put(ctx, dest, src, nbytes, pe);
+  return NULL;
+}
+
+void *shmemc_ctx_get_nbx(shmem_ctx_t ctx, void *dest, const void *src,
+                         size_t nbytes, int pe) {
+  shmemc_ctx_get(ctx, dest, src, nbytes, pe);
+  return NULL;
+}
+
+int shmemc_request_test(void *req) {
+  NO_WARN_UNUSED(req);
+
+  return 1;
+}
+
+#endif /* HAVE_UCP_PUT_NBX && HAVE_UCP_GET_NBX */
+
+void shmemc_request_wait(void *req) {
+  while (!shmemc_request_test(req)) {
+    continue;
+  }
+}
+
+/*
+ * -- strided puts & gets -------------------------------------------------
+ */
+
+/*
+ * Remote memory mapped here (or our own) is just copied.  Otherwise
+ * UCX RMA only describes a contiguous remote range, so:
+ *
+ *   - remote side contiguous, local side strided: (un)pack through a
+ *     bounce buffer and move it all in a single operation
+ *
+ *   - remote side strided: post every element back-to-back, only
+ *     waiting once STRIDED_MAX_INFLIGHT are outstanding
+ *
+ * Non-blocking variants complete at the next quiet.  Strides are in
+ * elements, as in the API.
+ */
+
+/*
+ * both sides addressable here
+ */
+inline static void strided_copy(void *dst, ptrdiff_t tst, const void *src,
+                                ptrdiff_t sst, size_t elsize, size_t nelems) {
+  const ptrdiff_t tst_nb = tst * (ptrdiff_t)elsize;
+  const ptrdiff_t sst_nb = sst * (ptrdiff_t)elsize;
+  char *dp = (char *)dst;
+  const char *sp = (const char *)src;
+  size_t i;
+
+  for (i = 0; i < nelems; ++i) {
+    memcpy(dp, sp, elsize);
+    dp += tst_nb;
+    sp += sst_nb;
+  }
+}
+
+/*
+ * returns non-zero if the remote side was mapped and it's all done
+ */
+inline static int strided_mapped(shmemc_context_h ch, int is_put, void *dest,
+                                 const void *src, ptrdiff_t tst,
+                                 ptrdiff_t sst, size_t elsize, size_t nelems,
+                                 int pe) {
+  void *mp = get_mapped_addr(ch, (uint64_t)(is_put ? dest : src), pe);
+
+  if (mp == NULL) {
+    return 0;
+    /* NOT REACHED */
+  }
+
+  if (is_put) {
+    strided_copy(mp, tst, src, sst, elsize, nelems);
+  } else {
+    strided_copy(dest, tst, mp, sst, elsize, nelems);
+  }
+
+  return 1;
+}
+
+#if defined(HAVE_UCP_PUT_NBX) && defined(HAVE_UCP_GET_NBX) &&                  \
+    defined(HAVE_UCP_EP_FLUSH_NBX)
+
+inline static void strided_pack(void *dst, const void *src, ptrdiff_t st,
+                                size_t elsize, size_t nelems) {
+  const ptrdiff_t st_nb = st * (ptrdiff_t)elsize;
+  char *dp = (char *)dst;
+  const char *sp = (const char *)src;
+  size_t i;
+
+  for (i = 0; i < nelems; ++i) {
+    memcpy(dp, sp, elsize);
+    dp += elsize;
+    sp += st_nb;
+  }
+}
+
+inline static void strided_unpack(void *dst, ptrdiff_t st, const void *src,
+                                  size_t elsize, size_t nelems) {
+  const ptrdiff_t st_nb = st * (ptrdiff_t)elsize;
+  char *dp = (char *)dst;
+  const char *sp = (const char *)src;
+  size_t i;
+
+  for (i = 0; i < nelems; ++i) {
+    memcpy(dp, sp, elsize);
+    dp += st_nb;
+    sp += elsize;
+  }
+}
+
+/*
+ * bounce buffer for a strided get, unpacked when the data lands
+ */
+typedef struct strided_bounce {
+  void *target;
+  ptrdiff_t tst;
+  size_t elsize;
+  size_t nelems;
+  char data[];
+} strided_bounce_t;
+
+static void strided_put_done_callbackx(void *req, ucs_status_t status,
+                                       void *user_data) {
+  free(user_data);
+  ucp_request_free(req);
+  NO_WARN_UNUSED(status);
+}
+
+static void strided_get_done_callbackx(void *req, ucs_status_t status,
+                                       void *user_data) {
+  strided_bounce_t *sbp = (strided_bounce_t *)user_data;
+
+  strided_unpack(sbp->target, sbp->tst, sbp->data, sbp->elsize, sbp->nelems);
+  free(sbp);
+  ucp_request_free(req);
+  NO_WARN_UNUSED(status);
+}
+
+inline static void strided_wait(shmemc_context_h ch, ucs_status_ptr_t rp,
+                                int is_put) {
+  const ucs_status_t s = check_wait_for_request(ch, rp);
+
+  shmemu_assert(s == UCS_OK, MODULE ": strided %s failed (status: %s)",
+                is_put ? "put" : "get", ucs_status_string(s));
+}
+
+/*
+ * remote side strided: one op per element.  Requests go round a ring
+ * so no more than STRIDED_MAX_INFLIGHT are ever outstanding; when
+ * it's full we wait for the oldest.  Blocking calls wait for the rest
+ * at the end, non-blocking ones hand them back to UCX.
+ */
+
+#define STRIDED_MAX_INFLIGHT 128
+
+static void strided_post_elements(shmemc_context_h ch, int is_put, void *dest,
+                                  const void *src, ptrdiff_t tst,
+                                  ptrdiff_t sst, size_t elsize, size_t nelems,
+                                  int pe, int blocking) {
+  const ptrdiff_t tst_nb = tst * (ptrdiff_t)elsize;
+  const ptrdiff_t sst_nb = sst * (ptrdiff_t)elsize;
+  const ucp_request_param_t prm = {.op_attr_mask = UCP_OP_ATTR_FIELD_CALLBACK,
+                                   .cb.send = noop_callbackx};
+  const ucp_ep_h ep = lookup_ucp_ep(ch, pe);
+  ucs_status_ptr_t reqs[STRIDED_MAX_INFLIGHT];
+  size_t head = 0;  /* oldest outstanding request */
+  size_t nreqs = 0; /* how many */
+  char *tp = (char *)dest;
+  const char *sp = (const char *)src;
+  size_t i;
+
+  for (i = 0; i < nelems; ++i) {
+    uint64_t r_addr;
+    ucp_rkey_h r_key;
+    ucs_status_ptr_t rp;
+
+    if (is_put) {
+      get_remote_key_and_addr(ch, (uint64_t)tp, pe, &r_key, &r_addr);
+      rp = ucp_put_nbx(ep, sp, elsize, r_addr, r_key, &prm);
+    } else {
+      get_remote_key_and_addr(ch, (uint64_t)sp, pe, &r_key, &r_addr);
+      rp = ucp_get_nbx(ep, tp, elsize, r_addr, r_key, &prm);
+    }
+    shmemu_assert(!UCS_PTR_IS_ERR(rp),
+                  MODULE ": strided %s failed (status: %s)",
+                  is_put ? "put" : "get",
+                  ucs_status_string(UCS_PTR_STATUS(rp)));
+
+    if (rp != NULL) {
+      if (nreqs == STRIDED_MAX_INFLIGHT) {
+        strided_wait(ch, reqs[head], is_put);
+        reqs[head] = rp;
+        head = (head + 1) % STRIDED_MAX_INFLIGHT;
+      } else {
+        reqs[(head + nreqs) % STRIDED_MAX_INFLIGHT] = rp;
+        ++nreqs;
+      }
+    }
+
+    tp += tst_nb;
+    sp += sst_nb;
+  }
+
+  for (i = 0; i < nreqs; ++i) {
+    const ucs_status_ptr_t rp = reqs[(head + i) % STRIDED_MAX_INFLIGHT];
+
+    if (blocking) {
+      strided_wait(ch, rp, is_put);
+    } else {
+      ucp_request_free(rp); /* goes once complete */
+    }
+  }
+}
+
+static void helper_iput(shmemc_context_h ch, void *dest, const void *src,
+                        ptrdiff_t tst, ptrdiff_t sst, size_t elsize,
+                        size_t nelems, int pe, int blocking) {
+  if (nelems == 0) {
+    return;
+    /* NOT REACHED */
+  }
+
+  if (strided_mapped(ch, 1, dest, src, tst, sst, elsize, nelems, pe)) {
+    return;
+    /* NOT REACHED */
+  }
+
+  if (tst == 1) {
+    const size_t nb = elsize * nelems;
+    uint64_t r_dest;
+    ucp_rkey_h r_key;
+    void *bounce;
+    ucs_status_ptr_t sp;
+
+    if (sst == 1) {
+      if (blocking) {
+        shmemc_ctx_put(ch, dest, src, nb, pe);
+      } else {
+        shmemc_ctx_put_nbi(ch, dest, src, nb, pe);
+      }
+      return;
+      /* NOT REACHED */
+    }
+
+    bounce = malloc(nb);
+    shmemu_assert(bounce != NULL,
+                  MODULE ": can't allocate %lu bytes for strided put",
+                  (unsigned long)nb);
+    strided_pack(bounce, src, sst, elsize, nelems);
+
+    get_remote_key_and_addr(ch, (uint64_t)dest, pe, &r_key, &r_dest);
+
+    if (blocking) {
+      const ucp_request_param_t prm = {.op_attr_mask =
+                                           UCP_OP_ATTR_FIELD_CALLBACK,
+                                       .cb.send = noop_callbackx};
+      ucs_status_t s;
+
+      sp = ucp_put_nbx(lookup_ucp_ep(ch, pe), bounce, nb, r_dest, r_key, &prm);
+      s = check_wait_for_request(ch, sp);
+      shmemu_assert(s == UCS_OK, MODULE ": strided put failed (status: %s)",
+                    ucs_status_string(s));
+      free(bounce);
+    } else {
+      const ucp_request_param_t prm = {
+          .op_attr_mask =
+              UCP_OP_ATTR_FIELD_CALLBACK | UCP_OP_ATTR_FIELD_USER_DATA,
+          .cb.send = strided_put_done_callbackx,
+          .user_data = bounce};
+
+      sp = ucp_put_nbx(lookup_ucp_ep(ch, pe), bounce, nb, r_dest, r_key, &prm);
+      shmemu_assert(!UCS_PTR_IS_ERR(sp),
+                    MODULE ": non-blocking strided put failed (status: %s)",
+                    ucs_status_string(UCS_PTR_STATUS(sp)));
+      if (sp == NULL) {
+        free(bounce);
+      }
+    }
+  } else {
+    strided_post_elements(ch, 1, dest, src, tst, sst, elsize, nelems, pe,
+                          blocking);
+  }
+}
+
+static void helper_iget(shmemc_context_h ch, void *dest, const void *src,
+                        ptrdiff_t tst, ptrdiff_t sst, size_t elsize,
+                        size_t nelems, int pe, int blocking) {
+  if (nelems == 0) {
+    return;
+    /* NOT REACHED */
+  }
+
+  if (strided_mapped(ch, 0, dest, src, tst, sst, elsize, nelems, pe)) {
+    return;
+    /* NOT REACHED */
+  }
+
+  if (sst == 1) {
+    const size_t nb = elsize * nelems;
+    uint64_t r_src;
+    ucp_rkey_h r_key;
+    strided_bounce_t *sbp;
+    ucs_status_ptr_t sp;
+
+    if (tst == 1) {
+      if (blocking) {
+        shmemc_ctx_get(ch, dest, src, nb, pe);
+      } else {
+        shmemc_ctx_get_nbi(ch, dest, src, nb, pe);
+      }
+      return;
+      /* NOT REACHED */
+    }
+
+    sbp = (strided_bounce_t *)malloc(sizeof(*sbp) + nb);
+    shmemu_assert(sbp != NULL,
+                  MODULE ": can't allocate %lu bytes for strided get",
+                  (unsigned long)nb);
+    sbp->target = dest;
+    sbp->tst = tst;
+    sbp->elsize = elsize;
+    sbp->nelems = nelems;
+
+    get_remote_key_and_addr(ch, (uint64_t)src, pe, &r_key, &r_src);
+
+    if (blocking) {
+      const ucp_request_param_t prm = {.op_attr_mask =
+                                           UCP_OP_ATTR_FIELD_CALLBACK,
+                                       .cb.send = noop_callbackx};
+      ucs_status_t s;
+
+      sp = ucp_get_nbx(lookup_ucp_ep(ch, pe), sbp->data, nb, r_src, r_key,
+                       &prm);
+      s = check_wait_for_request(ch, sp);
+      shmemu_assert(s == UCS_OK, MODULE ": strided get failed (status: %s)",
+                    ucs_status_string(s));
+      strided_unpack(dest, tst, sbp->data, elsize, nelems);
+      free(sbp);
+    } else {
+      const ucp_request_param_t prm = {
+          .op_attr_mask =
+              UCP_OP_ATTR_FIELD_CALLBACK | UCP_OP_ATTR_FIELD_USER_DATA,
+          .cb.send = strided_get_done_callbackx,
+          .user_data = sbp};
+
+      sp = ucp_get_nbx(lookup_ucp_ep(ch, pe), sbp->data, nb, r_src, r_key,
+                       &prm);
+      shmemu_assert(!UCS_PTR_IS_ERR(sp),
+                    MODULE ": non-blocking strided get failed (status: %s)",
+                    ucs_status_string(UCS_PTR_STATUS(sp)));
+      if (sp == NULL) {
+        strided_unpack(dest, tst, sbp->data, elsize, nelems);
+        free(sbp);
+      }
+    }
+  } else {
+    strided_post_elements(ch, 0, dest, src, tst, sst, elsize, nelems, pe,
+                          blocking);
+  }
+}
+
+#else /* older UCX: element-wise */
+
+static void helper_iput(shmemc_context_h ch, void *dest, const void *src,
+                        ptrdiff_t tst, ptrdiff_t sst, size_t elsize,
+                        size_t nelems, int pe, int blocking) {
+  const ptrdiff_t tst_nb = tst * (ptrdiff_t)elsize;
+  const ptrdiff_t sst_nb = sst * (ptrdiff_t)elsize;
+  char *tp = (char *)dest;
+  const char *sp = (const char *)src;
+  size_t i;
+
+  if (strided_mapped(ch, 1, dest, src, tst, sst, elsize, nelems, pe)) {
+    return;
+    /* NOT REACHED */
+  }
+
+  for (i = 0; i < nelems; ++i) {
+    if (blocking) {
+      shmemc_ctx_put(ch, tp, sp, elsize, pe);
+    } else {
+      shmemc_ctx_put_nbi(ch, tp, sp, elsize, pe);
+    }
+    tp += tst_nb;
+    sp += sst_nb;
+  }
+}
+
+static void helper_iget(shmemc_context_h ch, void *dest, const void *src,
+                        ptrdiff_t tst, ptrdiff_t sst, size_t elsize,
+                        size_t nelems, int pe, int blocking) {
+  const ptrdiff_t tst_nb = tst * (ptrdiff_t)elsize;
+  const ptrdiff_t sst_nb = sst * (ptrdiff_t)elsize;
+  char *tp = (char *)dest;
+  const char *sp = (const char *)src;
+  size_t i;
+
+  if (strided_mapped(ch, 0, dest, src, tst, sst, elsize, nelems, pe)) {
+    return;
+    /* NOT REACHED */
+  }
+
+  for (i = 0; i < nelems; ++i) {
+    if (blocking) {
+      shmemc_ctx_get(ch, tp, sp, elsize, pe);
+    } else {
+      shmemc_ctx_get_nbi(ch, tp, sp, elsize, pe);
+    }
+    tp += tst_nb;
+    sp += sst_nb;
+  }
+}
+
+#endif /* HAVE_UCP_PUT_NBX && HAVE_UCP_GET_NBX && HAVE_UCP_EP_FLUSH_NBX */
+
+void shmemc_ctx_iput(shmem_ctx_t ctx, void *dest, const void *src,
+                     ptrdiff_t tst, ptrdiff_t sst, size_t elsize,
+                     size_t nelems, int pe) {
+  helper_iput((shmemc_context_h)ctx, dest, src, tst, sst, elsize, nelems, pe,
+              1);
+}
+
+void shmemc_ctx_iget(shmem_ctx_t ctx, void *dest, const void *src,
+                     ptrdiff_t tst, ptrdiff_t sst, size_t elsize,
+                     size_t nelems, int pe) {
+  helper_iget((shmemc_context_h)ctx, dest, src, tst, sst, elsize, nelems, pe,
+              1);
+}
+
+void shmemc_ctx_iput_nbi(shmem_ctx_t ctx, void *dest, const void *src,
+                         ptrdiff_t tst, ptrdiff_t sst, size_t elsize,
+                         size_t nelems, int pe) {
+  helper_iput((shmemc_context_h)ctx, dest, src, tst, sst, elsize, nelems, pe,
+              0);
+}
+
+void shmemc_ctx_iget_nbi(shmem_ctx_t ctx, void *dest, const void *src,
+                         ptrdiff_t tst, ptrdiff_t sst, size_t elsize,
+                         size_t nelems, int pe) {
+  helper_iget((shmemc_context_h)ctx, dest, src, tst, sst, elsize, nelems, pe,
+              0);
+}
+
+/*
+ * -- vectored puts & gets ------------------------------------------------
+ */
+
+/*
+ * Descriptors are visited grouped by PE, so each target's endpoint is
+ * looked up once and its operations go out back-to-back.  Nothing
+ * waits per operation: the blocking variants flush every endpoint
+ * they used at the end, all flushes overlapped.  Non-blocking ones
+ * complete at the next quiet.
+ */
+
+#if defined(HAVE_UCP_PUT_NBX) && defined(HAVE_UCP_GET_NBX) &&                  \
+    defined(HAVE_UCP_EP_FLUSH_NBX)
+
+static int xfer_cmp_pe(const void *a, const void *b) {
+  const shmemc_xfer_t *xa = *(const shmemc_xfer_t *const *)a;
+  const shmemc_xfer_t *xb = *(const shmemc_xfer_t *const *)b;
+
+  if (xa->pe != xb->pe) {
+    return (xa->pe < xb->pe) ? -1 : 1;
+    /* NOT REACHED */
+  }
+
+  /* keep caller's order within a PE */
+  return (xa < xb) ? -1 : (xa > xb);
+}
+
+/*
+ * Order descriptors by PE, if they aren't already
+ */
+static const shmemc_xfer_t **xfer_order(const shmemc_xfer_t *xs, size_t n) {
+  const shmemc_xfer_t **order;
+  int sorted = 1;
+  size_t i;
+
+  order = (const shmemc_xfer_t **)malloc(n * sizeof(*order));
+  shmemu_assert(order != NULL,
+                MODULE ": can't allocate order for %lu vectored transfers",
+                (unsigned long)n);
+
+  for (i = 0; i < n; ++i) {
+    order[i] = &xs[i];
+    if ((i > 0) && (xs[i].pe < xs[i - 1].pe)) {
+      sorted = 0;
+    }
+  }
+
+  if (!sorted) {
+    qsort(order, n, sizeof(*order), xfer_cmp_pe);
+  }
+
+  return order;
+}
+
+/*
+ * Post everything for one PE, return non-zero if anything went via
+ * UCX
+ */
+static int xfer_post_pe(shmemc_context_h ch, int is_put,
+                        const shmemc_xfer_t **order, size_t first,
+                        size_t last) {
+  const int pe = order[first]->pe;
+  const ucp_ep_h ep = lookup_ucp_ep(ch, pe);
+  const ucp_request_param_t prm = {.op_attr_mask = UCP_OP_ATTR_FIELD_CALLBACK,
+                                   .cb.send = nb_callbackx};
+  int posted = 0;
+  size_t i;
+
+  for (i = first; i < last; ++i) {
+    const shmemc_xfer_t *xp = order[i];
+    const uint64_t sym = is_put ? (uint64_t)xp->dest : (uint64_t)xp->src;
+    void *mp;
+    uint64_t r_addr;
+    ucp_rkey_h r_key;
+    ucs_status_ptr_t rp;
+
+    if (xp->nbytes == 0) {
+      continue;
+    }
+
+    mp = get_mapped_addr(ch, sym, pe);
+    if (mp != NULL) {
+      if (is_put) {
+        mapped_put(mp, xp->src, xp->nbytes);
+      } else {
+        memcpy(xp->dest, mp, xp->nbytes);
+      }
+      continue;
+    }
+
+    get_remote_key_and_addr(ch, sym, pe, &r_key, &r_addr);
+
+    if (is_put) {
+      if ((ch->aggr != NULL) &&
+          shmemc_ucx_aggr_put(ch, r_addr, xp->src, xp->nbytes, pe)) {
+        continue;
+      }
+      rp = ucp_put_nbx(ep, xp->src, xp->nbytes, r_addr, r_key, &prm);
+    } else {
+      rp = ucp_get_nbx(ep, xp->dest, xp->nbytes, r_addr, r_key, &prm);
+    }
+    shmemu_assert(!UCS_PTR_IS_ERR(rp),
+                  MODULE ": vectored %s to PE %d failed (status: %s)",
+                  is_put ? "put" : "get", pe,
+                  ucs_status_string(UCS_PTR_STATUS(rp)));
+
+    posted = 1;
+  }
+
+  return posted;
+}
+
+static void helper_xfer(shmemc_context_h ch, int is_put,
+                        const shmemc_xfer_t *xs, size_t n, int blocking) {
+  const shmemc_xfer_t **order;
+  ucs_status_ptr_t *flushes = NULL;
+  size_t nflushes = 0;
+  size_t first = 0;
+  size_t i;
 
-#define HELPER_BITWISE_FETCH_ATOMIC_NBI(_ucp_op, _opname)                      \
-  inline static void helper_atomic_fetch_##_opname##_nbi(                      \
-      shmemc_context_h ch, void *t, void *vp, size_t vs, int pe, void *retp) { \
-    const ucs_status_ptr_t sp = helper_fetching_amo_nbi(                       \
-        ch, MAKE_UCP_FETCH_OP(_ucp_op), t, vp, vs, pe, retp);                  \
-                                                                               \
-    shmemu_assert(!UCS_PTR_IS_ERR(sp),                                         \
-                  MODULE ": AMO fetch nbi op \"%s\" failed", #_opname);        \
+  if (n == 0) {
+    return;
+    /* NOT REACHED */
   }
 
-HELPER_BITWISE_FETCH_ATOMIC_NBI(AND, and)
-HELPER_BITWISE_FETCH_ATOMIC_NBI(OR, or)
-HELPER_BITWISE_FETCH_ATOMIC_NBI(XOR, xor)
+  order = xfer_order(xs, n);
 
-#define HELPER_BITWISE_ATOMIC(_ucp_op, _opname)                                \
-  inline static void helper_atomic_##_opname(shmemc_context_h ch, void *t,     \
-                                             void *vp, size_t vs, int pe) {    \
-    const ucs_status_t s =                                                     \
-        helper_posted_amo(ch, MAKE_UCP_POST_OP(_ucp_op), t, vp, vs, pe);       \
-                                                                               \
-    shmemu_assert(s == UCS_OK,                                                 \
-                  MODULE ": AMO post op \"%s\" failed (status: %s)", #_opname, \
-                  ucs_status_string(s));                                       \
+  if (blocking) {
+    /* at worst one per descriptor */
+    flushes = (ucs_status_ptr_t *)malloc(n * sizeof(*flushes));
+    shmemu_assert(flushes != NULL,
+                  MODULE ": can't allocate flushes for %lu vectored transfers",
+                  (unsigned long)n);
   }
 
-HELPER_BITWISE_ATOMIC(AND, and)
-HELPER_BITWISE_ATOMIC(OR, or)
-HELPER_BITWISE_ATOMIC(XOR, xor)
+  while (first < n) {
+    size_t last = first + 1;
 
-#else /* ! HAVE_UCP_BITWISE_ATOMICS */
+    while ((last < n) && (order[last]->pe == order[first]->pe)) {
+      ++last;
+    }
 
-#define HELPER_BITWISE_FETCH_ATOMIC(_op, _opname)                              \
-  inline static void helper_atomic_fetch_##_opname(                            \
-      shmemc_context_h ch, void *t, void *vp, size_t vs, int pe, void *retp) { \
-    /* make sure zeroed for smaller types */                                   \
-    uint64_t ret = 0, rval = 0, rval_orig = 0, vcomp = 0;                      \
-    ucs_status_t s;                                                            \
-    uint64_t r_t;                                                              \
-    ucp_rkey_h r_key;                                                          \
-    ucp_ep_h ep;                                                               \
-                                                                               \
-    memcpy(&vcomp, vp, vs); /* save comparator */                              \
-    get_remote_key_and_addr(ch, (uint64_t)t, pe, &r_key, &r_t);                \
-    ep = lookup_ucp_ep(ch, pe);                                                \
-                                                                               \
-    do {                                                                       \
-      s = ucp_get(ep, &rval_orig, sizeof(rval_orig), r_t, r_key);              \
-      shmemu_assert(s == UCS_OK,                                               \
-                    MODULE ": AMO fetch failed in CAS (status: %s)",           \
-                    ucs_status_string(s));                                     \
-      rval = (rval_orig)_op vcomp;                                             \
-                                                                               \
-      s = ucp_atomic_cswap64(ep, rval_orig, rval, r_t, r_key, &ret);           \
-    } while (ret != rval_orig);                                                \
-                                                                               \
-    memcpy(retp, &ret, vs); /* copy out answer */                              \
+    if (xfer_post_pe(ch, is_put, order, first, last) && blocking) {
+      flushes[nflushes++] = post_ep_flush(ch, order[first]->pe);
+    }
+
+    first = last;
   }
 
-HELPER_BITWISE_FETCH_ATOMIC(|, or)
-HELPER_BITWISE_FETCH_ATOMIC(&, and)
-HELPER_BITWISE_FETCH_ATOMIC(^, xor)
+  for (i = 0; i < nflushes; ++i) {
+    const ucs_status_t s = check_wait_for_request(ch, flushes[i]);
 
-#define HELPER_BITWISE_FETCH_ATOMIC_NBI(_ucp_op, _opname)                      \
-  inline static void helper_atomic_fetch_##_opname##_nbi(                      \
-      shmemc_context_h ch, void *t, void *vp, size_t vs, int pe, void *retp) { \
-    helper_atomic_fetch_##_opname(ch, t, vp, vs, pe, retp);                    \
+    shmemu_assert(s == UCS_OK, MODULE ": vectored %s failed (status: %s)",
+                  is_put ? "put" : "get", ucs_status_string(s));
   }
 
-HELPER_BITWISE_FETCH_ATOMIC_NBI(AND, and)
-HELPER_BITWISE_FETCH_ATOMIC_NBI(OR, or)
-HELPER_BITWISE_FETCH_ATOMIC_NBI(XOR, xor)
+  free(flushes);
+  free(order);
+}
 
-#define HELPER_BITWISE_ATOMIC(_opname)                                         \
-  inline static void helper_atomic_##_opname(shmemc_context_h ch, void *t,     \
-                                             void *vp, size_t vs, int pe) {    \
-    uint64_t discard;                                                          \
-                                                                               \
-    (void)helper_atomic_fetch_##_opname(ch, t, vp, vs, pe, &discard);          \
+#else /* older UCX: one at a time */
+
+static void helper_xfer(shmemc_context_h ch, int is_put,
+                        const shmemc_xfer_t *xs, size_t n, int blocking) {
+  size_t i;
+
+  for (i = 0; i < n; ++i) {
+    const shmemc_xfer_t *xp = &xs[i];
+
+    if (is_put) {
+      if (blocking) {
+        shmemc_ctx_put(ch, xp->dest, xp->src, xp->nbytes, xp->pe);
+      } else {
+        shmemc_ctx_put_nbi(ch, xp->dest, xp->src, xp->nbytes, xp->pe);
+      }
+    } else {
+      if (blocking) {
+        shmemc_ctx_get(ch, xp->dest, xp->src, xp->nbytes, xp->pe);
+      } else {
+        shmemc_ctx_get_nbi(ch, xp->dest, xp->src, xp->nbytes, xp->pe);
+      }
+    }
   }
+}
 
-HELPER_BITWISE_ATOMIC(or)
-HELPER_BITWISE_ATOMIC(and)
-HELPER_BITWISE_ATOMIC(xor)
+#endif /* HAVE_UCP_PUT_NBX && HAVE_UCP_GET_NBX && HAVE_UCP_EP_FLUSH_NBX */
 
-#endif /* HAVE_UCP_BITWISE_ATOMICS */
+void shmemc_ctx_putv(shmem_ctx_t ctx, const shmemc_xfer_t *xs, size_t n) {
+  helper_xfer((shmemc_context_h)ctx, 1, xs, n, 1);
+}
 
-/*
- * fetched-bitwise
- */
+void shmemc_ctx_getv(shmem_ctx_t ctx, const shmemc_xfer_t *xs, size_t n) {
+  helper_xfer((shmemc_context_h)ctx, 0, xs, n, 1);
+}
 
-#define SHMEMC_CTX_FETCH_BITWISE(_op)                                          \
-  void shmemc_ctx_fetch_##_op(shmem_ctx_t ctx, void *t, void *vp, size_t vs,   \
-                              int pe, void *retp) {                            \
-    shmemc_context_h ch = (shmemc_context_h)ctx;                               \
-                                                                               \
-    helper_atomic_fetch_##_op(ch, t, vp, vs, pe, retp);                        \
-  }
+void shmemc_ctx_putv_nbi(shmem_ctx_t ctx, const shmemc_xfer_t *xs, size_t n) {
+  helper_xfer((shmemc_context_h)ctx, 1, xs, n, 0);
+}
 
-SHMEMC_CTX_FETCH_BITWISE(and)
-SHMEMC_CTX_FETCH_BITWISE(or)
-SHMEMC_CTX_FETCH_BITWISE(xor)
+void shmemc_ctx_getv_nbi(shmem_ctx_t ctx, const shmemc_xfer_t *xs, size_t n) {
+  helper_xfer((shmemc_context_h)ctx, 0, xs, n, 0);
+}
 
 /*
- * bitwise
+ * -- completion counters ------------------------------------------------
  */
 
-#define SHMEMC_CTX_BITWISE(_op)                                                \
-  void shmemc_ctx_##_op(shmem_ctx_t ctx, void *t, void *vp, size_t vs,         \
-                        int pe) {                                              \
-    shmemc_context_h ch = (shmemc_context_h)ctx;                               \
-                                                                               \
-    helper_atomic_##_op(ch, t, vp, vs, pe);                                    \
+/*
+ * A counter belongs to a context, and each counted operation bumps it
+ * once it has completed.  Gets count from their own completion
+ * callback.  Puts and AMOs are followed by a flush of the endpoint,
+ * which counts when it comes back, so the count means "done at the
+ * target".  Counted operations skip aggregation and striping, which
+ * have completion rules of their own.
+ */
+
+shmemc_counter_h shmemc_ctx_counter_create(shmem_ctx_t ctx) {
+  shmemc_counter_h c = (shmemc_counter_h)malloc(sizeof(*c));
+
+  if (c != NULL) {
+    c->ctx = ctx;
+    c->count = 0;
   }
 
-SHMEMC_CTX_BITWISE(and)
-SHMEMC_CTX_BITWISE(or)
-SHMEMC_CTX_BITWISE(xor)
+  return c;
+}
 
 /*
- * set/fetch
+ * callbacks still to come would write into a freed counter
  */
+void shmemc_counter_destroy(shmemc_counter_h c) {
+  shmemc_ctx_quiet(c->ctx);
+  free(c);
+}
 
-void shmemc_ctx_set(shmem_ctx_t ctx, void *tp, size_t ts, void *vp, size_t vs,
-                    int pe) {
-  uint64_t zap;
+uint64_t shmemc_counter_read(shmemc_counter_h c) {
+  return __atomic_load_n(&c->count, __ATOMIC_ACQUIRE);
+}
 
-  NO_WARN_UNUSED(ts);
+int shmemc_counter_test(shmemc_counter_h c, uint64_t n) {
+  if (shmemc_counter_read(c) >= n) {
+    return 1;
+    /* NOT REACHED */
+  }
 
-  shmemc_ctx_swap(ctx, tp, vp, vs, pe, &zap);
+  (void)helper_ctx_progress(c->ctx);
 
-  NO_WARN_UNUSED(zap);
+  return shmemc_counter_read(c) >= n;
 }
 
-void shmemc_ctx_fetch(shmem_ctx_t ctx, void *tp, size_t ts, int pe,
-                      void *valp) {
-  uint64_t zero = 0;
-
-  shmemc_ctx_fadd(ctx, tp, &zero, ts, pe, valp);
+void shmemc_counter_wait(shmemc_counter_h c, uint64_t n) {
+  while (!shmemc_counter_test(c, n)) {
+    continue;
+  }
 }
 
-void shmemc_ctx_fetch_nbi(shmem_ctx_t ctx, void *tp, size_t ts, int pe,
-                          void *valp) {
-  uint64_t zero = 0;
-
-  shmemc_ctx_fadd_nbi(ctx, tp, &zero, ts, pe, valp);
+inline static void counter_bump(shmemc_counter_h c) {
+  __atomic_add_fetch(&c->count, 1, __ATOMIC_RELEASE);
 }
 
+#if defined(HAVE_UCP_PUT_NBX) && defined(HAVE_UCP_GET_NBX) &&                  \
+    defined(HAVE_UCP_EP_FLUSH_NBX)
+
 /*
- * -- puts & gets --------------------------------------------------------
+ * count once everything already posted to the PE has completed there
  */
-
-void shmemc_ctx_put(shmem_ctx_t ctx, void *dest, const void *src, size_t nbytes,
-                    int pe) {
-  shmemc_context_h ch = (shmemc_context_h)ctx;
-  uint64_t r_dest;  /* address on other PE */
-  ucp_rkey_h r_key; /* rkey for remote address */
-  ucp_ep_h ep;
-#if defined(HAVE_UCP_PUT_NBX) || defined(HAVE_UCP_PUT_NB)
+static void counter_flush_ep(shmemc_counter_h c, int pe) {
+  const ucp_request_param_t prm = {.op_attr_mask =
+                                       UCP_OP_ATTR_FIELD_CALLBACK |
+                                       UCP_OP_ATTR_FIELD_USER_DATA,
+                                   .cb.send = counter_callbackx,
+                                   .user_data = &c->count};
   ucs_status_ptr_t sp;
-#endif /* HAVE_UCP_PUT_NBX || HAVE_UCP_PUT_NB */
-  ucs_status_t s;
 
-  get_remote_key_and_addr(ch, (uint64_t)dest, pe, &r_key, &r_dest);
-  ep = lookup_ucp_ep(ch, pe);
+  sp = ucp_ep_flush_nbx(lookup_ucp_ep((shmemc_context_h)c->ctx, pe), &prm);
+  if (sp == NULL) {
+    counter_bump(c);
+  } else {
+    shmemu_assert(!UCS_PTR_IS_ERR(sp),
+                  MODULE ": can't flush counted operation to PE %d "
+                         "(status: %s)",
+                  pe, ucs_status_string(UCS_PTR_STATUS(sp)));
+  }
+}
 
-#ifdef HAVE_UCP_PUT_NBX
+void shmemc_counter_put_nbi(shmemc_counter_h c, void *dest, const void *src,
+                            size_t nbytes, int pe) {
+  shmemc_context_h ch = (shmemc_context_h)c->ctx;
   const ucp_request_param_t prm = {.op_attr_mask = UCP_OP_ATTR_FIELD_CALLBACK,
-                                   .cb.send = noop_callbackx};
+                                   .cb.send = nb_callbackx};
+  uint64_t r_dest;
+  ucp_rkey_h r_key;
+  ucs_status_ptr_t sp;
+  void *mp = get_mapped_addr(ch, (uint64_t)dest, pe);
 
-  sp = ucp_put_nbx(ep, src, nbytes, r_dest, r_key, &prm);
-  s = check_wait_for_request(ch, sp);
-#elif defined(HAVE_UCP_PUT_NB)
-  sp = ucp_put_nb(ep, src, nbytes, r_dest, r_key, noop_callback);
-  s = check_wait_for_request(ch, sp);
-#else  /* ! HAVE_UCP_PUT_NB */
-  s = ucp_put(ep, src, nbytes, r_dest, r_key);
-#endif /* HAVE_UCP_PUT_NBX */
+  if (mp != NULL) {
+    mapped_put(mp, src, nbytes);
+    counter_bump(c);
+    return;
+    /* NOT REACHED */
+  }
 
-  shmemu_assert(s == UCS_OK, MODULE ": put failed (status: %s)",
-                ucs_status_string(s));
+  get_remote_key_and_addr(ch, (uint64_t)dest, pe, &r_key, &r_dest);
+
+  sp = ucp_put_nbx(lookup_ucp_ep(ch, pe), src, nbytes, r_dest, r_key, &prm);
+  shmemu_assert(!UCS_PTR_IS_ERR(sp),
+                MODULE ": counted put to PE %d failed (status: %s)", pe,
+                ucs_status_string(UCS_PTR_STATUS(sp)));
+
+  counter_flush_ep(c, pe);
 }
 
-void shmemc_ctx_get(shmem_ctx_t ctx, void *dest, const void *src, size_t nbytes,
-                    int pe) {
-  shmemc_context_h ch = (shmemc_context_h)ctx;
+void shmemc_counter_get_nbi(shmemc_counter_h c, void *dest, const void *src,
+                            size_t nbytes, int pe) {
+  shmemc_context_h ch = (shmemc_context_h)c->ctx;
+  const ucp_request_param_t prm = {.op_attr_mask =
+                                       UCP_OP_ATTR_FIELD_CALLBACK |
+                                       UCP_OP_ATTR_FIELD_USER_DATA,
+                                   .cb.send = counter_callbackx,
+                                   .user_data = &c->count};
   uint64_t r_src;
   ucp_rkey_h r_key;
-  ucp_ep_h ep;
-#if defined(HAVE_UCP_GET_NBX) || defined(HAVE_UCP_GET_NB)
   ucs_status_ptr_t sp;
-#endif /* HAVE_UCP_GET_NBX || HAVE_UCP_GET_NB */
-  ucs_status_t s;
+  void *mp = get_mapped_addr(ch, (uint64_t)src, pe);
+
+  if (mp != NULL) {
+    memcpy(dest, mp, nbytes);
+    counter_bump(c);
+    return;
+    /* NOT REACHED */
+  }
 
   get_remote_key_and_addr(ch, (uint64_t)src, pe, &r_key, &r_src);
-  ep = lookup_ucp_ep(ch, pe);
 
-#ifdef HAVE_UCP_GET_NBX
-  const ucp_request_param_t prm = {.op_attr_mask = UCP_OP_ATTR_FIELD_CALLBACK,
-                                   .cb.send = noop_callbackx};
+  sp = ucp_get_nbx(lookup_ucp_ep(ch, pe), dest, nbytes, r_src, r_key, &prm);
+  if (sp == NULL) {
+    counter_bump(c);
+  } else {
+    shmemu_assert(!UCS_PTR_IS_ERR(sp),
+                  MODULE ": counted get from PE %d failed (status: %s)", pe,
+                  ucs_status_string(UCS_PTR_STATUS(sp)));
+  }
+}
 
-  sp = ucp_get_nbx(ep, dest, nbytes, r_src, r_key, &prm);
-  s = check_wait_for_request(ch, sp);
-#elif defined(HAVE_UCP_GET_NB)
-  sp = ucp_get_nb(ep, dest, nbytes, r_src, r_key, noop_callback);
-  s = check_wait_for_request(ch, sp);
-#else  /* ! HAVE_UCP_GET_NB */
-  s = ucp_get(ep, dest, nbytes, r_src, r_key);
-#endif /* HAVE_UCP_GET_NB */
+void shmemc_counter_add(shmemc_counter_h c, void *t, void *vp, size_t vs,
+                        int pe) {
+  const ucs_status_t s =
+      shmemc_ucx_post_amo((shmemc_context_h)c->ctx, UCP_ATOMIC_POST_OP_ADD, t,
+                          *(uint64_t *)vp, vs, pe);
 
-  shmemu_assert(s == UCS_OK, MODULE ": get failed (status: %s)",
+  shmemu_assert(s == UCS_OK,
+                MODULE ": counted add on PE %d failed (status: %s)", pe,
                 ucs_status_string(s));
+
+  counter_flush_ep(c, pe);
 }
 
-/*
- * strided ops currently build on put/get in upper API
- */
+void shmemc_counter_fadd_nbi(shmemc_counter_h c, void *t, void *vp, size_t vs,
+                             int pe, void *retp) {
+  const ucs_status_ptr_t sp =
+      helper_fetching_amo_nbi((shmemc_context_h)c->ctx,
+                              UCP_ATOMIC_FETCH_OP_FADD, t, vp, vs, pe, retp);
 
-/**
- * Return status from UCP nbi routines probably needs more handling
- *
- */
+  shmemu_assert(!UCS_PTR_IS_ERR(sp),
+                MODULE ": counted fetch-add on PE %d failed (status: %s)", pe,
+                ucs_status_string(UCS_PTR_STATUS(sp)));
 
-void shmemc_ctx_put_nbi(shmem_ctx_t ctx, void *dest, const void *src,
-                        size_t nbytes, int pe) {
-  shmemc_context_h ch = (shmemc_context_h)ctx;
-  uint64_t r_dest;
-  ucp_rkey_h r_key;
-  ucp_ep_h ep;
-  ucs_status_t s;
+  /* the flush returns after the fetched value has landed */
+  counter_flush_ep(c, pe);
+}
 
-  get_remote_key_and_addr(ch, (uint64_t)dest, pe, &r_key, &r_dest);
-  ep = lookup_ucp_ep(ch, pe);
+#else /* older UCX: complete each one before counting it */
 
-  s = ucp_put_nbi(ep, src, nbytes, r_dest, r_key);
-  shmemu_assert(s == UCS_OK || s == UCS_INPROGRESS,
-                MODULE ": non-blocking put failed");
+void shmemc_counter_put_nbi(shmemc_counter_h c, void *dest, const void *src,
+                            size_t nbytes, int pe) {
+  shmemc_ctx_put(c->ctx, dest, src, nbytes, pe);
+  shmemc_ctx_pe_quiet(c->ctx, pe);
+  counter_bump(c);
 }
 
-void shmemc_ctx_get_nbi(shmem_ctx_t ctx, void *dest, const void *src,
-                        size_t nbytes, int pe) {
-  shmemc_context_h ch = (shmemc_context_h)ctx;
-  uint64_t r_src;
-  ucp_rkey_h r_key;
-  ucp_ep_h ep;
-  ucs_status_t s;
+void shmemc_counter_get_nbi(shmemc_counter_h c, void *dest, const void *src,
+                            size_t nbytes, int pe) {
+  shmemc_ctx_get(c->ctx, dest, src, nbytes, pe);
+  counter_bump(c);
+}
 
-  get_remote_key_and_addr(ch, (uint64_t)src, pe, &r_key, &r_src);
-  ep = lookup_ucp_ep(ch, pe);
+void shmemc_counter_add(shmemc_counter_h c, void *t, void *vp, size_t vs,
+                        int pe) {
+  shmemc_ctx_add(c->ctx, t, vp, vs, pe);
+  shmemc_ctx_pe_quiet(c->ctx, pe);
+  counter_bump(c);
+}
 
-  s = ucp_get_nbi(ep, dest, nbytes, r_src, r_key);
-  shmemu_assert(s == UCS_OK || s == UCS_INPROGRESS,
-                MODULE ": non-blocking get failed");
+void shmemc_counter_fadd_nbi(shmemc_counter_h c, void *t, void *vp, size_t vs,
+                             int pe, void *retp) {
+  shmemc_ctx_fadd(c->ctx, t, vp, vs, pe, retp);
+  counter_bump(c);
 }
 
+#endif /* HAVE_UCP_PUT_NBX && HAVE_UCP_GET_NBX && HAVE_UCP_EP_FLUSH_NBX */
+
 /*
  * puts with signals
  */
@@ -804,14 +3016,168 @@ void shmemc_ctx_put_signal(shmem_ctx_t ctx, void *dest, const void *src,
 }
 
 /*
- * TODO HACK1: just use blocking implementation for testing
+ * Non-blocking put-with-signal is pipelined on the target's endpoint:
+ *
+ *   1. post the payload with ucp_put_nbx()
+ *   2. flush only that endpoint, non-blocking
+ *   3. when the flush completes (payload delivered), post the signal
+ *      from the callback: an 8-byte put for SET, a non-fetching
+ *      atomic add for ADD
+ *
+ * Nothing here waits, so many of these can be in flight to different
+ * PEs at once.  The context counts chains whose signal has not yet
+ * been posted, and quiet drains those before flushing the worker.
+ */
+
+#if defined(HAVE_UCP_PUT_NBX) && defined(HAVE_UCP_EP_FLUSH_NBX)
+
+typedef struct put_signal_desc {
+  shmemc_context_h ch;
+  ucp_ep_h ep;
+  ucp_rkey_h r_key;
+  uint64_t r_sig;  /* signal address on target */
+  uint64_t signal; /* value, must live until SET put completes */
+  int sig_op;
+} put_signal_desc_t;
+
+static void put_signal_release_callbackx(void *req, ucs_status_t status,
+                                         void *user_data) {
+  free(user_data);
+  ucp_request_release(req);
+  NO_WARN_UNUSED(status);
+}
+
+static void put_signal_post_signal(put_signal_desc_t *psp) {
+  shmemc_context_h ch = psp->ch;
+  ucs_status_ptr_t sp;
+  ucs_status_t s;
+
+  switch (psp->sig_op) {
+  case SHMEM_SIGNAL_SET: {
+    const ucp_request_param_t prm = {
+        .op_attr_mask =
+            UCP_OP_ATTR_FIELD_CALLBACK | UCP_OP_ATTR_FIELD_USER_DATA,
+        .cb.send = put_signal_release_callbackx,
+        .user_data = psp};
+
+    sp = ucp_put_nbx(psp->ep, &psp->signal, sizeof(psp->signal), psp->r_sig,
+                     psp->r_key, &prm);
+    shmemu_assert(!UCS_PTR_IS_ERR(sp),
+                  MODULE ": signal put failed (status: %s)",
+                  ucs_status_string(UCS_PTR_STATUS(sp)));
+    if (sp == NULL) { /* completed in place, callback not called */
+      free(psp);
+    }
+    break;
+  }
+  case SHMEM_SIGNAL_ADD:
+    s = ucx_post_amo(psp->ep, UCP_ATOMIC_POST_OP_ADD, psp->signal,
+                     sizeof(psp->signal), psp->r_sig, psp->r_key);
+    shmemu_assert(s == UCS_OK, MODULE ": signal add failed (status: %s)",
+                  ucs_status_string(s));
+    free(psp);
+    break;
+  default:
+    shmemu_fatal(MODULE ": unknown signal operation code %d", psp->sig_op);
+    /* NOT REACHED */
+    break;
+  }
+
+  /* now covered by a worker flush */
+  __atomic_sub_fetch(&ch->pending_signals, 1, __ATOMIC_RELEASE);
+}
+
+static void put_signal_flushed_callbackx(void *req, ucs_status_t status,
+                                         void *user_data) {
+  shmemu_assert(status == UCS_OK,
+                MODULE ": endpoint flush for signal failed (status: %s)",
+                ucs_status_string(status));
+
+  put_signal_post_signal((put_signal_desc_t *)user_data);
+  ucp_request_release(req);
+}
+
+void shmemc_ctx_put_signal_nbi(shmem_ctx_t ctx, void *dest, const void *src,
+                               size_t nbytes, uint64_t *sig_addr,
+                               uint64_t signal, int sig_op, int pe) {
+  shmemc_context_h ch = (shmemc_context_h)ctx;
+  uint64_t r_dest;
+  ucp_rkey_h r_key;
+  put_signal_desc_t *psp;
+  ucs_status_ptr_t sp;
+
+  if (shmemu_unlikely(sig_op != SHMEM_SIGNAL_SET &&
+                      sig_op != SHMEM_SIGNAL_ADD)) {
+    shmemu_fatal(MODULE ": unknown signal operation code %d", sig_op);
+    /* NOT REACHED */
+  }
+
+  /* nothing to wait for when it's all local */
+  if (loopback_rma(pe)) {
+    shmemc_ctx_put_signal(ctx, dest, src, nbytes, sig_addr, signal, sig_op,
+                          pe);
+    return;
+    /* NOT REACHED */
+  }
+
+  psp = (put_signal_desc_t *)malloc(sizeof(*psp));
+  shmemu_assert(psp != NULL,
+                MODULE ": can't allocate put-with-signal descriptor");
+
+  psp->ch = ch;
+  psp->ep = lookup_ucp_ep(ch, pe);
+  psp->signal = signal;
+  psp->sig_op = sig_op;
+  get_remote_key_and_addr(ch, (uint64_t)sig_addr, pe, &psp->r_key,
+                          &psp->r_sig);
+
+  /* 1. payload */
+  get_remote_key_and_addr(ch, (uint64_t)dest, pe, &r_key, &r_dest);
+  {
+    const ucp_request_param_t prm = {.op_attr_mask =
+                                         UCP_OP_ATTR_FIELD_CALLBACK,
+                                     .cb.send = nb_callbackx};
+
+    sp = ucp_put_nbx(psp->ep, src, nbytes, r_dest, r_key, &prm);
+    shmemu_assert(!UCS_PTR_IS_ERR(sp),
+                  MODULE ": non-blocking put failed (status: %s)",
+                  ucs_status_string(UCS_PTR_STATUS(sp)));
+  }
+
+  __atomic_add_fetch(&ch->pending_signals, 1, __ATOMIC_RELAXED);
+
+  /* 2. order the signal behind the payload on this endpoint only */
+  {
+    const ucp_request_param_t prm = {
+        .op_attr_mask =
+            UCP_OP_ATTR_FIELD_CALLBACK | UCP_OP_ATTR_FIELD_USER_DATA,
+        .cb.send = put_signal_flushed_callbackx,
+        .user_data = psp};
+
+    sp = ucp_ep_flush_nbx(psp->ep, &prm);
+    shmemu_assert(!UCS_PTR_IS_ERR(sp),
+                  MODULE ": endpoint flush for signal failed (status: %s)",
+                  ucs_status_string(UCS_PTR_STATUS(sp)));
+  }
+
+  /* 3. nothing outstanding on endpoint, so signal right away */
+  if (sp == NULL) {
+    put_signal_post_signal(psp);
+  }
+}
+
+#else /* ! (HAVE_UCP_PUT_NBX && HAVE_UCP_EP_FLUSH_NBX) */
+
+/*
+ * older UCX: at least don't wait for the payload, and use a
+ * non-fetching add
  */
 
 void shmemc_ctx_put_signal_nbi(shmem_ctx_t ctx, void *dest, const void *src,
                                size_t nbytes, uint64_t *sig_addr,
                                uint64_t signal, int sig_op, int pe) {
 
-  shmemc_ctx_put(ctx, dest, src, nbytes, pe);
+  shmemc_ctx_put_nbi(ctx, dest, src, nbytes, pe);
   shmemc_ctx_fence(ctx);
 
   switch (sig_op) {
@@ -828,3 +3194,5 @@ void shmemc_ctx_put_signal_nbi(shmem_ctx_t ctx, void *dest, const void *src,
     break;
   }
 }
+
+#endif /* HAVE_UCP_PUT_NBX && HAVE_UCP_EP_FLUSH_NBX */
@@ -8,8 +8,11 @@
 #include "shmemc.h"
 #include "shmemu.h"
 #include "ucx/api.h"
+#include "ucx/aggregate.h"
+#include "module.h"
 
 #include <stdlib.h>
+#include <string.h>
 
 #include <ucp/api/ucp.h>
 
@@ -39,9 +42,73 @@ int shmemc_ucx_context_progress(shmemc_context_h ch) {
     /* NOT REACHED */
   }
 
+  /* fresh worker, nothing in flight */
+  ch->pending_signals = 0;
+  ch->striped = false;
+  ch->lane_flushes = 0;
+  ch->qtest_posted = false;
+  ch->qtest_req = NULL;
+  ch->amo_ext_pending = 0;
+  ch->ucx_pe = SHMEMC_PE_NONE;
+  ch->wakeup_fd = -1;
+  ch->wait_policy = SHMEMC_WAIT_DEFAULT;
+  memset(&ch->wait_stats, 0, sizeof(ch->wait_stats));
+
   return 0;
 }
 
+#define WAKEUP_FD_NONE (-2) /* worker can't give us one */
+
+/*
+ * the worker's wakeup event fd, fetched the first time it's wanted.
+ * -1 if there isn't one.
+ */
+
+int shmemc_ucx_context_efd(shmemc_context_h ch) {
+  if (!proc.comms.wakeup) {
+    return -1;
+    /* NOT REACHED */
+  }
+
+  if (ch->wakeup_fd == -1) {
+    const ucs_status_t s = ucp_worker_get_efd(ch->w, &ch->wakeup_fd);
+
+    if (s != UCS_OK) {
+      ch->wakeup_fd = WAKEUP_FD_NONE;
+    }
+  }
+
+  return (ch->wakeup_fd >= 0) ? ch->wakeup_fd : -1;
+}
+
+/*
+ * get ready to sleep on the wakeup fd.  Return false if events are
+ * already in, so there's work to do first.
+ */
+
+bool shmemc_ucx_context_arm(shmemc_context_h ch) {
+  const ucs_status_t s = ucp_worker_arm(ch->w);
+
+  if (s == UCS_ERR_BUSY) {
+    return false;
+    /* NOT REACHED */
+  }
+  shmemu_assert(s == UCS_OK, MODULE ": can't arm worker (status: %s)",
+                ucs_status_string(s));
+
+  return true;
+}
+
+/*
+ * wake whoever's sleeping on the wakeup fd (from any thread)
+ */
+
+void shmemc_ucx_context_signal(shmemc_context_h ch) {
+  if (proc.comms.wakeup) {
+    (void)ucp_worker_signal(ch->w);
+  }
+}
+
 /*
  * Fill out info for default context
  *
@@ -67,6 +134,9 @@ int shmemc_ucx_context_default_set_info(void) {
 }
 
 void shmemc_ucx_context_default_destroy(void) {
+  shmemc_ucx_aggr_drain(defcp);
+  shmemc_ucx_aggr_destroy(defcp);
+
   ucp_worker_release_address(defcp->w,
                              proc.comms.xchg_wrkr_info[proc.li.rank].addr);
   shmemc_ucx_teardown_context(defcp);
@@ -116,6 +116,64 @@ ucs_status_t shmemc_ucx_rkey_pack(ucp_mem_h mh, void **packed_rkey_p,
   return ucp_rkey_pack(proc.comms.ucx_ctxt, mh, packed_rkey_p, rkey_len_p);
 }
 
+/*
+ * remote address = local address + delta.  Globals are always
+ * aligned; heaps too if configured that way.
+ */
+
+inline static uint64_t region_delta(size_t r, int pe) {
+#ifdef ENABLE_ALIGNED_ADDRESSES
+  NO_WARN_UNUSED(r);
+  NO_WARN_UNUSED(pe);
+
+  return 0;
+#else
+  if (r == 0) {
+    return 0;
+  } else {
+    const mem_info_t *mip = proc.comms.regions[r].minfo;
+
+    return mip[pe].base - mip[proc.li.rank].base;
+  }
+#endif /* ENABLE_ALIGNED_ADDRESSES */
+}
+
+/*
+ * PEs on this node may be able to have their regions mapped straight
+ * into our address space (e.g. shared memory, xpmem).  If so, RMA to
+ * them can be plain loads & stores.
+ */
+
+static void map_node_local_regions(shmemc_context_h ch) {
+  ch->mapped = false;
+
+#ifdef HAVE_UCP_RKEY_PTR
+  int i;
+
+  if ((!proc.env.mapped_rma) || (proc.li.peers == NULL)) {
+    return;
+    /* NOT REACHED */
+  }
+
+  for (i = 0; i < proc.li.npeers; ++i) {
+    const int pe = proc.li.peers[i];
+    size_t r;
+
+    for (r = 0; r < proc.comms.nregions; ++r) {
+      mem_access_t *ap = &ch->racc[r].rinfo[pe];
+      const uint64_t rbase =
+          proc.comms.regions[r].minfo[proc.li.rank].base + ap->delta;
+      void *p;
+
+      if (ucp_rkey_ptr(ap->rkey, rbase, &p) == UCS_OK) {
+        ap->mapped = p;
+        ch->mapped = true;
+      }
+    }
+  }
+#endif /* HAVE_UCP_RKEY_PTR */
+}
+
 void shmemc_ucx_make_eps(shmemc_context_h ch) {
   ucp_ep_params_t epm;
   ucs_status_t s;
@@ -166,8 +224,15 @@ void shmemc_ucx_make_eps(shmemc_context_h ch) {
                     MODULE ": can't unpack remote rkey "
                            "for memory region %lu, PE %d: %s",
                     (unsigned long)r, pe, ucs_status_string(s));
+
+      ch->racc[r].rinfo[pe].delta = region_delta(r, pe);
     }
   }
+
+  map_node_local_regions(ch);
+
+  /* any valid entry will do to start the lookup cache */
+  ch->hot = &proc.comms.rtable[0];
 }
 
 ucs_status_t shmemc_ucx_worker_wireup(shmemc_context_h ch) {
@@ -13,6 +13,8 @@
 #include "allocator/memalloc.h"
 
 #include "api.h"
+#include "aggregate.h"
+#include "amo_ext.h"
 #include "module.h"
 
 #include <stdlib.h> /* getenv */
@@ -302,6 +304,43 @@ inline static void register_memory_regions(void) {
   }
 }
 
+/*
+ * sorted, cache-aligned interval table of my regions for address
+ * lookup
+ */
+
+static int interval_cmp(const void *a, const void *b) {
+  const mem_interval_t *ia = (const mem_interval_t *)a;
+  const mem_interval_t *ib = (const mem_interval_t *)b;
+
+  return (ia->base > ib->base) - (ia->base < ib->base);
+}
+
+inline static void build_region_table(void) {
+  size_t r;
+  int ret;
+
+  ret = posix_memalign((void **)&proc.comms.rtable, SHMEMC_CACHELINE_SIZE,
+                       proc.comms.nregions * sizeof(*proc.comms.rtable));
+  shmemu_assert(ret == 0,
+                MODULE ": can't allocate memory for region lookup table");
+
+  for (r = 0; r < proc.comms.nregions; ++r) {
+    const mem_info_t *mip = &proc.comms.regions[r].minfo[proc.li.rank];
+    mem_interval_t *ip = &proc.comms.rtable[r];
+
+    ip->base = mip->base;
+    ip->end = mip->end;
+    ip->region = r;
+    ip->pad = 0;
+  }
+
+  qsort(proc.comms.rtable, proc.comms.nregions, sizeof(*proc.comms.rtable),
+        interval_cmp);
+}
+
+inline static void destroy_region_table(void) { free(proc.comms.rtable); }
+
 inline static void deregister_memory_regions(void) {
   size_t hi;
 
@@ -367,8 +406,9 @@ inline static void ucx_init_ready(void) {
 #ifdef HAVE_UCP_PARAM_FIELD_NAME
       UCP_PARAM_FIELD_NAME |
 #endif /* HAVE_UCP_PARAM_FIELD_NAME */
-      UCP_PARAM_FIELD_FEATURES | UCP_PARAM_FIELD_MT_WORKERS_SHARED |
-      UCP_PARAM_FIELD_ESTIMATED_NUM_EPS | UCP_PARAM_FIELD_ESTIMATED_NUM_PPN;
+      UCP_PARAM_FIELD_FEATURES | UCP_PARAM_FIELD_REQUEST_SIZE |
+      UCP_PARAM_FIELD_MT_WORKERS_SHARED | UCP_PARAM_FIELD_ESTIMATED_NUM_EPS |
+      UCP_PARAM_FIELD_ESTIMATED_NUM_PPN;
 
 #ifdef HAVE_UCP_PARAM_FIELD_NAME
   pm.name = PACKAGE_NAME;
@@ -378,6 +418,23 @@ inline static void ucx_init_ready(void) {
                 UCP_FEATURE_AMO32 | /* 32-bit atomics */
                 UCP_FEATURE_AMO64;  /* 64-bit atomics */
 
+  /*
+   * sleeping waits, only if asked for: it can cost transports.  Event
+   * waits chosen per-context later yield without it.
+   */
+  proc.comms.wakeup = (proc.env.wait_policy == SHMEMC_WAIT_EVENT) ||
+                      proc.env.progress_events;
+  if (proc.comms.wakeup) {
+    pm.features |= UCP_FEATURE_WAKEUP;
+  }
+
+#if defined(SHMEMC_UCX_AGGREGATION) || defined(SHMEMC_UCX_AMO_EXT_AM)
+  pm.features |= UCP_FEATURE_AM; /* aggregated batches, remote AMOs */
+#endif /* SHMEMC_UCX_AGGREGATION || SHMEMC_UCX_AMO_EXT_AM */
+
+  /* so handle-based requests can find their context */
+  pm.request_size = sizeof(shmemc_ucx_request_t);
+
   pm.mt_workers_shared = (proc.td.osh_tl > SHMEM_THREAD_SINGLE);
 
   /* estimated program size */
@@ -409,6 +466,7 @@ void shmemc_ucx_init(void) {
   /* make remote memory usable */
   init_memory_regions();
   register_memory_regions();
+  build_region_table();
 
   /* master copy of exchanged rkeys */
   opaque_rkeys_init();
@@ -455,6 +513,7 @@ void shmemc_ucx_finalize(void) {
 
   opaque_rkeys_finalize();
 
+  destroy_region_table();
   deregister_memory_regions();
 
   ucx_cleanup();
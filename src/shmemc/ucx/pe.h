@@ -19,6 +19,7 @@
 #include "shmem/defs.h"
 
 #include <sys/types.h>
+#include <stdint.h>
 #include <ucp/api/ucp.h>
 
 /**
@@ -49,6 +50,8 @@ typedef struct mem_opaque {
  */
 typedef struct mem_access {
   ucp_rkey_h rkey; /* remote key for this heap */
+  uint64_t delta;  /* remote base - local base, add to translate */
+  void *mapped;    /* remote region mapped here (node-local), or NULL */
 } mem_access_t;
 
 /**
@@ -69,6 +72,23 @@ typedef struct mem_info {
   ucp_mem_h mh;  /* memory handle */
 } mem_info_t;
 
+/**
+ * @brief Assumed cache line size for aligning hot lookup tables
+ */
+#define SHMEMC_CACHELINE_SIZE 64
+
+/**
+ * @brief Local address range of a memory region, kept sorted by base
+ * so lookups don't have to scan every region.  Padded so two entries
+ * share a cache line.
+ */
+typedef struct mem_interval {
+  uint64_t base; /* start of region on this PE */
+  uint64_t end;  /* end of region on this PE */
+  size_t region; /* which region this is */
+  size_t pad;
+} mem_interval_t;
+
 /**
  * @brief Collection of memory region information for PE exchange
  */
@@ -82,6 +102,15 @@ typedef struct mem_region {
  */
 typedef struct shmemc_context *shmemc_context_h;
 
+/**
+ * @brief Reserved space at the front of every UCX request (see
+ * ucp_params_t::request_size), so a request handed out to the user
+ * knows which context's worker to progress
+ */
+typedef struct shmemc_ucx_request {
+  shmemc_context_h ch; /**< context the request was issued on */
+} shmemc_ucx_request_t;
+
 /**
  * @brief Handle for team management
  */
@@ -139,8 +168,45 @@ typedef struct shmemc_context_attr {
   bool serialized;
   bool privat; /* "private" is c++ keyword */
   bool nostore;
+  bool aggregate; /* buffer small puts/AMOs per PE */
 } shmemc_context_attr_t;
 
+/**
+ * @brief How point-to-point waits pass the time once a first check
+ * fails (values as shmemx_wait_policy)
+ */
+typedef enum shmemc_wait_policy {
+  SHMEMC_WAIT_DEFAULT = 0, /* whatever SHMEM_WAIT_POLICY says */
+  SHMEMC_WAIT_SPIN,        /* progress and pause, never give up the CPU */
+  SHMEMC_WAIT_YIELD,       /* spin for a while, then yield between checks */
+  SHMEMC_WAIT_BACKOFF,     /* spin, then sleep for longer and longer */
+  SHMEMC_WAIT_EVENT        /* spin, then sleep on worker wakeup events */
+} shmemc_wait_policy_t;
+
+/**
+ * @brief How often each phase of waiting happened on a context (same
+ * layout as shmemx_wait_stats_t)
+ */
+typedef struct shmemc_wait_stats {
+  uint64_t waits;   /* waits that didn't return straight away */
+  uint64_t spins;   /* checks while spinning */
+  uint64_t yields;  /* CPU yields */
+  uint64_t naps;    /* backoff sleeps */
+  uint64_t sleeps;  /* sleeps on wakeup events */
+  uint64_t wakeups; /* ...ended by an event rather than time */
+} shmemc_wait_stats_t;
+
+/**
+ * @brief Values of a context's ucx_pe other than a PE number
+ */
+#define SHMEMC_PE_NONE (-1)
+#define SHMEMC_PE_MANY (-2)
+
+/**
+ * @brief Per-context aggregation buffers, opaque outside aggregate.c
+ */
+struct shmemc_aggr;
+
 /**
  * @brief Structure representing an OpenSHMEM context
  */
@@ -156,8 +222,35 @@ typedef struct shmemc_context {
 
   mem_region_access_t *racc; /* for endpoint remote access */
 
+  const mem_interval_t *hot; /* last region translated through here */
+  bool mapped;               /* any racc entries directly mapped? */
+  int ucx_pe; /* UCX traffic since the last quiet to a PE we also
+                 store to directly: that PE, SHMEMC_PE_NONE or
+                 SHMEMC_PE_MANY */
+
   shmemc_team_h team; /* team we belong to */
 
+  unsigned long pending_signals; /* put-with-signals yet to post signal */
+
+  struct shmemc_aggr *aggr; /* aggregation state, NULL if not */
+
+  bool striped;               /* chunks sent over striping lanes since
+                                 last flush */
+  unsigned long lane_flushes; /* lane flushes still outstanding */
+
+  /*
+   * quiet/fence test started on an earlier call, not yet complete
+   */
+  bool qtest_posted; /* worker flush posted */
+  void *qtest_req;   /* its request (NULL if it completed at once) */
+
+  unsigned long amo_ext_pending; /* remote-executed AMOs awaiting reply */
+
+  int wakeup_fd; /* worker's event fd for sleeping waits, -1 until needed */
+
+  shmemc_wait_policy_t wait_policy; /* DEFAULT: use SHMEM_WAIT_POLICY */
+  shmemc_wait_stats_t wait_stats;
+
   /*
    * possibly other things
    */
@@ -179,7 +272,11 @@ typedef struct comms_info {
   mem_region_t *regions; /**< exchanged symmetric regions */
   size_t nregions;       /**< how many regions */
 
+  mem_interval_t *rtable; /**< my regions, sorted by address */
+
   mem_opaque_t *orks; /* opaque rkeys (nregions * PEs) */
+
+  bool wakeup; /* workers can give us wakeup events */
 } comms_info_t;
 
 /**
@@ -0,0 +1,385 @@
+/* For license: see LICENSE file at top-level */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif /* HAVE_CONFIG_H */
+
+#include "shmemu.h"
+#include "scan.h"
+
+#include <stdint.h>
+
+#if defined(__x86_64__) && defined(HAVE_TARGET_AVX2)
+#define SCAN_HAVE_AVX2 1
+#endif /* __x86_64__ && HAVE_TARGET_AVX2 */
+
+#if defined(__x86_64__) && defined(HAVE_TARGET_AVX512)
+#define SCAN_HAVE_AVX512 1
+#endif /* __x86_64__ && HAVE_TARGET_AVX512 */
+
+#if defined(SCAN_HAVE_AVX2) || defined(SCAN_HAVE_AVX512)
+#include <immintrin.h>
+#endif /* SCAN_HAVE_AVX2 || SCAN_HAVE_AVX512 */
+
+#if defined(__aarch64__) && defined(__ARM_NEON)
+#define SCAN_HAVE_NEON 1
+#include <arm_neon.h>
+#endif /* __aarch64__ && __ARM_NEON */
+
+/*
+ * -- plain C: any block, and the tails of the vector versions ----------
+ */
+
+#define SCAN_C_LOOP(_size, _cmp)                                               \
+  for (j = 0; j < n; ++j) {                                                    \
+    const int##_size##_t c = (values != NULL) ? values[j] : value;             \
+                                                                               \
+    m |= (uint64_t)(vars[j] _cmp c) << j;                                      \
+  }
+
+#define SCAN_C(_size)                                                          \
+  static uint64_t scan_c##_size(shmemc_ucx_cmp_t op,                           \
+                                const int##_size##_t *vars, size_t n,          \
+                                const int##_size##_t *values,                  \
+                                int##_size##_t value) {                        \
+    uint64_t m = 0;                                                            \
+    size_t j;                                                                  \
+                                                                               \
+    switch (op) {                                                              \
+    case SHMEMC_UCX_CMP_EQ:                                                    \
+      SCAN_C_LOOP(_size, ==);                                                  \
+      break;                                                                   \
+    case SHMEMC_UCX_CMP_NE:                                                    \
+      SCAN_C_LOOP(_size, !=);                                                  \
+      break;                                                                   \
+    case SHMEMC_UCX_CMP_GT:                                                    \
+      SCAN_C_LOOP(_size, >);                                                   \
+      break;                                                                   \
+    case SHMEMC_UCX_CMP_LE:                                                    \
+      SCAN_C_LOOP(_size, <=);                                                  \
+      break;                                                                   \
+    case SHMEMC_UCX_CMP_LT:                                                    \
+      SCAN_C_LOOP(_size, <);                                                   \
+      break;                                                                   \
+    case SHMEMC_UCX_CMP_GE:                                                    \
+      SCAN_C_LOOP(_size, >=);                                                  \
+      break;                                                                   \
+    default:                                                                   \
+      shmemu_fatal("unknown comparison %d", (int)op);                          \
+      /* NOT REACHED */                                                        \
+      break;                                                                   \
+    }                                                                          \
+                                                                               \
+    return m;                                                                  \
+  }
+
+SCAN_C(16)
+SCAN_C(32)
+SCAN_C(64)
+
+/*
+ * AVX2 and NEON can only compare for == and >.  The rest are those
+ * with the operands swapped and/or the answer inverted.
+ */
+
+#if defined(SCAN_HAVE_AVX2) || defined(SCAN_HAVE_NEON)
+
+typedef struct scan_recipe {
+  int gt;     /* > rather than == */
+  int swap;   /* c > v */
+  int invert; /* not */
+} scan_recipe_t;
+
+inline static scan_recipe_t scan_recipe(shmemc_ucx_cmp_t op) {
+  scan_recipe_t r = {0, 0, 0};
+
+  switch (op) {
+  case SHMEMC_UCX_CMP_EQ:
+    break;
+  case SHMEMC_UCX_CMP_NE:
+    r.invert = 1;
+    break;
+  case SHMEMC_UCX_CMP_GT:
+    r.gt = 1;
+    break;
+  case SHMEMC_UCX_CMP_LE:
+    r.gt = 1;
+    r.invert = 1;
+    break;
+  case SHMEMC_UCX_CMP_LT:
+    r.gt = 1;
+    r.swap = 1;
+    break;
+  case SHMEMC_UCX_CMP_GE:
+    r.gt = 1;
+    r.swap = 1;
+    r.invert = 1;
+    break;
+  default:
+    shmemu_fatal("unknown comparison %d", (int)op);
+    /* NOT REACHED */
+    break;
+  }
+
+  return r;
+}
+
+#endif /* SCAN_HAVE_AVX2 || SCAN_HAVE_NEON */
+
+/*
+ * -- AVX2 ---------------------------------------------------------------
+ */
+
+#ifdef SCAN_HAVE_AVX2
+
+/* one bit per lane */
+#define SCAN_AVX2_BITS_64(_r) _mm256_movemask_pd(_mm256_castsi256_pd(_r))
+#define SCAN_AVX2_BITS_32(_r) _mm256_movemask_ps(_mm256_castsi256_ps(_r))
+/* narrow to bytes: packs works per 128-bit half, the permute rejoins them */
+#define SCAN_AVX2_BITS_16(_r)                                                  \
+  (_mm256_movemask_epi8(_mm256_permute4x64_epi64(                              \
+       _mm256_packs_epi16(_r, _mm256_setzero_si256()), 0xd8)) &                \
+   0xffff)
+
+#define SCAN_AVX2(_size, _lanes, _set1)                                        \
+  __attribute__((target("avx2"))) static uint64_t scan_avx2_##_size(           \
+      shmemc_ucx_cmp_t op, const int##_size##_t *vars, size_t n,               \
+      const int##_size##_t *values, int##_size##_t value) {                    \
+    const scan_recipe_t rc = scan_recipe(op);                                  \
+    const __m256i bc = _set1(value);                                           \
+    uint64_t m = 0;                                                            \
+    size_t j;                                                                  \
+                                                                               \
+    for (j = 0; j + _lanes <= n; j += _lanes) {                                \
+      const __m256i v = _mm256_loadu_si256((const __m256i *)(vars + j));       \
+      const __m256i c =                                                        \
+          (values != NULL)                                                     \
+              ? _mm256_loadu_si256((const __m256i *)(values + j))              \
+              : bc;                                                            \
+      __m256i r;                                                               \
+                                                                               \
+      if (!rc.gt) {                                                            \
+        r = _mm256_cmpeq_epi##_size(v, c);                                     \
+      } else if (rc.swap) {                                                    \
+        r = _mm256_cmpgt_epi##_size(c, v);                                     \
+      } else {                                                                 \
+        r = _mm256_cmpgt_epi##_size(v, c);                                     \
+      }                                                                        \
+      m |= (uint64_t)(uint32_t)SCAN_AVX2_BITS_##_size(r) << j;                 \
+    }                                                                          \
+    if (rc.invert) {                                                           \
+      m ^= shmemc_ucx_scan_full(j);                                            \
+    }                                                                          \
+                                                                               \
+    if (j < n) {                                                               \
+      m |= scan_c##_size(op, vars + j, n - j,                                  \
+                         (values != NULL) ? values + j : NULL, value)          \
+           << j;                                                               \
+    }                                                                          \
+                                                                               \
+    return m;                                                                  \
+  }
+
+SCAN_AVX2(16, 16, _mm256_set1_epi16)
+SCAN_AVX2(32, 8, _mm256_set1_epi32)
+SCAN_AVX2(64, 4, _mm256_set1_epi64x)
+
+#endif /* SCAN_HAVE_AVX2 */
+
+/*
+ * -- AVX-512 ------------------------------------------------------------
+ *
+ * Compares straight into a mask register, all 6 operators, and
+ * masked loads take care of the tail.
+ */
+
+#ifdef SCAN_HAVE_AVX512
+
+#define SCAN_AVX512_LOOP(_size, _lanes, _mtype, _set1, _imm)                   \
+  for (j = 0; j < n; j += _lanes) {                                            \
+    const size_t left = n - j;                                                 \
+    const _mtype k =                                                           \
+        (_mtype)((left >= _lanes) ? ~(uint64_t)0                               \
+                                  : (((uint64_t)1 << left) - 1));              \
+    const __m512i v = _mm512_maskz_loadu_epi##_size(k, vars + j);              \
+    const __m512i c = (values != NULL)                                         \
+                          ? _mm512_maskz_loadu_epi##_size(k, values + j)       \
+                          : _set1(value);                                      \
+                                                                               \
+    m |= (uint64_t)_mm512_mask_cmp_epi##_size##_mask(k, v, c, _imm) << j;      \
+  }
+
+#define SCAN_AVX512(_size, _lanes, _mtype, _set1, _isa)                        \
+  __attribute__((target(_isa))) static uint64_t scan_avx512_##_size(           \
+      shmemc_ucx_cmp_t op, const int##_size##_t *vars, size_t n,               \
+      const int##_size##_t *values, int##_size##_t value) {                    \
+    uint64_t m = 0;                                                            \
+    size_t j;                                                                  \
+                                                                               \
+    switch (op) {                                                              \
+    case SHMEMC_UCX_CMP_EQ:                                                    \
+      SCAN_AVX512_LOOP(_size, _lanes, _mtype, _set1, _MM_CMPINT_EQ);           \
+      break;                                                                   \
+    case SHMEMC_UCX_CMP_NE:                                                    \
+      SCAN_AVX512_LOOP(_size, _lanes, _mtype, _set1, _MM_CMPINT_NE);           \
+      break;                                                                   \
+    case SHMEMC_UCX_CMP_GT:                                                    \
+      SCAN_AVX512_LOOP(_size, _lanes, _mtype, _set1, _MM_CMPINT_NLE);          \
+      break;                                                                   \
+    case SHMEMC_UCX_CMP_LE:                                                    \
+      SCAN_AVX512_LOOP(_size, _lanes, _mtype, _set1, _MM_CMPINT_LE);           \
+      break;                                                                   \
+    case SHMEMC_UCX_CMP_LT:                                                    \
+      SCAN_AVX512_LOOP(_size, _lanes, _mtype, _set1, _MM_CMPINT_LT);           \
+      break;                                                                   \
+    case SHMEMC_UCX_CMP_GE:                                                    \
+      SCAN_AVX512_LOOP(_size, _lanes, _mtype, _set1, _MM_CMPINT_NLT);          \
+      break;                                                                   \
+    default:                                                                   \
+      shmemu_fatal("unknown comparison %d", (int)op);                          \
+      /* NOT REACHED */                                                        \
+      break;                                                                   \
+    }                                                                          \
+                                                                               \
+    return m;                                                                  \
+  }
+
+SCAN_AVX512(16, 32, __mmask32, _mm512_set1_epi16, "avx512f,avx512bw")
+SCAN_AVX512(32, 16, __mmask16, _mm512_set1_epi32, "avx512f")
+SCAN_AVX512(64, 8, __mmask8, _mm512_set1_epi64, "avx512f")
+
+#endif /* SCAN_HAVE_AVX512 */
+
+/*
+ * -- NEON ---------------------------------------------------------------
+ *
+ * No movemask: AND each lane with its own bit and add across.
+ */
+
+#ifdef SCAN_HAVE_NEON
+
+static const uint16_t scan_bits16[8] = {1, 2, 4, 8, 16, 32, 64, 128};
+static const uint32_t scan_bits32[4] = {1, 2, 4, 8};
+static const uint64_t scan_bits64[2] = {1, 2};
+
+#define SCAN_NEON(_size, _lanes)                                               \
+  static uint64_t scan_neon##_size(shmemc_ucx_cmp_t op,                        \
+                                   const int##_size##_t *vars, size_t n,       \
+                                   const int##_size##_t *values,               \
+                                   int##_size##_t value) {                     \
+    const scan_recipe_t rc = scan_recipe(op);                                  \
+    const int##_size##x##_lanes##_t bc = vdupq_n_s##_size(value);              \
+    const uint##_size##x##_lanes##_t bits = vld1q_u##_size(scan_bits##_size);  \
+    uint64_t m = 0;                                                            \
+    size_t j;                                                                  \
+                                                                               \
+    for (j = 0; j + _lanes <= n; j += _lanes) {                                \
+      const int##_size##x##_lanes##_t v = vld1q_s##_size(vars + j);            \
+      const int##_size##x##_lanes##_t c =                                      \
+          (values != NULL) ? vld1q_s##_size(values + j) : bc;                  \
+      uint##_size##x##_lanes##_t r;                                            \
+                                                                               \
+      if (!rc.gt) {                                                            \
+        r = vceqq_s##_size(v, c);                                              \
+      } else if (rc.swap) {                                                    \
+        r = vcgtq_s##_size(c, v);                                              \
+      } else {                                                                 \
+        r = vcgtq_s##_size(v, c);                                              \
+      }                                                                        \
+      m |= (uint64_t)vaddvq_u##_size(vandq_u##_size(r, bits)) << j;            \
+    }                                                                          \
+    if (rc.invert) {                                                           \
+      m ^= shmemc_ucx_scan_full(j);                                            \
+    }                                                                          \
+                                                                               \
+    if (j < n) {                                                               \
+      m |= scan_c##_size(op, vars + j, n - j,                                  \
+                         (values != NULL) ? values + j : NULL, value)          \
+           << j;                                                               \
+    }                                                                          \
+                                                                               \
+    return m;                                                                  \
+  }
+
+SCAN_NEON(16, 8)
+SCAN_NEON(32, 4)
+SCAN_NEON(64, 2)
+
+#endif /* SCAN_HAVE_NEON */
+
+/*
+ * -- pick the best the CPU can do --------------------------------------
+ */
+
+typedef uint64_t (*scan16_fn_t)(shmemc_ucx_cmp_t, const int16_t *, size_t,
+                                const int16_t *, int16_t);
+typedef uint64_t (*scan32_fn_t)(shmemc_ucx_cmp_t, const int32_t *, size_t,
+                                const int32_t *, int32_t);
+typedef uint64_t (*scan64_fn_t)(shmemc_ucx_cmp_t, const int64_t *, size_t,
+                                const int64_t *, int64_t);
+
+static scan16_fn_t scan16 = scan_c16;
+static scan32_fn_t scan32 = scan_c32;
+static scan64_fn_t scan64 = scan_c64;
+
+void shmemc_ucx_scan_init(void) {
+#ifdef SCAN_HAVE_AVX2
+  if (__builtin_cpu_supports("avx2")) {
+    scan16 = scan_avx2_16;
+    scan32 = scan_avx2_32;
+    scan64 = scan_avx2_64;
+  }
+#endif /* SCAN_HAVE_AVX2 */
+#ifdef SCAN_HAVE_AVX512
+  if (__builtin_cpu_supports("avx512f")) {
+    scan32 = scan_avx512_32;
+    scan64 = scan_avx512_64;
+    if (__builtin_cpu_supports("avx512bw")) {
+      scan16 = scan_avx512_16;
+    }
+  }
+#endif /* SCAN_HAVE_AVX512 */
+#ifdef SCAN_HAVE_NEON
+  scan16 = scan_neon16;
+  scan32 = scan_neon32;
+  scan64 = scan_neon64;
+#endif /* SCAN_HAVE_NEON */
+}
+
+uint64_t shmemc_ucx_scan16(shmemc_ucx_cmp_t op, const int16_t *vars,
+                           size_t n, const int16_t *values, int16_t value) {
+  return scan16(op, vars, n, values, value);
+}
+
+uint64_t shmemc_ucx_scan32(shmemc_ucx_cmp_t op, const int32_t *vars,
+                           size_t n, const int32_t *values, int32_t value) {
+  return scan32(op, vars, n, values, value);
+}
+
+uint64_t shmemc_ucx_scan64(shmemc_ucx_cmp_t op, const int64_t *vars,
+                           size_t n, const int64_t *values, int64_t value) {
+  return scan64(op, vars, n, values, value);
+}
+
+/*
+ * status entries are ints: 0 means look at it
+ */
+uint64_t shmemc_ucx_scan_included(const int *status, size_t n) {
+  if (status == NULL) {
+    return shmemc_ucx_scan_full(n);
+    /* NOT REACHED */
+  }
+
+  if (sizeof(int) == sizeof(int32_t)) {
+    return scan32(SHMEMC_UCX_CMP_EQ, (const int32_t *)status, n, NULL, 0);
+    /* NOT REACHED */
+  } else {
+    uint64_t m = 0;
+    size_t j;
+
+    for (j = 0; j < n; ++j) {
+      m |= (uint64_t)(status[j] == 0) << j;
+    }
+    return m;
+  }
+}
@@ -0,0 +1,73 @@
+/* For license: see LICENSE file at top-level */
+
+#ifndef _SHMEMC_UCX_SCAN_H
+#define _SHMEMC_UCX_SCAN_H 1
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif /* HAVE_CONFIG_H */
+
+#include <sys/types.h>
+#include <stdint.h>
+
+/*
+ * Comparison kernels for the test/wait routines on arrays of
+ * variables.  They work on blocks of up to SHMEMC_UCX_SCAN_BLOCK
+ * variables and give back a bitmask: bit i set if vars[i] satisfies
+ * the comparison.  Uses AVX2/AVX-512 if the CPU has them (checked at
+ * run-time), NEON on aarch64, plain C otherwise.
+ */
+
+#define SHMEMC_UCX_SCAN_BLOCK 64
+
+typedef enum shmemc_ucx_cmp {
+  SHMEMC_UCX_CMP_EQ = 0,
+  SHMEMC_UCX_CMP_NE,
+  SHMEMC_UCX_CMP_GT,
+  SHMEMC_UCX_CMP_LE,
+  SHMEMC_UCX_CMP_LT,
+  SHMEMC_UCX_CMP_GE
+} shmemc_ucx_cmp_t;
+
+/*
+ * so the per-operation macros can name them
+ */
+#define SHMEMC_UCX_CMP_eq SHMEMC_UCX_CMP_EQ
+#define SHMEMC_UCX_CMP_ne SHMEMC_UCX_CMP_NE
+#define SHMEMC_UCX_CMP_gt SHMEMC_UCX_CMP_GT
+#define SHMEMC_UCX_CMP_le SHMEMC_UCX_CMP_LE
+#define SHMEMC_UCX_CMP_lt SHMEMC_UCX_CMP_LT
+#define SHMEMC_UCX_CMP_ge SHMEMC_UCX_CMP_GE
+
+/*
+ * choose kernels for this CPU
+ */
+void shmemc_ucx_scan_init(void);
+
+/*
+ * compare the first "n" of vars with value, or with values[i] if
+ * values isn't NULL
+ */
+uint64_t shmemc_ucx_scan16(shmemc_ucx_cmp_t op, const int16_t *vars,
+                           size_t n, const int16_t *values, int16_t value);
+uint64_t shmemc_ucx_scan32(shmemc_ucx_cmp_t op, const int32_t *vars,
+                           size_t n, const int32_t *values, int32_t value);
+uint64_t shmemc_ucx_scan64(shmemc_ucx_cmp_t op, const int64_t *vars,
+                           size_t n, const int64_t *values, int64_t value);
+
+/*
+ * which of "n" variables status lets us look at (all, if NULL)
+ */
+uint64_t shmemc_ucx_scan_included(const int *status, size_t n);
+
+inline static size_t shmemc_ucx_scan_len(size_t nelems, size_t base) {
+  const size_t left = nelems - base;
+
+  return (left < SHMEMC_UCX_SCAN_BLOCK) ? left : SHMEMC_UCX_SCAN_BLOCK;
+}
+
+inline static uint64_t shmemc_ucx_scan_full(size_t n) {
+  return (n >= 64) ? ~(uint64_t)0 : (((uint64_t)1 << n) - 1);
+}
+
+#endif /* ! _SHMEMC_UCX_SCAN_H */
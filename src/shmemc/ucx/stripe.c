@@ -0,0 +1,197 @@
+/* For license: see LICENSE file at top-level */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif /* HAVE_CONFIG_H */
+
+#include "state.h"
+#include "shmemu.h"
+#include "shmemc.h"
+#include "api.h"
+#include "stripe.h"
+#include "module.h"
+
+#include <stdlib.h>
+
+#include <ucp/api/ucp.h>
+
+#ifdef SHMEMC_UCX_STRIPING
+
+/*
+ * the internal lanes, lane 0 (caller's context) not included
+ */
+static shmemc_context_h *lanes = NULL;
+static size_t nlanes = 0;
+
+static shmemc_context_h lane_create(size_t i) {
+  shmemc_context_h lp;
+  ucs_status_t s;
+
+  lp = (shmemc_context_h)calloc(1, sizeof(*lp));
+  shmemu_assert(lp != NULL, MODULE ": can't allocate striping lane %lu",
+                (unsigned long)i);
+
+  /*
+   * lanes are shared by all contexts, so by all threads too, and a
+   * progress thread drives them as well (it doesn't exist yet, so go
+   * by whether one was asked for)
+   */
+  lp->attr.serialized = (proc.td.osh_tl != SHMEM_THREAD_MULTIPLE) &&
+                        (proc.env.progress_threads == NULL);
+
+  shmemu_assert(shmemc_ucx_context_progress(lp) == 0,
+                MODULE ": can't create worker for striping lane %lu",
+                (unsigned long)i);
+
+  shmemc_ucx_make_eps(lp);
+
+  s = shmemc_ucx_worker_wireup(lp);
+  shmemu_assert(s == UCS_OK,
+                MODULE ": can't wire up striping lane %lu (status: %s)",
+                (unsigned long)i, ucs_status_string(s));
+
+  lp->id = (unsigned long)i;
+  lp->creator_thread = threadwrap_thread_id();
+
+  return lp;
+}
+
+void shmemc_ucx_stripe_init(void) {
+  size_t i;
+
+  if (proc.env.stripe_lanes < 2) {
+    return;
+    /* NOT REACHED */
+  }
+
+  nlanes = proc.env.stripe_lanes - 1;
+
+  lanes = (shmemc_context_h *)calloc(nlanes, sizeof(*lanes));
+  shmemu_assert(lanes != NULL, MODULE ": can't allocate %lu striping lanes",
+                (unsigned long)nlanes);
+
+  for (i = 0; i < nlanes; ++i) {
+    lanes[i] = lane_create(i + 1);
+  }
+
+  logger(LOG_INIT, "striping transfers of %lu bytes or more over %lu lanes",
+         (unsigned long)proc.env.stripe_threshold,
+         (unsigned long)proc.env.stripe_lanes);
+}
+
+void shmemc_ucx_stripe_finalize(void) {
+  size_t i;
+
+  for (i = 0; i < nlanes; ++i) {
+    shmemc_ucx_teardown_context(lanes[i]);
+    free(lanes[i]);
+  }
+  free(lanes);
+
+  lanes = NULL;
+  nlanes = 0;
+}
+
+size_t shmemc_ucx_stripe_nlanes(void) { return nlanes; }
+
+shmemc_context_h shmemc_ucx_stripe_lane(size_t i) { return lanes[i]; }
+
+void shmemc_ucx_stripe_progress(void) {
+  size_t i;
+
+  for (i = 0; i < nlanes; ++i) {
+    (void)ucp_worker_progress(lanes[i]->w);
+  }
+}
+
+/*
+ * Lanes are shared, so this may complete other contexts' chunks too,
+ * which does no harm.  The first call posts a flush on every lane,
+ * later ones just progress until all have come back.
+ */
+
+static void lane_flushed_callbackx(void *req, ucs_status_t status,
+                                   void *user_data) {
+  shmemc_context_h ch = (shmemc_context_h)user_data;
+
+  shmemu_assert(status == UCS_OK,
+                MODULE ": flush of striping lane failed (status: %s)",
+                ucs_status_string(status));
+
+  __atomic_sub_fetch(&ch->lane_flushes, 1, __ATOMIC_RELEASE);
+  ucp_request_free(req);
+}
+
+int shmemc_ucx_stripe_test(shmemc_context_h ch) {
+  if (__atomic_exchange_n(&ch->striped, false, __ATOMIC_ACQ_REL)) {
+    const ucp_request_param_t prm = {.op_attr_mask =
+                                         UCP_OP_ATTR_FIELD_CALLBACK |
+                                         UCP_OP_ATTR_FIELD_USER_DATA,
+                                     .cb.send = lane_flushed_callbackx,
+                                     .user_data = ch};
+    size_t i;
+
+    for (i = 0; i < nlanes; ++i) {
+      ucs_status_ptr_t sp;
+
+      /* count it first, callback can run on another thread */
+      __atomic_add_fetch(&ch->lane_flushes, 1, __ATOMIC_RELEASE);
+
+      sp = ucp_worker_flush_nbx(lanes[i]->w, &prm);
+      if (sp == NULL) {
+        __atomic_sub_fetch(&ch->lane_flushes, 1, __ATOMIC_RELEASE);
+      } else {
+        shmemu_assert(!UCS_PTR_IS_ERR(sp),
+                      MODULE ": can't flush striping lane %lu (status: %s)",
+                      (unsigned long)(i + 1),
+                      ucs_status_string(UCS_PTR_STATUS(sp)));
+      }
+    }
+  }
+
+  if (__atomic_load_n(&ch->lane_flushes, __ATOMIC_ACQUIRE) == 0) {
+    return 1;
+    /* NOT REACHED */
+  }
+
+  shmemc_ucx_stripe_progress();
+
+  return __atomic_load_n(&ch->lane_flushes, __ATOMIC_ACQUIRE) == 0;
+}
+
+void shmemc_ucx_stripe_flush(shmemc_context_h ch) {
+  while (!shmemc_ucx_stripe_test(ch)) {
+    continue;
+  }
+}
+
+#else /* ! SHMEMC_UCX_STRIPING */
+
+void shmemc_ucx_stripe_init(void) {
+  if (proc.env.stripe_lanes > 1) {
+    shmemu_warn(MODULE ": this UCX can't stripe transfers, "
+                       "ignoring SHMEM_STRIPE_LANES");
+  }
+}
+
+void shmemc_ucx_stripe_finalize(void) {}
+
+size_t shmemc_ucx_stripe_nlanes(void) { return 0; }
+
+shmemc_context_h shmemc_ucx_stripe_lane(size_t i) {
+  NO_WARN_UNUSED(i);
+
+  return NULL;
+}
+
+void shmemc_ucx_stripe_progress(void) {}
+
+int shmemc_ucx_stripe_test(shmemc_context_h ch) {
+  NO_WARN_UNUSED(ch);
+
+  return 1;
+}
+
+void shmemc_ucx_stripe_flush(shmemc_context_h ch) { NO_WARN_UNUSED(ch); }
+
+#endif /* SHMEMC_UCX_STRIPING */
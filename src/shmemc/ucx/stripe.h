@@ -0,0 +1,52 @@
+/* For license: see LICENSE file at top-level */
+
+#ifndef _SHMEMC_UCX_STRIPE_H
+#define _SHMEMC_UCX_STRIPE_H 1
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif /* HAVE_CONFIG_H */
+
+#include "pe.h"
+
+#include <sys/types.h>
+
+/*
+ * Striping: large puts/gets are cut into chunks, one per lane.  Lane
+ * 0 is the caller's own context, the others are a small pool of
+ * internal contexts (own worker, endpoints and rkeys) shared by all
+ * user contexts, so the chunks can travel over different endpoints,
+ * and rails, at the same time.
+ *
+ * Off unless SHMEM_STRIPE_LANES > 1.
+ */
+
+#if defined(HAVE_UCP_PUT_NBX) && defined(HAVE_UCP_GET_NBX) &&                  \
+    defined(HAVE_UCP_WORKER_FLUSH_NBX)
+#define SHMEMC_UCX_STRIPING 1
+#endif /* HAVE_UCP_PUT_NBX && HAVE_UCP_GET_NBX && HAVE_UCP_WORKER_FLUSH_NBX */
+
+/*
+ * most lanes, counting the caller's context
+ */
+#define SHMEMC_MAX_STRIPE_LANES 16
+
+void shmemc_ucx_stripe_init(void);
+void shmemc_ucx_stripe_finalize(void);
+
+/*
+ * number of internal lanes (0 => not striping), and the i'th one
+ */
+size_t shmemc_ucx_stripe_nlanes(void);
+shmemc_context_h shmemc_ucx_stripe_lane(size_t i);
+
+void shmemc_ucx_stripe_progress(void);
+
+/*
+ * complete anything context has sent over the lanes: test only
+ * starts it and returns non-zero once done, flush waits
+ */
+int shmemc_ucx_stripe_test(shmemc_context_h ch);
+void shmemc_ucx_stripe_flush(shmemc_context_h ch);
+
+#endif /* ! _SHMEMC_UCX_STRIPE_H */
@@ -6,6 +6,9 @@
 
 #include "shmemu.h"
 #include "shmemc.h"
+#include "scan.h"
+
+#include <stdint.h>
 
 /*
  * return 1 if the memory location changed w.r.t "value", otherwise 0
@@ -50,26 +53,109 @@ COMMS_CTX_TEST_SIZE(32, ge, >=)
 COMMS_CTX_TEST_SIZE(64, ge, >=)
 
 /*
- * return 1 if all the memory locations changed w.r.t "value",
- * otherwise 0
+ * Arrays are compared a block at a time by the kernels in scan.c,
+ * which hand back bitmasks of the ones that match.  Progress once
+ * per call if nothing (or not everything) did, not once per
+ * variable.
  */
 
-#define COMMS_CTX_TEST_ALL_SIZE(_size, _opname)                                \
-  int shmemc_ctx_test_all_##_opname##_size(                                    \
-      shmem_ctx_t ctx, int##_size##_t *vars, size_t nelems, const int *status, \
-      int##_size##_t value) {                                                  \
-    size_t i;                                                                  \
-    int n = 0;                                                                 \
+#define TEST_INCLUDED(_status, _b, _n)                                         \
+  shmemc_ucx_scan_included(((_status) != NULL) ? (_status) + (_b) : NULL, _n)
+
+#define TEST_SCAN(_size, _op, _vars, _values, _value, _b, _n)                  \
+  shmemc_ucx_scan##_size(_op, (_vars) + (_b), _n,                              \
+                         ((_values) != NULL) ? (_values) + (_b) : NULL, _value)
+
+#define TEST_ARRAY(_size)                                                      \
+  static int test_all##_size(shmem_ctx_t ctx, shmemc_ucx_cmp_t op,             \
+                             const int##_size##_t *vars, size_t nelems,        \
+                             const int *status, const int##_size##_t *values,  \
+                             int##_size##_t value) {                           \
+    size_t b;                                                                  \
+                                                                               \
+    for (b = 0; b < nelems; b += SHMEMC_UCX_SCAN_BLOCK) {                      \
+      const size_t n = shmemc_ucx_scan_len(nelems, b);                         \
+      const uint64_t want = TEST_INCLUDED(status, b, n);                       \
+      const uint64_t hit = TEST_SCAN(_size, op, vars, values, value, b, n);    \
                                                                                \
-    for (i = 0; i < nelems; ++i) {                                             \
-      if ((status != NULL) && (status[i] != 0)) {                              \
-        continue;                                                              \
+      if ((hit & want) != want) {                                              \
+        shmemc_ctx_progress(ctx);                                              \
+        return 0;                                                              \
+        /* NOT REACHED */                                                      \
       }                                                                        \
+    }                                                                          \
+                                                                               \
+    /* the scans were plain loads: order what the caller reads next */         \
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);                                   \
+    return 1;                                                                  \
+  }                                                                            \
                                                                                \
-      n += shmemc_ctx_test_##_opname##_size(ctx, &(vars[i]), value);           \
+  static size_t test_any##_size(shmem_ctx_t ctx, shmemc_ucx_cmp_t op,          \
+                                const int##_size##_t *vars, size_t nelems,     \
+                                const int *status,                             \
+                                const int##_size##_t *values,                  \
+                                int##_size##_t value) {                        \
+    size_t b;                                                                  \
+                                                                               \
+    for (b = 0; b < nelems; b += SHMEMC_UCX_SCAN_BLOCK) {                      \
+      const size_t n = shmemc_ucx_scan_len(nelems, b);                         \
+      const uint64_t hit = TEST_SCAN(_size, op, vars, values, value, b, n) &   \
+                           TEST_INCLUDED(status, b, n);                        \
+                                                                               \
+      if (hit != 0) {                                                          \
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);                               \
+        return b + __builtin_ctzll(hit);                                       \
+        /* NOT REACHED */                                                      \
+      }                                                                        \
     }                                                                          \
                                                                                \
-    return ((size_t)n == nelems) ? 1 : 0;                                      \
+    shmemc_ctx_progress(ctx);                                                  \
+    return SIZE_MAX;                                                           \
+  }                                                                            \
+                                                                               \
+  static size_t test_some##_size(shmem_ctx_t ctx, shmemc_ucx_cmp_t op,         \
+                                 const int##_size##_t *vars, size_t nelems,    \
+                                 size_t *idxs, const int *status,              \
+                                 const int##_size##_t *values,                 \
+                                 int##_size##_t value) {                       \
+    size_t hits = 0;                                                           \
+    size_t b;                                                                  \
+                                                                               \
+    for (b = 0; b < nelems; b += SHMEMC_UCX_SCAN_BLOCK) {                      \
+      const size_t n = shmemc_ucx_scan_len(nelems, b);                         \
+      uint64_t hit = TEST_SCAN(_size, op, vars, values, value, b, n) &         \
+                     TEST_INCLUDED(status, b, n);                              \
+                                                                               \
+      while (hit != 0) {                                                       \
+        idxs[hits] = b + __builtin_ctzll(hit);                                 \
+        ++hits;                                                                \
+        hit &= hit - 1;                                                        \
+      }                                                                        \
+    }                                                                          \
+                                                                               \
+    if (hits == 0) {                                                           \
+      shmemc_ctx_progress(ctx);                                                \
+    } else {                                                                   \
+      __atomic_thread_fence(__ATOMIC_ACQUIRE);                                 \
+    }                                                                          \
+                                                                               \
+    return hits;                                                               \
+  }
+
+TEST_ARRAY(16)
+TEST_ARRAY(32)
+TEST_ARRAY(64)
+
+/*
+ * return 1 if all the memory locations changed w.r.t "value",
+ * otherwise 0
+ */
+#define COMMS_CTX_TEST_ALL_SIZE(_size, _opname)                                \
+  int shmemc_ctx_test_all_##_opname##_size(                                    \
+      shmem_ctx_t ctx, int##_size##_t *vars, size_t nelems, const int *status, \
+      int##_size##_t value) {                                                  \
+    return test_all##_size(ctx, SHMEMC_UCX_CMP_##_opname, vars, nelems,        \
+                           status, NULL, value);                               \
   }
 
 COMMS_CTX_TEST_ALL_SIZE(16, eq)
@@ -97,26 +183,15 @@ COMMS_CTX_TEST_ALL_SIZE(32, ge)
 COMMS_CTX_TEST_ALL_SIZE(64, ge)
 
 /*
- * return how many memory locations changed w.r.t "value", otherwise 0
+ * return how many memory locations changed w.r.t "value" (indices in
+ * idxs), otherwise 0
  */
-
 #define COMMS_CTX_TEST_SOME_SIZE(_size, _opname)                               \
   size_t shmemc_ctx_test_some_##_opname##_size(                                \
       shmem_ctx_t ctx, int##_size##_t *vars, size_t nelems, size_t *idxs,      \
       const int *status, int##_size##_t value) {                               \
-    size_t n;                                                                  \
-    size_t i = 0;                                                              \
-                                                                               \
-    for (n = 0; n < nelems; ++n) {                                             \
-      if ((status != NULL) && (status[n] != 0)) {                              \
-        continue;                                                              \
-      }                                                                        \
-                                                                               \
-      if (shmemc_ctx_test_##_opname##_size(ctx, &(vars[n]), value) != 0) {     \
-        idxs[i++] = n;                                                         \
-      }                                                                        \
-    }                                                                          \
-    return i;                                                                  \
+    return test_some##_size(ctx, SHMEMC_UCX_CMP_##_opname, vars, nelems,       \
+                            idxs, status, NULL, value);                        \
   }
 
 COMMS_CTX_TEST_SOME_SIZE(16, eq)
@@ -145,25 +220,14 @@ COMMS_CTX_TEST_SOME_SIZE(64, ge)
 
 /*
  * return the index of a memory location that changed w.r.t "value",
- * otherwise 0
+ * otherwise SIZE_MAX
  */
-
 #define COMMS_CTX_TEST_ANY_SIZE(_size, _opname)                                \
   size_t shmemc_ctx_test_any_##_opname##_size(                                 \
       shmem_ctx_t ctx, int##_size##_t *vars, size_t nelems, const int *status, \
       int##_size##_t value) {                                                  \
-    size_t n;                                                                  \
-                                                                               \
-    for (n = 0; n < nelems; ++n) {                                             \
-      if ((status != NULL) && (status[n] != 0)) {                              \
-        continue;                                                              \
-      }                                                                        \
-                                                                               \
-      if (shmemc_ctx_test_##_opname##_size(ctx, &(vars[n]), value) != 0) {     \
-        return n;                                                              \
-      }                                                                        \
-    }                                                                          \
-    return 0;                                                                  \
+    return test_any##_size(ctx, SHMEMC_UCX_CMP_##_opname, vars, nelems,        \
+                           status, NULL, value);                               \
   }
 
 COMMS_CTX_TEST_ANY_SIZE(16, eq)
@@ -194,19 +258,8 @@ COMMS_CTX_TEST_ANY_SIZE(64, ge)
   int shmemc_ctx_test_all_vector_##_opname##_size(                             \
       shmem_ctx_t ctx, int##_size##_t *vars, size_t nelems, const int *status, \
       void *values) {                                                          \
-    int##_size##_t *vs = (int##_size##_t *)values;                             \
-    size_t i;                                                                  \
-    int n = 0;                                                                 \
-                                                                               \
-    for (i = 0; i < nelems; ++i) {                                             \
-      if ((status != NULL) && (status[i] != 0)) {                              \
-        continue;                                                              \
-      }                                                                        \
-                                                                               \
-      n += shmemc_ctx_test_##_opname##_size(ctx, &(vars[i]), vs[i]);           \
-    }                                                                          \
-                                                                               \
-    return ((size_t)n == nelems) ? 1 : 0;                                      \
+    return test_all##_size(ctx, SHMEMC_UCX_CMP_##_opname, vars, nelems,        \
+                           status, (const int##_size##_t *)values, 0);         \
   }
 
 COMMS_CTX_TEST_ALL_VECTOR_SIZE(16, eq)
@@ -237,20 +290,8 @@ COMMS_CTX_TEST_ALL_VECTOR_SIZE(64, ge)
   size_t shmemc_ctx_test_some_vector_##_opname##_size(                         \
       shmem_ctx_t ctx, int##_size##_t *vars, size_t nelems, size_t *idxs,      \
       const int *status, void *values) {                                       \
-    int##_size##_t *vs = (int##_size##_t *)values;                             \
-    size_t n;                                                                  \
-    size_t i = 0;                                                              \
-                                                                               \
-    for (n = 0; n < nelems; ++n) {                                             \
-      if ((status != NULL) && (status[n] != 0)) {                              \
-        continue;                                                              \
-      }                                                                        \
-                                                                               \
-      if (shmemc_ctx_test_##_opname##_size(ctx, &(vars[n]), vs[n]) != 0) {     \
-        idxs[i++] = n;                                                         \
-      }                                                                        \
-    }                                                                          \
-    return i;                                                                  \
+    return test_some##_size(ctx, SHMEMC_UCX_CMP_##_opname, vars, nelems,       \
+                            idxs, status, (const int##_size##_t *)values, 0);  \
   }
 
 COMMS_CTX_TEST_SOME_VECTOR_SIZE(16, eq)
@@ -281,19 +322,8 @@ COMMS_CTX_TEST_SOME_VECTOR_SIZE(64, ge)
   size_t shmemc_ctx_test_any_vector_##_opname##_size(                          \
       shmem_ctx_t ctx, int##_size##_t *vars, size_t nelems, const int *status, \
       void *values) {                                                          \
-    int##_size##_t *vs = (int##_size##_t *)values;                             \
-    size_t n;                                                                  \
-                                                                               \
-    for (n = 0; n < nelems; ++n) {                                             \
-      if ((status != NULL) && (status[n] != 0)) {                              \
-        continue;                                                              \
-      }                                                                        \
-                                                                               \
-      if (shmemc_ctx_test_##_opname##_size(ctx, &(vars[n]), vs[n]) != 0) {     \
-        return n;                                                              \
-      }                                                                        \
-    }                                                                          \
-    return 0;                                                                  \
+    return test_any##_size(ctx, SHMEMC_UCX_CMP_##_opname, vars, nelems,        \
+                           status, (const int##_size##_t *)values, 0);         \
   }
 
 COMMS_CTX_TEST_ANY_VECTOR_SIZE(16, eq)
@@ -6,23 +6,213 @@
 
 #include "shmemu.h"
 #include "shmemc.h"
+#include "state.h"
+#include "module.h"
+#include "scan.h"
+#include "api.h"
+#include "boolean.h"
 
 #include "yielder.h"
 
+#include <stdint.h>
+#include <string.h>
+#ifdef HAVE_POLL_H
+#include <poll.h>
+#endif /* HAVE_POLL_H */
+
 #include <ucp/api/ucp.h>
 
-#if 0
-#define VOLATILIZE(_type, _var) (*(volatile _type *)(_var))
-#endif
+/*
+ * Waiting
+ *
+ * A wait spins making progress on its context for a while
+ * (SHMEM_WAIT_SPIN), then does what its policy says between checks:
+ *
+ *   spin     keep spinning (never leaves the spin phase)
+ *   yield    wait on the address, then sched_yield() (the default)
+ *   backoff  sleep, doubling from WAIT_NAP_MIN_NS to WAIT_NAP_MAX_NS
+ *   event    sleep on the worker's wakeup event (yield if the
+ *            workers weren't set up for them)
+ *
+ * Remote puts and AMOs into our memory raise no event, so event
+ * sleeps are cut short after WAIT_SLEEP_MS; anything that does
+ * (active messages, completions) wakes us at once.
+ *
+ * Backoff and event give the core away for longer and cost latency, so
+ * they have to be asked for.  The policy comes from SHMEM_WAIT_POLICY
+ * unless the context has its own.  Each context counts what its waits
+ * did.
+ */
+
+#define WAIT_SLEEP_MS 1
+
+#define WAIT_NAP_MIN_NS 1000L
+#define WAIT_NAP_MAX_NS 1000000L
+
+#define WAIT_COUNT(_wp, _field)                                                \
+  __atomic_add_fetch(&(_wp)->ch->wait_stats._field, 1, __ATOMIC_RELAXED)
+
+typedef struct waiter {
+  shmemc_context_h ch;
+  shmemc_wait_policy_t policy;
+  double spin_until; /* < 0 until the first miss */
+  long nap_ns;       /* next backoff sleep */
+} waiter_t;
+
+inline static void waiter_init(waiter_t *wp, shmem_ctx_t ctx) {
+  wp->ch = (shmemc_context_h)ctx;
+  wp->policy = (wp->ch->wait_policy != SHMEMC_WAIT_DEFAULT)
+                   ? wp->ch->wait_policy
+                   : proc.env.wait_policy;
+  /* no wakeup events unless event waits were asked for at startup */
+  if ((wp->policy == SHMEMC_WAIT_EVENT) && !proc.comms.wakeup) {
+    wp->policy = SHMEMC_WAIT_YIELD;
+  }
+  wp->spin_until = -1.0;
+  wp->nap_ns = WAIT_NAP_MIN_NS;
+}
+
+/*
+ * returns true if something woke us before the timeout
+ */
+static bool waiter_sleep(shmemc_context_h ch) {
+#if defined(HAVE_POLL_H) && defined(HAVE_POLL)
+  struct pollfd pfd;
+  const int fd = shmemc_ucx_context_efd(ch);
+
+  if (fd < 0) {
+    yielder();
+    return false;
+    /* NOT REACHED */
+  }
+
+  if (!shmemc_ucx_context_arm(ch)) {
+    return true; /* events already in, go and look */
+    /* NOT REACHED */
+  }
+
+  pfd.fd = fd;
+  pfd.events = POLLIN;
+  pfd.revents = 0;
+
+  return poll(&pfd, 1, WAIT_SLEEP_MS) > 0;
+#else
+  NO_WARN_UNUSED(ch);
+
+  yielder();
+  return false;
+#endif /* HAVE_POLL_H && HAVE_POLL */
+}
+
+/*
+ * nothing satisfied: progress, then spin on (watching ADDR, if only
+ * one) or back off as the policy says
+ */
+static void waiter_pause(waiter_t *wp, void *addr) {
+  double now;
+
+  shmemc_ctx_progress((shmem_ctx_t)wp->ch);
+
+  if (wp->policy == SHMEMC_WAIT_SPIN) {
+    if (wp->spin_until < 0.0) {
+      wp->spin_until = 0.0;
+      WAIT_COUNT(wp, waits);
+    }
+    WAIT_COUNT(wp, spins);
+    spinner();
+    return;
+    /* NOT REACHED */
+  }
+
+  now = shmemu_timer();
+  if (wp->spin_until < 0.0) {
+    wp->spin_until = now + (double)proc.env.wait_spin_ns * 1.0e-9;
+    WAIT_COUNT(wp, waits);
+  }
+
+  if (now < wp->spin_until) {
+    WAIT_COUNT(wp, spins);
+    if (addr != NULL) {
+      ucp_worker_wait_mem(wp->ch->w, addr);
+    } else {
+      spinner();
+    }
+    return;
+    /* NOT REACHED */
+  }
+
+  switch (wp->policy) {
+  case SHMEMC_WAIT_YIELD:
+    WAIT_COUNT(wp, yields);
+    if (addr != NULL) {
+      ucp_worker_wait_mem(wp->ch->w, addr);
+    }
+    yielder();
+    break;
+  case SHMEMC_WAIT_BACKOFF:
+    WAIT_COUNT(wp, naps);
+    napper(wp->nap_ns);
+    if (wp->nap_ns < WAIT_NAP_MAX_NS) {
+      wp->nap_ns *= 2;
+    }
+    break;
+  default:
+    WAIT_COUNT(wp, sleeps);
+    if (waiter_sleep(wp->ch)) {
+      WAIT_COUNT(wp, wakeups);
+    }
+    break;
+  }
+}
+
+/*
+ * per-context choices and counters
+ */
+
+void shmemc_ctx_set_wait_policy(shmem_ctx_t ctx, shmemc_wait_policy_t policy) {
+  shmemc_context_h ch = (shmemc_context_h)ctx;
+
+  ch->wait_policy = policy;
+}
+
+void shmemc_ctx_get_wait_stats(shmem_ctx_t ctx, shmemc_wait_stats_t *sp) {
+  shmemc_context_h ch = (shmemc_context_h)ctx;
+
+  sp->waits = __atomic_load_n(&ch->wait_stats.waits, __ATOMIC_RELAXED);
+  sp->spins = __atomic_load_n(&ch->wait_stats.spins, __ATOMIC_RELAXED);
+  sp->yields = __atomic_load_n(&ch->wait_stats.yields, __ATOMIC_RELAXED);
+  sp->naps = __atomic_load_n(&ch->wait_stats.naps, __ATOMIC_RELAXED);
+  sp->sleeps = __atomic_load_n(&ch->wait_stats.sleeps, __ATOMIC_RELAXED);
+  sp->wakeups = __atomic_load_n(&ch->wait_stats.wakeups, __ATOMIC_RELAXED);
+}
+
+void shmemc_ctx_reset_wait_stats(shmem_ctx_t ctx) {
+  shmemc_context_h ch = (shmemc_context_h)ctx;
+
+  memset(&ch->wait_stats, 0, sizeof(ch->wait_stats));
+}
+
+#define WAIT_READ(_var) __atomic_load_n(_var, __ATOMIC_ACQUIRE)
+
+#define WAIT_TEST_eq(_v, _c) ((_v) == (_c))
+#define WAIT_TEST_ne(_v, _c) ((_v) != (_c))
+#define WAIT_TEST_gt(_v, _c) ((_v) > (_c))
+#define WAIT_TEST_le(_v, _c) ((_v) <= (_c))
+#define WAIT_TEST_lt(_v, _c) ((_v) < (_c))
+#define WAIT_TEST_ge(_v, _c) ((_v) >= (_c))
+
+#define WAIT_SATISFIED(_opname, _var, _cmp)                                    \
+  WAIT_TEST_##_opname(WAIT_READ(_var), _cmp)
 
 #define COMMS_CTX_WAIT_SIZE(_size, _opname)                                    \
   void shmemc_ctx_wait_until_##_opname##_size(                                 \
       shmem_ctx_t ctx, int##_size##_t *var, int##_size##_t value) {            \
-    shmemc_context_h ch = (shmemc_context_h)ctx;                               \
+    waiter_t w;                                                                \
                                                                                \
-    while (shmemc_ctx_test_##_opname##_size(ctx, var, value) == 0) {           \
-      ucp_worker_wait_mem(ch->w, var);                                         \
-      yielder();                                                               \
+    waiter_init(&w, ctx);                                                      \
+                                                                               \
+    while (!WAIT_SATISFIED(_opname, var, value)) {                             \
+      waiter_pause(&w, var);                                                   \
     }                                                                          \
   }
 
@@ -50,24 +240,123 @@ COMMS_CTX_WAIT_SIZE(16, ge)
 COMMS_CTX_WAIT_SIZE(32, ge)
 COMMS_CTX_WAIT_SIZE(64, ge)
 
-#define COMMS_CTX_WAIT_UNTIL_ALL_SIZE(_size, _opname)                          \
-  void shmemc_ctx_wait_until_all_##_opname##_size(                             \
-      shmem_ctx_t ctx, int##_size##_t *vars, size_t nelems, const int *status, \
-      int##_size##_t value) {                                                  \
-    size_t n = 0;                                                              \
-    size_t i;                                                                  \
+/*
+ * Arrays are compared a block at a time by the kernels in scan.c
+ */
+
+#define WAIT_INCLUDED(_status, _b, _n)                                         \
+  shmemc_ucx_scan_included(((_status) != NULL) ? (_status) + (_b) : NULL, _n)
+
+#define WAIT_SCAN(_size, _op, _vars, _values, _value, _b, _n)                  \
+  shmemc_ucx_scan##_size(_op, (_vars) + (_b), _n,                              \
+                         ((_values) != NULL) ? (_values) + (_b) : NULL, _value)
+
+#define WAIT_ARRAY(_size)                                                      \
+  static void wait_all##_size(shmem_ctx_t ctx, shmemc_ucx_cmp_t op,            \
+                              const int##_size##_t *vars, size_t nelems,       \
+                              const int *status, const int##_size##_t *values, \
+                              int##_size##_t value) {                          \
+    waiter_t w;                                                                \
+    size_t b;                                                                  \
+                                                                               \
+    waiter_init(&w, ctx);                                                      \
+                                                                               \
+    /* wait on the first one still missing, then look again */                 \
+    for (b = 0; b < nelems; b += SHMEMC_UCX_SCAN_BLOCK) {                      \
+      const size_t n = shmemc_ucx_scan_len(nelems, b);                         \
+      const uint64_t want = WAIT_INCLUDED(status, b, n);                       \
+      uint64_t hit;                                                            \
+                                                                               \
+      while ((hit = WAIT_SCAN(_size, op, vars, values, value, b, n) & want) != \
+             want) {                                                           \
+        waiter_pause(&w, (void *)&vars[b + __builtin_ctzll(want & ~hit)]);     \
+      }                                                                        \
+    }                                                                          \
+                                                                               \
+    /* the scans were plain loads: order what the caller reads next */         \
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);                                   \
+  }                                                                            \
+                                                                               \
+  static size_t wait_any##_size(shmem_ctx_t ctx, shmemc_ucx_cmp_t op,          \
+                                const int##_size##_t *vars, size_t nelems,     \
+                                const int *status,                             \
+                                const int##_size##_t *values,                  \
+                                int##_size##_t value) {                        \
+    waiter_t w;                                                                \
+                                                                               \
+    waiter_init(&w, ctx);                                                      \
+                                                                               \
+    for (;;) {                                                                 \
+      uint64_t live = 0;                                                       \
+      size_t b;                                                                \
                                                                                \
-    do {                                                                       \
-      for (i = 0; i < nelems; ++i) {                                           \
-        if ((status != NULL) && (status[i] != 0)) {                            \
-          continue;                                                            \
+      for (b = 0; b < nelems; b += SHMEMC_UCX_SCAN_BLOCK) {                    \
+        const size_t n = shmemc_ucx_scan_len(nelems, b);                       \
+        const uint64_t want = WAIT_INCLUDED(status, b, n);                     \
+        const uint64_t hit =                                                   \
+            WAIT_SCAN(_size, op, vars, values, value, b, n) & want;            \
+                                                                               \
+        if (hit != 0) {                                                        \
+          __atomic_thread_fence(__ATOMIC_ACQUIRE);                             \
+          return b + __builtin_ctzll(hit);                                     \
+          /* NOT REACHED */                                                    \
         }                                                                      \
-        if (shmemc_ctx_test_##_opname##_size(ctx, &(vars[i]), value) != 0) {   \
-          ++n;                                                                 \
+        live |= want;                                                          \
+      }                                                                        \
+      if (live == 0) {                                                         \
+        return SIZE_MAX;                                                       \
+        /* NOT REACHED */                                                      \
+      }                                                                        \
+      waiter_pause(&w, NULL);                                                  \
+    }                                                                          \
+  }                                                                            \
+                                                                               \
+  static size_t wait_some##_size(shmem_ctx_t ctx, shmemc_ucx_cmp_t op,         \
+                                 const int##_size##_t *vars, size_t nelems,    \
+                                 size_t *idxs, const int *status,              \
+                                 const int##_size##_t *values,                 \
+                                 int##_size##_t value) {                       \
+    waiter_t w;                                                                \
+                                                                               \
+    waiter_init(&w, ctx);                                                      \
+                                                                               \
+    /* hand back every one satisfied on the first pass that finds any */       \
+    for (;;) {                                                                 \
+      uint64_t live = 0;                                                       \
+      size_t hits = 0;                                                         \
+      size_t b;                                                                \
+                                                                               \
+      for (b = 0; b < nelems; b += SHMEMC_UCX_SCAN_BLOCK) {                    \
+        const size_t n = shmemc_ucx_scan_len(nelems, b);                       \
+        const uint64_t want = WAIT_INCLUDED(status, b, n);                     \
+        uint64_t hit = WAIT_SCAN(_size, op, vars, values, value, b, n) & want; \
+                                                                               \
+        while (hit != 0) {                                                     \
+          idxs[hits] = b + __builtin_ctzll(hit);                               \
+          ++hits;                                                              \
+          hit &= hit - 1;                                                      \
         }                                                                      \
-        yielder();                                                             \
+        live |= want;                                                          \
+      }                                                                        \
+      if ((hits > 0) || (live == 0)) {                                         \
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);                               \
+        return hits;                                                           \
+        /* NOT REACHED */                                                      \
       }                                                                        \
-    } while (n < nelems);                                                      \
+      waiter_pause(&w, NULL);                                                  \
+    }                                                                          \
+  }
+
+WAIT_ARRAY(16)
+WAIT_ARRAY(32)
+WAIT_ARRAY(64)
+
+#define COMMS_CTX_WAIT_UNTIL_ALL_SIZE(_size, _opname)                          \
+  void shmemc_ctx_wait_until_all_##_opname##_size(                             \
+      shmem_ctx_t ctx, int##_size##_t *vars, size_t nelems, const int *status, \
+      int##_size##_t value) {                                                  \
+    wait_all##_size(ctx, SHMEMC_UCX_CMP_##_opname, vars, nelems, status, NULL, \
+                    value);                                                    \
   }
 
 COMMS_CTX_WAIT_UNTIL_ALL_SIZE(16, eq)
@@ -98,26 +387,8 @@ COMMS_CTX_WAIT_UNTIL_ALL_SIZE(64, ge)
   size_t shmemc_ctx_wait_until_any_##_opname##_size(                           \
       shmem_ctx_t ctx, int##_size##_t *vars, size_t nelems, const int *status, \
       int##_size##_t value) {                                                  \
-    size_t winner;                                                             \
-    size_t i;                                                                  \
-                                                                               \
-    while (1) {                                                                \
-      for (i = 0; i < nelems; ++i) {                                           \
-        if ((status != NULL) && (status[i] != 0)) {                            \
-          continue;                                                            \
-        }                                                                      \
-                                                                               \
-        if (shmemc_ctx_test_##_opname##_size(ctx, &(vars[i]), value) != 0) {   \
-          winner = i;                                                          \
-          goto ret;                                                            \
-          /* NOT REACHED */                                                    \
-        }                                                                      \
-        yielder();                                                             \
-      }                                                                        \
-    }                                                                          \
-                                                                               \
-  ret:                                                                         \
-    return winner;                                                             \
+    return wait_any##_size(ctx, SHMEMC_UCX_CMP_##_opname, vars, nelems,        \
+                           status, NULL, value);                               \
   }
 
 COMMS_CTX_WAIT_UNTIL_ANY_SIZE(16, eq)
@@ -148,25 +419,8 @@ COMMS_CTX_WAIT_UNTIL_ANY_SIZE(64, ge)
   size_t shmemc_ctx_wait_until_some_##_opname##_size(                          \
       shmem_ctx_t ctx, int##_size##_t *vars, size_t nelems, size_t *idxs,      \
       const int *status, int##_size##_t value) {                               \
-    size_t i;                                                                  \
-    size_t hits = 0;                                                           \
-                                                                               \
-    /* find any one (there may be others too, further up) */                   \
-    (void)shmemc_ctx_wait_until_any_##_opname##_size(ctx, vars, nelems,        \
-                                                     status, value);           \
-    /* see which ones match */                                                 \
-    for (i = 0; i < nelems; ++i) {                                             \
-      if ((status != NULL) && (status[i] != 0)) {                              \
-        continue;                                                              \
-      }                                                                        \
-                                                                               \
-      if (shmemc_ctx_test_##_opname##_size(ctx, &(vars[i]), value) != 0) {     \
-        idxs[hits] = i;                                                        \
-        ++hits;                                                                \
-      }                                                                        \
-      yielder();                                                               \
-    }                                                                          \
-    return hits;                                                               \
+    return wait_some##_size(ctx, SHMEMC_UCX_CMP_##_opname, vars, nelems,       \
+                            idxs, status, NULL, value);                        \
   }
 
 COMMS_CTX_WAIT_UNTIL_SOME_SIZE(16, eq)
@@ -197,21 +451,8 @@ COMMS_CTX_WAIT_UNTIL_SOME_SIZE(64, ge)
   void shmemc_ctx_wait_until_all_vector_##_opname##_size(                      \
       shmem_ctx_t ctx, int##_size##_t *vars, size_t nelems, const int *status, \
       void *values) {                                                          \
-    int##_size##_t *vs = (int##_size##_t *)values;                             \
-    size_t n = 0;                                                              \
-    size_t i;                                                                  \
-                                                                               \
-    do {                                                                       \
-      for (i = 0; i < nelems; ++i) {                                           \
-        if ((status != NULL) && (status[i] != 0)) {                            \
-          continue;                                                            \
-        }                                                                      \
-        if (shmemc_ctx_test_##_opname##_size(ctx, &(vars[i]), vs[i]) != 0) {   \
-          ++n;                                                                 \
-        }                                                                      \
-        yielder();                                                             \
-      }                                                                        \
-    } while (n < nelems);                                                      \
+    wait_all##_size(ctx, SHMEMC_UCX_CMP_##_opname, vars, nelems, status,       \
+                    (const int##_size##_t *)values, 0);                        \
   }
 
 COMMS_CTX_WAIT_UNTIL_ALL_VECTOR_SIZE(16, eq)
@@ -242,27 +483,8 @@ COMMS_CTX_WAIT_UNTIL_ALL_VECTOR_SIZE(64, ge)
   size_t shmemc_ctx_wait_until_any_vector_##_opname##_size(                    \
       shmem_ctx_t ctx, int##_size##_t *vars, size_t nelems, const int *status, \
       void *values) {                                                          \
-    int##_size##_t *vs = (int##_size##_t *)values;                             \
-    size_t winner;                                                             \
-    size_t i;                                                                  \
-                                                                               \
-    while (1) {                                                                \
-      for (i = 0; i < nelems; ++i) {                                           \
-        if ((status != NULL) && (status[i] != 0)) {                            \
-          continue;                                                            \
-        }                                                                      \
-                                                                               \
-        if (shmemc_ctx_test_##_opname##_size(ctx, &(vars[i]), vs[i]) != 0) {   \
-          winner = i;                                                          \
-          goto ret;                                                            \
-          /* NOT REACHED */                                                    \
-        }                                                                      \
-        yielder();                                                             \
-      }                                                                        \
-    }                                                                          \
-                                                                               \
-  ret:                                                                         \
-    return winner;                                                             \
+    return wait_any##_size(ctx, SHMEMC_UCX_CMP_##_opname, vars, nelems,        \
+                           status, (const int##_size##_t *)values, 0);         \
   }
 
 COMMS_CTX_WAIT_UNTIL_ANY_VECTOR_SIZE(16, eq)
@@ -293,26 +515,8 @@ COMMS_CTX_WAIT_UNTIL_ANY_VECTOR_SIZE(64, ge)
   size_t shmemc_ctx_wait_until_some_vector_##_opname##_size(                   \
       shmem_ctx_t ctx, int##_size##_t *vars, size_t nelems, size_t *idxs,      \
       const int *status, void *values) {                                       \
-    int##_size##_t *vs = (int##_size##_t *)values;                             \
-    size_t i;                                                                  \
-    size_t hits = 0;                                                           \
-                                                                               \
-    /* find any one (there may be others too, further up) */                   \
-    (void)shmemc_ctx_wait_until_any_vector_##_opname##_size(ctx, vars, nelems, \
-                                                            status, vs);       \
-    /* see which ones match */                                                 \
-    for (i = 0; i < nelems; ++i) {                                             \
-      if ((status != NULL) && (status[i] != 0)) {                              \
-        continue;                                                              \
-      }                                                                        \
-                                                                               \
-      if (shmemc_ctx_test_##_opname##_size(ctx, &(vars[i]), vs[i]) != 0) {     \
-        idxs[hits] = i;                                                        \
-        ++hits;                                                                \
-      }                                                                        \
-      yielder();                                                               \
-    }                                                                          \
-    return hits;                                                               \
+    return wait_some##_size(ctx, SHMEMC_UCX_CMP_##_opname, vars, nelems,       \
+                            idxs, status, (const int##_size##_t *)values, 0);  \
   }
 
 COMMS_CTX_WAIT_UNTIL_SOME_VECTOR_SIZE(16, eq)
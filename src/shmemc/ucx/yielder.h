@@ -24,4 +24,31 @@ inline static void yielder(void) {
 #endif /* HAVE_SCHED_YIELDER || NANOSLEEP */
 }
 
+/*
+ * tell the CPU we're in a spin loop (saves power, and a sibling
+ * hyperthread gets the core)
+ */
+inline static void spinner(void) {
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_ia32_pause();
+#elif defined(__aarch64__)
+  __asm__ __volatile__("yield" ::: "memory");
+#endif /* arch */
+}
+
+/*
+ * sleep for about "ns" nanoseconds
+ */
+inline static void napper(long ns) {
+#ifdef HAVE_NANOSLEEP
+  const struct timespec req = {ns / 1000000000L, ns % 1000000000L};
+
+  (void)nanosleep(&req, NULL);
+#else
+  (void)ns;
+
+  yielder();
+#endif /* HAVE_NANOSLEEP */
+}
+
 #endif /* ! _SHMEMC_YIELDER_H */
@@ -8,6 +8,12 @@
  * - Running on legacy hardware or without direct transport-supported RDMA/AMO
  * - Explicitly enabled by the user
  *
+ * The thread goes round every context that can be shared between threads.
+ * It polls flat out while work is completing, and backs off geometrically
+ * up to SHMEM_PROGRESS_DELAY when there's nothing to do.  Or, with
+ * SHMEM_PROGRESS_MODE=event, it sleeps on the workers' wakeup events
+ * instead.  It can be pinned to a CPU with SHMEM_PROGRESS_CPU.
+ *
  * @note This code only gets activated if UCX's emulation mode is being
  * used: where we're running on legacy hardware, or where we don't
  * have direct transport-supported RDMA and AMO.
@@ -24,6 +30,13 @@
 #include "config.h"
 #endif /* HAVE_CONFIG_H */
 
+#ifdef HAVE_SCHED_SETAFFINITY
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE /* for CPU_SET() */
+#endif /* _GNU_SOURCE */
+#include <sched.h>
+#endif /* HAVE_SCHED_SETAFFINITY */
+
 #include "boolean.h"
 #include "shmemc.h"
 #include "shmemu.h"
@@ -45,41 +58,185 @@
 static threadwrap_thread_t thr;
 
 /**
- * Delay between progress calls in nanoseconds
- * @note mutable in case we want to look at adaptive polling
+ * Longest delay between progress calls in nanoseconds
  */
 static long delay_ns;
 
+/** First delay after progress goes idle */
+#define PROGRESS_MIN_DELAY_NS 100L
+
+/**
+ * Longest sleep on events (ms).  Finalize and new contexts wake the
+ * thread themselves, this is just a safety net.
+ */
+#define PROGRESS_EVENT_TIMEOUT_MS 1000
+
+/** CPU to pin the thread to, or -1 */
+static int pin_cpu = -1;
+
 /** Flag to control progress thread execution */
 static volatile bool done = false;
 
 /** Nanoseconds per second constant */
 static const long billion = 1e9;
 
+/**
+ * @brief Pin the calling thread to a CPU
+ *
+ * @param cpu CPU to run on, ignored if < 0
+ */
+static void pin_progress_thread(int cpu) {
+#ifdef HAVE_SCHED_SETAFFINITY
+  cpu_set_t set;
+
+  if (cpu < 0) {
+    return;
+    /* NOT REACHED */
+  }
+
+  CPU_ZERO(&set);
+  CPU_SET(cpu, &set);
+
+  /* 0 == this thread */
+  if (sched_setaffinity(0, sizeof(set), &set) != 0) {
+    shmemu_warn(MODULE ": can't pin progress thread to CPU %d (%s)", cpu,
+                strerror(errno));
+  }
+#else
+  NO_WARN_UNUSED(cpu);
+#endif /* HAVE_SCHED_SETAFFINITY */
+}
+
+/**
+ * @brief Drive progress, sleeping on network events when idle
+ *
+ * @return 0 when signaled to stop, non-zero if events can't be used
+ */
+static int progress_events(void) {
+  do {
+    /* do everything there is before sleeping */
+    while ((shmemc_progress_all() > 0) && !done) {
+      continue;
+    }
+
+    if (shmemc_progress_block(PROGRESS_EVENT_TIMEOUT_MS) != 0) {
+      return 1;
+      /* NOT REACHED */
+    }
+  } while (!done);
+
+  return 0;
+}
+
+/**
+ * @brief Drive progress, polling
+ *
+ * Polls again at once while anything completes, and backs off up to
+ * delay_ns when idle (less if buffered ops need flushing sooner).
+ */
+static void progress_poll(void) {
+  long idle_ns = 0;
+
+  do {
+    if (shmemc_progress_all() > 0) {
+      idle_ns = 0;
+      continue;
+      /* NOT REACHED */
+    }
+
+    idle_ns = (idle_ns == 0) ? PROGRESS_MIN_DELAY_NS : 2 * idle_ns;
+    if (idle_ns > delay_ns) {
+      idle_ns = delay_ns;
+    }
+    idle_ns = shmemc_progress_idle_ns(idle_ns);
+
+    if (idle_ns > 0) {
+      const struct timespec ts = {.tv_sec = idle_ns / billion,
+                                  .tv_nsec = idle_ns % billion};
+
+      nanosleep(&ts, NULL); /* back off */
+    }
+  } while (!done);
+}
+
 /**
  * @brief Progress thread main function
  *
- * Continuously calls communication progress function with configurable delay
- * until signaled to stop.
+ * Drives all shared contexts until signaled to stop.
  *
- * @param args Thread arguments (unused)
+ * @param args Pointer to CPU to pin to
  * @return NULL
  */
 static void *start_progress(void *args) {
-  NO_WARN_UNUSED(args);
+  pin_progress_thread(*(int *)args);
 
-  do {
-    const struct timespec ts = {.tv_sec = delay_ns / billion,
-                                .tv_nsec = delay_ns % billion};
+  if (proc.env.progress_events) {
+    if (progress_events() == 0) {
+      return NULL;
+      /* NOT REACHED */
+    }
 
-    shmemc_progress();
+    shmemu_warn(MODULE ": can't sleep on network events, "
+                       "progress thread will poll");
+  }
 
-    nanosleep(&ts, NULL); /* back off */
-  } while (!done);
+  progress_poll();
 
   return NULL;
 }
 
+/**
+ * @brief Work out which CPU this PE's progress thread goes on
+ *
+ * PEs on a node take CPUs from SHMEM_PROGRESS_CPU in turn.
+ *
+ * @return CPU, or -1 for no pinning
+ */
+static int choose_progress_cpu(void) {
+  int *cpus = NULL;
+  size_t ncpus;
+  char *copy;
+  int cpu = -1;
+  int s;
+
+  if (proc.env.progress_cpu == NULL) {
+    return -1;
+    /* NOT REACHED */
+  }
+
+  /* shmemu_parse_csv zaps the input string */
+  copy = strdup(proc.env.progress_cpu);
+  if (copy == NULL) {
+    shmemu_fatal(MODULE ": unable to allocate memory during "
+                        "progress CPU check: %s",
+                 strerror(errno));
+    /* NOT REACHED */
+  }
+
+  s = shmemu_parse_csv(copy, &cpus, &ncpus);
+  if ((s > 0) && (ncpus > 0)) {
+    int local = 0;
+    int i;
+
+    for (i = 0; (proc.li.peers != NULL) && (i < proc.li.npeers); ++i) {
+      if (proc.li.peers[i] == proc.li.rank) {
+        local = i;
+        break;
+      }
+    }
+
+    cpu = cpus[local % ncpus];
+  } else {
+    shmemu_warn(MODULE ": ignoring progress CPU list \"%s\"",
+                proc.env.progress_cpu);
+  }
+
+  free(cpus);
+  free(copy);
+
+  return cpu;
+}
+
 /**
  * @brief Check if progress thread should be enabled for this PE
  *
@@ -153,10 +310,13 @@ void shmemu_progress_init(void) {
 
     /* pull in progress timing */
     delay_ns = (long)proc.env.progress_delay_ns;
+    pin_cpu = choose_progress_cpu();
 
-    logger(LOG_INIT, "progress thread delay = %ldns", delay_ns);
+    logger(LOG_INIT, "progress thread %s, max delay = %ldns, cpu = %d",
+           proc.env.progress_events ? "event-driven" : "polling", delay_ns,
+           pin_cpu);
 
-    s = threadwrap_thread_create(&thr, start_progress, NULL);
+    s = threadwrap_thread_create(&thr, start_progress, &pin_cpu);
     shmemu_assert(s == 0, MODULE ": could not create progress thread (%s)",
                   strerror(s));
   }
@@ -172,17 +332,20 @@ void shmemu_progress_finalize(void) {
     int s;
 
     done = true;
+    shmemc_progress_unblock();
 
     s = threadwrap_thread_join(thr, NULL);
     shmemu_assert(s == 0, MODULE ": could not terminate progress thread (%s)",
                   strerror(s));
+
+    shmemc_progress_block_finalize();
   }
 }
 
 /**
  * @brief Set progress thread delay
  *
- * Updates the delay between progress calls.
+ * Updates the longest delay between idle progress calls.
  *
  * @param newdelay New delay value in nanoseconds
  */